@@ -0,0 +1,89 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/GamutBoundary.hh"
+#include "tukan/RGBSpace.hh"
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    // Catalogue-like queries: random L*C*h over [0..100] x [0..120] x [0..360), or L*a*b over
+    // [0..100] x [-120..120] x [-120..120]; f(L, C, h) or f(L, a, b) answers one.
+    enum class Query { lch, lab };
+
+    template <typename F>
+    void query_kernel (std::string const &name, Query query, double flops, F f) {
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            auto lch = std::make_shared<std::vector<double>>(3 * pixels);
+            const std::uint32_t seed = bench::seed_of(name);
+            bench::Random random (seed);
+            for (std::size_t i=0; i!=pixels; ++i) {
+                (*lch)[3*i+0] = random(0, 100);
+                (*lch)[3*i+1] = query == Query::lch ? random(0, 120) : random(-120, 120);
+                (*lch)[3*i+2] = query == Query::lch ? random(0, 360) : random(-120, 120);
+            }
+            return [=](std::size_t iterations) {
+                double const *q = lch->data();
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    std::size_t inside = 0;
+                    for (std::size_t i=0; i!=pixels; ++i)
+                        inside += f(q[3*i+0], q[3*i+1], q[3*i+2]);
+                    bench::do_not_optimize(inside);
+                }
+            };
+        }, 3 * sizeof(double), flops);
+    }
+
+    // The same LCh queries in planes, through the batch version.
+    template <typename T>
+    void batch_kernel (std::string const &name, double flops) {
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            auto planes = std::make_shared<std::vector<T>>(3 * pixels);
+            auto mask = std::make_shared<std::vector<std::uint8_t>>(pixels);
+            bench::Random random (bench::seed_of(name));
+            for (std::size_t i=0; i!=pixels; ++i) {
+                (*planes)[i] = T(random(0, 100));
+                (*planes)[pixels+i] = T(random(0, 120));
+                (*planes)[2*pixels+i] = T(random(0, 360));
+            }
+            return [=](std::size_t iterations) {
+                GamutBoundary<T,sRGB> const &b = gamut_boundary<T,sRGB>();
+                T const *p = planes->data();
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    bench::do_not_optimize(b.in_gamut(p, p + pixels, p + 2*pixels, pixels,
+                                                      mask->data()));
+                }
+            };
+        }, 3 * sizeof(T) + 1, flops);
+    }
+
+    const bench::Registrar gamut_boundary_queries ([] {
+        // The table, against the exact test from LCh (sin and cos, then the conversion) and
+        // from Lab (the conversion only).
+        query_kernel("GamutBoundary/in_gamut/table", Query::lch, 20, [](double L, double C, double h) {
+            static GamutBoundary<double,sRGB> const &b = gamut_boundary<double,sRGB>();
+            return b.in_gamut(L, C, h);
+        });
+        query_kernel("GamutBoundary/in_gamut/exact_lch", Query::lch, 60, [](double L, double C, double h) {
+            static const detail::lab_gamut_test test = detail::lab_gamut_test::of<sRGB>();
+            const double r = h * (3.14159265358979323846 / 180);
+            return test(L, C * std::cos(r), C * std::sin(r));
+        });
+        query_kernel("GamutBoundary/in_gamut/exact_lab", Query::lab, 40,
+                     [](double L, double a, double b) {
+            static const detail::lab_gamut_test test = detail::lab_gamut_test::of<sRGB>();
+            return test(L, a, b);
+        });
+        batch_kernel<double>("GamutBoundary/in_gamut/batch_double", 20);
+        batch_kernel<float>("GamutBoundary/in_gamut/batch_float", 20);
+    });
+}
@@ -0,0 +1,288 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+// Characterizes the accuracy and speed of the transfer functions in gammas.hh and of the fast
+// float approximations (detail/gamma_approx.hh, detail/exp.hh), to decide which fast paths
+// are safe to use.
+//
+// Usage: tukan_accuracy [--stride=N] [--filter=REGEX] [--min-time=SECONDS]
+//
+// Every function is swept over every float in its domain, in increasing order, e.g. all
+// 1065353217 floats in [0..1] for the transfer functions; with --stride=N, only every N-th
+// float is taken, which keeps the sweep of the whole range but is N times faster. The sweep
+// runs in parallel with OpenMP. Results are compared against a long double evaluation of the
+// same formula, and reported per function:
+//
+//   values       the number of inputs swept
+//   max ulp      the largest error in units in the last place of the float nearest to the
+//                reference, and the input where it occurs; a correctly rounded function has
+//                0.5. Non-finite results of finite references count as infinite error.
+//   mean ulp     the average error
+//   max abs      the largest absolute error, which is what matters for quantization
+//   non-mono     how often the result decreases from one input to the next, although all
+//                functions here increase monotonically
+//   ns/value     the throughput of the candidate in a plain loop over 16384 inputs
+//
+// "(double)" rows are the library's double implementations, rounded to float, as used for
+// float colours; the others are the float fast paths.
+//
+// Example: tukan_accuracy --stride=64 --filter=sRGB
+
+#include "benchmark.hh"
+#include "tukan/gammas.hh"
+#include "tukan/detail/exp.hh"
+#include "tukan/detail/gamma_approx.hh"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using tukan::detail::float_bits;
+    using tukan::detail::bits_float;
+
+    struct Options {
+        std::int64_t stride = 1;
+        std::string filter = ".*";
+        double min_time = 0.1;
+    };
+
+    struct Report {
+        std::int64_t values = 0, non_monotonic = 0;
+        long double max_ulp = 0, sum_ulp = 0, max_abs = 0;
+        float max_ulp_at = 0;
+        double ns_per_value = 0;
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Floats in order
+    //----------------------------------------------------------------------------------------------
+    // Consecutive integers for consecutive floats; -0 and +0 both map to 0.
+    std::int64_t ordinal (float f) {
+        const std::uint32_t u = float_bits(f);
+        return u & 0x80000000u ? -std::int64_t(u & 0x7fffffffu) : std::int64_t(u);
+    }
+
+    float from_ordinal (std::int64_t o) {
+        return bits_float(o < 0 ? 0x80000000u | std::uint32_t(-o) : std::uint32_t(o));
+    }
+
+    long double ulp_error (float y, long double ref) {
+        if (std::isnan(ref))
+            return std::isnan(y) ? 0 : std::numeric_limits<long double>::infinity();
+        if (!std::isfinite(y))
+            return y == ref ? 0 : std::numeric_limits<long double>::infinity();
+        const float r = std::fabs(float(ref));
+        const float next = std::nextafter(r, std::numeric_limits<float>::infinity());
+        const long double ulp = std::isinf(next) ? r - std::nextafter(r, 0.f) : next - r;
+        return std::fabs(y - ref) / ulp;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Sweep and throughput
+    //----------------------------------------------------------------------------------------------
+    template <typename Candidate, typename Reference>
+    Report characterize (float lo, float hi, Candidate candidate, Reference reference,
+                         Options const &opts)
+    {
+        struct Chunk {
+            Report report;
+            float first = 0, last = 0;
+        };
+        const std::int64_t first = ordinal(lo);
+        const std::int64_t n = (ordinal(hi) - first) / opts.stride + 1;
+        const std::int64_t chunk_size = 1 << 16;
+        std::vector<Chunk> chunks ((n + chunk_size - 1) / chunk_size);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (std::int64_t c=0; c<std::int64_t(chunks.size()); ++c) {
+            Chunk &ch = chunks[c];
+            Report &r = ch.report;
+            const std::int64_t end = std::min(n, (c + 1) * chunk_size);
+            for (std::int64_t k=c*chunk_size; k!=end; ++k) {
+                const float x = from_ordinal(first + k * opts.stride);
+                const float y = candidate(x);
+                const long double ref = reference(x);
+                const long double e = ulp_error(y, ref);
+                r.sum_ulp += e;
+                if (e > r.max_ulp || (r.values == 0 && e == r.max_ulp)) {
+                    r.max_ulp = e;
+                    r.max_ulp_at = x;
+                }
+                r.max_abs = std::max(r.max_abs, std::fabs(y - ref));
+                if (r.values != 0 && y < ch.last)
+                    ++r.non_monotonic;
+                if (r.values == 0)
+                    ch.first = y;
+                ch.last = y;
+                ++r.values;
+            }
+        }
+
+        Report ret;
+        for (std::size_t c=0; c!=chunks.size(); ++c) {
+            Report const &r = chunks[c].report;
+            ret.values += r.values;
+            ret.sum_ulp += r.sum_ulp;
+            ret.non_monotonic += r.non_monotonic + (c && chunks[c].first < chunks[c-1].last);
+            ret.max_abs = std::max(ret.max_abs, r.max_abs);
+            if (c == 0 || r.max_ulp > ret.max_ulp) {
+                ret.max_ulp = r.max_ulp;
+                ret.max_ulp_at = r.max_ulp_at;
+            }
+        }
+
+        // Throughput over inputs spread evenly over the domain.
+        std::vector<float> in (16384), out (in.size());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            in[i] = from_ordinal(first + (ordinal(hi) - first) * std::int64_t(i)
+                                         / std::int64_t(in.size() - 1));
+        const bench::Run run = [&](std::size_t iterations) {
+            float const *src = in.data();
+            float *dst = out.data();
+            for (std::size_t it=0; it!=iterations; ++it) {
+                bench::clobber_memory();
+                for (std::size_t i=0; i!=in.size(); ++i)
+                    dst[i] = candidate(src[i]);
+                bench::do_not_optimize(dst);
+            }
+        };
+        std::size_t iterations = 1;
+        double seconds;
+        while ((seconds = bench::time_run(run, iterations)) < opts.min_time)
+            iterations *= 2;
+        ret.ns_per_value = seconds * 1e9 / (double(iterations) * in.size());
+        return ret;
+    }
+
+
+    struct Entry {
+        std::string name;
+        std::function<Report (Options const &)> run;
+    };
+
+    std::vector<Entry>& entries() {
+        static std::vector<Entry> ret;
+        return ret;
+    }
+
+    template <typename Candidate, typename Reference>
+    void add (std::string name, float lo, float hi, Candidate c, Reference r) {
+        entries().push_back(Entry{name, [=](Options const &opts) {
+            return characterize(lo, hi, c, r, opts);
+        }});
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Long double references, the formulas of gammas.hh for v >= 0
+    //----------------------------------------------------------------------------------------------
+    using gamma::detail::simple_gamma;
+
+    long double ref_to_linear (simple_gamma g, long double v) {
+        return std::pow(v, (long double)g.gamma);
+    }
+    long double ref_to_nonlinear (simple_gamma g, long double v) {
+        return std::pow(v, 1 / (long double)g.gamma);
+    }
+
+    long double ref_to_linear (gamma::detail::sRGB, long double v) {
+        return v <= 0.04045L ? v / 12.92L : std::pow((v + 0.055L) / 1.055L, 2.4L);
+    }
+    long double ref_to_nonlinear (gamma::detail::sRGB, long double v) {
+        return v <= 0.0031308L ? v * 12.92L : 1.055L * std::pow(v, 1 / 2.4L) - 0.055L;
+    }
+
+    long double ref_to_linear (gamma::detail::L, long double v) {
+        return v <= 0.08L ? 100 * v / 903.3L : std::pow((v + 0.16L) / 1.16L, 3.0L);
+    }
+    long double ref_to_nonlinear (gamma::detail::L, long double v) {
+        return v <= 0.008856L ? v * 9.033L : 1.16L * std::cbrt(v) - 0.16L;
+    }
+
+
+    template <typename Gamma>
+    void add_gamma (std::string const &name, Gamma g) {
+        add(name + " to_linear (double)", 0.f, 1.f,
+            [=](float v) mutable { return float(g.to_linear(v)); },
+            [=](float v) { return ref_to_linear(g, v); });
+        add(name + " to_nonlinear (double)", 0.f, 1.f,
+            [=](float v) mutable { return float(g.to_nonlinear(v)); },
+            [=](float v) { return ref_to_nonlinear(g, v); });
+        add(name + " to_nonlinear_approx", 0.f, 1.f,
+            [=](float v) { return tukan::detail::to_nonlinear_approx(g, v); },
+            [=](float v) { return ref_to_nonlinear(g, v); });
+    }
+
+    void add_all () {
+        add_gamma("gamma 1.0", gamma::_1_0);
+        add_gamma("gamma 1.8", gamma::_1_8);
+        add_gamma("gamma 2.2", gamma::_2_2);
+        add_gamma("gamma sRGB", gamma::sRGB);
+        add_gamma("gamma L", gamma::L);
+
+        const float min_normal = std::numeric_limits<float>::min();
+        add("exp_approx", -87.f, 88.f,
+            [](float x) { return tukan::detail::exp_approx(x); },
+            [](float x) { return std::exp((long double)x); });
+        add("log2_approx", min_normal, std::numeric_limits<float>::max(),
+            [](float x) { return tukan::detail::log2_approx(x); },
+            [](float x) { return std::log2((long double)x); });
+        add("pow_approx(x,1/2.4)", 0.f, 1.f,
+            [](float x) { return tukan::detail::pow_approx(x, 1/2.4f); },
+            [](float x) { return std::pow((long double)x, (long double)(1/2.4f)); });
+        add("pow_approx(x,2.4)", 0.f, 1.f,
+            [](float x) { return tukan::detail::pow_approx(x, 2.4f); },
+            [](float x) { return std::pow((long double)x, 2.4L); });
+    }
+
+
+    int usage () {
+        std::cerr << "usage: tukan_accuracy [--stride=N] [--filter=REGEX] [--min-time=SECONDS]\n";
+        return 2;
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+    Options opts;
+    try {
+        for (int i=1; i<argc; ++i) {
+            const std::string arg = argv[i];
+            std::string v;
+            if      (bench::parse_option(arg, "stride", v))   opts.stride = std::stoll(v);
+            else if (bench::parse_option(arg, "filter", v))   opts.filter = v;
+            else if (bench::parse_option(arg, "min-time", v)) opts.min_time = std::stod(v);
+            else return usage();
+        }
+    } catch (std::exception const &) {
+        return usage();
+    }
+    if (opts.stride < 1)
+        return usage();
+
+    add_all();
+    const std::regex filter (opts.filter);
+    std::printf("%-34s %11s %11s %14s %10s %10s %9s %9s\n", "function", "values", "max ulp",
+                "at", "mean ulp", "max abs", "non-mono", "ns/value");
+    for (Entry const &e : entries()) {
+        if (!std::regex_search(e.name, filter))
+            continue;
+        const Report r = e.run(opts);
+        std::printf("%-34s %11lld %11.3Lg %14.7g %10.4Lg %10.3Lg %9lld %9.3f\n", e.name.c_str(),
+                    (long long)r.values, r.max_ulp, r.max_ulp_at, r.sum_ulp / r.values,
+                    r.max_abs, (long long)r.non_monotonic, r.ns_per_value);
+        std::fflush(stdout);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,425 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef BENCHMARK_HH_INCLUDED_20261018
+#define BENCHMARK_HH_INCLUDED_20261018
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// bench:
+//
+//    A small benchmark harness in the manner of Google Benchmark, without the dependency.
+//    Kernels are registered at static initialization, each processing a buffer of pixels per
+//    iteration; the harness picks the number of iterations so that a run takes at least
+//    --min-time seconds, and reports ns/pixel and pixels/s.
+//
+//    Inputs are random, but reproducible: the generator is seeded from the kernel's name and
+//    --seed, and turns the standardized mt19937 sequence into floats itself, so the same
+//    kernel sees the same pixels on every platform and in every filter selection. Buffers are
+//    allocated when a kernel is run, after filtering.
+//
+//    Output is a table on stdout and, with --json=FILE, a JSON document in the layout of
+//    Google Benchmark's ("context" and "benchmarks", times in ns), one entry per repetition.
+//
+//    With --roofline, each kernel that declares its traffic runs over working sets from 4 KiB
+//    (L1-resident) up to --max-working-set (DRAM), growing by 4x, and the table reports the
+//    achieved GB/s and GFLOP/s and the arithmetic intensity, on one thread. Entries are named
+//    "<kernel>/ws:<size>". A kernel whose GB/s falls with the working set is memory-bound
+//    there, and gains from fusing passes or smaller pixel formats; one whose GB/s holds up to
+//    DRAM is compute-bound. Bytes are those of the input and output pixels (without write
+//    allocation); FLOPs are the arithmetic of the formula as declared by the kernel, counting
+//    each pow or cbrt as one.
+//
+//    Options:
+//      --filter=REGEX      run only kernels whose name matches (ECMAScript, searched)
+//      --min-time=SECONDS  minimum time per repetition, default 0.1
+//      --repetitions=N     default 1
+//      --pixels=N          pixels per iteration, default 16384 (fits into L2)
+//      --seed=N            default 1
+//      --json=FILE         also write the results as JSON
+//      --list              print the kernel names and exit
+//      --roofline          sweep working sets, see above
+//      --max-working-set=N largest working set in bytes, default 268435456 (256 MiB)
+//
+//
+// Definitions:
+//
+//    // Registers 'setup', which allocates its inputs for the given number of pixels and
+//    // returns the function that runs the given number of iterations over them. Bytes and
+//    // FLOPs are per pixel, 0 if unknown; kernels without bytes are left out of --roofline.
+//    void add (std::string name, Setup setup, double bytes = 0, double flops = 0)
+//
+//    // Registers out[i] = f(in[i]) over random colours with channels in [lo..hi), moving
+//    // sizeof(In) + sizeof(Out) bytes per pixel.
+//    void map <In> (std::string name, double lo, double hi, F f, double flops = 0)
+//
+//    std::vector<Color> random_colors <Color> (size_t n, double lo, double hi, uint32_t seed)
+//    void do_not_optimize (T const &)
+//    void clobber_memory ()
+//
+//    Registrar r ([] { map<...>(...); ... });   // runs the lambda at static initialization
+//    int main (int argc, char **argv)           // for benchmarks/main.cc
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace bench {
+
+    using Run   = std::function<void (std::size_t iterations)>;
+    using Setup = std::function<Run (std::size_t pixels)>;
+
+    struct Kernel {
+        std::string name;
+        Setup setup;
+        double bytes, flops;   // per pixel
+    };
+
+    struct Options {
+        std::string filter = ".*", json;
+        double min_time = 0.1;
+        unsigned repetitions = 1;
+        std::size_t pixels = 16384;
+        std::uint32_t seed = 1;
+        bool list = false, roofline = false;
+        std::size_t max_working_set = std::size_t(256) << 20;
+    };
+
+    struct Result {
+        std::string name;
+        unsigned repetition;
+        std::size_t pixels, iterations;
+        double seconds;
+        double bytes, flops;        // per pixel
+        std::size_t working_set;    // 0 unless --roofline
+
+        double ns_per_pixel() const { return seconds * 1e9 / (double(pixels) * iterations); }
+        double pixels_per_second() const { return double(pixels) * iterations / seconds; }
+        double bytes_per_second() const { return bytes * pixels_per_second(); }
+        double flops_per_second() const { return flops * pixels_per_second(); }
+    };
+
+
+    inline std::vector<Kernel>& registry() {
+        static std::vector<Kernel> kernels;
+        return kernels;
+    }
+
+    inline Options& options() {
+        static Options opts;
+        return opts;
+    }
+
+    inline void add (std::string name, Setup setup, double bytes = 0, double flops = 0) {
+        registry().push_back(Kernel{std::move(name), std::move(setup), bytes, flops});
+    }
+
+    struct Registrar {
+        template <typename F>
+        explicit Registrar (F f) { f(); }
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Inputs
+    //----------------------------------------------------------------------------------------------
+    // FNV-1a, so that a kernel's inputs depend on its name and --seed only. Call it from the
+    // setup, after the options are parsed.
+    inline std::uint32_t seed_of (std::string const &name) {
+        std::uint32_t h = 2166136261u ^ options().seed;
+        for (unsigned char c : name)
+            h = (h ^ c) * 16777619u;
+        return h;
+    }
+
+    class Random {
+    public:
+        explicit Random (std::uint32_t seed) : engine_(seed) {}
+
+        // Uniform in [lo..hi); from the top 24 bits, so exact in float.
+        double operator() (double lo, double hi) {
+            const double u = (engine_() >> 8) * (1.0 / (1 << 24));
+            return lo + u * (hi - lo);
+        }
+
+    private:
+        std::mt19937 engine_;
+    };
+
+    template <typename Color>
+    std::vector<Color> random_colors (std::size_t n, double lo, double hi, std::uint32_t seed) {
+        using T = typename Color::value_type;
+        enum { channels = sizeof(Color) / sizeof(T) };
+        Random random (seed);
+        std::vector<Color> ret (n);
+        for (Color &c : ret)
+            for (unsigned k=0; k!=channels; ++k)
+                c[k] = T(random(lo, hi));
+        return ret;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Keeping the optimizer honest
+    //----------------------------------------------------------------------------------------------
+    template <typename T>
+    inline void do_not_optimize (T const &value) {
+#if defined(__GNUC__)
+        asm volatile ("" : : "r,m"(value) : "memory");
+#else
+        static volatile char sink;
+        sink = *reinterpret_cast<char const volatile*>(&value);
+#endif
+    }
+
+    inline void clobber_memory () {
+#if defined(__GNUC__)
+        asm volatile ("" : : : "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+
+    template <typename In, typename F>
+    void map (std::string name, double lo, double hi, F f, double flops = 0) {
+        using Out = decltype(f(In()));
+        add(name, [=](std::size_t pixels) -> Run {
+            const std::uint32_t seed = seed_of(name);
+            auto in = std::make_shared<std::vector<In>>(random_colors<In>(pixels, lo, hi, seed));
+            auto out = std::make_shared<std::vector<Out>>(pixels);
+            return [=](std::size_t iterations) {
+                In const *src = in->data();
+                Out *dst = out->data();
+                const std::size_t n = in->size();
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    clobber_memory();
+                    for (std::size_t i=0; i!=n; ++i)
+                        dst[i] = f(src[i]);
+                    do_not_optimize(dst);
+                }
+            };
+        }, sizeof(In) + sizeof(Out), flops);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Running
+    //----------------------------------------------------------------------------------------------
+    inline double time_run (Run const &run, std::size_t iterations) {
+        using clock = std::chrono::steady_clock;
+        const clock::time_point start = clock::now();
+        run(iterations);
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // Grows the number of iterations until a run takes min_time, as Google Benchmark does.
+    inline Result measure (Kernel const &kernel, Run const &run, unsigned repetition,
+                           std::size_t pixels, std::size_t working_set = 0)
+    {
+        Options const &opts = options();
+        std::size_t iterations = 1;
+        for (;;) {
+            const double seconds = time_run(run, iterations);
+            if (seconds >= opts.min_time || iterations >= 1000000000)
+                return Result{kernel.name, repetition, pixels, iterations, seconds,
+                              kernel.bytes, kernel.flops, working_set};
+            const double factor = seconds <= opts.min_time / 100 ? 10
+                                : 1.4 * opts.min_time / seconds;
+            iterations = std::max(iterations + 1, std::size_t(iterations * factor));
+        }
+    }
+
+    inline std::string json_escape (std::string const &s) {
+        std::string ret;
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                ret += '\\';
+            ret += c;
+        }
+        return ret;
+    }
+
+    inline void write_json (std::ostream &os, std::vector<Result> const &results) {
+        char date[64];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        Options const &opts = options();
+
+        os.precision(10);
+        os << "{\n"
+           << "  \"context\": {\n"
+           << "    \"date\": \"" << date << "\",\n"
+           << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#if defined(__VERSION__)
+           << "    \"compiler\": \"" << json_escape(__VERSION__) << "\",\n"
+#endif
+#if defined(__OPTIMIZE__)
+           << "    \"library_build_type\": \"release\",\n"
+#else
+           << "    \"library_build_type\": \"debug\",\n"
+#endif
+           << "    \"pixels\": " << opts.pixels << ",\n"
+           << "    \"seed\": " << opts.seed << ",\n"
+           << "    \"min_time\": " << opts.min_time << "\n"
+           << "  },\n"
+           << "  \"benchmarks\": [";
+        for (std::size_t i=0; i!=results.size(); ++i) {
+            Result const &r = results[i];
+            os << (i ? "," : "") << "\n    {"
+               << "\"name\": \"" << json_escape(r.name) << "\", "
+               << "\"repetition\": " << r.repetition << ", "
+               << "\"pixels\": " << r.pixels << ", "
+               << "\"iterations\": " << r.iterations << ", "
+               << "\"real_time\": " << r.seconds * 1e9 / r.iterations << ", "
+               << "\"time_unit\": \"ns\", "
+               << "\"ns_per_pixel\": " << r.ns_per_pixel() << ", "
+               << "\"pixels_per_second\": " << r.pixels_per_second();
+            if (r.working_set)
+                os << ", \"working_set\": " << r.working_set;
+            if (r.bytes)
+                os << ", \"bytes_per_second\": " << r.bytes_per_second();
+            if (r.flops)
+                os << ", \"flops_per_second\": " << r.flops_per_second();
+            os << "}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    inline bool parse_option (std::string const &arg, char const *name, std::string &value) {
+        const std::string prefix = std::string("--") + name + "=";
+        if (arg.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        value = arg.substr(prefix.size());
+        return true;
+    }
+
+    inline void parse_options (int argc, char **argv) {
+        Options &opts = options();
+        for (int i=1; i<argc; ++i) {
+            const std::string arg = argv[i];
+            std::string v;
+            if      (parse_option(arg, "filter", v))      opts.filter = v;
+            else if (parse_option(arg, "json", v))        opts.json = v;
+            else if (parse_option(arg, "min-time", v))    opts.min_time = std::stod(v);
+            else if (parse_option(arg, "repetitions", v)) opts.repetitions = std::stoul(v);
+            else if (parse_option(arg, "pixels", v))      opts.pixels = std::stoul(v);
+            else if (parse_option(arg, "seed", v))        opts.seed = std::uint32_t(std::stoul(v));
+            else if (parse_option(arg, "max-working-set", v))
+                opts.max_working_set = std::stoull(v);
+            else if (arg == "--list")                     opts.list = true;
+            else if (arg == "--roofline")                 opts.roofline = true;
+            else throw std::runtime_error("unknown option '" + arg + "'");
+        }
+        if (opts.pixels == 0 || opts.repetitions == 0 || !(opts.min_time >= 0)
+            || opts.max_working_set < 4096)
+            throw std::runtime_error("invalid option value");
+    }
+
+    inline std::vector<Result> run_kernels (std::vector<Kernel> const &kernels) {
+        Options const &opts = options();
+        std::printf("%-44s %12s %12s %14s\n", "kernel", "iterations", "ns/pixel", "Mpixels/s");
+        std::vector<Result> results;
+        for (Kernel const &k : kernels) {
+            const Run run = k.setup(opts.pixels);
+            run(1); // warm up caches and page in the buffers
+            for (unsigned rep=0; rep!=opts.repetitions; ++rep) {
+                const Result r = measure(k, run, rep, opts.pixels);
+                std::printf("%-44s %12zu %12.3f %14.2f\n", r.name.c_str(), r.iterations,
+                            r.ns_per_pixel(), r.pixels_per_second() / 1e6);
+                std::fflush(stdout);
+                results.push_back(r);
+            }
+        }
+        return results;
+    }
+
+    inline std::string format_size (std::size_t bytes) {
+        return bytes >= (1 << 20) ? std::to_string(bytes >> 20) + "MiB"
+                                  : std::to_string(bytes >> 10) + "KiB";
+    }
+
+    inline std::vector<Result> run_roofline (std::vector<Kernel> const &kernels) {
+        Options const &opts = options();
+        std::printf("%-56s %10s %10s %10s %9s\n", "kernel", "ns/pixel", "GB/s", "GFLOP/s",
+                    "FLOP/B");
+        std::vector<Result> results;
+        for (Kernel const &k : kernels) {
+            if (k.bytes <= 0)
+                continue;
+            for (std::size_t ws = 4096; ws <= opts.max_working_set; ws *= 4) {
+                const std::size_t pixels = std::max(std::size_t(1), std::size_t(ws / k.bytes));
+                const Run run = k.setup(pixels);
+                run(1);
+                for (unsigned rep=0; rep!=opts.repetitions; ++rep) {
+                    Result r = measure(k, run, rep, pixels, ws);
+                    r.name += "/ws:" + format_size(ws);
+                    if (k.flops > 0)
+                        std::printf("%-56s %10.3f %10.2f %10.2f %9.3f\n", r.name.c_str(),
+                                    r.ns_per_pixel(), r.bytes_per_second() / 1e9,
+                                    r.flops_per_second() / 1e9, k.flops / k.bytes);
+                    else
+                        std::printf("%-56s %10.3f %10.2f %10s %9s\n", r.name.c_str(),
+                                    r.ns_per_pixel(), r.bytes_per_second() / 1e9, "-", "-");
+                    std::fflush(stdout);
+                    results.push_back(r);
+                }
+            }
+        }
+        return results;
+    }
+
+    inline int main (int argc, char **argv) {
+        try {
+            parse_options(argc, argv);
+        } catch (std::exception const &e) {
+            std::cerr << argv[0] << ": " << e.what() << "\n";
+            return 2;
+        }
+        Options const &opts = options();
+        const std::regex filter (opts.filter);
+
+        std::vector<Kernel> kernels;
+        for (Kernel const &k : registry())
+            if (std::regex_search(k.name, filter))
+                kernels.push_back(k);
+        std::sort(kernels.begin(), kernels.end(),
+                  [](Kernel const &a, Kernel const &b) { return a.name < b.name; });
+        if (opts.list) {
+            for (Kernel const &k : kernels)
+                std::cout << k.name << "\n";
+            return 0;
+        }
+
+        const std::vector<Result> results = opts.roofline ? run_roofline(kernels)
+                                                          : run_kernels(kernels);
+
+        if (!opts.json.empty()) {
+            std::ofstream ofs (opts.json);
+            write_json(ofs, results);
+            if (!ofs) {
+                std::cerr << argv[0] << ": cannot write '" << opts.json << "'\n";
+                return 1;
+            }
+        }
+        return 0;
+    }
+}
+
+#endif // BENCHMARK_HH_INCLUDED_20261018
@@ -0,0 +1,165 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/cmath.hh"
+#include <string>
+#include <utility>
+
+// Every function of cmath.hh on LinearRGB<float>. Binary functions take their second and
+// third colour operands from the channels of the pixel, rotated; scalar operands are constants.
+// The input ranges keep the results finite and away from denormals, whose slow paths would
+// dominate the timings.
+
+namespace {
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+    using IntColor = RebindValueType<int, Color>;
+    using LongColor = RebindValueType<long, Color>;
+
+    Color rot  (Color c) { return Color(c.g, c.b, c.r); }
+    Color rot2 (Color c) { return Color(c.b, c.r, c.g); }
+
+    template <typename F>
+    void kernel (char const *name, double lo, double hi, F f) {
+        bench::map<Color>(std::string("cmath/") + name, lo, hi, f);
+    }
+
+    const bench::Registrar trigonometric ([] {
+        kernel("cos",  -4, 4, [](Color c) { return cos(c); });
+        kernel("sin",  -4, 4, [](Color c) { return sin(c); });
+        kernel("tan",  -1.5, 1.5, [](Color c) { return tan(c); });
+        kernel("acos", -0.99, 0.99, [](Color c) { return acos(c); });
+        kernel("asin", -0.99, 0.99, [](Color c) { return asin(c); });
+        kernel("atan", -4, 4, [](Color c) { return atan(c); });
+        kernel("atan2(c,c)", -4, 4, [](Color c) { return atan2(c, rot(c)); });
+        kernel("atan2(c,s)", -4, 4, [](Color c) { return atan2(c, 0.5f); });
+        kernel("atan2(s,c)", -4, 4, [](Color c) { return atan2(0.5f, c); });
+    });
+
+    const bench::Registrar hyperbolic ([] {
+        kernel("cosh",  -4, 4, [](Color c) { return cosh(c); });
+        kernel("sinh",  -4, 4, [](Color c) { return sinh(c); });
+        kernel("tanh",  -4, 4, [](Color c) { return tanh(c); });
+        kernel("acosh",  1, 8, [](Color c) { return acosh(c); });
+        kernel("asinh", -4, 4, [](Color c) { return asinh(c); });
+        kernel("atanh", -0.99, 0.99, [](Color c) { return atanh(c); });
+    });
+
+    const bench::Registrar exponential ([] {
+        kernel("exp",   -8, 8, [](Color c) { return exp(c); });
+        kernel("frexp", 0.001, 16, [](Color c) {
+            IntColor e;
+            const Color m = frexp(c, &e);
+            return std::make_pair(m, e);
+        });
+        kernel("ldexp", -4, 4, [](Color c) { return ldexp(c, IntColor(-3, 0, 5)); });
+        kernel("log",   0.001, 16, [](Color c) { return log(c); });
+        kernel("log10", 0.001, 16, [](Color c) { return log10(c); });
+        kernel("modf",  -8, 8, [](Color c) {
+            Color i;
+            const Color f = modf(c, &i);
+            return std::make_pair(f, i);
+        });
+        kernel("exp2",  -8, 8, [](Color c) { return exp2(c); });
+        kernel("expm1", -8, 8, [](Color c) { return expm1(c); });
+        kernel("ilogb", 0.001, 16, [](Color c) { return ilogb(c); });
+        kernel("log1p", 0.001, 16, [](Color c) { return log1p(c); });
+        kernel("log2",  0.001, 16, [](Color c) { return log2(c); });
+        kernel("scalbn(c,int)",  -4, 4, [](Color c) { return scalbn(c, 3); });
+        kernel("scalbn(c,c)",    -4, 4, [](Color c) { return scalbn(c, IntColor(-3, 0, 5)); });
+        kernel("scalbln(c,long)", -4, 4, [](Color c) { return scalbln(c, 3L); });
+        kernel("scalbln(c,c)",   -4, 4, [](Color c) { return scalbln(c, LongColor(-3, 0, 5)); });
+    });
+
+    const bench::Registrar power ([] {
+        kernel("pow(c,c)", 0.001, 4, [](Color c) { return pow(c, rot(c)); });
+        kernel("pow(c,s)", 0.001, 4, [](Color c) { return pow(c, 2.4f); });
+        kernel("pow(s,c)", 0.001, 4, [](Color c) { return pow(1.5f, c); });
+        kernel("sqrt", 0.001, 16, [](Color c) { return sqrt(c); });
+        kernel("cbrt", -16, 16, [](Color c) { return cbrt(c); });
+        kernel("hypot(c,c)", -4, 4, [](Color c) { return hypot(c, rot(c)); });
+        kernel("hypot(c,s)", -4, 4, [](Color c) { return hypot(c, 0.5f); });
+        kernel("hypot(s,c)", -4, 4, [](Color c) { return hypot(0.5f, c); });
+    });
+
+    const bench::Registrar error_and_gamma ([] {
+        kernel("erf",  -3, 3, [](Color c) { return erf(c); });
+        kernel("erfc", -3, 3, [](Color c) { return erfc(c); });
+        kernel("lgamma", 0.1, 8, [](Color c) { return lgamma(c); });
+        kernel("tgamma", 0.1, 8, [](Color c) { return tgamma(c); });
+    });
+
+    const bench::Registrar rounding ([] {
+        kernel("ceil",  -100, 100, [](Color c) { return ceil(c); });
+        kernel("floor", -100, 100, [](Color c) { return floor(c); });
+        kernel("fmod(c,c)", 0.5, 8, [](Color c) { return fmod(c, rot(c)); });
+        kernel("fmod(c,s)", 0.5, 8, [](Color c) { return fmod(c, 0.75f); });
+        kernel("fmod(s,c)", 0.5, 8, [](Color c) { return fmod(5.5f, c); });
+        kernel("trunc", -100, 100, [](Color c) { return trunc(c); });
+        kernel("round", -100, 100, [](Color c) { return round(c); });
+        kernel("lround",  -100, 100, [](Color c) { return lround(c); });
+        kernel("llround", -100, 100, [](Color c) { return llround(c); });
+        kernel("rint",  -100, 100, [](Color c) { return rint(c); });
+        kernel("lrint",  -100, 100, [](Color c) { return lrint(c); });
+        kernel("llrint", -100, 100, [](Color c) { return llrint(c); });
+        kernel("nearbyint", -100, 100, [](Color c) { return nearbyint(c); });
+        kernel("remainder(c,c)", 0.5, 8, [](Color c) { return remainder(c, rot(c)); });
+        kernel("remainder(c,s)", 0.5, 8, [](Color c) { return remainder(c, 0.75f); });
+        kernel("remainder(s,c)", 0.5, 8, [](Color c) { return remainder(5.5f, c); });
+        kernel("remquo(c,c)", 0.5, 8, [](Color c) {
+            IntColor q;
+            const Color r = remquo(c, rot(c), &q);
+            return std::make_pair(r, q);
+        });
+        kernel("remquo(c,s)", 0.5, 8, [](Color c) {
+            IntColor q;
+            const Color r = remquo(c, 0.75f, &q);
+            return std::make_pair(r, q);
+        });
+        kernel("remquo(s,c)", 0.5, 8, [](Color c) {
+            IntColor q;
+            const Color r = remquo(5.5f, c, &q);
+            return std::make_pair(r, q);
+        });
+    });
+
+    const bench::Registrar manipulation ([] {
+        kernel("copysign(c,c)", -4, 4, [](Color c) { return copysign(c, rot(c)); });
+        kernel("copysign(c,s)", -4, 4, [](Color c) { return copysign(c, -1.f); });
+        kernel("copysign(s,c)", -4, 4, [](Color c) { return copysign(2.f, c); });
+        kernel("nextafter(c,c)", -4, 4, [](Color c) { return nextafter(c, rot(c)); });
+        kernel("nextafter(c,s)", -4, 4, [](Color c) { return nextafter(c, 0.f); });
+        kernel("nextafter(s,c)", -4, 4, [](Color c) { return nextafter(0.f, c); });
+        kernel("nexttoward(c,c)", -4, 4, [](Color c) {
+            return nexttoward(c, RebindValueType<long double, Color>(0, 1, -1));
+        });
+        kernel("nexttoward(c,s)", -4, 4, [](Color c) { return nexttoward(c, 0.0L); });
+    });
+
+    const bench::Registrar min_max ([] {
+        kernel("fmin(c,c)", -4, 4, [](Color c) { return fmin(c, rot(c)); });
+        kernel("fmax(c,c)", -4, 4, [](Color c) { return fmax(c, rot(c)); });
+        kernel("fdim(c,c)", -4, 4, [](Color c) { return fdim(c, rot(c)); });
+        kernel("fmin(c,s)", -4, 4, [](Color c) { return fmin(c, 0.5f); });
+        kernel("fmax(c,s)", -4, 4, [](Color c) { return fmax(c, 0.5f); });
+        kernel("fdim(c,s)", -4, 4, [](Color c) { return fdim(c, 0.5f); });
+        kernel("fmin(s,c)", -4, 4, [](Color c) { return fmin(0.5f, c); });
+        kernel("fmax(s,c)", -4, 4, [](Color c) { return fmax(0.5f, c); });
+        kernel("fdim(s,c)", -4, 4, [](Color c) { return fdim(0.5f, c); });
+    });
+
+    const bench::Registrar other ([] {
+        kernel("fabs", -4, 4, [](Color c) { return fabs(c); });
+        kernel("abs",  -4, 4, [](Color c) { return abs(c); });
+        kernel("fma(c,c,c)", -4, 4, [](Color c) { return fma(c, rot(c), rot2(c)); });
+        kernel("fma(c,c,s)", -4, 4, [](Color c) { return fma(c, rot(c), 0.5f); });
+        kernel("fma(c,s,c)", -4, 4, [](Color c) { return fma(c, 1.5f, rot(c)); });
+        kernel("fma(c,s,s)", -4, 4, [](Color c) { return fma(c, 1.5f, 0.5f); });
+        kernel("fma(s,c,c)", -4, 4, [](Color c) { return fma(1.5f, c, rot(c)); });
+        kernel("fma(s,c,s)", -4, 4, [](Color c) { return fma(1.5f, c, 0.5f); });
+        kernel("fma(s,s,c)", -4, 4, [](Color c) { return fma(1.5f, 0.5f, c); });
+    });
+}
@@ -0,0 +1,105 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/RGB.hh"
+#include "tukan/RGBSpace.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/LinearRGBA.hh"
+#include "tukan/XYZ.hh"
+#include "tukan/luminance.hh"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    // sRGB primaries with gamma 1.0, the one gamma no predefined space uses.
+    template <typename T> struct LinearGammaRGB : RGBSpace<T, tukan::gamma::detail::simple_gamma> {
+     constexpr LinearGammaRGB() noexcept : RGBSpace<T, tukan::gamma::detail::simple_gamma>(
+      RGBSpace<T, tukan::gamma::detail::simple_gamma>::FromXYTriple(
+       0.6400,0.3300, 0.3000,0.6000, 0.1500,0.0600, whitepoint::D65, gamma::_1_0)) {} };
+
+    template <typename T>
+    std::string type_name();
+    template <> std::string type_name<float>()  { return "float"; }
+    template <> std::string type_name<double>() { return "double"; }
+
+    // FLOPs per pixel, for --roofline: a 3x3 matrix is 9 multiplications and 6 additions.
+    template <typename T>
+    void xyz_kernels () {
+        using Linear = LinearRGB<T,sRGB>;
+        bench::map<Linear>("LinearRGB->XYZ/" + type_name<T>(), 0, 1,
+                           [](Linear c) { return static_cast<XYZ<T>>(c); }, 15);
+        bench::map<XYZ<T>>("XYZ->LinearRGB/" + type_name<T>(), 0, 1,
+                           [](XYZ<T> c) { return Linear(c); }, 15);
+    }
+
+    // Luminance alone, per pixel and as the batch kernel into a plane: 3 multiplications and
+    // 2 additions.
+    template <typename T>
+    void luminance_kernels () {
+        using Linear = LinearRGB<T,sRGB>;
+        bench::map<Linear>("LinearRGB->luminance/" + type_name<T>(), 0, 1,
+                           [](Linear c) { return luminance(c); }, 5);
+        const std::string name = "LinearRGB->luminance/batch/" + type_name<T>();
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            auto in = std::make_shared<std::vector<Linear>>(
+                          bench::random_colors<Linear>(pixels, 0, 1, bench::seed_of(name)));
+            auto out = std::make_shared<std::vector<T>>(pixels);
+            return [=](std::size_t iterations) {
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    luminance(in->data(), in->data() + in->size(), out->data());
+                    bench::do_not_optimize(out->data());
+                }
+            };
+        }, sizeof(Linear) + sizeof(T), 5);
+    }
+
+    // to_linear and to_nonlinear are FLOPs per channel of the curves in gammas.hh, including
+    // the sign.
+    template <typename T, template <typename> class Space>
+    void gamma_kernels (std::string const &gamma, double to_linear, double to_nonlinear) {
+        using Linear = LinearRGB<T,Space>;
+        using Gamma = RGB<T,Space>;
+        const std::string suffix = "/gamma_" + gamma + "/" + type_name<T>();
+        bench::map<Gamma>("RGB->LinearRGB" + suffix, 0, 1,
+                          [](Gamma c) { return static_cast<Linear>(c); }, 3 * to_linear);
+        bench::map<Linear>("LinearRGB->RGB" + suffix, 0, 1,
+                           [](Linear c) { return Gamma(c); }, 3 * to_nonlinear);
+    }
+
+    // LinearRGBA has no conversions of its own; these are the passes around it: adding and
+    // dropping alpha, which only move data, and premultiplying.
+    template <typename T>
+    void alpha_kernels () {
+        using Linear = LinearRGB<T,sRGB>;
+        using RGBA = LinearRGBA<T,sRGB>;
+        bench::map<Linear>("LinearRGB->LinearRGBA/" + type_name<T>(), 0, 1,
+                           [](Linear c) { return RGBA(c.r, c.g, c.b, 1); });
+        bench::map<RGBA>("LinearRGBA->LinearRGB/" + type_name<T>(), 0, 1,
+                         [](RGBA c) { return Linear(c.r, c.g, c.b); });
+        bench::map<RGBA>("LinearRGBA/premultiply/" + type_name<T>(), 0, 1,
+                         [](RGBA c) { return RGBA(c.r*c.a, c.g*c.a, c.b*c.a, c.a); }, 3);
+    }
+
+    template <typename T>
+    void conversion_kernels () {
+        xyz_kernels<T>();
+        luminance_kernels<T>();
+        gamma_kernels<T, LinearGammaRGB>("1.0", 2, 3);
+        gamma_kernels<T, AppleRGB>("1.8", 2, 3);
+        gamma_kernels<T, AdobeRGB>("2.2", 2, 3);
+        gamma_kernels<T, sRGB>("sRGB", 4, 4);
+        gamma_kernels<T, ECIRGBv2>("L", 4, 4);
+        alpha_kernels<T>();
+    }
+
+    const bench::Registrar conversions ([] {
+        conversion_kernels<float>();
+        conversion_kernels<double>();
+    });
+}
@@ -0,0 +1,54 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGBSpace.hh"
+#include "tukan/gamut.hh"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Pro    = LinearRGB<float,ProPhotoRGB>;
+    using Linear = LinearRGB<float,sRGB>;
+
+    // 'flops' per pixel of the strategy, including the conversion (15) and the gamut test (6).
+    template <typename Strategy>
+    void gamut_kernels (Strategy s, double flops) {
+        const std::string name = std::string("gamut_map/") + Strategy::name();
+
+        // Colour by colour, against the batch version over rows of 256 (or fewer) pixels with
+        // a mask. Random ProPhotoRGB colours are mostly out of sRGB.
+        bench::map<Pro>(name + "/single", 0, 1, [s](Pro c) { return gamut_map<sRGB>(c, s); },
+                        flops);
+        bench::add(name + "/batch", [=](std::size_t pixels) -> bench::Run {
+            const std::size_t width = std::min<std::size_t>(pixels, 256),
+                              height = pixels / width;
+            auto in = std::make_shared<std::vector<Pro>>(
+                          bench::random_colors<Pro>(width * height, 0, 1, bench::seed_of(name)));
+            auto out = std::make_shared<std::vector<Linear>>(width * height);
+            auto mask = std::make_shared<std::vector<std::uint8_t>>(width * height);
+            return [=](std::size_t iterations) {
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    const std::size_t count = gamut_map(
+                        ImageView<Pro const>(in->data(), width, height),
+                        ImageView<Linear>(out->data(), width, height),
+                        ImageView<std::uint8_t>(mask->data(), width, height), s);
+                    bench::do_not_optimize(count);
+                }
+            };
+        }, sizeof(Pro) + sizeof(Linear) + 1, flops);
+    }
+
+    const bench::Registrar gamut_mapping ([] {
+        gamut_kernels(Clip(), 27);
+        gamut_kernels(LuminanceClip(), 60);
+        gamut_kernels(Compress(), 150);
+        gamut_kernels(OklchChroma(), 700);
+    });
+}
@@ -0,0 +1,72 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/algorithm/lerp.hh"
+#include "tukan/future/Spectrum.hh"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+
+    // Samples a spectrum of 81 bins over [380..780] nm at random points; 'query' maps the
+    // point f in [0..1) to the interpolator's argument.
+    template <typename Query>
+    void interpolator_kernel (std::string const &name, Query query) {
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            using future::LinearInterpolator;
+            using future::Spectrum;
+            using future::SpectrumSample;
+            bench::Random random (bench::seed_of(name));
+            std::vector<float> bins (81);
+            for (float &b : bins)
+                b = float(random(0, 1));
+            auto spectrum = std::make_shared<Spectrum>(380_nm, 780_nm, bins);
+            auto in = std::make_shared<std::vector<float>>(pixels);
+            for (float &f : *in)
+                f = float(random(0, 1));
+            auto out = std::make_shared<std::vector<SpectrumSample>>(pixels);
+            return [=](std::size_t iterations) {
+                const LinearInterpolator interpolate (*spectrum);
+                float const *src = in->data();
+                SpectrumSample *dst = out->data();
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    for (std::size_t i=0; i!=pixels; ++i)
+                        dst[i] = interpolate(query(src[i]));
+                    bench::do_not_optimize(dst);
+                }
+            };
+        });
+    }
+
+    const bench::Registrar interpolation ([] {
+        // Factors outside [0..1] half of the time, to exercise the saturation.
+        bench::map<Color>("lerp_sat/scalar", -0.5, 1.5, [](Color c) {
+            return lerp_sat(c.r, c.g, c.b);
+        });
+        bench::map<Color>("lerp_sat/color,color,scalar", -0.5, 1.5, [](Color c) {
+            return lerp_sat(c, Color(0.25f, 0.5f, 0.75f), c.g);
+        });
+        bench::map<Color>("lerp_sat/scalar,scalar,color", -0.5, 1.5, [](Color c) {
+            return lerp_sat(0.f, 2.f, c);
+        });
+        bench::map<Color>("lerp_sat/color,color,color", -0.5, 1.5, [](Color c) {
+            return lerp_sat(Color(0), Color(c.b, c.r, c.g), c);
+        });
+
+        interpolator_kernel("LinearInterpolator/float", [](float f) { return f; });
+        interpolator_kernel("LinearInterpolator/Nanometer", [](float f) {
+            return Nanometer(380 + 400 * f);
+        });
+        interpolator_kernel("LinearInterpolator/Interval", [](float f) {
+            return interval(f * 0.95f, f * 0.95f + 0.05f);
+        });
+    });
+}
@@ -0,0 +1,10 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+
+int main (int argc, char **argv)
+{
+    return bench::main(argc, argv);
+}
@@ -0,0 +1,53 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/statistics.hh"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    // The pixels as one image of rows of 256 (or fewer) pixels, over [0..4) like HDR frames.
+    template <typename Color, typename F>
+    void image_kernel (std::string const &name, double bytes_per_pixel, double flops, F f) {
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            const std::size_t width = std::min<std::size_t>(pixels, 256),
+                              height = pixels / width;
+            auto in = std::make_shared<std::vector<Color>>(
+                          bench::random_colors<Color>(width * height, 0, 4, bench::seed_of(name)));
+            return [=](std::size_t iterations) {
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    const auto result = f(ImageView<Color const>(in->data(), width, height));
+                    bench::do_not_optimize(result);
+                }
+            };
+        }, bytes_per_pixel, flops);
+    }
+
+    template <typename T>
+    void statistics_kernels (std::string const &type) {
+        using Color = LinearRGB<T,sRGB>;
+        // Luminance is 5 FLOPs, the sums 5 additions, and the log one more.
+        image_kernel<Color>("statistics/" + type, sizeof(Color), 11, [](ImageView<Color const> img) {
+            return statistics(img).log_average_luminance;
+        });
+        image_kernel<Color>("histograms/" + type, sizeof(Color), 0, [](ImageView<Color const> img) {
+            static const Histogram channels (256, 0, 4),
+                                   luminance (256, std::ldexp(1, -16), std::ldexp(1, 16),
+                                              Histogram::Scale::log2);
+            return histograms(img, channels, luminance).luminance.percentile(0.5);
+        });
+    }
+
+    const bench::Registrar reductions ([] {
+        statistics_kernels<float>("float");
+        statistics_kernels<double>("double");
+    });
+}
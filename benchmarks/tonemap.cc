@@ -0,0 +1,72 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "benchmark.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGB.hh"
+#include "tukan/dither.hh"
+#include "tukan/tonemap.hh"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Linear = LinearRGB<float,sRGB>;
+    using Code8  = RGB<unorm8,sRGB>;
+
+    // An HDR frame of rows of 256 (or fewer) pixels over [0..16), and an output of Out pixels;
+    // f(in, out, temporary) runs one pass, 'temporary' is a LinearRGB image of the same size.
+    template <typename Out, typename F>
+    void frame_kernel (std::string const &name, double flops, F f) {
+        bench::add(name, [=](std::size_t pixels) -> bench::Run {
+            const std::size_t width = std::min<std::size_t>(pixels, 256),
+                              height = pixels / width;
+            auto in = std::make_shared<std::vector<Linear>>(
+                          bench::random_colors<Linear>(width * height, 0, 16, bench::seed_of(name)));
+            auto out = std::make_shared<std::vector<Out>>(width * height);
+            auto temporary = std::make_shared<std::vector<Linear>>(width * height);
+            return [=](std::size_t iterations) {
+                for (std::size_t it=0; it!=iterations; ++it) {
+                    bench::clobber_memory();
+                    f(ImageView<Linear const>(in->data(), width, height),
+                      ImageView<Out>(out->data(), width, height),
+                      ImageView<Linear>(temporary->data(), width, height));
+                    bench::do_not_optimize(out->data());
+                }
+            };
+        }, sizeof(Linear) + sizeof(Out), flops);
+    }
+
+    // 'flops' per pixel of the operator, including the exposure.
+    template <typename Operator>
+    void tonemap_kernels (Operator op, double flops) {
+        const std::string name = Operator::name();
+        frame_kernel<Linear>("tonemap/" + name + "/float", flops,
+            [op](ImageView<Linear const> in, ImageView<Linear> out, ImageView<Linear>) {
+                tonemap(in, out, op, 0.5);
+            });
+
+        // Fused, against tone mapping into a temporary image and encoding that.
+        for (Dither method : {Dither::none, Dither::blue_noise}) {
+            const std::string suffix = method == Dither::none ? "/none" : "/blue_noise";
+            frame_kernel<Code8>("tonemap_encode/" + name + suffix, flops,
+                [op, method](ImageView<Linear const> in, ImageView<Code8> out, ImageView<Linear>) {
+                    tonemap_encode(in, out, op, 0.5, method);
+                });
+        }
+        frame_kernel<Code8>("tonemap+encode/" + name + "/none", flops,
+            [op](ImageView<Linear const> in, ImageView<Code8> out, ImageView<Linear> temporary) {
+                tonemap(in, temporary, op, 0.5);
+                encode(ImageView<Linear const>(temporary), out, Dither::none);
+            });
+    }
+
+    const bench::Registrar tonemapping ([] {
+        tonemap_kernels(Reinhard(), 14);
+        tonemap_kernels(ACESFilmic(), 27);
+        tonemap_kernels(Hable(), 36);
+        tonemap_kernels(AgX(), 90);
+    });
+}
@@ -0,0 +1,395 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef GAMUTBOUNDARY_HH_INCLUDED_20261018
+#define GAMUTBOUNDARY_HH_INCLUDED_20261018
+
+#include "detail/Matrix33.hh"
+#include "detail/exp.hh"
+#include "detail/planes.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// GamutBoundary:
+//
+//    The boundary of an RGB space's gamut in CIE L*C*h, as a table of the largest chroma per
+//    hue slice and lightness, for gamut checks on colours given in Lab or LCh (e.g. measured
+//    colours of a catalogue): max_chroma() interpolates the table bilinearly, so that neither
+//    check needs sin, cos or a conversion into the space. The table is computed from the
+//    space's matrices, by bisection along the chroma of each sample.
+//
+//    The boundary has a sharp bend at the cusp, the lightness of the largest chroma of a hue,
+//    which is near white for yellow and near black for blue. Evenly spaced lightnesses would
+//    cut it off by tens of units of chroma, so each hue slice is sampled separately below and
+//    above its cusp, with half of the samples each and the cusp itself as the middle one.
+//
+//    Lab is relative to the white of the space, i.e. L=100, C=0 is RGB (1,1,1) of the space;
+//    there is no chromatic adaptation. L is in [0..100], h in degrees (any value, it wraps
+//    around). Outside [0..100] of L, max_chroma() is 0 and nothing is in gamut.
+//
+//    With the default of 360 hues by 101 lightnesses, max_chroma() is within 0.15 units of
+//    chroma of the exact boundary for 99% of lightnesses and hues, and within 0.6 (sRGB) to 1.5
+//    (ProPhotoRGB) for 99.9%. The rest lies next to the cusps of the primaries and secondaries,
+//    where a ray of constant lightness and hue can leave the cube and enter it again. in_gamut()
+//    is exact for colours further away from the boundary than that.
+//
+//    A single check costs about half of converting LCh into the space (which needs sin and
+//    cos), but not less than converting Lab (which needs only cubes): for colours in Lab, RGB
+//    or XYZ, the range check after the conversion is as fast and exact. The batch version over
+//    planes of L, C and h vectorizes (double from SSE4.1 on) and is several times faster than
+//    either.
+//
+//    gamut_boundary() computes the table at the default resolution on the first call per
+//    value type and space, and caches it.
+//
+//
+// Definitions:
+//
+//    template <typename T, template <typename> class RGBSpace>
+//    class GamutBoundary {
+//        // Throws std::logic_error for fewer than 3 hues or 3 lightnesses.
+//        explicit GamutBoundary (unsigned hues = 360, unsigned lightnesses = 101);
+//
+//        unsigned hues(), lightnesses()
+//        // Of hue slice i, at hue 360*i/hues: the lightness of its cusp, and the lightness
+//        // and chroma of its sample j. Throw std::out_of_range.
+//        T cusp      (unsigned i)
+//        T lightness (unsigned i, unsigned j)
+//        T at        (unsigned i, unsigned j)
+//
+//        T    max_chroma (T L, T h)
+//        bool in_gamut   (T L, T C, T h)      // C <= max_chroma(L, h)
+//        // The same over n colours in planes, with 1 (inside) or 0 per colour in 'mask'
+//        // (if not null); returns the number of colours inside. Vectorized.
+//        size_t in_gamut (T const *L, T const *C, T const *h, ptrdiff_t n,
+//                         uint8_t *mask = nullptr)
+//    };
+//
+//    GamutBoundary<T,RGBSpace> const& gamut_boundary <T, RGBSpace> ()
+//    T    max_chroma <RGBSpace> (T L, T h)
+//    bool in_gamut   <RGBSpace> (T L, T C, T h)
+//
+//
+// Examples:
+//
+//    // From Lab: C = hypot(a, b), h = atan2(b, a) in degrees.
+//    if (!in_gamut<sRGB>(L, C, h))
+//        flag_as_not_displayable();
+//
+//    const float limit = gamut_boundary<float,AdobeRGB>().max_chroma(50, 140);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    template <typename T, template <typename> class RGBSpace>
+    class GamutBoundary {
+        static_assert(std::is_floating_point<T>::value,
+                      "GamutBoundary<T,RGBSpace>: T must be floating point");
+    public:
+        using value_type = T;
+
+        explicit GamutBoundary (unsigned hues = 360, unsigned lightnesses = 101);
+
+        unsigned hues () const noexcept { return hues_; }
+        unsigned lightnesses () const noexcept { return lightnesses_; }
+        T cusp (unsigned i) const ;
+        T lightness (unsigned i, unsigned j) const ;
+        T at (unsigned i, unsigned j) const ;
+
+        T    max_chroma (T L, T h) const noexcept ;
+        bool in_gamut (T L, T C, T h) const noexcept ;
+        std::size_t in_gamut (T const *L, T const *C, T const *h, std::ptrdiff_t n,
+                              std::uint8_t *mask = nullptr) const noexcept ;
+
+    private:
+        T position (T L, T cusp) const noexcept ;
+        T lookup (T L, T turn) const noexcept ;
+
+        std::vector<T> chroma_;   // hue slices of 'lightnesses_' samples each
+        std::vector<T> cusp_;     // per hue slice, the lightness of its largest chroma
+        unsigned hues_, lightnesses_, knee_;
+    };
+
+
+    template <typename T, template <typename> class RGBSpace>
+    GamutBoundary<T,RGBSpace> const& gamut_boundary ();
+
+    template <template <typename> class RGBSpace, typename T>
+    T max_chroma (T L, T h);
+
+    template <template <typename> class RGBSpace, typename T>
+    bool in_gamut (T L, T C, T h);
+
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+        // Whether CIE Lab (relative to the space's white) is within the RGB cube.
+        struct lab_gamut_test {
+            Matrix33<double> xyz_to_rgb;
+            double white_X, white_Y, white_Z;
+
+            template <template <typename> class RGBSpace>
+            static lab_gamut_test of () {
+                const RGBSpace<double> space;
+                Matrix33<double> const &m = space.rgb_to_xyz;
+                return {space.xyz_to_rgb, m._11 + m._12 + m._13, m._21 + m._22 + m._23,
+                        m._31 + m._32 + m._33};
+            }
+
+            static double f_inverse (double t) noexcept {
+                const double delta = 6.0 / 29.0;
+                return t > delta ? t*t*t : 3*delta*delta * (t - 4.0/29.0);
+            }
+
+            bool operator() (double L, double a, double b) const noexcept {
+                const double fy = (L + 16) / 116,
+                             X = white_X * f_inverse(fy + a / 500),
+                             Y = white_Y * f_inverse(fy),
+                             Z = white_Z * f_inverse(fy - b / 200);
+                Matrix33<double> const &m = xyz_to_rgb;
+                const double e = 1e-9;
+                const double rgb[3] = {m._11*X + m._12*Y + m._13*Z,
+                                       m._21*X + m._22*Y + m._23*Z,
+                                       m._31*X + m._32*Y + m._33*Z};
+                for (double v : rgb)
+                    if (!(v >= -e && v <= 1 + e))
+                        return false;
+                return true;
+            }
+
+            // The largest chroma at L and h (in degrees) that is in gamut.
+            double max_chroma (double L, double h) const noexcept {
+                const double ca = std::cos(h * 3.14159265358979323846 / 180),
+                             sa = std::sin(h * 3.14159265358979323846 / 180);
+                if (!(*this)(L, 0, 0))
+                    return 0;
+                double lo = 0, hi = 64;
+                while (hi < 1024 && (*this)(L, hi*ca, hi*sa)) {
+                    lo = hi;
+                    hi *= 2;
+                }
+                for (int i=0; i!=48; ++i) {
+                    const double mid = (lo + hi) / 2;
+                    if ((*this)(L, mid*ca, mid*sa))
+                        lo = mid;
+                    else
+                        hi = mid;
+                }
+                return lo;
+            }
+
+            // The lightness with the largest max_chroma() at h: a coarse search, refined by
+            // golden section search (the chroma rises up to the cusp and falls after it).
+            double cusp (double h) const noexcept {
+                double best = 0, best_chroma = -1;
+                for (int L=0; L<=100; ++L) {
+                    const double c = max_chroma(L, h);
+                    if (c > best_chroma) {
+                        best = L;
+                        best_chroma = c;
+                    }
+                }
+                const double g = 0.6180339887498949;
+                double lo = std::max(best - 1, 0.0), hi = std::min(best + 1, 100.0);
+                for (int i=0; i!=48; ++i) {
+                    const double a = hi - g * (hi - lo), b = lo + g * (hi - lo);
+                    if (max_chroma(a, h) < max_chroma(b, h))
+                        lo = a;
+                    else
+                        hi = b;
+                }
+                return (lo + hi) / 2;
+            }
+        };
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline GamutBoundary<T,RGBSpace>::GamutBoundary (unsigned hues, unsigned lightnesses)
+        : hues_(hues), lightnesses_(lightnesses), knee_((lightnesses - 1) / 2)
+    {
+        if (hues < 3 || lightnesses < 3)
+            throw std::logic_error("GamutBoundary: at least 3 hues and 3 lightnesses are needed");
+        chroma_.resize(std::size_t(hues) * lightnesses);
+        cusp_.resize(hues);
+
+        const detail::lab_gamut_test test = detail::lab_gamut_test::of<RGBSpace>();
+        const long n = static_cast<long>(hues);
+        #pragma omp parallel for schedule(dynamic)
+        for (long i=0; i<n; ++i) {
+            const double h = 360.0 * i / hues, cusp = test.cusp(h);
+            cusp_[i] = T(cusp);
+            for (unsigned j=0; j!=lightnesses; ++j) {
+                const double L = j <= knee_
+                               ? cusp * j / knee_
+                               : cusp + (100 - cusp) * (j - knee_) / (lightnesses - 1 - knee_);
+                chroma_[std::size_t(i)*lightnesses + j] = T(test.max_chroma(L, h));
+            }
+        }
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::cusp (unsigned i) const
+    {
+        if (i >= hues_)
+            throw std::out_of_range("GamutBoundary::cusp: hue out of range");
+        return cusp_[i];
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::lightness (unsigned i, unsigned j) const
+    {
+        if (i >= hues_ || j >= lightnesses_)
+            throw std::out_of_range("GamutBoundary::lightness: sample out of range");
+        const double cusp = cusp_[i];
+        return T(j <= knee_ ? cusp * j / knee_
+                            : cusp + (100 - cusp) * (j - knee_) / (lightnesses_ - 1 - knee_));
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::at (unsigned i, unsigned j) const
+    {
+        if (i >= hues_ || j >= lightnesses_)
+            throw std::out_of_range("GamutBoundary::at: sample out of range");
+        return chroma_[std::size_t(i)*lightnesses_ + j];
+    }
+
+
+    // Sample position y (in [0..lightnesses-1]) of lightness L relative to 'cusp'. Branch-free:
+    // for random queries, a branch on the side of the cusp is mispredicted half of the time.
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::position (T L, T cusp) const noexcept
+    {
+        using detail::select;
+        const T tiny = T(1e-6),
+                below = L / select(cusp > tiny, cusp, tiny) * knee_,
+                above = knee_ + (L - cusp) / select(cusp < 100 - tiny, 100 - cusp, tiny)
+                                * (lightnesses_ - 1 - knee_);
+        return select(L <= cusp, below, above);
+    }
+
+
+    // max_chroma() for L in [0..100] and the hue as a fraction of a turn in [0..1). Branch-free,
+    // so that the batch version vectorizes; the table reads become gathers.
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::lookup (T L, T turn) const noexcept
+    {
+        using detail::select;
+
+        // Hue slice i and the next one around the circle. A tiny negative turn wraps to 1 by
+        // rounding, which is 0 again.
+        T x = turn * hues_;
+        x = select(x >= hues_, T(0), x);
+        const std::uint32_t i = static_cast<std::uint32_t>(static_cast<int>(x));
+        const std::uint32_t i1 = select(i + 1 == hues_, std::uint32_t(0), i + 1);
+        const T fh = x - T(i);
+
+        // Both slices at the same position relative to the cusp interpolated between them,
+        // so that the bend of the boundary moves along with the cusp.
+        const T y = position(L, cusp_[i] + (cusp_[i1] - cusp_[i]) * fh);
+        std::uint32_t j = static_cast<std::uint32_t>(static_cast<int>(y));
+        j = select(j >= lightnesses_ - 1, std::uint32_t(lightnesses_ - 2), j);
+        const T fl = y - T(j);
+
+        T const *c = chroma_.data();
+        const std::uint32_t a = i*lightnesses_ + j, b = i1*lightnesses_ + j;
+        const T lo = c[a] + (c[b] - c[a]) * fh,
+                hi = c[a+1] + (c[b+1] - c[a+1]) * fh;
+        return lo + (hi - lo) * fl;
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline T GamutBoundary<T,RGBSpace>::max_chroma (T L, T h) const noexcept
+    {
+        if (!(L >= 0 && L <= 100) || !std::isfinite(h))
+            return 0;
+        const T turn = h * T(1 / 360.0);
+        return lookup(L, turn - std::floor(turn));
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline bool GamutBoundary<T,RGBSpace>::in_gamut (T L, T C, T h) const noexcept
+    {
+        return L >= 0 && L <= 100 && C >= 0 && C <= max_chroma(L, h);
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline std::size_t GamutBoundary<T,RGBSpace>::in_gamut (T const *L, T const *C, T const *h,
+                                                            std::ptrdiff_t n,
+                                                            std::uint8_t *mask) const noexcept
+    {
+        using detail::select;
+        std::size_t count = 0;
+        for (std::ptrdiff_t first=0; first<n; first+=detail::plane_chunk) {
+            const std::ptrdiff_t m = std::min<std::ptrdiff_t>(n - first, detail::plane_chunk);
+            std::uint8_t inside[detail::plane_chunk];
+            #pragma omp simd
+            for (std::ptrdiff_t k=0; k<m; ++k) {
+                const T l = L[first+k], c = C[first+k], hue = h[first+k];
+                // Invalid queries look up black at hue 0 and are thrown away.
+                const bool valid = (l >= 0) & (l <= 100) & (c >= 0) & (hue - hue == 0);
+                // Hue in turns, wrapped without std::floor, which does not vectorize; the turn
+                // is limited to what fits the integer conversion (beyond, T has no fraction
+                // left anyway).
+                T turn = select(valid, hue, T(0)) * T(1 / 360.0);
+                turn = select(turn < T(-1e9), T(-1e9), select(turn > T(1e9), T(1e9), turn));
+                const T whole = T(static_cast<int>(turn));
+                turn -= select(whole > turn, whole - 1, whole);
+                const T limit = lookup(select(valid, l, T(0)), turn);
+                inside[k] = static_cast<std::uint8_t>(static_cast<int>(
+                                select(valid & (c <= limit), T(1), T(0))));
+            }
+            for (std::ptrdiff_t k=0; k<m; ++k)
+                count += inside[k];
+            if (mask)
+                std::copy(inside, inside + m, mask + first);
+        }
+        return count;
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline GamutBoundary<T,RGBSpace> const& gamut_boundary ()
+    {
+        static const GamutBoundary<T,RGBSpace> boundary;
+        return boundary;
+    }
+
+
+    template <template <typename> class RGBSpace, typename T>
+    inline T max_chroma (T L, T h)
+    {
+        return gamut_boundary<T,RGBSpace>().max_chroma(L, h);
+    }
+
+
+    template <template <typename> class RGBSpace, typename T>
+    inline bool in_gamut (T L, T C, T h)
+    {
+        return gamut_boundary<T,RGBSpace>().in_gamut(L, C, h);
+    }
+
+}
+
+#endif // GAMUTBOUNDARY_HH_INCLUDED_20261018
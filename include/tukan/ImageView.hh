@@ -0,0 +1,103 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef IMAGEVIEW_HH_INCLUDED_20261018
+#define IMAGEVIEW_HH_INCLUDED_20261018
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+namespace tukan {
+
+    //---------------------------------------------------------------------------------------------
+    // ImageView
+    // ---------
+    //
+    // About
+    // -----
+    // A non-owning view of a two dimensional array of pixels, as used by the batch operations.
+    // Rows are 'stride' elements apart (stride >= width), so that sub-images and padded rows can
+    // be viewed without copying. An ImageView<T> converts to ImageView<T const>.
+    //
+    // Batch operations are written as kernels over one row, i.e. over [first, last) with an
+    // output iterator, and are lifted to whole images by 'transform_rows', which processes the
+    // rows in parallel.
+    //---------------------------------------------------------------------------------------------
+
+    // -- structure -------------------------------------------------------------------------------
+    template <typename T>
+    struct ImageView {
+
+        // Data.
+        T *data = nullptr;
+        std::size_t width = 0, height = 0, stride = 0;
+
+
+        // Construction.
+        constexpr ImageView() noexcept = default;
+        constexpr ImageView(T *data, std::size_t width, std::size_t height) noexcept
+            : data(data), width(width), height(height), stride(width) {}
+        constexpr ImageView(T *data, std::size_t width, std::size_t height, std::size_t stride) noexcept
+            : data(data), width(width), height(height), stride(stride) {}
+
+        template <typename U, typename std::enable_if<std::is_convertible<U*, T*>::value, int>::type = 0>
+        constexpr ImageView(ImageView<U> const &v) noexcept
+            : data(v.data), width(v.width), height(v.height), stride(v.stride) {}
+
+
+        // Access.
+        T* row (std::size_t y) const noexcept { return data + y*stride; }
+        T& operator() (std::size_t x, std::size_t y) const noexcept { return data[y*stride + x]; }
+
+        constexpr std::size_t size() const noexcept { return width*height; }
+        constexpr bool empty() const noexcept { return 0 == width*height; }
+
+
+        // Meta.
+        using value_type = T;
+    };
+
+
+    template <typename T>
+    constexpr ImageView<T> image_view (T *data, std::size_t width, std::size_t height) noexcept {
+        return {data, width, height};
+    }
+
+    template <typename T, typename U>
+    constexpr bool same_extent (ImageView<T> const &a, ImageView<U> const &b) noexcept {
+        return a.width == b.width && a.height == b.height;
+    }
+
+
+    // -- transform_rows --------------------------------------------------------------------------
+    //
+    //    Calls 'kernel(in.row(y), in.row(y)+width, out.row(y))' for each row, in parallel.
+    //    Throws std::logic_error if the views differ in extent.
+    //
+    template <typename In, typename Out, typename Kernel>
+    void transform_rows (ImageView<In> in, ImageView<Out> out, Kernel kernel);
+
+}
+
+
+
+namespace tukan {
+
+    template <typename In, typename Out, typename Kernel>
+    inline void transform_rows (ImageView<In> in, ImageView<Out> out, Kernel kernel)
+    {
+        if (!same_extent(in, out))
+            throw std::logic_error("transform_rows: input and output differ in extent");
+
+        const long height = static_cast<long>(in.height);
+        #pragma omp parallel for schedule(static)
+        for (long y=0; y<height; ++y) {
+            In *first = in.row(y);
+            kernel(first, first + in.width, out.row(y));
+        }
+    }
+
+}
+
+#endif // IMAGEVIEW_HH_INCLUDED_20261018
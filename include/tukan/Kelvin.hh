@@ -0,0 +1,82 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef KELVIN_HH_INCLUDED_20261018
+#define KELVIN_HH_INCLUDED_20261018
+
+#include <limits>
+#include "algorithm/rel_equal.hh"
+
+namespace tukan {
+    //----------------------------------------------------------------------------------------------
+    // Kelvin
+    //
+    //    An absolute temperature. Like Nanometer, it only converts explicitly from and to float.
+    //----------------------------------------------------------------------------------------------
+    struct Kelvin {
+        constexpr explicit Kelvin (float k=0) noexcept : k_(k) {}
+        constexpr explicit operator float() noexcept { return k_; }
+
+        Kelvin& operator+= (Kelvin rhs) noexcept { k_+=rhs.k_; return *this; }
+        Kelvin& operator-= (Kelvin rhs) noexcept { k_-=rhs.k_; return *this; }
+
+        Kelvin& operator*= (float rhs) noexcept { k_*=rhs; return *this; }
+        Kelvin& operator/= (float rhs) noexcept { k_/=rhs; return *this; }
+    private:
+        float k_;
+    };
+
+    // relation
+    constexpr inline bool operator== (Kelvin lhs, Kelvin rhs) noexcept {
+        return static_cast<float>(lhs) == static_cast<float>(rhs);
+    }
+    constexpr inline bool operator!= (Kelvin lhs, Kelvin rhs) noexcept {
+        return !(lhs == rhs);
+    }
+    constexpr bool rel_equal (Kelvin lhs, Kelvin rhs,
+                              float max_rel_diff=std::numeric_limits<float>::epsilon()
+                             ) noexcept
+    {
+        return rel_equal (static_cast<float>(lhs), static_cast<float>(rhs), max_rel_diff);
+    }
+
+    constexpr inline bool operator> (Kelvin lhs, Kelvin rhs) noexcept {
+        return static_cast<float>(lhs) > static_cast<float>(rhs);
+    }
+    constexpr inline bool operator< (Kelvin lhs, Kelvin rhs) noexcept {
+        return static_cast<float>(lhs) < static_cast<float>(rhs);
+    }
+    constexpr inline bool operator>= (Kelvin lhs, Kelvin rhs) noexcept {
+        return static_cast<float>(lhs) >= static_cast<float>(rhs);
+    }
+    constexpr inline bool operator<= (Kelvin lhs, Kelvin rhs) noexcept {
+        return static_cast<float>(lhs) <= static_cast<float>(rhs);
+    }
+
+    // arithmetic
+    constexpr inline Kelvin operator+ (Kelvin lhs, Kelvin rhs) noexcept {
+        return Kelvin(static_cast<float>(lhs) + static_cast<float>(rhs));
+    }
+    constexpr inline Kelvin operator- (Kelvin lhs, Kelvin rhs) noexcept {
+        return Kelvin(static_cast<float>(lhs) - static_cast<float>(rhs));
+    }
+    constexpr inline Kelvin operator* (float lhs, Kelvin rhs) noexcept {
+        return Kelvin(lhs * static_cast<float>(rhs));
+    }
+    constexpr inline Kelvin operator* (Kelvin lhs, float rhs) noexcept {
+        return Kelvin(static_cast<float>(lhs) * rhs);
+    }
+    constexpr inline Kelvin operator/ (Kelvin lhs, float rhs) noexcept {
+        return Kelvin(static_cast<float>(lhs) / rhs);
+    }
+
+    // literals ------------------------------------------------------------------------------------
+    inline constexpr Kelvin operator"" _kelvin (long double k) noexcept {
+        return Kelvin(k);
+    }
+    inline constexpr Kelvin operator"" _kelvin (unsigned long long k) noexcept {
+        return Kelvin(k);
+    }
+}
+
+#endif // KELVIN_HH_INCLUDED_20261018
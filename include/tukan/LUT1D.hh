@@ -0,0 +1,441 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef LUT1D_HH_INCLUDED_20261018
+#define LUT1D_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "algorithm/lerp.hh"
+#include "profile.hh"
+#include "detail/lut.hh"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LUT1D:
+//
+//    One curve per channel, each sampled at N points spread evenly over the channel's domain
+//    and linearly interpolated in between; as used for transfer functions and as shapers in
+//    front of a LUT3D. Inputs outside the domain are clamped to it, NaN goes to domain_min.
+//    With Curves::shared, all channels use the curve of channel 0, which takes a third of the
+//    cache.
+//
+//    As for LUT3D, apply() on a single colour is the reference, written with lerp(); the
+//    batch versions are branch-free and vectorize with gathers, the ImageView version is also
+//    parallel over rows.
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Log2LUT1D:
+//
+//    A LUT1D over float for HDR data, whose samples are spaced evenly in log2 instead: 2^Bits
+//    samples per octave from 2^MinExp to 2^MaxExp, plus one at 0. Evenly spaced samples would
+//    waste most of the table on the highlights and leave too few for the shadows.
+//
+//    The sample index is read from the bits of the float, the exponent and the top Bits bits
+//    of the mantissa, without calling log2; the remaining mantissa bits are the fraction for
+//    the linear interpolation, which thus is linear in the input. The spacing relative to the
+//    input is at most 2^-Bits everywhere, so the interpolation error of a smooth curve is
+//    bounded relative to the curve's scale over the full range, not only near the top.
+//    Below 2^MinExp, the curve is interpolated linearly between the samples at 0 and 2^MinExp.
+//    Inputs are clamped to [0..2^MaxExp], NaN goes to 0.
+//
+//    position(i) is the input at which sample i lies, for filling the curves.
+//
+//
+// Definitions:
+//
+//    enum class Curves { per_channel, shared };
+//
+//    LUT1D<T,N> (Curves = per_channel)                      identity
+//    Log2LUT1D<MinExp,MaxExp,Bits> (Curves = per_channel)   identity
+//
+//    unsigned size()                             the number of samples per curve
+//    float position (unsigned i)                 Log2LUT1D only
+//    std::array<T,3> domain_min, domain_max      LUT1D only; default to 0 and 1
+//    T* curve (unsigned channel)                 the samples of a channel
+//    T* at    (unsigned channel)                 as curve(), throws std::out_of_range
+//    bool shared()
+//
+//    // For both kinds of LUT:
+//    Color apply (LUT const &lut, Color c)
+//    void  apply (LUT const &lut, In const *first, In const *last, Out *out)
+//    // Throws std::logic_error if the views differ in extent.
+//    void  apply (LUT const &lut, ImageView<In> in, ImageView<Out> out)
+//
+//
+// Examples:
+//
+//    LUT1D<float,4096> decode (Curves::shared);
+//    for (unsigned i=0; i!=4096; ++i)
+//        decode.curve(0)[i] = std::pow(i / 4095.f, 2.4f);
+//
+//    // 32 samples per stop over 30 stops.
+//    Log2LUT1D<-14, 16, 5> pq (Curves::shared);
+//    for (unsigned i=0; i!=pq.size(); ++i)
+//        pq.curve(0)[i] = pq_encode(pq.position(i));
+//    apply(pq, hdr.data(), hdr.data()+hdr.size(), encoded.data());
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    enum class Curves {
+        per_channel,
+        shared
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // LUT1D
+    //----------------------------------------------------------------------------------------------
+    template <typename T, unsigned N>
+    class LUT1D {
+        static_assert(std::is_floating_point<T>::value, "LUT1D<T,N>: T must be floating point");
+        static_assert(N >= 2, "LUT1D<T,N>: at least two samples are needed");
+    public:
+        using value_type = T;
+        static constexpr unsigned size() noexcept { return N; }
+
+        explicit LUT1D (Curves curves = Curves::per_channel);
+
+        T*       curve (unsigned channel)       noexcept ;
+        T const* curve (unsigned channel) const noexcept ;
+        T*       at    (unsigned channel)       ;
+        T const* at    (unsigned channel) const ;
+
+        bool shared() const noexcept { return stride_ == 0; }
+        // Distance from one channel's curve to the next, 0 if shared.
+        std::size_t stride() const noexcept { return stride_; }
+
+        std::array<T,3> domain_min {{0, 0, 0}}, domain_max {{1, 1, 1}};
+
+    private:
+        std::vector<T> samples_;
+        std::size_t stride_;
+    };
+
+
+    template <typename T, unsigned N, typename Color>
+    Color apply (LUT1D<T,N> const &lut, Color c) noexcept ;
+
+    template <typename T, unsigned N, typename In, typename Out>
+    void apply (LUT1D<T,N> const &lut, In const *first, In const *last, Out *out) noexcept ;
+
+    template <typename T, unsigned N, typename In, typename Out>
+    void apply (LUT1D<T,N> const &lut, ImageView<In> in, ImageView<Out> out);
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // Log2LUT1D
+    //----------------------------------------------------------------------------------------------
+    template <int MinExp, int MaxExp, unsigned Bits = 5>
+    class Log2LUT1D {
+        static_assert(MinExp < MaxExp, "Log2LUT1D: MinExp must be less than MaxExp");
+        static_assert(MinExp >= -126 && MaxExp <= 127, "Log2LUT1D: exponents must be normal");
+        static_assert(Bits <= 16, "Log2LUT1D: at most 2^16 samples per octave");
+    public:
+        using value_type = float;
+        static constexpr unsigned size() noexcept { return 2 + (unsigned(MaxExp - MinExp) << Bits); }
+        static float position (unsigned i) noexcept ;
+
+        explicit Log2LUT1D (Curves curves = Curves::per_channel);
+
+        float*       curve (unsigned channel)       noexcept ;
+        float const* curve (unsigned channel) const noexcept ;
+        float*       at    (unsigned channel)       ;
+        float const* at    (unsigned channel) const ;
+
+        bool shared() const noexcept { return stride_ == 0; }
+        std::size_t stride() const noexcept { return stride_; }
+
+    private:
+        std::vector<float> samples_;
+        std::size_t stride_;
+    };
+
+
+    template <int MinExp, int MaxExp, unsigned Bits, typename Color>
+    Color apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, Color c) noexcept ;
+
+    template <int MinExp, int MaxExp, unsigned Bits, typename In, typename Out>
+    void apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, In const *first, In const *last,
+                Out *out) noexcept ;
+
+    template <int MinExp, int MaxExp, unsigned Bits, typename In, typename Out>
+    void apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, ImageView<In> in, ImageView<Out> out);
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    // LUT1D
+    template <typename T, unsigned N>
+    inline LUT1D<T,N>::LUT1D (Curves curves)
+        : samples_(curves == Curves::shared ? N : 3 * N),
+          stride_(curves == Curves::shared ? 0 : N)
+    {
+        for (unsigned c=0; c!=3; ++c)
+            for (unsigned i=0; i!=N; ++i)
+                curve(c)[i] = T(i) / (N - 1);
+    }
+
+
+    template <typename T, unsigned N>
+    inline T* LUT1D<T,N>::curve (unsigned channel) noexcept
+    {
+        return samples_.data() + channel * stride_;
+    }
+
+
+    template <typename T, unsigned N>
+    inline T const* LUT1D<T,N>::curve (unsigned channel) const noexcept
+    {
+        return samples_.data() + channel * stride_;
+    }
+
+
+    template <typename T, unsigned N>
+    inline T* LUT1D<T,N>::at (unsigned channel)
+    {
+        if (channel >= 3)
+            throw std::out_of_range("LUT1D::at: channel out of range");
+        return curve(channel);
+    }
+
+
+    template <typename T, unsigned N>
+    inline T const* LUT1D<T,N>::at (unsigned channel) const
+    {
+        if (channel >= 3)
+            throw std::out_of_range("LUT1D::at: channel out of range");
+        return curve(channel);
+    }
+
+
+    // apply
+    template <typename T, unsigned N, typename Color>
+    inline Color apply (LUT1D<T,N> const &lut, Color c) noexcept
+    {
+        detail::check_lut_color<T,Color>();
+        Color ret;
+        for (unsigned k=0; k!=3; ++k) {
+            std::uint32_t i;
+            T f;
+            detail::lut_axis<T,N>(lut.domain_min[k], lut.domain_max[k])(c[k], i, f);
+            T const *curve = lut.curve(k);
+            ret[k] = lerp(curve[i], curve[i+1], f);
+        }
+        return ret;
+    }
+
+
+    template <typename T, unsigned N, typename In, typename Out>
+    inline void apply (LUT1D<T,N> const &lut, In const *first, In const *last, Out *out) noexcept
+    {
+        detail::check_lut_color<T,In>();
+        detail::check_lut_color<T,Out>();
+        const detail::lut_axis<T,N> axes[3] = {
+            {lut.domain_min[0], lut.domain_max[0]},
+            {lut.domain_min[1], lut.domain_max[1]},
+            {lut.domain_min[2], lut.domain_max[2]}
+        };
+        T const *curves = lut.curve(0);
+        const std::size_t stride = lut.stride();
+        T const *in = reinterpret_cast<T const*>(first);
+        T *o = reinterpret_cast<T*>(out);
+        const std::ptrdiff_t n = last - first;
+
+        static const profile::Site site ("LUT1D apply", "linear");
+        const profile::Scope scope (site, n, n * (sizeof(In) + sizeof(Out)));
+
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i) {
+            for (unsigned k=0; k!=3; ++k) {
+                std::uint32_t j;
+                T f;
+                axes[k](in[3*i+k], j, f);
+                T const *curve = curves + k*stride;
+                o[3*i+k] = lerp(curve[j], curve[j+1], f);
+            }
+        }
+    }
+
+
+    template <typename T, unsigned N, typename In, typename Out>
+    inline void apply (LUT1D<T,N> const &lut, ImageView<In> in, ImageView<Out> out)
+    {
+        transform_rows(in, out, [&](In *first, In *last, Out *o) { apply(lut, first, last, o); });
+    }
+
+
+
+    namespace detail {
+        // Sample i and fraction f for x, from the bits of x. Sample 1 + (j << Bits) + m lies at
+        // 2^(MinExp+j) * (1 + m/2^Bits); the biased exponent and the top mantissa bits of x
+        // give this index directly, once shifted.
+        template <int MinExp, int MaxExp, unsigned Bits>
+        struct log2_axis {
+            const float min = std::ldexp(1.f, MinExp), max = std::ldexp(1.f, MaxExp),
+                        inv_min = std::ldexp(1.f, -MinExp),
+                        inv_mantissa = std::ldexp(1.f, -int(23 - Bits));
+
+            void operator() (float x, std::uint32_t &i, float &f) const noexcept {
+                enum : std::uint32_t {
+                    last = (std::uint32_t(MaxExp - MinExp) << Bits),
+                    offset = (std::uint32_t(127 + MinExp) << Bits) - 1
+                };
+                x = select(x > 0, x, 0.f); // also maps NaN to 0
+                x = select(x < max, x, max);
+                const std::uint32_t bits = float_bits(x);
+                const bool small = x < min, top = x == max;
+                const std::uint32_t j = (bits >> (23 - Bits)) - offset;
+                i = select(small, 0u, select(top, std::uint32_t(last), j));
+                f = select(small, x * inv_min,
+                    select(top, 1.f, float(std::int32_t(bits & ((1u << (23 - Bits)) - 1)))
+                                     * inv_mantissa));
+            }
+        };
+    }
+
+
+    // Log2LUT1D
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline float Log2LUT1D<MinExp,MaxExp,Bits>::position (unsigned i) noexcept
+    {
+        if (i == 0)
+            return 0;
+        const unsigned j = i - 1;
+        return std::ldexp(1 + float(j & ((1u << Bits) - 1)) / (1u << Bits),
+                          MinExp + int(j >> Bits));
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline Log2LUT1D<MinExp,MaxExp,Bits>::Log2LUT1D (Curves curves)
+        : samples_(curves == Curves::shared ? size() : 3 * size()),
+          stride_(curves == Curves::shared ? 0 : size())
+    {
+        for (unsigned c=0; c!=3; ++c)
+            for (unsigned i=0; i!=size(); ++i)
+                curve(c)[i] = position(i);
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline float* Log2LUT1D<MinExp,MaxExp,Bits>::curve (unsigned channel) noexcept
+    {
+        return samples_.data() + channel * stride_;
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline float const* Log2LUT1D<MinExp,MaxExp,Bits>::curve (unsigned channel) const noexcept
+    {
+        return samples_.data() + channel * stride_;
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline float* Log2LUT1D<MinExp,MaxExp,Bits>::at (unsigned channel)
+    {
+        if (channel >= 3)
+            throw std::out_of_range("Log2LUT1D::at: channel out of range");
+        return curve(channel);
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits>
+    inline float const* Log2LUT1D<MinExp,MaxExp,Bits>::at (unsigned channel) const
+    {
+        if (channel >= 3)
+            throw std::out_of_range("Log2LUT1D::at: channel out of range");
+        return curve(channel);
+    }
+
+
+    // apply; the reference finds the sample with frexp rather than from the bits.
+    template <int MinExp, int MaxExp, unsigned Bits, typename Color>
+    inline Color apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, Color c) noexcept
+    {
+        using L = Log2LUT1D<MinExp,MaxExp,Bits>;
+        detail::check_lut_color<float,Color>();
+        const float min = std::ldexp(1.f, MinExp), max = std::ldexp(1.f, MaxExp);
+        Color ret;
+        for (unsigned k=0; k!=3; ++k) {
+            const float x = c[k] > 0 ? std::min(c[k], max) : 0;
+            unsigned i;
+            float f;
+            if (x < min) {
+                i = 0;
+                f = x / min;
+            } else if (x == max) {
+                i = L::size() - 2;
+                f = 1;
+            } else {
+                int e;
+                const float m = 2 * std::frexp(x, &e) - 1; // x = (1+m) * 2^(e-1)
+                const float t = std::ldexp(m, Bits);
+                const unsigned octave = unsigned(e - 1 - MinExp), step = unsigned(t);
+                i = 1 + (octave << Bits) + step;
+                f = t - step;
+            }
+            float const *curve = lut.curve(k);
+            ret[k] = lerp(curve[i], curve[i+1], f);
+        }
+        return ret;
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits, typename In, typename Out>
+    inline void apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, In const *first, In const *last,
+                       Out *out) noexcept
+    {
+        detail::check_lut_color<float,In>();
+        detail::check_lut_color<float,Out>();
+        const detail::log2_axis<MinExp,MaxExp,Bits> axis {};
+        float const *curves = lut.curve(0);
+        const std::size_t stride = lut.stride();
+        float const *in = reinterpret_cast<float const*>(first);
+        float *o = reinterpret_cast<float*>(out);
+        const std::ptrdiff_t n = last - first;
+
+        static const profile::Site site ("Log2LUT1D apply", "linear");
+        const profile::Scope scope (site, n, n * (sizeof(In) + sizeof(Out)));
+
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i) {
+            for (unsigned k=0; k!=3; ++k) {
+                std::uint32_t j;
+                float f;
+                axis(in[3*i+k], j, f);
+                float const *curve = curves + k*stride;
+                o[3*i+k] = lerp(curve[j], curve[j+1], f);
+            }
+        }
+    }
+
+
+    template <int MinExp, int MaxExp, unsigned Bits, typename In, typename Out>
+    inline void apply (Log2LUT1D<MinExp,MaxExp,Bits> const &lut, ImageView<In> in,
+                       ImageView<Out> out)
+    {
+        transform_rows(in, out, [&](In *first, In *last, Out *o) { apply(lut, first, last, o); });
+    }
+
+}
+
+#endif // LUT1D_HH_INCLUDED_20261018
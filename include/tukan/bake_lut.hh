@@ -0,0 +1,241 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef BAKE_LUT_HH_INCLUDED_20261018
+#define BAKE_LUT_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "Interval.hh"
+#include "LUT1D.hh"
+#include "LUT3D.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// bake_lut:
+//
+//    Samples any callable from colour to colour, typically a chain of gamma decode, matrix,
+//    tone curve and encode, into a 1D shaper followed by a 3D LUT. Applying the result costs
+//    a table lookup per channel plus one interpolation in the cube, whatever the chain does.
+//
+//    The input domain is the same for all channels. 'shape' maps it monotonically onto [0..1]
+//    and is sampled into the LUT1D; the cube nodes are spread evenly in shaped space, i.e. at
+//    shape^-1(k/(N3-1)), so that a shape like log2(1+x) puts more of them into the shadows of
+//    HDR input. Without a shape, the domain is mapped linearly.
+//
+//    The maximum absolute error per channel against the exact chain is measured at the centres
+//    of all cells in shaped space, where interpolation is least accurate, and stored in the
+//    result along with the input where it occurs.
+//
+//    The result is a drop-in replacement for the chain: it is callable like it, and has the
+//    same apply() overloads as the LUTs, with the batches run in blocks small enough to stay
+//    in the L1 cache between shaper and cube.
+//
+//
+// Definitions:
+//
+//    BakedLUT<In, Out, N3, N1>
+//        LUT1D<T,N1> shaper;  LUT3D<T,N3> cube;  Interpolation method;
+//        T max_error;  In max_error_at;
+//        Out operator() (In c) const
+//
+//    // Out is the result type of f(In).
+//    BakedLUT<In,Out,N3,N1> bake_lut<In, N3=33, N1=1024> (F f, Interval<T> domain = [0..1])
+//    BakedLUT<In,Out,N3,N1> bake_lut<In, N3=33, N1=1024> (F f, Interval<T> domain, Shape shape)
+//
+//    Out  apply (BakedLUT const &lut, In c)
+//    void apply (BakedLUT const &lut, In const *first, In const *last, Out *out)
+//    // Throws std::logic_error if the views differ in extent.
+//    void apply (BakedLUT const &lut, ImageView<In> in, ImageView<Out> out)
+//
+//
+// Examples:
+//
+//    using Linear = LinearRGB<float,sRGB>;
+//    auto grade = bake_lut<Linear>([](Linear c) {
+//        return static_cast<RGB<float,sRGB>>(tone_curve(matrix * c));
+//    }, interval(0.f, 16.f), [](float x) { return std::log2(1 + x) / std::log2(17.f); });
+//    apply(grade, image_view(hdr.data(), w, h), image_view(ldr.data(), w, h));
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    //----------------------------------------------------------------------------------------------
+    // BakedLUT
+    //----------------------------------------------------------------------------------------------
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    struct BakedLUT {
+        using value_type = typename In::value_type;
+        static_assert(std::is_same<typename Out::value_type, value_type>::value,
+                      "BakedLUT: input and output colours must have the same value type");
+
+        LUT1D<value_type,N1> shaper;
+        LUT3D<value_type,N3> cube;
+        Interpolation method = Interpolation::tetrahedral;
+
+        value_type max_error = 0;
+        In max_error_at;
+
+        Out operator() (In c) const noexcept ;
+    };
+
+
+    template <typename In, unsigned N3 = 33, unsigned N1 = 1024, typename F>
+    auto bake_lut (F f, Interval<typename In::value_type> domain
+                            = interval(typename In::value_type(0), typename In::value_type(1)))
+      -> BakedLUT<In, typename std::decay<decltype(f(In()))>::type, N3, N1>;
+
+    template <typename In, unsigned N3 = 33, unsigned N1 = 1024, typename F, typename Shape>
+    auto bake_lut (F f, Interval<typename In::value_type> domain, Shape shape)
+      -> BakedLUT<In, typename std::decay<decltype(f(In()))>::type, N3, N1>;
+
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    Out apply (BakedLUT<In,Out,N3,N1> const &lut, In c) noexcept ;
+
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    void apply (BakedLUT<In,Out,N3,N1> const &lut, In const *first, In const *last,
+                Out *out) noexcept ;
+
+    template <typename In, typename Out, unsigned N3, unsigned N1, typename I, typename O>
+    void apply (BakedLUT<In,Out,N3,N1> const &lut, ImageView<I> in, ImageView<O> out);
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+        // x in [domain.min..domain.max] with shape(x) = u, for monotonically increasing shapes.
+        template <typename T, typename Shape>
+        inline T unshape (Interval<T> domain, Shape &shape, double u)
+        {
+            double lo = domain.min, hi = domain.max;
+            for (int i=0; i!=64 && lo < hi; ++i) {
+                const double mid = lo + (hi - lo) / 2;
+                if (mid == lo || mid == hi)
+                    break;
+                (double(shape(T(mid))) < u ? lo : hi) = mid;
+            }
+            return T(u <= 0 ? domain.min : u >= 1 ? domain.max : hi);
+        }
+    }
+
+
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    inline Out BakedLUT<In,Out,N3,N1>::operator() (In c) const noexcept
+    {
+        const In v = apply(cube, apply(shaper, c), method);
+        Out ret;
+        for (unsigned k=0; k!=3; ++k)
+            ret[k] = v[k];
+        return ret;
+    }
+
+
+    template <typename In, unsigned N3, unsigned N1, typename F, typename Shape>
+    inline auto bake_lut (F f, Interval<typename In::value_type> domain, Shape shape)
+      -> BakedLUT<In, typename std::decay<decltype(f(In()))>::type, N3, N1>
+    {
+        using T = typename In::value_type;
+        using Out = typename std::decay<decltype(f(In()))>::type;
+        BakedLUT<In,Out,N3,N1> lut;
+
+        // Shaper.
+        for (unsigned c=0; c!=3; ++c) {
+            lut.shaper.domain_min[c] = domain.min;
+            lut.shaper.domain_max[c] = domain.max;
+            T *curve = lut.shaper.curve(c);
+            for (unsigned i=0; i!=N1; ++i) {
+                const T u = shape(lerp(domain.min, domain.max, T(i) / (N1 - 1)));
+                curve[i] = std::max(T(0), std::min(T(1), u));
+            }
+        }
+
+        // Cube, with nodes at evenly spaced points in shaped space.
+        std::vector<T> nodes (N3);
+        for (unsigned k=0; k!=N3; ++k)
+            nodes[k] = detail::unshape(domain, shape, double(k) / (N3 - 1));
+        for (unsigned b=0; b!=N3; ++b)
+        for (unsigned g=0; g!=N3; ++g)
+        for (unsigned r=0; r!=N3; ++r) {
+            const Out v = f(In(nodes[r], nodes[g], nodes[b]));
+            T *n = lut.cube.node(r, g, b);
+            for (unsigned k=0; k!=3; ++k)
+                n[k] = v[k];
+        }
+
+        // Error, at the centres of the cells.
+        std::vector<T> centres (N3 - 1);
+        for (unsigned k=0; k!=N3-1; ++k)
+            centres[k] = detail::unshape(domain, shape, (k + 0.5) / (N3 - 1));
+        for (T b : centres)
+        for (T g : centres)
+        for (T r : centres) {
+            const In c (r, g, b);
+            const Out exact = f(c), baked = lut(c);
+            for (unsigned k=0; k!=3; ++k) {
+                const T e = std::fabs(exact[k] - baked[k]);
+                if (e > lut.max_error) {
+                    lut.max_error = e;
+                    lut.max_error_at = c;
+                }
+            }
+        }
+        return lut;
+    }
+
+
+    template <typename In, unsigned N3, unsigned N1, typename F>
+    inline auto bake_lut (F f, Interval<typename In::value_type> domain)
+      -> BakedLUT<In, typename std::decay<decltype(f(In()))>::type, N3, N1>
+    {
+        using T = typename In::value_type;
+        const T min = domain.min, length = domain.max - domain.min;
+        return bake_lut<In,N3,N1>(f, domain, [=](T x) { return (x - min) / length; });
+    }
+
+
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    inline Out apply (BakedLUT<In,Out,N3,N1> const &lut, In c) noexcept
+    {
+        return lut(c);
+    }
+
+
+    template <typename In, typename Out, unsigned N3, unsigned N1>
+    inline void apply (BakedLUT<In,Out,N3,N1> const &lut, In const *first, In const *last,
+                       Out *out) noexcept
+    {
+        // The shaped values are kept in 'out', block by block, for the cube to read in place.
+        const std::ptrdiff_t block = 256;
+        while (first != last) {
+            const std::ptrdiff_t n = std::min(block, last - first);
+            apply(lut.shaper, first, first + n, out);
+            apply(lut.cube, out, out + n, out, lut.method);
+            first += n;
+            out += n;
+        }
+    }
+
+
+    template <typename In, typename Out, unsigned N3, unsigned N1, typename I, typename O>
+    inline void apply (BakedLUT<In,Out,N3,N1> const &lut, ImageView<I> in, ImageView<O> out)
+    {
+        transform_rows(in, out, [&](I *first, I *last, O *o) {
+            apply(lut, first, last, o);
+        });
+    }
+
+}
+
+#endif // BAKE_LUT_HH_INCLUDED_20261018
@@ -79,7 +79,7 @@ namespace tukan {  namespace detail {
     template <typename T>
     constexpr Matrix33<T> inverse (Matrix33<T> const &m) noexcept
     {
-        return (1 / determinant(m))
+        return T(1 / determinant(m))
              * Matrix33<T>{
                      +m._22*m._33-m._23*m._32,  -m._12*m._33+m._13*m._32,  +m._12*m._23-m._13*m._22,
                      -m._21*m._33+m._23*m._31,  +m._11*m._33-m._13*m._31,  -m._11*m._23+m._13*m._21,
@@ -0,0 +1,190 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef EXP_HH_INCLUDED_20261018
+#define EXP_HH_INCLUDED_20261018
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tukan { namespace detail {
+
+    //----------------------------------------------------------------------------------------------
+    // select
+    //
+    //    Branch-free 'c ? a : b' on the bit patterns. A plain conditional operator keeps loops
+    //    from vectorizing: the compiler sinks the float arithmetic feeding it into a branch, and
+    //    then refuses to if-convert that, because floating point operations may trap.
+    //----------------------------------------------------------------------------------------------
+    inline float select (bool c, float a, float b) noexcept
+    {
+        std::uint32_t ia, ib;
+        std::memcpy(&ia, &a, sizeof a);
+        std::memcpy(&ib, &b, sizeof b);
+        const std::uint32_t mask = 0u - std::uint32_t(c);
+        const std::uint32_t ret = (ia & mask) | (ib & ~mask);
+        float f;
+        std::memcpy(&f, &ret, sizeof f);
+        return f;
+    }
+
+
+    // The integer version keeps the compiler from turning the selection into a branch, too,
+    // e.g. where an index for a gather is selected.
+    inline std::uint32_t select (bool c, std::uint32_t a, std::uint32_t b) noexcept
+    {
+        const std::uint32_t mask = 0u - std::uint32_t(c);
+        return (a & mask) | (b & ~mask);
+    }
+
+
+    inline double select (bool c, double a, double b) noexcept
+    {
+        std::uint64_t ia, ib;
+        std::memcpy(&ia, &a, sizeof a);
+        std::memcpy(&ib, &b, sizeof b);
+        const std::uint64_t mask = 0u - std::uint64_t(c);
+        const std::uint64_t ret = (ia & mask) | (ib & ~mask);
+        double d;
+        std::memcpy(&d, &ret, sizeof d);
+        return d;
+    }
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // float_bits, bits_float
+    //
+    //    The IEEE 754 bit pattern of a float, and back.
+    //----------------------------------------------------------------------------------------------
+    inline std::uint32_t float_bits (float f) noexcept
+    {
+        std::uint32_t u;
+        std::memcpy(&u, &f, sizeof u);
+        return u;
+    }
+
+
+    inline float bits_float (std::uint32_t u) noexcept
+    {
+        float f;
+        std::memcpy(&f, &u, sizeof f);
+        return f;
+    }
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // exp_approx
+    //
+    //    Branch-free float exp, written so that loops over it auto-vectorize (std::exp does not,
+    //    as it sets errno and handles special values). The argument is split into
+    //    x = n*ln(2) + f with integral n and |f| <= ln(2)/2; exp(f) is a Taylor polynomial and 2^n
+    //    is put into the exponent bits directly. The relative error is below 2e-7 in the clamped
+    //    domain [-87, 88]; outside of it, the result saturates instead of returning 0 or inf.
+    //    NaN is not propagated.
+    //----------------------------------------------------------------------------------------------
+    inline float exp_approx (float x) noexcept
+    {
+        x = select(x < -87.f, -87.f, x);
+        x = select(x >  88.f,  88.f, x);
+
+        // n = round(x/ln(2)). Adding 1.5*2^23 rounds to an integer, which then sits in the low
+        // mantissa bits of r; no float to int conversion is needed.
+        const float magic = 12582912.f;
+        const float r = x * 1.44269504f + magic;
+        const float n = r - magic;
+        std::uint32_t ni;
+        std::memcpy(&ni, &r, sizeof r);
+
+        // f = x - n*ln(2), with ln(2) split in two parts so that n*ln2_hi is exact.
+        const float f = (x - n*0.693145752f) - n*1.42860677e-6f;
+
+        float p = 1.f/5040;
+        p = p*f + 1.f/720;
+        p = p*f + 1.f/120;
+        p = p*f + 1.f/24;
+        p = p*f + 1.f/6;
+        p = p*f + 0.5f;
+        p = p*f + 1.f;
+        p = p*f + 1.f;
+
+        const std::uint32_t bits = (ni - 0x4B400000u + 127u) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof scale);
+        return p * scale;
+    }
+
+
+    inline void exp_approx (float const *first, float const *last, float *out) noexcept
+    {
+        const std::ptrdiff_t n = last - first;
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i)
+            out[i] = exp_approx(first[i]);
+    }
+
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // log2_approx, pow_approx
+    //
+    //    Branch-free counterparts of std::log2 and std::pow for positive, finite x, for use in
+    //    vectorized loops. x is split into 2^e * m with m in [sqrt(1/2), sqrt(2)), and log(m) is
+    //    the series 2*atanh((m-1)/(m+1)). The absolute error of log2_approx is below 4e-6, the
+    //    relative error of pow_approx(x,y) below 3e-6 as long as |y*log2(x)| < 24. Zero and
+    //    subnormal x are treated as the smallest normal float.
+    //----------------------------------------------------------------------------------------------
+    inline float log2_approx (float x) noexcept
+    {
+        x = select(x < 1.17549435e-38f, 1.17549435e-38f, x);
+
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof x);
+        // Subtracting the bits of sqrt(1/2) puts the exponent rollover at sqrt(2).
+        const std::uint32_t offset = bits - 0x3f3504f3u;
+        const std::int32_t e = std::int32_t(offset) >> 23;
+        const std::uint32_t mbits = bits - (std::uint32_t(e) << 23);
+        float m;
+        std::memcpy(&m, &mbits, sizeof m);
+
+        const float s = (m - 1) / (m + 1), s2 = s*s;
+        float p = 1.f/9;
+        p = p*s2 + 1.f/7;
+        p = p*s2 + 1.f/5;
+        p = p*s2 + 1.f/3;
+        p = p*s2 + 1.f;
+        return float(e) + p * s * 2.88539008f; // 2/ln(2)
+    }
+
+
+    inline float pow_approx (float x, float y) noexcept
+    {
+        return exp_approx(y * log2_approx(x) * 0.693147181f);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // log2_simd, pow_simd, cbrt_simd
+    //
+    //    For templates over float and double: log2_approx and pow_approx for float, so that loops
+    //    over them vectorize, and std::log2, std::pow and std::cbrt for double. cbrt_simd also
+    //    takes negative x.
+    //----------------------------------------------------------------------------------------------
+    inline float log2_simd (float x) noexcept { return log2_approx(x); }
+    inline double log2_simd (double x) noexcept { return std::log2(x); }
+    inline float pow_simd (float x, float y) noexcept { return pow_approx(x, y); }
+    inline double pow_simd (double x, double y) noexcept { return std::pow(x, y); }
+
+    inline float cbrt_simd (float x) noexcept {
+        const float c = pow_approx(select(x < 0, -x, x), 1.f/3);
+        return select(x < 0, -c, c);
+    }
+    inline double cbrt_simd (double x) noexcept { return std::cbrt(x); }
+
+} }
+
+#endif // EXP_HH_INCLUDED_20261018
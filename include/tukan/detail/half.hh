@@ -0,0 +1,82 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef HALF_BITS_HH_INCLUDED_20261018
+#define HALF_BITS_HH_INCLUDED_20261018
+
+#include <cstdint>
+#include <cstring>
+
+namespace tukan { namespace detail {
+
+    //----------------------------------------------------------------------------------------------
+    // Conversion between float and the bit pattern of an IEEE 754 binary16.
+    //
+    //    float_to_half_bits rounds to nearest even, overflows to infinity and produces subnormals;
+    //    both directions return quiet NaNs for NaNs. Otherwise, half_bits_to_float is exact.
+    //    The results are the same as those of the F16C instructions.
+    //----------------------------------------------------------------------------------------------
+    inline std::uint16_t float_to_half_bits (float f) noexcept
+    {
+        std::uint32_t x;
+        std::memcpy(&x, &f, sizeof x);
+
+        const std::uint32_t sign = (x >> 16) & 0x8000u;
+        const std::uint32_t abs  = x & 0x7fffffffu;
+
+        if (abs > 0x7f800000u) // NaN, keeping the upper payload bits
+            return std::uint16_t(sign | 0x7e00u | ((abs >> 13) & 0x3ffu));
+        if (abs == 0x7f800000u)
+            return std::uint16_t(sign | 0x7c00u);
+        if (abs >= 0x477ff000u) // rounds to >= 65520
+            return std::uint16_t(sign | 0x7c00u);
+        if (abs < 0x38800000u) { // below the smallest normal half, 2^-14
+            if (abs < 0x33000000u) // below half of the smallest subnormal, 2^-25
+                return std::uint16_t(sign);
+            // The value is mant * 2^(exp-150), in units of the smallest subnormal, 2^-24:
+            const std::uint32_t mant  = (abs & 0x7fffffu) | 0x800000u,
+                                shift = 126 - (abs >> 23),
+                                half  = mant >> shift,
+                                rest  = mant & ((1u << shift) - 1),
+                                mid   = 1u << (shift - 1);
+            return std::uint16_t(sign | (half + (rest > mid || (rest == mid && (half & 1)))));
+        }
+
+        // Normal: rebias the exponent, round the 13 dropped mantissa bits to nearest even.
+        const std::uint32_t rebiased = abs - 0x38000000u;
+        const std::uint32_t rounded  = rebiased + 0xfffu + ((rebiased >> 13) & 1);
+        return std::uint16_t(sign | (rounded >> 13));
+    }
+
+
+    inline float half_bits_to_float (std::uint16_t h) noexcept
+    {
+        const std::uint32_t sign = std::uint32_t(h & 0x8000u) << 16;
+        const std::uint32_t exp  = (h >> 10) & 0x1fu;
+        std::uint32_t mant = h & 0x3ffu;
+
+        std::uint32_t x;
+        if (exp == 0x1f) {
+            x = sign | 0x7f800000u | (mant << 13) | (mant ? 0x400000u : 0u); // quiet NaNs
+        } else if (exp != 0) {
+            x = sign | ((exp + 112) << 23) | (mant << 13);
+        } else if (mant == 0) {
+            x = sign;
+        } else {
+            // Subnormal: normalize.
+            std::uint32_t e = 113;
+            while (!(mant & 0x400u)) {
+                mant <<= 1;
+                --e;
+            }
+            x = sign | (e << 23) | ((mant & 0x3ffu) << 13);
+        }
+
+        float f;
+        std::memcpy(&f, &x, sizeof f);
+        return f;
+    }
+
+} }
+
+#endif // HALF_BITS_HH_INCLUDED_20261018
@@ -0,0 +1,45 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef LUT_HH_INCLUDED_20261018
+#define LUT_HH_INCLUDED_20261018
+
+#include "exp.hh"
+#include <cstdint>
+#include <type_traits>
+
+namespace tukan { namespace detail {
+
+    //----------------------------------------------------------------------------------------------
+    // Helpers shared by LUT1D and LUT3D.
+    //----------------------------------------------------------------------------------------------
+    template <typename T, typename Color>
+    struct check_lut_color {
+        static_assert(std::is_same<typename Color::value_type, T>::value,
+                      "LUT<T,N> maps colours over T");
+        static_assert(sizeof(Color) == 3 * sizeof(T), "LUTs map 3 channel colours");
+    };
+
+
+    // Maps x from the domain to [0..N-1], with the cell i in [0..N-2] and the fraction
+    // f in [0..1] within it. Clamps to the domain, NaN goes to its minimum. Branch-free.
+    template <typename T, unsigned N>
+    struct lut_axis {
+        T scale, bias;
+
+        lut_axis (T min, T max) noexcept
+            : scale(T(N - 1) / (max - min)), bias(-min * T(N - 1) / (max - min)) {}
+
+        void operator() (T x, std::uint32_t &i, T &f) const noexcept {
+            x = x * scale + bias;
+            x = select(x > 0, x, T(0)); // also maps NaN to 0
+            x = select(x < T(N - 1), x, T(N - 1));
+            const std::uint32_t t = static_cast<std::uint32_t>(x);
+            i = t < N - 2 ? t : N - 2;
+            f = x - T(i);
+        }
+    };
+
+} }
+
+#endif // LUT_HH_INCLUDED_20261018
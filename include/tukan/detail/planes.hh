@@ -0,0 +1,98 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef PLANES_HH_INCLUDED_20261018
+#define PLANES_HH_INCLUDED_20261018
+
+#include "Matrix33.hh"
+#include "exp.hh"
+#include <algorithm>
+#include <cstddef>
+
+namespace tukan { namespace detail {
+
+    //----------------------------------------------------------------------------------------------
+    // Planes
+    //
+    //    Per-pixel kernels with transcendental functions or several passes (tonemap.hh, gamut.hh)
+    //    are too large for the compiler to inline into a vectorized loop over interleaved pixels.
+    //    Instead, chunks of pixels are split into planes of red, green and blue, and the kernels
+    //    map those in small passes, each a loop of its own that vectorizes.
+    //----------------------------------------------------------------------------------------------
+    constexpr std::ptrdiff_t plane_chunk = 256;
+
+
+    template <typename T>
+    inline T clamp01 (T v) noexcept {
+        v = select(v > 0, v, T(0)); // also maps NaN to 0
+        return select(v < 1, v, T(1));
+    }
+
+
+    // Applies 'curve' to each of the planes.
+    template <typename T, typename Curve>
+    inline void map_planes (T *r, T *g, T *b, std::ptrdiff_t n, Curve curve) noexcept {
+        T *planes[3] = {r, g, b};
+        for (T *p : planes) {
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i)
+                p[i] = curve(p[i]);
+        }
+    }
+
+
+    // In place; the rows of m are the output channels.
+    template <typename T>
+    inline void multiply_planes (T *r, T *g, T *b, std::ptrdiff_t n, Matrix33<T> const &m) noexcept
+    {
+        const Matrix33<T> k = m;
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i) {
+            const T vr = r[i], vg = g[i], vb = b[i];
+            r[i] = k._11*vr + k._12*vg + k._13*vb;
+            g[i] = k._21*vr + k._22*vg + k._23*vb;
+            b[i] = k._31*vr + k._32*vg + k._33*vb;
+        }
+    }
+
+
+    // n pixels of three channels from 'in' to 'out' (which may be the same), in chunks of up
+    // to plane_chunk pixels: each chunk is multiplied with m into planes, mapped in place by
+    // 'f(r, g, b, count, first)', where 'first' is the index of the chunk's first pixel, and
+    // interleaved again.
+    template <typename T, typename F>
+    inline void transform_planes (T const *in, std::ptrdiff_t n, T *out, Matrix33<T> const &m,
+                                  F f)
+    {
+        T r[plane_chunk], g[plane_chunk], b[plane_chunk];
+        const Matrix33<T> k = m;
+        for (std::ptrdiff_t first=0; first<n; first+=plane_chunk) {
+            const std::ptrdiff_t c = std::min(plane_chunk, n - first);
+            T const *src = in + 3*first;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<c; ++i) {
+                const T vr = src[3*i+0], vg = src[3*i+1], vb = src[3*i+2];
+                r[i] = k._11*vr + k._12*vg + k._13*vb;
+                g[i] = k._21*vr + k._22*vg + k._23*vb;
+                b[i] = k._31*vr + k._32*vg + k._33*vb;
+            }
+            f(r, g, b, c, first);
+            T *dst = out + 3*first;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<c; ++i) {
+                dst[3*i+0] = r[i];
+                dst[3*i+1] = g[i];
+                dst[3*i+2] = b[i];
+            }
+        }
+    }
+
+
+    template <typename T>
+    inline Matrix33<T> scale_matrix (double f) noexcept {
+        return {T(f), 0, 0,  0, T(f), 0,  0, 0, T(f)};
+    }
+
+} }
+
+#endif // PLANES_HH_INCLUDED_20261018
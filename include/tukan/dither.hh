@@ -0,0 +1,538 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef DITHER_HH_INCLUDED_20261018
+#define DITHER_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "RGB.hh"
+#include "profile.hh"
+#include "unorm.hh"
+#include "detail/exp.hh"
+#include "detail/gamma_approx.hh"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Dithered encoding:
+//
+//    Encodes linear float images to 8 bit (or other unorm) RGB like encode() in unorm.hh, but
+//    quantizes with a dither, so that smooth gradients do not band. Gamma encoding and dithering
+//    are fused into one pass over the pixels. The gamma is computed with the float
+//    approximations in detail/gamma_approx.hh, which are within 1e-6 of the exact curve.
+//
+//    Dither::none            rounds to the nearest code
+//    Dither::bayer           ordered dither with the 8x8 Bayer matrix
+//    Dither::blue_noise      ordered dither with a 64x64 blue noise tile (void-and-cluster)
+//    Dither::floyd_steinberg error diffusion along serpentine rows
+//
+//    The ordered variants compute each code as floor(v*(2^Bits-1) + t), with the threshold t
+//    taken from the tile at the pixel's position; they are vectorized and parallel over rows.
+//    Error diffusion is inherently sequential, only its gamma pre-pass per row is vectorized.
+//    All three channels of a pixel use the same threshold.
+//
+//
+// Definitions:
+//
+//    enum class Dither { none, bayer, blue_noise, floyd_steinberg };
+//
+//    // In is LinearRGB<float,S> (const), Out is RGB<unorm<B>,S>. Throws std::logic_error if
+//    // the views differ in extent.
+//    void encode (ImageView<In> in, ImageView<Out> out, Dither method)
+//
+//
+// Examples:
+//
+//    std::vector<LinearRGB<float,sRGB>> hdr = ...;
+//    std::vector<RGB<unorm8,sRGB>> png (hdr.size());
+//    encode(image_view(hdr.data(), w, h), image_view(png.data(), w, h), Dither::blue_noise);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    enum class Dither {
+        none,
+        bayer,
+        blue_noise,
+        floyd_steinberg
+    };
+
+    template <typename In, typename Out>
+    void encode (ImageView<In> in, ImageView<Out> out, Dither method);
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace detail {
+
+    // Thresholds are (rank+0.5)/64 and (rank+0.5)/256, respectively.
+    static constexpr std::uint8_t bayer_8x8[64] = {
+         0, 32,  8, 40,  2, 34, 10, 42,
+        48, 16, 56, 24, 50, 18, 58, 26,
+        12, 44,  4, 36, 14, 46,  6, 38,
+        60, 28, 52, 20, 62, 30, 54, 22,
+         3, 35, 11, 43,  1, 33,  9, 41,
+        51, 19, 59, 27, 49, 17, 57, 25,
+        15, 47,  7, 39, 13, 45,  5, 37,
+        63, 31, 55, 23, 61, 29, 53, 21
+    };
+
+    static constexpr std::uint8_t blue_noise_64x64[64*64] = {
+        241,  9,112,208,128,186, 22,199,169,231,141,195, 21,238, 34,149,
+        255, 18,226,146, 81,213, 58,244,195, 69,180,208,152,230,121,237,
+        157,221,  8, 60,106, 32,130,158,  0,137,210,163,  6,189, 87, 26,
+        121, 80,200, 22,252, 15,157, 84,  9,170, 62,198,146, 72,164, 89,
+        185,135,232, 35,160, 49, 96,248, 35, 89,  9, 63,114, 79,215,123,
+         50,160, 97, 40,237,105,154, 87,142,231,  8, 95, 76, 39,  3,205,
+         66,112,191,247,149,198,236, 55,180, 71, 29,230,129, 62,208,150,
+         52,235,158, 95,183,120,202, 53,249, 93,227,112, 18,253,118, 54,
+         33, 81,170, 68,105,225,145, 65,126,188,156,251,176,144,  0,186,
+         84,217,198,132,182, 20,202, 46, 27,106,164,242,126,195,172, 85,
+        145, 24,175, 43, 80, 20, 91,214,113,245, 87,106,183, 40, 99,244,
+        175,  5,130,221, 75, 42,225,110,135, 19,156, 44,179,207,  6,222,
+        101,204, 20,255,189,  1,209,166, 16,218,104, 37,205, 57,100,241,
+         28,118,  8, 73, 55,116,252,132,190,221, 53, 19,147, 58,252,115,
+         45,239, 98,138,231,121,171, 14, 40,155,193, 11,143,226, 18,134,
+         74,192, 61, 29,144,172,  0, 68,179,200, 80,235, 65, 92,132,158,
+        230,123,152, 52,134, 83, 39,108,239, 49, 81,130, 18,228,166,136,
+         67,171,248,144,220,166,  1, 95,157, 73,119,185,216,101, 22,213,
+        162,199, 71,  4,194, 61,223,141,204,126, 57,236, 68,165,204,108,
+         34,214,114,248,199, 99,236,151,217, 34,121,140,170, 25,196, 60,
+        175, 11, 76,213,115,242,183,139, 73,177,200,237,154, 89, 40,202,
+        222, 47, 92,186, 33, 80,231, 61,211, 11,248, 90, 32,170,138, 64,
+         13,123,221,170,104,152, 44, 99, 78,250, 31,175,118, 84, 48,255,
+        145, 87,165, 10, 81, 48,128, 22, 92, 58,248,  4,212,110,241, 36,
+         91,245,186, 35,169, 11, 57,205, 26,146,  3,111, 66,191,125,  6,
+        105,153, 15,209,108,137,182, 38,126,176,145, 47,230, 78,193,240,
+         92,153, 36, 55,253, 25,235,177,  3,161,102,210, 16,197,154,  3,
+        184,230, 52,140,216,168,190,244,118,159,183, 98, 48,156, 72,144,
+        208, 50,108,223, 96,150,230, 88,117,250,169, 46,219, 28,253, 81,
+        189,233,129, 63,242, 17,203,101,238, 25,107,199,129,  4,115, 46,
+        182,229,112,207, 84,131,190, 64,124,225, 73,144, 41,234, 98,128,
+         69, 24,122,240, 19,109, 35, 65,205, 18,219, 77,231,193, 27,117,
+          2,155,134, 19, 71,192,125, 41,220, 61, 90,134,179,103,160,139,
+         58, 23,179, 85,163, 50,147, 69,160, 83,222, 62,165,251,147,214,
+         28, 77,  6,144,167, 14,108,215, 29,194, 52,241,122,168, 59,223,
+        208,171,102,192, 74,156,227, 87,135, 41,113,146, 12,127,251,173,
+        228, 79,238,166, 48,249, 15,180,148, 11,196,241, 20, 72,207, 41,
+        243,114,205, 37,220,120,254,  4,207, 45,183, 14, 96, 36, 72,104,
+        169,136,246,191, 66,238, 45,153, 90,134,  8,180, 77, 27,189, 15,
+         88,144, 30, 57,209,137, 11,186,162,252,176, 61,187, 38, 88, 58,
+        104, 34,197,115,213,143,103, 77,211,110,158, 42,122,223, 12,175,
+         76,164, 96,143, 21,190, 89,177,134,110,242,149,216,178,206, 15,
+        234, 49, 96, 36,116,203, 80,227,173,253,107,211, 95,151,250,111,
+         47,229,182,252, 93, 42,239,106, 56,  2, 89,236,106,220,164,203,
+        124,178, 63,  8, 90, 32,170,240, 28, 66,235, 86,192,146, 94,128,
+        227,  1,215, 67,233,109, 59, 34,229, 66, 21,119, 76,131, 57,156,
+        195,124,210,155, 17,176,125, 11, 38, 63,161, 18,228, 39,130,200,
+        161, 72,127,  7,162,118,200, 75,222,124,208, 26,152, 72,136, 18,
+        225,148,254,133,182,232, 57,123,199,134,175, 10, 56,250, 31,187,
+         53,150, 39,126,168,  9,153,212, 93,169,198, 43,224,  0,245,113,
+         80, 19, 65,225, 87,247, 55,144,189, 85,204,127, 57,183, 70,  1,
+        239, 27,105,221, 65,177, 17,147, 34,173,141, 50,200,  7,246, 52,
+         78, 25, 95, 42,202, 75,153,  6, 92, 48,225,101,156,114,214, 82,
+        238,103,179,248, 83,198,243,127, 14,140,251,102,151,192, 92, 33,
+        186,253,140,182, 42,159,101,209,240,115, 32,149,242,102,218,148,
+         94,171,198,139, 33,247, 88,232,195, 67, 99,240,120,160, 98,189,
+        117,172,214,156,109, 21,216,184,253,146, 27,210,183, 67,  7,168,
+        124, 17,210, 54, 27,116, 69, 44,191, 57, 82, 24,173, 50,135,229,
+        154, 47,103,  4,127,219, 24, 70,  2,166,223, 78, 12,165, 34,122,
+         59,225, 46, 83,209,153, 50,130,110,  9,213, 36, 81,179, 25,210,
+         39,237,  5, 65,245,139, 83, 38,107,167, 75,121, 36,232,143, 45,
+        193, 74,143, 95,162,222,181, 99,231,159,217,125,238, 72,213,  9,
+        119, 69,201,239, 79,190,113,177,139, 95, 53,187,114,207, 86,254,
+        190, 13,157,118,  5,103,184, 25,167,255,154,188, 59,224,129, 66,
+        147, 88,128,194, 47,168,119,235, 61,198,  0,246,134, 91,206,106,
+        255, 31,231,197, 10,134, 33,149,  3,115, 37,185, 15,108,163, 41,
+        179,223,162, 33,147, 58,252, 37,231,202, 26,249,138, 48,176, 21,
+        134, 78,235,182,243, 70,226,203, 58, 82, 20,106,144,  0,249,168,
+        218, 23,176, 99,226, 10,206, 19,137,227, 86,191, 54,172, 15,154,
+         61,131,171,112, 67,251, 84,200,240, 76,209, 61,147,205, 82,244,
+        101, 17, 86,122,208, 12,162, 82,122, 63,151,100,  5,220, 68,151,
+        214,109, 32, 54,132,160, 40, 96,142,218,124,238,198, 90, 52,104,
+        184, 74,252, 35,148, 77,185, 96,159, 33,111,151, 23,237, 75,225,
+        187,  2, 84, 42,211,175, 52,106, 26,165,134, 96,254, 31,125,195,
+         60,142,188, 51,233, 97,137,196,  8,179,212, 74,162,117,236, 97,
+         45,170,204, 92,218, 16,119,245,  4,178, 45, 71, 30,153,206, 14,
+        134, 49,158,116,212, 56,130,249, 49,216,183, 68,211,104,125, 34,
+         97,215,244,151, 15,123,227,143,188, 44,226,  6,172, 55,155, 10,
+        228,110,250, 22,171, 66,222, 46,246,109, 41,231,192, 30,181, 12,
+        247,126,  2,152, 65,179,199, 73,162,104,192,135,224,174,116,241,
+         96,226,189,  2, 88,238, 30,171, 74,126, 12,252,137, 47,201,165,
+        141, 50,117,200, 90,163, 23, 71,247,120, 83,200,106,234, 77,177,
+         39,163, 73,201,105,126, 26,168, 85,142, 17,124, 55, 86,140, 63,
+        195, 75,227,111,251, 29,140, 49,222, 23,242, 93,  9, 60, 79, 32,
+        165, 65, 24,138,198,156,109,  6,230, 91,165, 34, 93,178,  7,247,
+         78,177, 25, 68,236, 48,216, 99,  9,177, 62,149, 19,138,218, 98,
+        207,129,  2,149, 41,240,210,150, 57,220,173,241,152,202,224,103,
+        159, 31,187, 47,169, 99,233,116, 85,146, 40,169,201,129,230,194,
+        120,211,108,235, 70, 44,222,187,142,196, 54,207,150,233, 66,110,
+         18,228,192,147,105,180,127,198,157,221, 34,244,181, 43,121, 24,
+         62,244, 90,222,186, 79,  6,113,192, 30,100, 76,  0,113, 23, 48,
+        239,136, 89,146,  8, 69,205, 17,174,208, 64,113,253, 47,150, 11,
+        247, 40,154, 28,175,125, 95, 63, 23,111,237, 73,118, 26,217,138,
+        161, 87,121, 41, 10,254, 32, 84, 54,136,107, 90,208, 66,239,198,
+        151,180, 27,114, 59,136,176, 91,249,134,204, 51,179,254,164,207,
+        120, 13,217,194,237,130,185, 42,125,239,  1,160, 81, 27,182, 89,
+        143, 75,201, 90,255, 13,214,164,246, 43,133,  3,189, 88,173, 37,
+        201, 56,241,206,166, 65,144,212, 17,237,170,  0,129,161, 87,  8,
+        107, 52,211,165,255, 17,205, 44, 70, 19,157,226,126, 43, 93, 67,
+        180, 79, 51,114, 32, 87,156,221,100, 74,190,131,212,104,222, 57,
+          5,229,169, 51,134,185, 36,139, 86,181,219,152,210, 51,127,253,
+        100,  3,153, 75,113,222, 98,178,117, 73,193, 52,252, 28,185,136,
+        233, 78,131, 39, 95,150,232,127,168,236,107, 84, 28,199,141, 18,
+        244,153,229,174, 64,253, 14, 60,146, 28,224, 54, 15,170,128,191,
+         97,124, 23,103,219, 76,114,206,  9, 66, 96, 31,108,235, 12, 70,
+        166,226,133, 23,187, 46,  4,243,159, 40,227,145, 77,115,220, 43,
+        195,158, 13,228,199, 75, 26, 99,212,  4, 58,188,151,234,105,215,
+         40,127,  2,102,213,167,116,197,245,173,108,157,247, 68, 36,238,
+         53,212,181,144,  0,236, 55,152,230,129,249,162, 61,178,139,193,
+        115, 49,209, 94,249,129,202, 61, 90,131, 20, 97,202,169, 62,100,
+         21,244,112,174, 56,122,187, 47,143,178,119,218, 10, 54, 75,161,
+        190, 88,203,149, 21,136, 46, 94,  6, 81, 39,137, 91,201,115,156,
+         82, 30,250, 62,193,163,100, 25,175, 44,195, 18,227, 83, 36,242,
+         16, 80,178, 37,161, 70,148, 29,232,185,217,162, 38,  5,246,145,
+        178, 53, 88,141,  2,216,160,242, 72, 35,252, 79,132,173,248, 14,
+        116, 62,245, 44, 76,231,179,219,130,204,231,180, 25,223,  9,186,
+        136,165,109, 87, 37,129,246,199, 91,121, 76,145,111,204,158, 98,
+        218,145,238,121, 11,227,103,171,116,  7, 59,109,233,128,207, 72,
+        118,219, 31,190,251, 85, 24,113,199, 94,157, 21,193,110, 42,138,
+        209, 29,175, 99,194,111, 31, 61,159, 21, 67,120, 51,145, 74,245,
+        203, 16,233,147,221, 18, 74, 51,218, 14,170,214, 48,  1,128, 54,
+        173, 25, 63,204, 86,188, 44,247, 76,197,139, 80,179, 50, 94, 13,
+        197,153,236, 68,109,152, 60,230, 14,135,225, 62,214, 92,229,183,
+         84,232,130,158,  5,250,151, 90,240,188,102,254,196,167,106, 43,
+        122, 71, 49,200,169,114,185,156,135,254, 36, 97,233,184,248, 76,
+        198,135,104,168, 54,215,131, 22,152,222, 36,254, 24,147,229,167,
+         42,101, 16,135, 43,182,209,126,170, 51,184,114, 33,160,  7, 59,
+        153, 17, 50,220, 65,125,205, 11,123, 44,142,  4, 84,215, 19,226,
+         96,185,132, 11, 81, 44,227,  3,106, 66,202,125, 62,142, 25,116,
+         42,232, 14,255,142,  1, 99,182, 51, 95,162,205,116,191, 65,131,
+        216, 80,172,206,229,  6, 96, 36, 79,239,  1,148,245, 70,205,125,
+        252,108,202, 91,174, 39, 77,228,169, 70,217,158, 37,133, 63,174,
+          2,253,215,102,242,142,196, 89,234,181,154, 10,175, 83,222,164,
+        214, 89,186, 37,114,163,232, 71,241,122, 11, 60, 92,  2,242, 30,
+        112,248, 56,115, 76,163,249,145,192,105,210, 84,131,182,101, 39,
+        168, 73,146, 27,244,139,191,108, 28,197, 97,233,185,109,239,149,
+         87, 37,155, 59,176, 31, 63,130, 28, 48, 86,243, 33,197,101,  5,
+         64,126,155, 73,220, 58,193,135, 19,211,187,138,222,173, 79,150,
+        185,  9,143,189, 22,132, 63,218, 20, 59,161, 27, 49,233, 21,217,
+        189,  2,234,195,104, 14,161, 47,250,128, 16, 56, 78, 22,193, 52,
+        170,204,112, 20,212,119,237,171,210,147,224,110,132, 46,251,146,
+        190, 28,243,100,202, 24, 92, 39,174,103, 73,248, 40,124,210, 50,
+         96,214, 38,232, 93,203, 34,113,172,128,254,196,115,165,141, 90,
+         52,112,133, 44, 80,223, 61,207, 81,152,178,118,248,141,220,124,
+        234, 62,138,246, 91,161,  6,107, 78, 13,185, 63,213,157, 71,114,
+        209, 54,175,  7,148,121,250,155,225, 52,151, 26,164,103, 16,233,
+        166, 71,123,159, 53,245,180, 83,235,  8, 95, 73,219,  5, 66,247,
+        155,224, 69,179,154,117,182,133,  0,232, 36,204,161, 44, 98, 15,
+        188, 83, 11,180, 40, 73,203, 51,250,137, 98, 27,174,  9,225, 22,
+         91,232,135, 68,228, 51,183, 74,  3,116,235, 88,203, 58,192,130,
+         28,255,202,  0,108,149, 14,138, 47,189,153, 36,174,107,205,125,
+         16,200, 30,254, 10,236, 29, 94,218,111, 64, 92,  7,210, 70,151,
+         34,121,229,149,195,129,232,150,190, 37,205,238,119, 83,186,131,
+        163, 35,111,199,167, 15,107,209,142,195,170, 11,135,245, 81,154,
+        111, 56, 88,176,226, 73,199,103,215, 67,226,140,241, 55,183, 38,
+         81,170, 99,138, 85, 56,202,146, 46,167,188,239,134,177,108,249,
+        166,214, 52,106, 63, 24, 97, 16,117, 88,157, 54,142, 35,244, 53,
+        206, 76,251, 21, 87,132,240, 29, 94, 45, 68,211,112, 36,172,  5,
+        213,184,145, 25,131, 43,239, 29,167,120, 23,104, 14, 90,138,238,
+        219,118, 51,187,217,109,165, 74,248, 17,121, 32, 79,221, 20, 58,
+        138, 94,  5,205,254,161,220,175, 64,242,  7,224,100,201,153,105,
+          1,181,144, 49,223,190, 61,172,224,123,253, 23,148,225, 69,236,
+         97, 42,243, 67,216, 95,182,150, 84,244, 53,201,164,211, 26, 62,
+        152,  4,210,158, 25,233,  6,130,192, 86,157,199, 53,153,117,194,
+         25,242,174,118, 35, 82,132, 45,193,127,165, 72,178, 20, 64,230,
+        125,214, 95,164,120, 39,154, 77, 12,192,159, 85,187,102, 47,196,
+        137, 16,116,200,163, 15,124, 60,  7,208,183,130, 71,246,114,176,
+         94,235, 77, 41,125, 71,177, 39,226, 58,215,101,255,  2,231, 83,
+        160, 45, 75,147,188,234,  0,207, 85, 29,216, 41,120,255, 89,169,
+         45, 24, 63,242,  7,211,104,246,138, 96, 34, 59,218,  9,123,160,
+         78,221,155, 86, 49,249,190,226,106,142, 37, 97,  1,148, 44,198,
+         19,131,192,103,245,147,203, 95,116, 12,143, 27,128,181, 64,207,
+        102,221,195, 16,101, 54,155,112,248,148,104,190,140,209, 13,144,
+        188,221,111,195, 82,135, 23,196, 50,220,172,111,140,241,177, 30,
+        252, 60,185, 30,143,110, 75, 35,172,254, 66,231,178,218, 82,141,
+        253, 52,162, 10,212, 53, 22,251,164,186,232, 75,168, 93, 35,133,
+          7,120, 59,248,137,213, 72,173, 22, 60,229,  4, 79, 51,109,236,
+         69,132,156, 33,178,236, 69,168,115,  0,236,197, 20, 64, 90,202,
+        113, 10, 98,235,203,  2,220,154, 89, 13,119,161, 54,107, 30,208,
+         71,113,222, 89,171,119, 84,141, 65, 43,105,202, 48,219,245,186,
+         79,230,157, 87, 37,181, 12,223,131,201, 92,156,240,173,200, 34,
+         96,  4,251, 57,107,149, 44,213, 88,147, 54, 82,158,212,133, 48,
+        147,215,166,127, 66,176,132, 52,195,217,139, 26,196,243,124,166,
+         12,188, 38,139, 28,193,236,  1,217,129,243, 10,156,118, 21,148,
+         42,175, 18,206,123,237,103, 83, 46,166, 33,127, 64, 22,147,123,
+        223,176, 88,210, 11,224,127, 16,255,190,130, 29,247,110,  3,235,
+        187, 26, 79, 42,246, 23, 93,240, 30, 71,100,227, 85,  9, 63,225,
+         91,148,243, 78,228, 59,152,108,180, 32, 71,141,195, 86, 60,208,
+        253,134,111, 53,164, 27,141,194,253,114,232,182,211,101,250, 58,
+        194, 43,137,163, 74,187, 93,161, 38, 70,228, 97,183, 42,169, 86,
+         57,123,228,194,106,160,209,120,184,151,173, 46,188,155,133,179,
+         49,206,122,  5,177, 98, 43,201, 81,167,212,100, 40,235,164, 99,
+         12, 70,185,241, 79,221, 61,157,  7, 75, 20, 86, 44,164, 12, 84,
+        157, 18,237,117, 31,243, 59,207,120,174,  7,149,206, 73,221,140,
+        245,102,155,  7,136, 45, 77, 15, 58,234,  5,126,252,101, 35,236,
+         16,104, 64,156,216,131,250, 14,228,116, 18,251,180,  3,126,191,
+        146,224, 33, 99,  2,200,115, 38,181,219,148,196,119,228,138,213,
+        112, 68,202, 50,174,106,146, 22,240,103,217, 57,124, 13,114, 32,
+        176, 19,213, 72,187,224,167,249,135,105, 80,208, 22, 70,199,117,
+        159,249,184, 41, 83, 23,162, 67,139, 45,158, 59,136, 76,228, 52,
+         87,159,206,121,144,170, 91,244,128,100, 55,247,  1, 67,178, 33,
+        244,171, 94,133,215,  8,196, 82, 48,158, 31, 84,180,252,160, 67,
+        198, 49, 93,255, 31,115, 94,197, 39,219,186, 49,145,172,218, 56,
+         84, 28,136,230,197,117,181, 99,193,238, 89,204,106,213, 34,115,
+        196, 21, 57,250, 40,223, 16, 59,211, 26,171,136, 93,192,105, 53,
+        127,  6,225, 27, 77,249,129,178,224,135,197,235,142, 45,212,103,
+        233,151,122,169, 60,144,  0, 68,155, 20,163,112,230, 91,  2,140,
+        191,221, 98, 10, 62,242, 48,217,  6,123, 31,176, 16,148,173,247,
+         72,132,177, 85,189, 69,132,197,159, 81,231, 43,214, 23,234,158,
+        198, 83,145,186,157, 61, 38, 98, 10, 72,115, 19,100, 75, 25,133,
+          3, 78,191, 17,210,229,177,238,121, 89,244, 62, 33,128,246, 39,
+        165, 68,123,171,146, 91, 29,151, 78,167,223, 69,241, 49, 94,  5,
+        215,102,234,  8,110,154,241, 35,105,  9,191,124,163, 76,139, 13,
+         64,251, 37,104,234,117,203,164,245,184, 56,211,162,190,239,171,
+        204, 38,237,102,126, 35, 86, 49,201,143,  8,207,168,196, 73,108,
+        206, 17,255, 43,205,225,133,184,251, 55,107,139,194,119,226,164,
+         32,150, 45,167,209, 21, 86,181,122,252, 66, 98, 31,246,110,220,
+        172,118,208, 55,  0,218, 24,139, 80, 32,150,242,  8,119, 56, 85,
+        112,141, 55,162, 72,197,159,110, 28,222, 76,133, 99, 13,155,237,
+         55,150,180, 80,111,  1, 65,102, 18,207,159,  9, 38, 82,137, 61,
+        244,121,193, 64,129,226, 55,145,221, 46,150,208,180, 56,201, 38,
+         94, 20,165,141, 88,174, 65,107,227,200,125, 89, 42,226,154, 31,
+        251,211,180,  7,243,139, 13,253,184, 53,174,248, 46,227,122, 27,
+         92,118,233, 29,191,156,243,197,127, 45, 87,214,246,188, 21,206,
+         89, 10, 79,255, 29, 96,194,  0, 77,171, 24,237, 10,143, 82,128,
+        189,227, 74,239,194,122,254, 47,161,  4, 60,181,141,203,104,176,
+         17, 70, 97,219, 46, 90,209, 67,148,122, 93, 22,191, 62,172,219,
+        189,  8, 62,140,219, 54, 90, 34,149,234,179,121, 68,149,109,174,
+        130,163,214,111,142,166,234,118,211,102,133, 68,116,172,233,  4,
+        153, 48,133, 14, 41,154, 20,183, 92,220,112,247, 77, 12, 67,196,
+        137,117, 33,152,123,182, 29,100,231,  4,219,160,107,138, 80, 40,
+        145,210,167, 95,124, 14,166,223, 72,105, 17, 56,169,  1,237, 50,
+         32,239, 55, 19,184, 43, 69, 18,183, 41,223,194, 92, 45,206, 68,
+        252, 92,199,110, 67,212, 81,235,131, 37,157, 22,212,131,240, 47,
+        225,167,247,197, 74,229,136,169, 43,201, 77, 35,238,204,  1,241,
+        109, 75,249, 37,181,234,109,188, 24,196,254,137,216,101, 77,201,
+        181, 94,151,204, 80,242,133,160,251, 82,148, 15,247,155, 28,109,
+        166, 24,220,144,243,173,113, 11,205, 69,194, 97,172, 38,159, 98,
+          1, 85, 57, 23,108,  5, 59,243,113,143,182,129, 55,155, 91,184,
+         50,132, 20,199, 58, 78,142, 46,128,158, 91, 42,186, 26,227,145,
+          8, 70,229,119,  5,192, 93, 53,112, 26,189, 60,120,215, 78,194,
+        125, 60,181,  3, 95, 30,140, 58,152,250,124, 50,229, 82,119,188,
+        216,146,184,234,162,212,187, 85, 13, 64,250,100, 15,224,120, 30,
+        206,159,224,117,153,246,  3,216, 66,204, 13,230,113,160, 48,117,
+        191,137, 30,168,102,215, 32,176,207,136,237,101,179,  6,140,241,
+         41,232, 83,158, 50,200,230,186, 33, 86,  3,184,143, 13,253, 25,
+         65,114, 40, 97,140, 47,119,150,223,171, 24,215,193, 74,173,254,
+         97, 67,  6, 88, 31,189, 93,168,240,118, 82,149, 63,209, 81,248,
+        100,217, 47,250,142, 60,152,240,  3, 71,161, 32,228, 53, 94,175,
+         12,136,208,113,249,127, 74,102,217,163,238,105,216, 71,198,137,
+        174,243,203, 17, 79,255, 19,203, 41, 93,122,154, 36,140, 57, 12,
+        135,185,239,170,213,126, 41,107, 26, 51,183,245,  4,175,130, 21,
+        150, 64,177, 85, 15,229, 78,123,105, 46,213, 85,128,163,203, 69,
+        107,187, 65, 29,177,  8,167, 19,120, 40,132, 56, 27,168, 98, 51,
+         30, 87,129,165,218,178, 69,103,240,191, 51, 80,246,110,228,166,
+        216, 38,111, 56,141, 70,231,193,143,217,126, 35,101,224, 39,201
+    };
+
+    // No dithering: thresholds of 0.5 at a scale of 1, i.e. rounding. A tile of one would do,
+    // but chunks as wide as the tile keep the inner loop of encode_ordered_row() long enough
+    // to vectorize.
+    static constexpr std::uint8_t none_64x64[64*64] = {};
+
+
+    // floor(v*(2^Bits-1) + t) for v clamped to [0..1] and t in (0..1).
+    template <unsigned Bits>
+    inline std::int32_t quantize_dithered (float v, float t) noexcept
+    {
+        return std::int32_t(v * float((1u << Bits) - 1) + t);
+    }
+
+    inline float clamp01 (float v) noexcept
+    {
+        v = select(v > 0, v, 0.f); // also maps NaN to 0
+        return select(v < 1, v, 1.f);
+    }
+
+
+    // Pixels [0..n) of a row, as 3n floats in, 3n codes out; 'thresholds' is one tile row
+    // with the threshold of every pixel repeated for its three channels.
+    template <unsigned Bits, typename Gamma>
+    inline void encode_ordered_row (float const *in, std::size_t n,
+                                    float const *thresholds, std::size_t tile_width,
+                                    typename unorm<Bits>::storage_type *out,
+                                    Gamma const &gamma) noexcept
+    {
+        using storage_type = typename unorm<Bits>::storage_type;
+
+        // Chunks aligned to the tile, so that the inner loop reads thresholds contiguously.
+        std::size_t x = 0;
+        while (x != n) {
+            const std::size_t tx = x % tile_width;
+            const std::size_t m = std::min(n - x, tile_width - tx);
+            float const *f = in + 3*x;
+            float const *t = thresholds + 3*tx;
+            storage_type *o = out + 3*x;
+            const std::ptrdiff_t count = 3*m;
+
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<count; ++i)
+                o[i] = storage_type(quantize_dithered<Bits>(
+                            to_nonlinear_approx(gamma, clamp01(f[i])), t[i]));
+            x += m;
+        }
+    }
+
+
+    // The rows to encode, as linear floats, three per pixel. 'rows(y, scratch)' returns row y;
+    // sources that compute their rows (e.g. tonemap_encode()) write them into 'scratch', which
+    // holds rows.scratch_size() floats.
+    struct channel_rows {
+        ImageView<float const> in;   // three times as wide as the image
+        std::size_t scratch_size () const noexcept { return 0; }
+        float const* operator() (std::size_t y, float *) const noexcept { return in.row(y); }
+    };
+
+
+    // 'out' is a view of channels, i.e. three times as wide as the image.
+    template <unsigned Bits, typename Rows, typename Gamma>
+    inline void encode_ordered (Rows const &rows, ImageView<typename unorm<Bits>::storage_type> out,
+                                std::uint8_t const *tile, std::size_t tile_size, float tile_scale,
+                                Gamma const &gamma)
+    {
+        const long height = static_cast<long>(out.height);
+        const std::size_t width = out.width / 3;
+
+        #pragma omp parallel
+        {
+            std::vector<float> thresholds (3*tile_size), scratch (rows.scratch_size());
+            #pragma omp for schedule(static)
+            for (long y=0; y<height; ++y) {
+                std::uint8_t const *tile_row = tile + (y % tile_size) * tile_size;
+                for (std::size_t x=0; x!=tile_size; ++x)
+                    thresholds[3*x] = thresholds[3*x+1] = thresholds[3*x+2]
+                                    = (tile_row[x] + 0.5f) * tile_scale;
+                encode_ordered_row<Bits>(rows(y, scratch.data()), width, thresholds.data(),
+                                         tile_size, out.row(y), gamma);
+            }
+        }
+    }
+
+
+    template <unsigned Bits, typename Rows, typename Gamma>
+    inline void encode_floyd_steinberg (Rows const &rows,
+                                        ImageView<typename unorm<Bits>::storage_type> out,
+                                        Gamma const &gamma)
+    {
+        using storage_type = typename unorm<Bits>::storage_type;
+        const float max = float((1u << Bits) - 1);
+        const std::ptrdiff_t w = static_cast<std::ptrdiff_t>(out.width / 3);
+
+        // Errors for the current and the next row, with one pixel of padding at either end.
+        std::vector<float> value (3*w), err_cur (3*(w+2)), err_next (3*(w+2)),
+                           scratch (rows.scratch_size());
+
+        for (std::size_t y=0; y!=out.height; ++y) {
+            float const *f = rows(y, scratch.data());
+            const std::ptrdiff_t count = 3*w;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<count; ++i)
+                value[i] = to_nonlinear_approx(gamma, clamp01(f[i])) * max;
+
+            std::fill(err_next.begin(), err_next.end(), 0.f);
+            storage_type *o = out.row(y);
+            const bool reverse = y & 1;
+            const std::ptrdiff_t dir = reverse ? -1 : 1;
+
+            for (std::ptrdiff_t k=0; k!=w; ++k) {
+                const std::ptrdiff_t x = reverse ? w-1-k : k;
+                for (int c=0; c!=3; ++c) {
+                    const float v = value[3*x+c] + err_cur[3*(x+1)+c];
+                    float q = float(std::int32_t(v + 0.5f));
+                    q = v < 0 ? 0 : q > max ? max : q;
+                    o[3*x+c] = storage_type(q);
+
+                    const float e = v - q;
+                    err_cur [3*(x+1+dir)+c] += e * (7/16.f);
+                    err_next[3*(x+1-dir)+c] += e * (3/16.f);
+                    err_next[3*(x+1)    +c] += e * (5/16.f);
+                    err_next[3*(x+1+dir)+c] += e * (1/16.f);
+                }
+            }
+            err_cur.swap(err_next);
+        }
+    }
+
+} }
+
+
+namespace tukan {
+
+    namespace detail {
+        template <unsigned B, template <typename> class S>
+        inline void encode_dithered (ImageView<LinearRGB<float,S> const> in,
+                                     ImageView<RGB<unorm<B>,S>> out, Dither method)
+        {
+            using storage_type = typename unorm<B>::storage_type;
+            static_assert(sizeof(LinearRGB<float,S>) == 3*sizeof(float) &&
+                          sizeof(RGB<unorm<B>,S>) == 3*sizeof(storage_type),
+                          "encode: pixels must be three channels without padding");
+
+            if (!same_extent(in, out))
+                throw std::logic_error("encode: input and output differ in extent");
+
+            // Views of the channels.
+            const channel_rows fin {{reinterpret_cast<float const*>(in.data),
+                                     3*in.width, in.height, 3*in.stride}};
+            const ImageView<storage_type> fout (reinterpret_cast<storage_type*>(out.data),
+                                                3*out.width, out.height, 3*out.stride);
+            const auto gamma = S<float>().gamma;
+
+            static const profile::Site sites[] = {
+                {"encode", "none"}, {"encode", "bayer"}, {"encode", "blue_noise"},
+                {"encode", "floyd_steinberg"}
+            };
+            const std::uint64_t pixels = std::uint64_t(in.width) * in.height;
+            const profile::Scope scope (sites[int(method)], pixels,
+                                        pixels * (sizeof(LinearRGB<float,S>) + sizeof(RGB<unorm<B>,S>)));
+
+            switch (method) {
+            case Dither::none:
+                encode_ordered<B>(fin, fout, none_64x64, 64, 1.f, gamma);
+                break;
+            case Dither::bayer:
+                encode_ordered<B>(fin, fout, bayer_8x8, 8, 1/64.f, gamma);
+                break;
+            case Dither::blue_noise:
+                encode_ordered<B>(fin, fout, blue_noise_64x64, 64, 1/256.f, gamma);
+                break;
+            case Dither::floyd_steinberg:
+                encode_floyd_steinberg<B>(fin, fout, gamma);
+                break;
+            }
+        }
+    }
+
+
+    template <typename In, typename Out>
+    inline void encode (ImageView<In> in, ImageView<Out> out, Dither method)
+    {
+        detail::encode_dithered(ImageView<typename std::remove_const<In>::type const>(in), out,
+                                method);
+    }
+
+}
+
+#endif // DITHER_HH_INCLUDED_20261018
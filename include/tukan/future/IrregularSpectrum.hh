@@ -0,0 +1,265 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef IRREGULARSPECTRUM_HH_INCLUDED_20261018
+#define IRREGULARSPECTRUM_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "../Interval.hh"
+#include "../Nanometer.hh"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// IrregularSpectrum:
+//
+//    A spectrum given as samples at arbitrary, strictly increasing wavelengths, as delivered by
+//    spectrophotometers or LED datasheets. Like Spectrum, it is read as the piecewise linear
+//    function through its samples, see IrregularInterpolator.
+//
+//    To avoid a binary search per lookup, the constructor lays a uniform grid over
+//    [lambda_min..lambda_max] with two cells per sample. Each cell stores the first segment
+//    reaching into it, so a lookup is a multiplication plus, on average, less than one step
+//    forward.
+//
+//
+// Definitions:
+//
+//    IrregularSpectrum (Cont const &samples)     Cont of SpectrumSample; throws std::logic_error
+//                                                if there are fewer than two samples or the
+//                                                wavelengths are not strictly increasing
+//
+//    IrregularInterpolator (IrregularSpectrum const &spec)
+//    SpectrumSample operator() (Nanometer g)       const
+//    SpectrumSample operator() (float f)           const     f in [0..1]
+//    SpectrumSample operator() (Interval<float> r) const     average over r, r in [0..1]
+//    void           operator() (Nanometer const *first, Nanometer const *last, float *out) const
+//
+//
+// Examples:
+//
+//    std::vector<SpectrumSample> led {{400_nm, 0.0f}, {447_nm, 1.0f}, {462_nm, 0.3f}, ...};
+//    IrregularSpectrum spec (led);
+//    float a = IrregularInterpolator(spec)(450_nm).amplitude;
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    //----------------------------------------------------------------------------------------------
+    // IrregularSpectrum
+    //----------------------------------------------------------------------------------------------
+    class IrregularSpectrum {
+    public:
+        template <typename Cont>
+        IrregularSpectrum (Cont const &samples);
+
+        Nanometer lambda_min() const noexcept ;
+        Nanometer lambda_max() const noexcept ;
+
+        std::size_t size() const noexcept ;
+        bool empty() const noexcept ;
+
+        SpectrumSample operator[] (std::size_t i) const noexcept ;
+        SpectrumSample at (std::size_t i) const ;
+
+        // Index i of the segment [i, i+1] containing 'lambda', which must be in range.
+        std::size_t segment (float lambda) const noexcept ;
+
+    private:
+        void build_grid();
+
+        std::vector<float> lambdas_, amplitudes_;
+        std::vector<std::size_t> grid_;
+        float grid_scale_ = 0;
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // IrregularInterpolator
+    //----------------------------------------------------------------------------------------------
+    struct IrregularInterpolator {
+
+        IrregularInterpolator (IrregularSpectrum const &spec) : spec(&spec) {}
+
+        SpectrumSample operator() (Interval<float> r) const ;
+        SpectrumSample operator() (float f)           const ;
+        SpectrumSample operator() (Nanometer g)       const ;
+
+        void operator() (Nanometer const *first, Nanometer const *last, float *out) const ;
+
+    private:
+        float at (float lambda) const noexcept ;
+        float integral (float a, float b) const noexcept ;
+
+        IrregularSpectrum const *spec;
+    };
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    // IrregularSpectrum
+    template <typename Cont>
+    IrregularSpectrum::IrregularSpectrum (Cont const &samples)
+    {
+        for (SpectrumSample const &s : samples) {
+            const float l = static_cast<float>(s.wavelength);
+            if (!lambdas_.empty() && !(lambdas_.back() < l))
+                throw std::logic_error("IrregularSpectrum: wavelengths must be strictly increasing");
+            lambdas_.push_back(l);
+            amplitudes_.push_back(s.amplitude);
+        }
+        if (lambdas_.size() < 2)
+            throw std::logic_error("IrregularSpectrum: at least two samples are needed");
+        build_grid();
+    }
+
+
+    inline void IrregularSpectrum::build_grid()
+    {
+        const std::size_t cells = 2*lambdas_.size();
+        const float lmin = lambdas_.front(), lmax = lambdas_.back();
+        grid_scale_ = cells / (lmax - lmin);
+        grid_.resize(cells);
+
+        std::size_t seg = 0;
+        for (std::size_t c=0; c!=cells; ++c) {
+            const float cell_min = lmin + c / grid_scale_;
+            while (seg+2 < lambdas_.size() && lambdas_[seg+1] <= cell_min)
+                ++seg;
+            grid_[c] = seg;
+        }
+    }
+
+
+    inline Nanometer IrregularSpectrum::lambda_min() const noexcept {
+        return Nanometer(lambdas_.front());
+    }
+
+
+    inline Nanometer IrregularSpectrum::lambda_max() const noexcept {
+        return Nanometer(lambdas_.back());
+    }
+
+
+    inline std::size_t IrregularSpectrum::size() const noexcept {
+        return lambdas_.size();
+    }
+
+
+    inline bool IrregularSpectrum::empty() const noexcept {
+        return lambdas_.empty();
+    }
+
+
+    inline SpectrumSample IrregularSpectrum::operator[] (std::size_t i) const noexcept {
+        return SpectrumSample(Nanometer(lambdas_[i]), amplitudes_[i]);
+    }
+
+
+    inline SpectrumSample IrregularSpectrum::at (std::size_t i) const {
+        if (i>=size())
+            throw std::out_of_range("passed value outside range to IrregularSpectrum::at(size_t)");
+        return (*this)[i];
+    }
+
+
+    inline std::size_t IrregularSpectrum::segment (float lambda) const noexcept
+    {
+        std::size_t c = static_cast<std::size_t>((lambda - lambdas_.front()) * grid_scale_);
+        if (c >= grid_.size()) c = grid_.size()-1;
+        std::size_t i = grid_[c];
+        while (i+2 < lambdas_.size() && lambdas_[i+1] < lambda)
+            ++i;
+        return i;
+    }
+
+
+
+    // IrregularInterpolator
+    inline float IrregularInterpolator::at (float lambda) const noexcept
+    {
+        const std::size_t i = spec->segment(lambda);
+        const SpectrumSample a = (*spec)[i], b = (*spec)[i+1];
+        const float la = static_cast<float>(a.wavelength), lb = static_cast<float>(b.wavelength);
+        const float frac = (lambda - la) / (lb - la);
+        return a.amplitude*(1-frac) + b.amplitude*frac;
+    }
+
+
+    inline float IrregularInterpolator::integral (float a, float b) const noexcept
+    {
+        // Trapezoids over the samples between a and b, plus the partial segments at the ends.
+        std::size_t i = spec->segment(a);
+        float sum = 0, l = a, v = at(a);
+        while (i+1 < spec->size() && static_cast<float>((*spec)[i+1].wavelength) < b) {
+            const SpectrumSample s = (*spec)[i+1];
+            const float ls = static_cast<float>(s.wavelength);
+            sum += 0.5f * (v + s.amplitude) * (ls - l);
+            l = ls;
+            v = s.amplitude;
+            ++i;
+        }
+        return sum + 0.5f * (v + at(b)) * (b - l);
+    }
+
+
+    inline SpectrumSample IrregularInterpolator::operator() (Nanometer g) const
+    {
+        if (g<spec->lambda_min()) throw std::logic_error("passed value < lambda_min to "
+                                                         "IrregularSpectrum::operator()(Nanometer)");
+        if (g>spec->lambda_max()) throw std::logic_error("passed value > lambda_max to "
+                                                         "IrregularSpectrum::operator()(Nanometer)");
+        return SpectrumSample(g, at(static_cast<float>(g)));
+    }
+
+
+    inline SpectrumSample IrregularInterpolator::operator() (float f) const
+    {
+        if (f<0) throw std::logic_error("passed value < 0 to IrregularSpectrum::operator()(float)");
+        if (f>1) throw std::logic_error("passed value > 1 to IrregularSpectrum::operator()(float)");
+        const Nanometer g = spec->lambda_min() + f*(spec->lambda_max() - spec->lambda_min());
+        return SpectrumSample(g, at(static_cast<float>(g)));
+    }
+
+
+    inline SpectrumSample IrregularInterpolator::operator() (Interval<float> r) const
+    {
+        if (r.min<0) throw std::logic_error("passed value < 0 to "
+                                            "IrregularSpectrum::operator()(Interval<float>)");
+        if (r.max>1) throw std::logic_error("passed value > 1 to "
+                                            "IrregularSpectrum::operator()(Interval<float>)");
+        if (r.min == r.max)
+            return (*this)(r.min);
+
+        const float lmin = static_cast<float>(spec->lambda_min()),
+                    range = static_cast<float>(spec->lambda_max()) - lmin,
+                    a = lmin + r.min*range,
+                    b = lmin + r.max*range;
+        return SpectrumSample(Nanometer(0.5f*(a+b)), integral(a, b) / (b-a));
+    }
+
+
+    inline void IrregularInterpolator::operator() (Nanometer const *first, Nanometer const *last,
+                                                   float *out) const
+    {
+        for (; first!=last; ++first, ++out) {
+            if (*first<spec->lambda_min() || *first>spec->lambda_max())
+                throw std::logic_error("passed value outside [lambda_min..lambda_max] to "
+                                       "IrregularSpectrum::operator()(Nanometer*,Nanometer*,float*)");
+            *out = at(static_cast<float>(*first));
+        }
+    }
+
+} }
+
+#endif // IRREGULARSPECTRUM_HH_INCLUDED_20261018
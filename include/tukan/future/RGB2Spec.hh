@@ -0,0 +1,550 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef RGB2SPEC_HH_INCLUDED_20261018
+#define RGB2SPEC_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "cie1931.hh"
+#include "../LinearRGB.hh"
+#include "../algorithm/lerp.hh"
+#include "../detail/Matrix33.hh"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// RGB2Spec:
+//
+//    Upsampling of RGB colors to smooth reflectance spectra, following
+//
+//      Wenzel Jakob and Johannes Hanika. 2019. "A Low-Dimensional Function Space for
+//      Efficient Spectral Upsampling". Computer Graphics Forum 38(2).
+//
+//    Each reflectance is represented by three coefficients of a sigmoid-wrapped quadratic
+//
+//        s(l) = S(c0*l*l + c1*l + c2),   S(x) = 1/2 + x / (2*sqrt(1+x*x))
+//
+//    The coefficients for all RGB colors of a color space are found offline (see
+//    'optimize_rgb2spec_table' and tools/rgb2spec_opt.cc) and stored in a 3D table, which is
+//    looked up with trilinear interpolation.
+//
+//
+// Binary table format (native byte order, checked on load):
+//
+//    offset  size           content
+//    - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//    0       4              magic "TKRS"
+//    4       4              uint32 version (1)
+//    8       4              uint32 resolution (res, 2..4096)
+//    12      4              uint32 byte order mark (0x01020304)
+//    16      4*res          float z-scale
+//    ...     4*9*res^3      float coefficients [3][res][res][res][3]
+//
+//    The format does not need any parsing, 'RGB2SpecTable::from_memory' can point directly
+//    into a memory mapped file.
+//
+//
+// Examples:
+//
+//    auto table = optimize_rgb2spec_table<sRGB>(64);
+//    auto coeffs = table(LinearRGB<float, sRGB>(0.2, 0.5, 0.1));
+//    float reflectance = coeffs(550_nm);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    //----------------------------------------------------------------------------------------------
+    // RGB2SpecCoefficients
+    //----------------------------------------------------------------------------------------------
+    struct RGB2SpecCoefficients {
+        // Polynomial coefficients, with wavelengths given in nanometers.
+        float c0 = 0, c1 = 0, c2 = 0;
+
+        constexpr RGB2SpecCoefficients() = default;
+        constexpr RGB2SpecCoefficients(float c0, float c1, float c2) : c0(c0), c1(c1), c2(c2) {}
+
+        float operator() (Nanometer lambda) const noexcept ;
+    };
+
+    Spectrum to_spectrum (RGB2SpecCoefficients const &coeffs,
+                          Nanometer lambda_min, Nanometer lambda_max, std::size_t bins);
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // RGB2SpecTable
+    //----------------------------------------------------------------------------------------------
+    class RGB2SpecTable {
+    public:
+        // Construction. 'from_memory' does not copy, the memory must outlive the table.
+        static RGB2SpecTable from_memory (void const *data, std::size_t bytes);
+        static RGB2SpecTable read (std::istream &is);
+        void write (std::ostream &os) const;
+
+        std::size_t resolution() const noexcept ;
+
+        // Lookup. Inputs are clamped to [0..1].
+        RGB2SpecCoefficients operator() (float r, float g, float b) const noexcept ;
+
+        template <typename T, template <typename> class RGBSpace>
+        RGB2SpecCoefficients operator() (LinearRGB<T, RGBSpace> const &rgb) const noexcept ;
+
+    private:
+        RGB2SpecTable (std::size_t res, float const *scale, float const *data,
+                       std::shared_ptr<std::vector<float>> storage);
+        static RGB2SpecTable owning (std::size_t res, std::shared_ptr<std::vector<float>> storage);
+
+        template <template <typename> class RGBSpace>
+        friend RGB2SpecTable optimize_rgb2spec_table (std::size_t resolution);
+
+        std::size_t res_;
+        float const *scale_;
+        float const *data_;
+        std::shared_ptr<std::vector<float>> storage_; // Empty for tables created by from_memory.
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // optimize_rgb2spec_table
+    //
+    //    Runs the Gauss-Newton optimization for each table entry. The residual is measured in
+    //    CIELAB, after adapting the color space's whitepoint to equal energy (Bradford), so that
+    //    RGB white maps to the constant 1 reflectance. Expensive, meant to be run offline.
+    //----------------------------------------------------------------------------------------------
+    template <template <typename> class RGBSpace>
+    RGB2SpecTable optimize_rgb2spec_table (std::size_t resolution);
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    namespace detail { namespace rgb2spec {
+
+        struct Header {
+            char          magic[4];
+            std::uint32_t version;
+            std::uint32_t resolution;
+            std::uint32_t byte_order;
+        };
+
+        static constexpr char          magic[4]   = {'T','K','R','S'};
+        static constexpr std::uint32_t version    = 1;
+        static constexpr std::uint32_t byte_order = 0x01020304;
+
+        // Far beyond any useful table (4096 is 2.5 TB); keeps the sizes of the header's
+        // resolution within std::size_t on 64 bit.
+        static constexpr std::uint32_t max_resolution = 4096;
+
+        inline std::size_t float_count (std::size_t res) noexcept {
+            return res + 9*res*res*res;
+        }
+
+        // Whether float_count(res) <= floats, without overflowing.
+        inline bool table_fits (std::size_t res, std::size_t floats) noexcept {
+            return res <= floats && (floats - res) / 9 / res / res >= res;
+        }
+
+        inline void check_header (Header const &header) {
+            if (std::memcmp(header.magic, magic, 4) != 0)
+                throw std::runtime_error("RGB2SpecTable: not an rgb2spec table");
+            if (header.version != version)
+                throw std::runtime_error("RGB2SpecTable: unsupported version");
+            if (header.byte_order != byte_order)
+                throw std::runtime_error("RGB2SpecTable: table was written with foreign byte order");
+            if (header.resolution < 2)
+                throw std::runtime_error("RGB2SpecTable: resolution must be at least 2");
+            if (header.resolution > max_resolution)
+                throw std::runtime_error("RGB2SpecTable: resolution is too large");
+        }
+
+        inline double sigmoid (double x) noexcept {
+            return 0.5 * x / std::sqrt(1.0 + x*x) + 0.5;
+        }
+
+        inline double smoothstep (double x) noexcept {
+            return x*x*(3.0 - 2.0*x);
+        }
+
+        // CIELAB relative to the equal energy white (1,1,1).
+        inline void xyz_to_lab (double const xyz[3], double lab[3]) noexcept {
+            auto f = [](double t) {
+                const double delta = 6.0/29.0;
+                return t > delta*delta*delta ? std::cbrt(t) : t/(3*delta*delta) + 4.0/29.0;
+            };
+            const double fx = f(xyz[0]), fy = f(xyz[1]), fz = f(xyz[2]);
+            lab[0] = 116*fy - 16;
+            lab[1] = 500*(fx - fy);
+            lab[2] = 200*(fy - fz);
+        }
+
+        struct Context {
+            tukan::detail::Matrix33<double> rgb_to_xyz_e;
+            double cmf[3][cie1931::size];   // Color matching functions, normalized to sum 1.
+            double lambda[cie1931::size];   // Wavelengths, normalized to [0..1].
+
+            explicit Context (tukan::detail::Matrix33<double> const &rgb_to_xyz)
+            {
+                using tukan::detail::Matrix33;
+
+                // Bradford chromatic adaptation from the space's whitepoint to E.
+                const Matrix33<double> bradford { 0.8951,  0.2664, -0.1614,
+                                                 -0.7502,  1.7135,  0.0367,
+                                                  0.0389, -0.0685,  1.0296};
+                const Matrix33<double> &m = rgb_to_xyz;
+                const double wx = m._11 + m._12 + m._13,
+                             wy = m._21 + m._22 + m._23,
+                             wz = m._31 + m._32 + m._33;
+                const double rho = bradford._11*wx + bradford._12*wy + bradford._13*wz,
+                             gam = bradford._21*wx + bradford._22*wy + bradford._23*wz,
+                             bet = bradford._31*wx + bradford._32*wy + bradford._33*wz;
+                const double e_rho = bradford._11 + bradford._12 + bradford._13,
+                             e_gam = bradford._21 + bradford._22 + bradford._23,
+                             e_bet = bradford._31 + bradford._32 + bradford._33;
+                const Matrix33<double> scale { e_rho/rho, 0, 0,
+                                               0, e_gam/gam, 0,
+                                               0, 0, e_bet/bet };
+                rgb_to_xyz_e = inverse(bradford) * scale * bradford * m;
+
+                double sum[3] = {0, 0, 0};
+                for (std::size_t i=0; i!=cie1931::size; ++i) {
+                    sum[0] += cie1931::x_bar[i];
+                    sum[1] += cie1931::y_bar[i];
+                    sum[2] += cie1931::z_bar[i];
+                }
+                for (std::size_t i=0; i!=cie1931::size; ++i) {
+                    cmf[0][i] = cie1931::x_bar[i] / sum[0];
+                    cmf[1][i] = cie1931::y_bar[i] / sum[1];
+                    cmf[2][i] = cie1931::z_bar[i] / sum[2];
+                    lambda[i] = double(i) / (cie1931::size-1);
+                }
+            }
+
+            void residual (double const coeffs[3], double const rgb[3], double out[3]) const noexcept
+            {
+                double xyz[3] = {0, 0, 0};
+                for (std::size_t i=0; i!=cie1931::size; ++i) {
+                    const double l = lambda[i];
+                    const double s = sigmoid((coeffs[0]*l + coeffs[1])*l + coeffs[2]);
+                    xyz[0] += s * cmf[0][i];
+                    xyz[1] += s * cmf[1][i];
+                    xyz[2] += s * cmf[2][i];
+                }
+
+                const auto &m = rgb_to_xyz_e;
+                const double target[3] = {
+                    m._11*rgb[0] + m._12*rgb[1] + m._13*rgb[2],
+                    m._21*rgb[0] + m._22*rgb[1] + m._23*rgb[2],
+                    m._31*rgb[0] + m._32*rgb[1] + m._33*rgb[2]
+                };
+
+                double lab_target[3], lab[3];
+                xyz_to_lab(target, lab_target);
+                xyz_to_lab(xyz, lab);
+                for (int j=0; j!=3; ++j)
+                    out[j] = lab_target[j] - lab[j];
+            }
+
+            // Gauss-Newton with a finite difference jacobian.
+            void gauss_newton (double const rgb[3], double coeffs[3]) const noexcept
+            {
+                const int    max_iterations = 15;
+                const double eps = 1e-5;
+
+                for (int it=0; it!=max_iterations; ++it) {
+                    double r[3];
+                    residual(coeffs, rgb, r);
+
+                    double J[3][3];
+                    for (int i=0; i!=3; ++i) {
+                        double lo[3] = {coeffs[0], coeffs[1], coeffs[2]},
+                               hi[3] = {coeffs[0], coeffs[1], coeffs[2]};
+                        lo[i] -= eps;
+                        hi[i] += eps;
+                        double r_lo[3], r_hi[3];
+                        residual(lo, rgb, r_lo);
+                        residual(hi, rgb, r_hi);
+                        for (int j=0; j!=3; ++j)
+                            J[j][i] = (r_hi[j] - r_lo[j]) / (2*eps);
+                    }
+
+                    // Solve J*x = r.
+                    const tukan::detail::Matrix33<double> Jm {J[0][0], J[0][1], J[0][2],
+                                                              J[1][0], J[1][1], J[1][2],
+                                                              J[2][0], J[2][1], J[2][2]};
+                    const double det = determinant(Jm);
+                    if (std::fabs(det) < 1e-15)
+                        break;
+                    const auto Ji = inverse(Jm);
+                    coeffs[0] -= Ji._11*r[0] + Ji._12*r[1] + Ji._13*r[2];
+                    coeffs[1] -= Ji._21*r[0] + Ji._22*r[1] + Ji._23*r[2];
+                    coeffs[2] -= Ji._31*r[0] + Ji._32*r[1] + Ji._33*r[2];
+
+                    // Keep the coefficients in a range where the sigmoid is well behaved.
+                    const double max_coeff = std::max(std::fabs(coeffs[0]),
+                                             std::max(std::fabs(coeffs[1]), std::fabs(coeffs[2])));
+                    if (max_coeff > 200) {
+                        for (int j=0; j!=3; ++j)
+                            coeffs[j] *= 200 / max_coeff;
+                    }
+
+                    if (r[0]*r[0] + r[1]*r[1] + r[2]*r[2] < 1e-6)
+                        break;
+                }
+            }
+        };
+
+        // Converts coefficients of the [0..1] parametrization to nanometers.
+        inline void store (double const coeffs[3], float *out) noexcept {
+            const double c0 = cie1931::lambda_min,
+                         c1 = 1.0 / (cie1931::lambda_max - cie1931::lambda_min);
+            const double A = coeffs[0], B = coeffs[1], C = coeffs[2];
+            out[0] = float(A*c1*c1);
+            out[1] = float(B*c1 - 2*A*c0*c1*c1);
+            out[2] = float(C - B*c0*c1 + A*c0*c0*c1*c1);
+        }
+
+        inline std::size_t find_interval (float const *scale, std::size_t res, float z) noexcept {
+            std::size_t lo = 0, count = res - 2;
+            while (count > 0) {
+                const std::size_t half = count / 2, mid = lo + half;
+                if (scale[mid+1] <= z) { lo = mid + 1; count -= half + 1; }
+                else                   { count = half; }
+            }
+            return lo;
+        }
+    } }
+
+
+
+    // RGB2SpecCoefficients
+    inline float RGB2SpecCoefficients::operator() (Nanometer lambda) const noexcept {
+        using std::fma; using std::sqrt; using std::isinf;
+        const float l = static_cast<float>(lambda);
+        const float x = fma(fma(c0, l, c1), l, c2);
+        if (isinf(x))
+            return x > 0 ? 1 : 0;
+        const float y = 1 / sqrt(fma(x, x, 1.0f));
+        return fma(0.5f*x, y, 0.5f);
+    }
+
+
+    inline Spectrum to_spectrum (RGB2SpecCoefficients const &coeffs,
+                                 Nanometer lambda_min, Nanometer lambda_max, std::size_t bins)
+    {
+        if (bins < 2)
+            throw std::logic_error("to_spectrum(RGB2SpecCoefficients,...) needs at least two bins");
+        std::vector<float> values(bins);
+        const Nanometer step = (lambda_max - lambda_min) / float(bins-1);
+        for (std::size_t i=0; i!=bins; ++i)
+            values[i] = coeffs(lambda_min + step*float(i));
+        return Spectrum(lambda_min, lambda_max, values);
+    }
+
+
+
+    // RGB2SpecTable
+    inline RGB2SpecTable::RGB2SpecTable (std::size_t res, float const *scale, float const *data,
+                                         std::shared_ptr<std::vector<float>> storage)
+    : res_(res), scale_(scale), data_(data), storage_(std::move(storage))
+    {}
+
+
+    inline RGB2SpecTable RGB2SpecTable::owning (std::size_t res,
+                                                std::shared_ptr<std::vector<float>> storage)
+    {
+        float const *scale = storage->data();
+        return RGB2SpecTable(res, scale, scale + res, std::move(storage));
+    }
+
+
+    inline RGB2SpecTable RGB2SpecTable::from_memory (void const *data, std::size_t bytes)
+    {
+        using namespace detail::rgb2spec;
+        if (bytes < sizeof(Header))
+            throw std::runtime_error("RGB2SpecTable: truncated header");
+        if (reinterpret_cast<std::uintptr_t>(data) % alignof(float) != 0)
+            throw std::runtime_error("RGB2SpecTable: table memory is not aligned to float");
+
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+        check_header(header);
+        if (!table_fits(header.resolution, (bytes - sizeof(Header)) / sizeof(float)))
+            throw std::runtime_error("RGB2SpecTable: truncated table");
+
+        float const *scale = reinterpret_cast<float const*>(
+                                 static_cast<char const*>(data) + sizeof(Header));
+        return RGB2SpecTable(header.resolution, scale, scale + header.resolution,
+                             std::shared_ptr<std::vector<float>>());
+    }
+
+
+    inline RGB2SpecTable RGB2SpecTable::read (std::istream &is)
+    {
+        using namespace detail::rgb2spec;
+        Header header;
+        if (!is.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+            throw std::runtime_error("RGB2SpecTable: truncated header");
+
+        check_header(header);
+        const std::size_t head = sizeof(Header)/sizeof(float), res = header.resolution;
+        if (!table_fits(res, std::numeric_limits<std::size_t>::max() / sizeof(float) - head))
+            throw std::runtime_error("RGB2SpecTable: table is too large");
+
+        // Read in chunks, so that a damaged or truncated file allocates no more than it holds.
+        const std::size_t total = head + float_count(res);
+        auto storage = std::make_shared<std::vector<float>>(head);
+        std::memcpy(storage->data(), &header, sizeof(Header));
+        while (storage->size() != total) {
+            const std::size_t at = storage->size(),
+                              n = std::min<std::size_t>(total - at, std::size_t(1) << 20);
+            storage->resize(at + n);
+            if (!is.read(reinterpret_cast<char*>(storage->data() + at), sizeof(float)*n))
+                throw std::runtime_error("RGB2SpecTable: truncated table");
+        }
+
+        // Validate via from_memory, but keep the storage alive.
+        const auto view = from_memory(storage->data(), sizeof(float)*storage->size());
+        return RGB2SpecTable(view.res_, view.scale_, view.data_, std::move(storage));
+    }
+
+
+    inline void RGB2SpecTable::write (std::ostream &os) const
+    {
+        using namespace detail::rgb2spec;
+        Header header;
+        std::memcpy(header.magic, magic, 4);
+        header.version    = version;
+        header.resolution = static_cast<std::uint32_t>(res_);
+        header.byte_order = byte_order;
+        os.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+        os.write(reinterpret_cast<char const*>(scale_), sizeof(float)*res_);
+        os.write(reinterpret_cast<char const*>(data_), sizeof(float)*9*res_*res_*res_);
+    }
+
+
+    inline std::size_t RGB2SpecTable::resolution() const noexcept {
+        return res_;
+    }
+
+
+    inline RGB2SpecCoefficients RGB2SpecTable::operator() (float r, float g, float b) const noexcept
+    {
+        using std::min; using std::max; using std::sqrt;
+        const float rgb[3] = { min(max(r, 0.0f), 1.0f),
+                               min(max(g, 0.0f), 1.0f),
+                               min(max(b, 0.0f), 1.0f) };
+
+        // Grays (including black and white) are representable exactly.
+        if (rgb[0] == rgb[1] && rgb[1] == rgb[2])
+            return {0, 0, (rgb[0] - 0.5f) / sqrt(rgb[0] * (1 - rgb[0]))};
+
+        // Find the largest component; the table is split into three parts by that.
+        const int i = rgb[0] < rgb[1] ? (rgb[1] < rgb[2] ? 2 : 1)
+                                      : (rgb[0] < rgb[2] ? 2 : 0);
+        const int res = static_cast<int>(res_);
+        const float z = rgb[i],
+                    scale = (res - 1) / z,
+                    x = rgb[(i+1)%3] * scale,
+                    y = rgb[(i+2)%3] * scale;
+
+        const int xi = min(static_cast<int>(x), res - 2),
+                  yi = min(static_cast<int>(y), res - 2),
+                  zi = static_cast<int>(detail::rgb2spec::find_interval(scale_, res_, z));
+
+        const float x1 = x - xi,
+                    y1 = y - yi,
+                    z1 = (z - scale_[zi]) / (scale_[zi+1] - scale_[zi]);
+
+        const std::size_t dx = 3, dy = 3*res_, dz = 3*res_*res_;
+        float const *d = data_ + (((i*res_ + zi)*res_ + yi)*res_ + xi)*3;
+
+        float c[3];
+        for (int j=0; j!=3; ++j, ++d) {
+            c[j] = lerp(lerp(lerp(d[0],       d[dx],       x1),
+                             lerp(d[dy],      d[dy+dx],    x1), y1),
+                        lerp(lerp(d[dz],      d[dz+dx],    x1),
+                             lerp(d[dz+dy],   d[dz+dy+dx], x1), y1), z1);
+        }
+        return {c[0], c[1], c[2]};
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline RGB2SpecCoefficients RGB2SpecTable::operator() (LinearRGB<T, RGBSpace> const &rgb) const noexcept
+    {
+        return (*this)(static_cast<float>(rgb.r), static_cast<float>(rgb.g), static_cast<float>(rgb.b));
+    }
+
+
+
+    // optimize_rgb2spec_table
+    template <template <typename> class RGBSpace>
+    inline RGB2SpecTable optimize_rgb2spec_table (std::size_t resolution)
+    {
+        using namespace detail::rgb2spec;
+        if (resolution < 2)
+            throw std::logic_error("optimize_rgb2spec_table: resolution must be at least 2");
+
+        const std::size_t res = resolution;
+        const Context ctx (RGBSpace<double>().rgb_to_xyz);
+
+        auto storage = std::make_shared<std::vector<float>>(float_count(res));
+        float *scale = storage->data(),
+              *data  = storage->data() + res;
+
+        for (std::size_t k=0; k!=res; ++k)
+            scale[k] = float(smoothstep(smoothstep(double(k) / (res-1))));
+
+        for (int l=0; l!=3; ++l) {
+            #pragma omp parallel for schedule(dynamic)
+            for (long j=0; j<long(res); ++j) {
+                const double y = double(j) / (res-1);
+                for (std::size_t i=0; i!=res; ++i) {
+                    const double x = double(i) / (res-1);
+
+                    // Walk up and down in z from a well-conditioned start, using each solution
+                    // as the initial guess for the next one.
+                    auto solve = [&](std::size_t k, double coeffs[3]) {
+                        double rgb[3];
+                        const double z = scale[k];
+                        rgb[l]       = z;
+                        rgb[(l+1)%3] = x*z;
+                        rgb[(l+2)%3] = y*z;
+                        ctx.gauss_newton(rgb, coeffs);
+                        store(coeffs, data + (((l*res + k)*res + j)*res + i)*3);
+                    };
+
+                    const std::size_t start = res / 5;
+                    double coeffs[3] = {0, 0, 0};
+                    for (std::size_t k=start; k<res; ++k)
+                        solve(k, coeffs);
+
+                    coeffs[0] = coeffs[1] = coeffs[2] = 0;
+                    for (std::size_t k=start; k-- > 0; )
+                        solve(k, coeffs);
+                }
+            }
+        }
+
+        return RGB2SpecTable::owning(res, std::move(storage));
+    }
+
+} }
+
+#endif // RGB2SPEC_HH_INCLUDED_20261018
@@ -0,0 +1,164 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef SMITS_HH_INCLUDED_20261018
+#define SMITS_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "../LinearRGB.hh"
+#include "../ImageView.hh"
+#include "../algorithm/lerp.hh"
+#include <array>
+#include <cstddef>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// smits:
+//
+//    Fast RGB to reflectance spectrum conversion after
+//
+//      Brian Smits. 1999. "An RGB-to-Spectrum Conversion for Reflectances".
+//      Journal of Graphics Tools 4(4), pp. 11-22.
+//
+//    The spectrum is a positive combination of seven basis spectra (white, cyan, magenta,
+//    yellow, red, green, blue):
+//
+//        spectrum = min * white + (mid-min) * secondary + (max-mid) * primary
+//
+//    where the secondary is the complement of the smallest channel and the primary is the
+//    largest channel. Compared to RGB2Spec, this needs no table, but the result is not smooth
+//    and only approximately reproduces the input color. Use it for previews.
+//
+//    The result is a FixedSpectrum<N> over [380nm..720nm] (Smits' range); the basis spectra are
+//    resampled once per N.
+//
+//
+// Definitions:
+//
+//    FixedSpectrum<N> smits<N> (LinearRGB<T,sRGB> rgb) noexcept
+//    void             smits<N> (LinearRGB<T,sRGB> const *first, LinearRGB<T,sRGB> const *last,
+//                               FixedSpectrum<N> *out) noexcept
+//    void             smits<N> (ImageView<LinearRGB<T,sRGB> const> in,
+//                               ImageView<FixedSpectrum<N>> out)
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    template <std::size_t N=10, typename T>
+    FixedSpectrum<N> smits (LinearRGB<T, sRGB> const &rgb) noexcept ;
+
+    template <std::size_t N=10, typename T>
+    void smits (LinearRGB<T, sRGB> const *first, LinearRGB<T, sRGB> const *last,
+                FixedSpectrum<N> *out) noexcept ;
+
+    template <std::size_t N=10, typename T>
+    void smits (ImageView<LinearRGB<T, sRGB> const> in, ImageView<FixedSpectrum<N>> out);
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    namespace detail { namespace smits {
+
+        static constexpr float lambda_min = 380, lambda_max = 720;
+
+        // Table 1 of Smits' paper, 10 bins from 380nm to 720nm.
+        // Order: white, cyan, magenta, yellow, red, green, blue.
+        static constexpr float basis[7][10] = {
+            {1.0000f, 1.0000f, 0.9999f, 0.9993f, 0.9992f, 0.9998f, 1.0000f, 1.0000f, 1.0000f, 1.0000f},
+            {0.9710f, 0.9426f, 1.0007f, 1.0007f, 1.0007f, 1.0007f, 0.1564f, 0.0000f, 0.0000f, 0.0000f},
+            {1.0000f, 1.0000f, 0.9685f, 0.2229f, 0.0000f, 0.0458f, 0.8369f, 1.0000f, 1.0000f, 0.9959f},
+            {0.0001f, 0.0000f, 0.1088f, 0.6651f, 1.0000f, 1.0000f, 0.9996f, 0.9586f, 0.9685f, 0.9840f},
+            {0.1012f, 0.0515f, 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.8325f, 1.0149f, 1.0149f, 1.0149f},
+            {0.0000f, 0.0000f, 0.0273f, 0.7937f, 1.0000f, 0.9418f, 0.1719f, 0.0000f, 0.0000f, 0.0025f},
+            {1.0000f, 1.0000f, 0.8916f, 0.3323f, 0.0000f, 0.0000f, 0.0003f, 0.0369f, 0.0483f, 0.0496f},
+        };
+
+        // The basis, linearly resampled to N bins. Computed once per N.
+        template <std::size_t N>
+        struct Basis {
+            float white[N], secondary[3][N], primary[3][N];
+
+            Basis() noexcept {
+                for (std::size_t i=0; i!=N; ++i) {
+                    const float f = float(i) * 9 / (N-1);
+                    const std::size_t k = std::min<std::size_t>(std::size_t(f), 8);
+                    auto at = [&](int b) { return lerp(basis[b][k], basis[b][k+1], f-k); };
+                    white[i] = at(0);
+                    for (int c=0; c!=3; ++c) {
+                        secondary[c][i] = at(1+c);
+                        primary[c][i]   = at(4+c);
+                    }
+                }
+            }
+
+            static Basis const& get() noexcept {
+                static const Basis basis;
+                return basis;
+            }
+        };
+
+        template <std::size_t N, typename T>
+        inline void convert (Basis<N> const &B, T r, T g, T b, FixedSpectrum<N> &out) noexcept
+        {
+            // Sort the channels without branching on the data in the inner loop.
+            const int lo = (r <= g) ? (r <= b ? 0 : 2) : (g <= b ? 1 : 2);
+            const int hi = (r >  g) ? (r >  b ? 0 : 2) : (g >  b ? 1 : 2);
+            const float c[3] = {float(r), float(g), float(b)};
+            const float cmin = c[lo],
+                        cmax = c[hi],
+                        cmid = c[0] + c[1] + c[2] - cmin - cmax;
+
+            const float w_white = cmin,
+                        w_secondary = cmid - cmin,
+                        w_primary = cmax - cmid;
+            float const *secondary = B.secondary[lo],
+                        *primary   = B.primary[hi];
+            for (std::size_t i=0; i!=N; ++i)
+                out[i] = w_white*B.white[i] + w_secondary*secondary[i] + w_primary*primary[i];
+        }
+    } }
+
+
+    template <std::size_t N, typename T>
+    inline FixedSpectrum<N> smits (LinearRGB<T, sRGB> const &rgb) noexcept
+    {
+        using namespace detail::smits;
+        FixedSpectrum<N> ret {Nanometer(lambda_min), Nanometer(lambda_max)};
+        convert(Basis<N>::get(), rgb.r, rgb.g, rgb.b, ret);
+        return ret;
+    }
+
+
+    template <std::size_t N, typename T>
+    inline void smits (LinearRGB<T, sRGB> const *first, LinearRGB<T, sRGB> const *last,
+                       FixedSpectrum<N> *out) noexcept
+    {
+        using namespace detail::smits;
+        auto const &B = Basis<N>::get();
+        for (; first!=last; ++first, ++out) {
+            *out = FixedSpectrum<N>(Nanometer(lambda_min), Nanometer(lambda_max));
+            convert(B, first->r, first->g, first->b, *out);
+        }
+    }
+
+
+    template <std::size_t N, typename T>
+    inline void smits (ImageView<LinearRGB<T, sRGB> const> in, ImageView<FixedSpectrum<N>> out)
+    {
+        detail::smits::Basis<N>::get(); // Initialize before going parallel.
+        transform_rows(in, out, [](LinearRGB<T, sRGB> const *first, LinearRGB<T, sRGB> const *last,
+                                   FixedSpectrum<N> *out) {
+            smits<N>(first, last, out);
+        });
+    }
+
+} }
+
+#endif // SMITS_HH_INCLUDED_20261018
@@ -0,0 +1,531 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef SPECTRALLIBRARY_HH_INCLUDED_20261018
+#define SPECTRALLIBRARY_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "../Nanometer.hh"
+#include "../detail/half.hh"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// SpectralLibrary:
+//
+//    A read-only collection of named spectra sharing one uniform bin layout, stored in a binary
+//    format that is used in place: 'SpectralLibrary::from_memory' only validates the header and
+//    index, and the SpectrumViews it hands out point directly into the given memory, e.g. a
+//    memory mapped file. Opening a library therefore costs the same for ten or for ten thousand
+//    spectra.
+//
+//    Libraries are created with SpectralLibraryWriter, or with tools/spectral_import.cc from
+//    CSV, CGATS or JSON files.
+//
+//
+// Binary format (native byte order, checked on load):
+//
+//    offset        size           content
+//    - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//    0             4              magic "TKSL"
+//    4             4              uint32 version (1)
+//    8             4              uint32 byte order mark (0x01020304)
+//    12            4              uint32 encoding (0: float32, 1: float16)
+//    16            4              uint32 number of spectra (count, at least 1)
+//    20            4              uint32 bins per spectrum
+//    24            4              float  lambda_min
+//    28            4              float  lambda_max
+//    32            8              uint64 offset of the name characters (names)
+//    40            8              uint64 offset of the spectra (data), a multiple of 16
+//    48            8*count        uint32 pairs (name offset relative to 'names', length),
+//                                 sorted by name
+//    names         ...            name characters, not terminated
+//    data          count*bins*e   bins, in the order of the index; e = 4 or 2 bytes
+//
+//
+// Definitions:
+//
+//    SpectralLibrary SpectralLibrary::from_memory (void const *data, size_t bytes)
+//    SpectralLibrary SpectralLibrary::read        (std::istream &is)
+//
+//    size_t       size(), bins()
+//    Nanometer    lambda_min(), lambda_max()
+//    std::string  name (size_t i)
+//    size_t       find (std::string const &name)      size() if not found
+//    SpectrumView operator[] (size_t i)
+//    SpectrumView at (size_t i), at (std::string const &name)    throw std::out_of_range
+//
+//    SpectrumView has the read interface of Spectrum (lambda_min(), lambda_max(), size(),
+//    empty(), operator[], at), so it can be passed to everything taking a sampled spectrum,
+//    and can be copied with 'Spectrum(v.lambda_min(), v.lambda_max(), v)'.
+//
+//
+// Examples:
+//
+//    SpectralLibraryWriter w (380_nm, 780_nm, 81, SpectralEncoding::float16);
+//    w.add("brick", brick_bins);
+//    w.write(ofs);
+//
+//    auto lib = SpectralLibrary::from_memory(mapped, mapped_size);
+//    XYZ<double> xyz = cie1931::sampled_tristimulus(lib.at("brick"));
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    enum class SpectralEncoding : std::uint32_t {
+        float32 = 0,
+        float16 = 1
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // SpectrumView
+    //----------------------------------------------------------------------------------------------
+    class SpectrumView {
+    public:
+        SpectrumView (Nanometer lambda_min, Nanometer lambda_max, std::size_t bins,
+                      SpectralEncoding encoding, void const *data) noexcept ;
+
+        Nanometer lambda_min() const noexcept ;
+        Nanometer lambda_max() const noexcept ;
+
+        std::size_t size() const noexcept ;
+        bool empty() const noexcept ;
+
+        float operator[] (std::size_t i) const noexcept ;
+        float at (std::size_t i) const ;
+
+    private:
+        Nanometer lambda_min_, lambda_max_;
+        std::size_t bins_;
+        SpectralEncoding encoding_;
+        void const *data_;
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // SpectralLibrary
+    //----------------------------------------------------------------------------------------------
+    class SpectralLibrary {
+    public:
+        // Construction. 'from_memory' does not copy, the memory must outlive the library.
+        static SpectralLibrary from_memory (void const *data, std::size_t bytes);
+        static SpectralLibrary read (std::istream &is);
+
+        std::size_t size() const noexcept ;
+        bool empty() const noexcept ;
+        std::size_t bins() const noexcept ;
+        Nanometer lambda_min() const noexcept ;
+        Nanometer lambda_max() const noexcept ;
+        SpectralEncoding encoding() const noexcept ;
+
+        std::string name (std::size_t i) const ;
+        std::size_t find (std::string const &name) const noexcept ;
+
+        SpectrumView operator[] (std::size_t i) const noexcept ;
+        SpectrumView at (std::size_t i) const ;
+        SpectrumView at (std::string const &name) const ;
+
+    private:
+        SpectralLibrary() = default;
+
+        char const *base_ = nullptr;
+        std::size_t count_ = 0, bins_ = 0, element_size_ = 0;
+        Nanometer lambda_min_, lambda_max_;
+        SpectralEncoding encoding_ = SpectralEncoding::float32;
+        char const *index_ = nullptr, *names_ = nullptr, *data_ = nullptr;
+        std::shared_ptr<std::vector<std::uint64_t>> storage_; // Empty for from_memory.
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // SpectralLibraryWriter
+    //----------------------------------------------------------------------------------------------
+    class SpectralLibraryWriter {
+    public:
+        SpectralLibraryWriter (Nanometer lambda_min, Nanometer lambda_max, std::size_t bins,
+                               SpectralEncoding encoding = SpectralEncoding::float32);
+
+        // Throws std::logic_error if the number of bins does not match, or if a spectrum with
+        // that name was already added.
+        template <typename Cont>
+        void add (std::string const &name, Cont const &bins);
+
+        std::size_t size() const noexcept ;
+
+        // Throws std::logic_error if no spectrum was added; readers reject empty libraries.
+        void write (std::ostream &os) const ;
+
+    private:
+        Nanometer lambda_min_, lambda_max_;
+        std::size_t bins_;
+        SpectralEncoding encoding_;
+        std::map<std::string, std::vector<float>> spectra_;
+    };
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    namespace detail { namespace spectral_library {
+
+        struct Header {
+            char          magic[4];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint32_t encoding;
+            std::uint32_t count;
+            std::uint32_t bins;
+            float         lambda_min;
+            float         lambda_max;
+            std::uint64_t names_offset;
+            std::uint64_t data_offset;
+        };
+        static_assert(sizeof(Header) == 48, "unexpected padding in SpectralLibrary header");
+
+        struct IndexEntry {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        static constexpr char          magic[4]   = {'T','K','S','L'};
+        static constexpr std::uint32_t version    = 1;
+        static constexpr std::uint32_t byte_order = 0x01020304;
+
+        inline std::size_t element_size (SpectralEncoding e) noexcept {
+            return e == SpectralEncoding::float16 ? 2 : 4;
+        }
+
+        // Checks the fields of the header on their own, before any size is computed from
+        // them. Returns the size of the whole library, or throws if it does not fit uint64.
+        inline std::uint64_t check_header (Header const &header) {
+            if (std::memcmp(header.magic, magic, 4) != 0)
+                throw std::runtime_error("SpectralLibrary: not a spectral library");
+            if (header.version != version)
+                throw std::runtime_error("SpectralLibrary: unsupported version");
+            if (header.byte_order != byte_order)
+                throw std::runtime_error("SpectralLibrary: library was written with foreign byte order");
+            if (header.encoding > 1)
+                throw std::runtime_error("SpectralLibrary: unknown encoding");
+            if (header.count == 0)
+                throw std::runtime_error("SpectralLibrary: no spectra");
+            if (header.bins < 2)
+                throw std::runtime_error("SpectralLibrary: at least two bins are needed");
+            if (header.names_offset < sizeof(Header) || header.data_offset < header.names_offset)
+                throw std::runtime_error("SpectralLibrary: corrupt header");
+
+            // count and bins are 32 bit, so their product fits; the rest is checked.
+            const std::uint64_t max = std::numeric_limits<std::uint64_t>::max(),
+                                values = std::uint64_t(header.count) * header.bins,
+                                e = element_size(SpectralEncoding(header.encoding));
+            if (values > max / e || header.data_offset > max - values * e)
+                throw std::runtime_error("SpectralLibrary: corrupt header");
+            const std::uint64_t data_size = values * e;
+            return header.data_offset + data_size;
+        }
+
+        inline IndexEntry entry (char const *index, std::size_t i) noexcept {
+            IndexEntry e;
+            std::memcpy(&e, index + i*sizeof(IndexEntry), sizeof(IndexEntry));
+            return e;
+        }
+    } }
+
+
+
+    // SpectrumView
+    inline SpectrumView::SpectrumView (Nanometer lambda_min, Nanometer lambda_max,
+                                       std::size_t bins, SpectralEncoding encoding,
+                                       void const *data) noexcept
+    : lambda_min_(lambda_min), lambda_max_(lambda_max), bins_(bins), encoding_(encoding),
+      data_(data)
+    {}
+
+
+    inline Nanometer SpectrumView::lambda_min() const noexcept {
+        return lambda_min_;
+    }
+
+
+    inline Nanometer SpectrumView::lambda_max() const noexcept {
+        return lambda_max_;
+    }
+
+
+    inline std::size_t SpectrumView::size() const noexcept {
+        return bins_;
+    }
+
+
+    inline bool SpectrumView::empty() const noexcept {
+        return 0 == bins_;
+    }
+
+
+    inline float SpectrumView::operator[] (std::size_t i) const noexcept {
+        if (encoding_ == SpectralEncoding::float16)
+            return tukan::detail::half_bits_to_float(static_cast<std::uint16_t const*>(data_)[i]);
+        return static_cast<float const*>(data_)[i];
+    }
+
+
+    inline float SpectrumView::at (std::size_t i) const {
+        if (i>=size())
+            throw std::out_of_range("passed value outside range to SpectrumView::at(size_t)");
+        return (*this)[i];
+    }
+
+
+
+    // SpectralLibrary
+    inline SpectralLibrary SpectralLibrary::from_memory (void const *data, std::size_t bytes)
+    {
+        using namespace detail::spectral_library;
+        if (bytes < sizeof(Header))
+            throw std::runtime_error("SpectralLibrary: truncated header");
+
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+        if (check_header(header) > bytes)
+            throw std::runtime_error("SpectralLibrary: truncated data");
+
+        SpectralLibrary ret;
+        ret.base_ = static_cast<char const*>(data);
+        ret.count_ = header.count;
+        ret.bins_ = header.bins;
+        ret.encoding_ = static_cast<SpectralEncoding>(header.encoding);
+        ret.element_size_ = element_size(ret.encoding_);
+        ret.lambda_min_ = Nanometer(header.lambda_min);
+        ret.lambda_max_ = Nanometer(header.lambda_max);
+
+        const std::uint64_t index_end = sizeof(Header) + sizeof(IndexEntry)*std::uint64_t(ret.count_);
+        if (index_end > bytes || header.names_offset < index_end || header.names_offset > bytes)
+            throw std::runtime_error("SpectralLibrary: truncated index");
+        if ((reinterpret_cast<std::uintptr_t>(ret.base_) + header.data_offset) % ret.element_size_ != 0)
+            throw std::runtime_error("SpectralLibrary: data is not aligned");
+
+        ret.index_ = ret.base_ + sizeof(Header);
+        ret.names_ = ret.base_ + header.names_offset;
+        ret.data_  = ret.base_ + header.data_offset;
+
+        const std::uint64_t names_size = header.data_offset - header.names_offset;
+        for (std::size_t i=0; i!=ret.count_; ++i) {
+            const IndexEntry e = entry(ret.index_, i);
+            if (std::uint64_t(e.offset) + e.length > names_size)
+                throw std::runtime_error("SpectralLibrary: name outside of the name table");
+        }
+        return ret;
+    }
+
+
+    inline SpectralLibrary SpectralLibrary::read (std::istream &is)
+    {
+        using namespace detail::spectral_library;
+        Header header;
+        if (!is.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+            throw std::runtime_error("SpectralLibrary: truncated header");
+
+        // The size of the whole file follows from the header; the index and names are
+        // validated by from_memory. uint64 storage keeps the data 16-byte aligned.
+        const std::uint64_t size = check_header(header);
+        if (size > std::numeric_limits<std::size_t>::max() - 7)
+            throw std::runtime_error("SpectralLibrary: library is too large");
+        const std::size_t bytes = std::size_t(size);
+
+        // Read in chunks, so that a damaged or truncated file allocates no more than it holds.
+        auto storage = std::make_shared<std::vector<std::uint64_t>>(sizeof(Header) / 8);
+        std::memcpy(storage->data(), &header, sizeof(Header));
+        for (std::size_t at = sizeof(Header); at != bytes; ) {
+            const std::size_t n = std::min<std::size_t>(bytes - at, std::size_t(1) << 23);
+            storage->resize((at + n + 7) / 8);
+            if (!is.read(reinterpret_cast<char*>(storage->data()) + at, n))
+                throw std::runtime_error("SpectralLibrary: truncated library");
+            at += n;
+        }
+
+        char const *base = reinterpret_cast<char const*>(storage->data());
+        SpectralLibrary ret = from_memory(base, bytes);
+        ret.storage_ = std::move(storage);
+        return ret;
+    }
+
+
+    inline std::size_t SpectralLibrary::size() const noexcept {
+        return count_;
+    }
+
+
+    inline bool SpectralLibrary::empty() const noexcept {
+        return 0 == count_;
+    }
+
+
+    inline std::size_t SpectralLibrary::bins() const noexcept {
+        return bins_;
+    }
+
+
+    inline Nanometer SpectralLibrary::lambda_min() const noexcept {
+        return lambda_min_;
+    }
+
+
+    inline Nanometer SpectralLibrary::lambda_max() const noexcept {
+        return lambda_max_;
+    }
+
+
+    inline SpectralEncoding SpectralLibrary::encoding() const noexcept {
+        return encoding_;
+    }
+
+
+    inline std::string SpectralLibrary::name (std::size_t i) const {
+        if (i>=size())
+            throw std::out_of_range("passed value outside range to SpectralLibrary::name(size_t)");
+        const auto e = detail::spectral_library::entry(index_, i);
+        return std::string(names_ + e.offset, e.length);
+    }
+
+
+    inline std::size_t SpectralLibrary::find (std::string const &name) const noexcept
+    {
+        // Binary search over the sorted index, comparing in place.
+        std::size_t lo = 0, count = count_;
+        while (count > 0) {
+            const std::size_t half = count / 2, mid = lo + half;
+            const auto e = detail::spectral_library::entry(index_, mid);
+            if (name.compare(0, std::string::npos, names_ + e.offset, e.length) > 0) {
+                lo = mid + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        if (lo == count_)
+            return count_;
+        const auto e = detail::spectral_library::entry(index_, lo);
+        return name.compare(0, std::string::npos, names_ + e.offset, e.length) == 0 ? lo : count_;
+    }
+
+
+    inline SpectrumView SpectralLibrary::operator[] (std::size_t i) const noexcept {
+        return SpectrumView(lambda_min_, lambda_max_, bins_, encoding_,
+                            data_ + i*bins_*element_size_);
+    }
+
+
+    inline SpectrumView SpectralLibrary::at (std::size_t i) const {
+        if (i>=size())
+            throw std::out_of_range("passed value outside range to SpectralLibrary::at(size_t)");
+        return (*this)[i];
+    }
+
+
+    inline SpectrumView SpectralLibrary::at (std::string const &name) const {
+        const std::size_t i = find(name);
+        if (i == size())
+            throw std::out_of_range("SpectralLibrary::at(std::string): no spectrum named '"
+                                    + name + "'");
+        return (*this)[i];
+    }
+
+
+
+    // SpectralLibraryWriter
+    inline SpectralLibraryWriter::SpectralLibraryWriter (Nanometer lambda_min,
+                                                         Nanometer lambda_max, std::size_t bins,
+                                                         SpectralEncoding encoding)
+    : lambda_min_(lambda_min), lambda_max_(lambda_max), bins_(bins), encoding_(encoding)
+    {
+        if (bins < 2)
+            throw std::logic_error("SpectralLibraryWriter: at least two bins are needed");
+    }
+
+
+    template <typename Cont>
+    inline void SpectralLibraryWriter::add (std::string const &name, Cont const &bins)
+    {
+        if (bins.size() != bins_)
+            throw std::logic_error("SpectralLibraryWriter::add: wrong number of bins for '"
+                                   + name + "'");
+        std::vector<float> values (bins_);
+        for (std::size_t i=0; i!=bins_; ++i)
+            values[i] = bins[i];
+        if (!spectra_.emplace(name, std::move(values)).second)
+            throw std::logic_error("SpectralLibraryWriter::add: duplicate name '" + name + "'");
+    }
+
+
+    inline std::size_t SpectralLibraryWriter::size() const noexcept {
+        return spectra_.size();
+    }
+
+
+    inline void SpectralLibraryWriter::write (std::ostream &os) const
+    {
+        using namespace detail::spectral_library;
+        if (spectra_.empty())
+            throw std::logic_error("SpectralLibraryWriter::write: no spectra");
+
+        std::vector<IndexEntry> index;
+        std::string names;
+        for (auto const &s : spectra_) {
+            index.push_back({static_cast<std::uint32_t>(names.size()),
+                             static_cast<std::uint32_t>(s.first.size())});
+            names += s.first;
+        }
+
+        Header header;
+        std::memcpy(header.magic, magic, 4);
+        header.version      = version;
+        header.byte_order   = byte_order;
+        header.encoding     = static_cast<std::uint32_t>(encoding_);
+        header.count        = static_cast<std::uint32_t>(spectra_.size());
+        header.bins         = static_cast<std::uint32_t>(bins_);
+        header.lambda_min   = static_cast<float>(lambda_min_);
+        header.lambda_max   = static_cast<float>(lambda_max_);
+        header.names_offset = sizeof(Header) + sizeof(IndexEntry)*index.size();
+        header.data_offset  = (header.names_offset + names.size() + 15) / 16 * 16;
+
+        os.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+        os.write(reinterpret_cast<char const*>(index.data()), sizeof(IndexEntry)*index.size());
+        os.write(names.data(), names.size());
+        const char padding[16] = {};
+        os.write(padding, header.data_offset - header.names_offset - names.size());
+
+        for (auto const &s : spectra_) {
+            if (encoding_ == SpectralEncoding::float16) {
+                std::vector<std::uint16_t> h (bins_);
+                for (std::size_t i=0; i!=bins_; ++i)
+                    h[i] = tukan::detail::float_to_half_bits(s.second[i]);
+                os.write(reinterpret_cast<char const*>(h.data()), sizeof(std::uint16_t)*bins_);
+            } else {
+                os.write(reinterpret_cast<char const*>(s.second.data()), sizeof(float)*bins_);
+            }
+        }
+    }
+
+} }
+
+#endif // SPECTRALLIBRARY_HH_INCLUDED_20261018
@@ -8,6 +8,7 @@
 #include "../Nanometer.hh"
 #include "../Interval.hh"
 #include <valarray>
+#include <array>
 #include <stdexcept>
 
 namespace tukan { namespace future {
@@ -52,6 +53,40 @@ namespace tukan { namespace future {
 
 
 
+    //----------------------------------------------------------------------------------------------
+    // FixedSpectrum
+    //
+    //    Same layout semantics as Spectrum, but with the number of bins known at compile time,
+    //    so that it can be stored in arrays and images without any allocation. A FixedSpectrum
+    //    can be converted with 'Spectrum(fs.lambda_min(), fs.lambda_max(), fs)'.
+    //----------------------------------------------------------------------------------------------
+    template <std::size_t N>
+    class FixedSpectrum {
+    public:
+        static_assert(N >= 2, "FixedSpectrum needs at least two bins");
+
+        constexpr FixedSpectrum() = default;
+        constexpr FixedSpectrum (Nanometer lambda_min, Nanometer lambda_max) noexcept ;
+        constexpr FixedSpectrum (Nanometer lambda_min, Nanometer lambda_max,
+                                 std::array<float, N> const &bins) noexcept ;
+
+        Nanometer lambda_min() const noexcept ;
+        Nanometer lambda_max() const noexcept ;
+
+        constexpr std::size_t size() const noexcept { return N; }
+        constexpr bool empty() const noexcept { return false; }
+
+        float  operator[] (std::size_t i) const noexcept ;
+        float& operator[] (std::size_t i) noexcept ;
+        float at (std::size_t i) const ;
+
+    private:
+        Nanometer lambda_min_, lambda_max_;
+        std::array<float, N> bins_ {};
+    };
+
+
+
     //----------------------------------------------------------------------------------------------
     // LinearInterpolator
     //----------------------------------------------------------------------------------------------
@@ -137,6 +172,53 @@ namespace tukan { namespace future {
 
 
 
+    // FixedSpectrum
+    template <std::size_t N>
+    constexpr FixedSpectrum<N>::FixedSpectrum (Nanometer lambda_min, Nanometer lambda_max) noexcept
+    : lambda_min_(lambda_min), lambda_max_(lambda_max)
+    {}
+
+
+    template <std::size_t N>
+    constexpr FixedSpectrum<N>::FixedSpectrum (Nanometer lambda_min, Nanometer lambda_max,
+                                               std::array<float, N> const &bins) noexcept
+    : lambda_min_(lambda_min), lambda_max_(lambda_max), bins_(bins)
+    {}
+
+
+    template <std::size_t N>
+    inline Nanometer FixedSpectrum<N>::lambda_min() const noexcept {
+        return lambda_min_;
+    }
+
+
+    template <std::size_t N>
+    inline Nanometer FixedSpectrum<N>::lambda_max() const noexcept {
+        return lambda_max_;
+    }
+
+
+    template <std::size_t N>
+    inline float FixedSpectrum<N>::operator[] (std::size_t i) const noexcept {
+        return bins_[i];
+    }
+
+
+    template <std::size_t N>
+    inline float& FixedSpectrum<N>::operator[] (std::size_t i) noexcept {
+        return bins_[i];
+    }
+
+
+    template <std::size_t N>
+    inline float FixedSpectrum<N>::at (std::size_t i) const {
+        if (i>=N)
+            throw std::out_of_range("passed value outside range to FixedSpectrum::at(size_t)");
+        return bins_[i];
+    }
+
+
+
     inline SpectrumSample LinearInterpolator::operator() (float f) const
     {
         if (f<0) throw std::logic_error("passed value < 0 to Spectrum::operator()(float)");
@@ -0,0 +1,415 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef SPECTRUMRESAMPLER_HH_INCLUDED_20261018
+#define SPECTRUMRESAMPLER_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "../Interval.hh"
+#include "../Nanometer.hh"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// SpectrumResampler:
+//
+//    Converts spectra from one bin layout to another. Both layouts are lists of strictly
+//    increasing wavelengths; uniform layouts (like the ones of Spectrum and FixedSpectrum) are
+//    just the common case. The source is read as the piecewise linear function through its
+//    samples, as by LinearInterpolator, and is 0 outside of its range.
+//
+//    Modes:
+//
+//      linear  Each destination bin samples the source at its wavelength.
+//      box     Each destination bin averages the source over its extent, which reaches half way
+//              to the neighbouring bins. Like LinearInterpolator's interval lookup, the average
+//              only covers the overlap with the source range. This preserves area and is the
+//              right choice when going to coarser layouts.
+//
+//    Either mode is a linear map, so the resampler builds a sparse weight matrix (compressed
+//    rows) once per (source layout, destination layout, mode) and keeps it in a process-wide
+//    cache of the 64 most recently used matrices (a resampler keeps its own alive). Applying it
+//    is a sparse matrix-vector product per spectrum; batches are processed in parallel.
+//
+//
+// Definitions:
+//
+//    SpectralLayout SpectralLayout::uniform   (Nanometer min, Nanometer max, size_t bins)
+//    SpectralLayout SpectralLayout::irregular (std::vector<Nanometer> wavelengths)
+//
+//    SpectrumResampler (SpectralLayout const &src, SpectralLayout const &dst,
+//                       ResampleMode mode = ResampleMode::box)
+//    void SpectrumResampler::operator() (float const *src, float *dst) const noexcept
+//    void SpectrumResampler::operator() (float const *src, float *dst, size_t count) const
+//
+//    Spectrum          resample    (Spectrum const &s, Nanometer min, Nanometer max, size_t bins,
+//                                   ResampleMode mode = ResampleMode::box)
+//    FixedSpectrum<N>  resample<N> (Spectrum const &s, Nanometer min, Nanometer max,
+//                                   ResampleMode mode = ResampleMode::box)
+//
+//
+// Examples:
+//
+//    // 5nm measurements to the renderer's 16 bins, for a whole material library at once.
+//    SpectrumResampler r (SpectralLayout::uniform(380_nm, 780_nm, 81),
+//                         SpectralLayout::uniform(400_nm, 700_nm, 16));
+//    r(measured.data(), rendered.data(), material_count);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    enum class ResampleMode {
+        box,
+        linear
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // SpectralLayout
+    //----------------------------------------------------------------------------------------------
+    class SpectralLayout {
+    public:
+        static SpectralLayout uniform (Nanometer lambda_min, Nanometer lambda_max, std::size_t bins);
+        static SpectralLayout irregular (std::vector<Nanometer> const &wavelengths);
+
+        std::size_t size() const noexcept { return lambdas_.size(); }
+        Nanometer operator[] (std::size_t i) const noexcept { return Nanometer(lambdas_[i]); }
+
+        friend bool operator== (SpectralLayout const &lhs, SpectralLayout const &rhs) noexcept {
+            return lhs.lambdas_ == rhs.lambdas_;
+        }
+        friend bool operator< (SpectralLayout const &lhs, SpectralLayout const &rhs) noexcept {
+            return lhs.lambdas_ < rhs.lambdas_;
+        }
+
+    private:
+        SpectralLayout() = default;
+        std::vector<float> lambdas_;
+    };
+
+    bool operator!= (SpectralLayout const &lhs, SpectralLayout const &rhs) noexcept ;
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // SpectrumResampler
+    //----------------------------------------------------------------------------------------------
+    class SpectrumResampler {
+    public:
+        SpectrumResampler (SpectralLayout const &src, SpectralLayout const &dst,
+                           ResampleMode mode = ResampleMode::box);
+
+        std::size_t source_size() const noexcept ;
+        std::size_t destination_size() const noexcept ;
+
+        // One spectrum of source_size() values to one of destination_size() values.
+        void operator() (float const *src, float *dst) const noexcept ;
+
+        // 'count' spectra, stored back to back.
+        void operator() (float const *src, float *dst, std::size_t count) const ;
+
+    private:
+        struct Matrix {
+            std::size_t cols = 0;
+            std::vector<std::size_t> row_begin; // size rows+1
+            std::vector<std::size_t> col;
+            std::vector<float>       weight;
+        };
+
+        static std::shared_ptr<Matrix const> build (SpectralLayout const &src,
+                                                    SpectralLayout const &dst, ResampleMode mode);
+
+        std::shared_ptr<Matrix const> matrix_;
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // resample
+    //----------------------------------------------------------------------------------------------
+    Spectrum resample (Spectrum const &s, Nanometer lambda_min, Nanometer lambda_max,
+                       std::size_t bins, ResampleMode mode = ResampleMode::box);
+
+    template <std::size_t N>
+    FixedSpectrum<N> resample (Spectrum const &s, Nanometer lambda_min, Nanometer lambda_max,
+                               ResampleMode mode = ResampleMode::box);
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    // SpectralLayout
+    inline SpectralLayout SpectralLayout::uniform (Nanometer lambda_min, Nanometer lambda_max,
+                                                   std::size_t bins)
+    {
+        if (bins < 2)
+            throw std::logic_error("SpectralLayout::uniform: at least two bins are needed");
+        if (!(lambda_min < lambda_max))
+            throw std::logic_error("SpectralLayout::uniform: lambda_min must be < lambda_max");
+
+        const float lmin = static_cast<float>(lambda_min),
+                    step = (static_cast<float>(lambda_max) - lmin) / (bins-1);
+        SpectralLayout ret;
+        ret.lambdas_.resize(bins);
+        for (std::size_t i=0; i!=bins; ++i)
+            ret.lambdas_[i] = lmin + step*i;
+        ret.lambdas_.back() = static_cast<float>(lambda_max);
+        return ret;
+    }
+
+
+    inline SpectralLayout SpectralLayout::irregular (std::vector<Nanometer> const &wavelengths)
+    {
+        if (wavelengths.size() < 2)
+            throw std::logic_error("SpectralLayout::irregular: at least two bins are needed");
+        SpectralLayout ret;
+        ret.lambdas_.reserve(wavelengths.size());
+        for (auto l : wavelengths) {
+            if (!ret.lambdas_.empty() && !(ret.lambdas_.back() < static_cast<float>(l)))
+                throw std::logic_error("SpectralLayout::irregular: wavelengths must be strictly "
+                                       "increasing");
+            ret.lambdas_.push_back(static_cast<float>(l));
+        }
+        return ret;
+    }
+
+
+    inline bool operator!= (SpectralLayout const &lhs, SpectralLayout const &rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+
+
+    // SpectrumResampler
+    namespace detail { namespace resample {
+
+        // Adds the weights of the mean of the piecewise linear source over 'r' (which lies
+        // within the source range) to 'w', scaled by the length of 'r'.
+        inline void integrate (SpectralLayout const &src, Interval<float> r, std::vector<float> &w)
+        {
+            for (std::size_t i=0; i+1<src.size(); ++i) {
+                const Interval<float> seg (static_cast<float>(src[i]), static_cast<float>(src[i+1]));
+                if (seg.min >= r.max) break;
+                const auto overlap = intersection(seg, r);
+                if (!overlap || length(*overlap) <= 0)
+                    continue;
+                const float len = length(seg),
+                            ta = (overlap->min - seg.min) / len,
+                            tb = (overlap->max - seg.min) / len,
+                            half = 0.5f * length(*overlap);
+                w[i]   += half * ((1-ta) + (1-tb));
+                w[i+1] += half * (ta + tb);
+            }
+        }
+
+        // Weights of the source sampled at 'l'.
+        inline void sample (SpectralLayout const &src, float l, std::vector<float> &w)
+        {
+            const std::size_t n = src.size();
+            if (l < static_cast<float>(src[0]) || l > static_cast<float>(src[n-1]))
+                return;
+            std::size_t i = 0;
+            while (i+2 < n && static_cast<float>(src[i+1]) <= l)
+                ++i;
+            const float a = static_cast<float>(src[i]), b = static_cast<float>(src[i+1]),
+                        t = (l - a) / (b - a);
+            w[i]   += 1-t;
+            w[i+1] += t;
+        }
+
+        struct Key {
+            SpectralLayout src, dst;
+            ResampleMode mode;
+
+            friend bool operator< (Key const &lhs, Key const &rhs) {
+                if (lhs.mode != rhs.mode) return lhs.mode < rhs.mode;
+                if (lhs.src != rhs.src) return lhs.src < rhs.src;
+                return lhs.dst < rhs.dst;
+            }
+        };
+
+        // Matrices kept for reuse; the least recently used one is dropped beyond that, so
+        // that importing many distinct irregular layouts does not grow the cache without end.
+        static constexpr std::size_t cache_capacity = 64;
+    } }
+
+
+    inline std::shared_ptr<SpectrumResampler::Matrix const>
+    SpectrumResampler::build (SpectralLayout const &src, SpectralLayout const &dst,
+                              ResampleMode mode)
+    {
+        auto m = std::make_shared<Matrix>();
+        m->cols = src.size();
+        m->row_begin.push_back(0);
+
+        const float src_min = static_cast<float>(src[0]),
+                    src_max = static_cast<float>(src[src.size()-1]);
+        std::vector<float> w (src.size());
+
+        for (std::size_t j=0; j!=dst.size(); ++j) {
+            std::fill(w.begin(), w.end(), 0.f);
+            const float l = static_cast<float>(dst[j]);
+
+            switch (mode) {
+            case ResampleMode::linear:
+                detail::resample::sample(src, l, w);
+                break;
+            case ResampleMode::box: {
+                const float lo = j==0 ? l - 0.5f*(static_cast<float>(dst[1]) - l)
+                                      : 0.5f*(static_cast<float>(dst[j-1]) + l),
+                            hi = j+1==dst.size() ? l + 0.5f*(l - static_cast<float>(dst[j-1]))
+                                                 : 0.5f*(l + static_cast<float>(dst[j+1]));
+                const auto overlap = intersection(Interval<float>(lo, hi),
+                                                  Interval<float>(src_min, src_max));
+                if (!overlap)
+                    break;
+                if (length(*overlap) <= 0) {
+                    // Touches the source range in a single point.
+                    detail::resample::sample(src, overlap->min, w);
+                    break;
+                }
+                detail::resample::integrate(src, *overlap, w);
+                for (auto &x : w)
+                    x /= length(*overlap);
+                break;
+            }
+            }
+
+            for (std::size_t i=0; i!=w.size(); ++i) {
+                if (w[i] != 0) {
+                    m->col.push_back(i);
+                    m->weight.push_back(w[i]);
+                }
+            }
+            m->row_begin.push_back(m->col.size());
+        }
+        return m;
+    }
+
+
+    inline SpectrumResampler::SpectrumResampler (SpectralLayout const &src,
+                                                 SpectralLayout const &dst, ResampleMode mode)
+    {
+        using detail::resample::Key;
+        struct Entry {
+            std::shared_ptr<Matrix const> matrix;
+            std::uint64_t used;
+        };
+        static std::mutex mutex;
+        static std::map<Key, Entry> cache;
+        static std::uint64_t clock = 0;
+
+        Key key {src, dst, mode};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                it->second.used = ++clock;
+                matrix_ = it->second.matrix;
+                return;
+            }
+        }
+
+        // Built outside of the lock; if another thread was faster, its matrix is used.
+        auto m = build(src, dst, mode);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.emplace(std::move(key), Entry{std::move(m), 0}).first;
+        it->second.used = ++clock;
+        matrix_ = it->second.matrix;
+        if (cache.size() > detail::resample::cache_capacity) {
+            auto oldest = cache.begin();
+            for (auto i = cache.begin(); i != cache.end(); ++i)
+                if (i->second.used < oldest->second.used)
+                    oldest = i;
+            cache.erase(oldest);
+        }
+    }
+
+
+    inline std::size_t SpectrumResampler::source_size() const noexcept {
+        return matrix_->cols;
+    }
+
+
+    inline std::size_t SpectrumResampler::destination_size() const noexcept {
+        return matrix_->row_begin.size() - 1;
+    }
+
+
+    inline void SpectrumResampler::operator() (float const *src, float *dst) const noexcept
+    {
+        Matrix const &m = *matrix_;
+        const std::size_t rows = m.row_begin.size() - 1;
+        for (std::size_t j=0; j!=rows; ++j) {
+            float sum = 0;
+            for (std::size_t k=m.row_begin[j]; k!=m.row_begin[j+1]; ++k)
+                sum += m.weight[k] * src[m.col[k]];
+            dst[j] = sum;
+        }
+    }
+
+
+    inline void SpectrumResampler::operator() (float const *src, float *dst,
+                                               std::size_t count) const
+    {
+        const std::size_t in = source_size(), out = destination_size();
+        const long n = static_cast<long>(count);
+        #pragma omp parallel for schedule(static)
+        for (long i=0; i<n; ++i)
+            (*this)(src + i*in, dst + i*out);
+    }
+
+
+
+    // resample
+    inline Spectrum resample (Spectrum const &s, Nanometer lambda_min, Nanometer lambda_max,
+                              std::size_t bins, ResampleMode mode)
+    {
+        const SpectrumResampler r (SpectralLayout::uniform(s.lambda_min(), s.lambda_max(), s.size()),
+                                   SpectralLayout::uniform(lambda_min, lambda_max, bins),
+                                   mode);
+        std::vector<float> in (s.size()), out (bins);
+        for (std::size_t i=0; i!=s.size(); ++i)
+            in[i] = s[i];
+        r(in.data(), out.data());
+        return Spectrum(lambda_min, lambda_max, out);
+    }
+
+
+    template <std::size_t N>
+    inline FixedSpectrum<N> resample (Spectrum const &s, Nanometer lambda_min,
+                                      Nanometer lambda_max, ResampleMode mode)
+    {
+        const SpectrumResampler r (SpectralLayout::uniform(s.lambda_min(), s.lambda_max(), s.size()),
+                                   SpectralLayout::uniform(lambda_min, lambda_max, N),
+                                   mode);
+        std::vector<float> in (s.size());
+        for (std::size_t i=0; i!=s.size(); ++i)
+            in[i] = s[i];
+        float out[N];
+        r(in.data(), out);
+
+        FixedSpectrum<N> ret {lambda_min, lambda_max};
+        for (std::size_t i=0; i!=N; ++i)
+            ret[i] = out[i];
+        return ret;
+    }
+
+} }
+
+#endif // SPECTRUMRESAMPLER_HH_INCLUDED_20261018
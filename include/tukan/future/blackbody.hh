@@ -0,0 +1,241 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef BLACKBODY_HH_INCLUDED_20261018
+#define BLACKBODY_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "cie1931.hh"
+#include "../Kelvin.hh"
+#include "../Nanometer.hh"
+#include "../XYZ.hh"
+#include "../detail/exp.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// blackbody:
+//
+//    Spectral radiance of a Planckian radiator,
+//
+//        B(l,T) = c1 / l^5 / (exp(c2 / (l*T)) - 1)
+//
+//    with c1 = 2hc^2 and c2 = hc/k (CODATA 2018). 'blackbody' returns the absolute radiance
+//    in W/(m^2 sr nm); 'blackbody_normalized' is scaled to 1 at the peak wavelength given by
+//    Wien's displacement law, which needs no extra exp.
+//
+//    The batch overloads evaluate exp with the vectorizable 'detail::exp_approx' (relative
+//    error around 1e-6), the single-wavelength overloads share the same kernel, so that both
+//    give identical results.
+//
+//    'blackbody_xyz' is meant for color temperature controls, which ask for the same few
+//    temperatures over and over: the CIE 1931 tristimulus values of the Planckian locus are
+//    tabulated once, in steps of 1 mired (1e6/T) from 1000K to 40000K, and linearly
+//    interpolated. The result is normalized to Y=1.
+//
+//
+// Definitions:
+//
+//    Nanometer wien_peak (Kelvin T) noexcept
+//
+//    float blackbody            (Kelvin T, Nanometer lambda) noexcept
+//    float blackbody_normalized (Kelvin T, Nanometer lambda) noexcept
+//
+//    void  blackbody            (Kelvin T, Nanometer const *first, Nanometer const *last,
+//                                float *out) noexcept
+//    void  blackbody_normalized (Kelvin T, Nanometer const *first, Nanometer const *last,
+//                                float *out) noexcept
+//
+//    FixedSpectrum<N> blackbody<N>            (Kelvin T, Nanometer lambda_min,
+//                                              Nanometer lambda_max) noexcept
+//    FixedSpectrum<N> blackbody_normalized<N> (Kelvin T, Nanometer lambda_min,
+//                                              Nanometer lambda_max) noexcept
+//
+//    XYZ<T> blackbody_xyz<T=double> (Kelvin T)     throws std::out_of_range unless
+//                                                  1000K <= T <= 40000K
+//
+//
+// Examples:
+//
+//    auto spd = blackbody_normalized<41>(3200_kelvin, 380_nm, 780_nm);
+//    XYZ<float> white = blackbody_xyz<float>(6500_kelvin);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future {
+
+    Nanometer wien_peak (Kelvin T) noexcept ;
+
+    float blackbody            (Kelvin T, Nanometer lambda) noexcept ;
+    float blackbody_normalized (Kelvin T, Nanometer lambda) noexcept ;
+
+    void blackbody            (Kelvin T, Nanometer const *first, Nanometer const *last,
+                               float *out) noexcept ;
+    void blackbody_normalized (Kelvin T, Nanometer const *first, Nanometer const *last,
+                               float *out) noexcept ;
+
+    template <std::size_t N>
+    FixedSpectrum<N> blackbody (Kelvin T, Nanometer lambda_min, Nanometer lambda_max) noexcept ;
+    template <std::size_t N>
+    FixedSpectrum<N> blackbody_normalized (Kelvin T, Nanometer lambda_min,
+                                           Nanometer lambda_max) noexcept ;
+
+    template <typename T=double>
+    XYZ<T> blackbody_xyz (Kelvin temperature);
+
+} }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future {
+
+    namespace detail { namespace blackbody {
+
+        // Radiation constants, with wavelengths in nanometers.
+        static constexpr float c1 = 1.191042972e20f;  // 2hc^2,  W nm^4 / (m^2 sr)
+        static constexpr float c2 = 1.438776877e7f;   // hc/k,   nm K
+        static constexpr float wien = 2.897771955e6f; // nm K
+
+        // At the peak l = wien/T, the exponent c2/(l*T) is the constant c2/wien, hence
+        // B(peak) = c1/peak^5 / peak_denom.
+        static constexpr float peak_denom = 142.32492f; // exp(c2/wien) - 1
+
+        // out[i] = scale * (ref/l)^5 / (exp(c2/(l*T)) - 1)
+        inline void kernel (float T, float scale, float ref,
+                            Nanometer const *first, Nanometer const *last, float *out) noexcept
+        {
+            const std::ptrdiff_t n = last - first;
+            const float k = c2 / T;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const float l = static_cast<float>(first[i]);
+                const float r = ref / l,
+                            r2 = r*r;
+                out[i] = scale * r2*r2*r / (tukan::detail::exp_approx(k / l) - 1);
+            }
+        }
+
+        template <std::size_t N>
+        inline FixedSpectrum<N> spectrum (float T, float scale, float ref,
+                                          Nanometer lambda_min, Nanometer lambda_max) noexcept
+        {
+            Nanometer lambdas[N];
+            const float lmin = static_cast<float>(lambda_min),
+                        step = (static_cast<float>(lambda_max) - lmin) / (N-1);
+            for (std::size_t i=0; i!=N; ++i)
+                lambdas[i] = Nanometer(lmin + step*i);
+
+            FixedSpectrum<N> ret {lambda_min, lambda_max};
+            float values[N];
+            kernel(T, scale, ref, lambdas, lambdas+N, values);
+            for (std::size_t i=0; i!=N; ++i)
+                ret[i] = values[i];
+            return ret;
+        }
+
+
+        // Planckian locus in steps of 1 mired.
+        static constexpr float mired_min = 25, mired_max = 1000;
+
+        inline std::vector<XYZ<double>> const& locus()
+        {
+            static const std::vector<XYZ<double>> table = [] {
+                std::vector<XYZ<double>> ret;
+                for (float m=mired_min; m<=mired_max; ++m) {
+                    const Kelvin T {1e6f / m};
+                    const XYZ<double> xyz = cie1931::tristimulus([T](Nanometer l) {
+                        return tukan::future::blackbody(T, l);
+                    });
+                    ret.push_back(xyz / xyz.Y);
+                }
+                return ret;
+            }();
+            return table;
+        }
+    } }
+
+
+    inline Nanometer wien_peak (Kelvin T) noexcept
+    {
+        return Nanometer(detail::blackbody::wien / static_cast<float>(T));
+    }
+
+
+    inline float blackbody (Kelvin T, Nanometer lambda) noexcept
+    {
+        float ret;
+        detail::blackbody::kernel(static_cast<float>(T), detail::blackbody::c1, 1,
+                                  &lambda, &lambda+1, &ret);
+        return ret;
+    }
+
+
+    inline float blackbody_normalized (Kelvin T, Nanometer lambda) noexcept
+    {
+        float ret;
+        blackbody_normalized(T, &lambda, &lambda+1, &ret);
+        return ret;
+    }
+
+
+    inline void blackbody (Kelvin T, Nanometer const *first, Nanometer const *last,
+                           float *out) noexcept
+    {
+        detail::blackbody::kernel(static_cast<float>(T), detail::blackbody::c1, 1,
+                                  first, last, out);
+    }
+
+
+    inline void blackbody_normalized (Kelvin T, Nanometer const *first, Nanometer const *last,
+                                      float *out) noexcept
+    {
+        detail::blackbody::kernel(static_cast<float>(T), detail::blackbody::peak_denom,
+                                  static_cast<float>(wien_peak(T)), first, last, out);
+    }
+
+
+    template <std::size_t N>
+    inline FixedSpectrum<N> blackbody (Kelvin T, Nanometer lambda_min,
+                                       Nanometer lambda_max) noexcept
+    {
+        return detail::blackbody::spectrum<N>(static_cast<float>(T), detail::blackbody::c1, 1,
+                                              lambda_min, lambda_max);
+    }
+
+
+    template <std::size_t N>
+    inline FixedSpectrum<N> blackbody_normalized (Kelvin T, Nanometer lambda_min,
+                                                  Nanometer lambda_max) noexcept
+    {
+        return detail::blackbody::spectrum<N>(static_cast<float>(T),
+                                              detail::blackbody::peak_denom,
+                                              static_cast<float>(wien_peak(T)),
+                                              lambda_min, lambda_max);
+    }
+
+
+    template <typename T>
+    inline XYZ<T> blackbody_xyz (Kelvin temperature)
+    {
+        using namespace detail::blackbody;
+        if (temperature < Kelvin(1000) || temperature > Kelvin(40000))
+            throw std::out_of_range("blackbody_xyz: temperature must be in [1000K..40000K]");
+
+        auto const &table = locus();
+        const float f = 1e6f / static_cast<float>(temperature) - mired_min;
+        const std::size_t i = std::min(std::size_t(f), table.size()-2);
+        const double t = f - i;
+        const XYZ<double> xyz = table[i]*(1-t) + table[i+1]*t;
+        return XYZ<T>(T(xyz.X), T(xyz.Y), T(xyz.Z));
+    }
+
+} }
+
+#endif // BLACKBODY_HH_INCLUDED_20261018
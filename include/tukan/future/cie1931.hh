@@ -0,0 +1,144 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef CIE1931_HH_INCLUDED_20261018
+#define CIE1931_HH_INCLUDED_20261018
+
+#include "../Nanometer.hh"
+#include "../XYZ.hh"
+#include <cstddef>
+
+namespace tukan { namespace future { namespace cie1931 {
+
+    //----------------------------------------------------------------------------------------------
+    // CIE 1931 2° standard observer, tabulated in 10nm steps from 380nm to 780nm.
+    //
+    // Values from: CIE 15:2004, Table T.4 (also http://www.cvrl.org/).
+    //----------------------------------------------------------------------------------------------
+    static constexpr std::size_t size = 41;
+    static constexpr float lambda_min  = 380;
+    static constexpr float lambda_max  = 780;
+    static constexpr float lambda_step = 10;
+
+    static constexpr double x_bar[size] = {
+        0.001368, 0.004243, 0.014310, 0.043510, 0.134380, 0.283900, 0.348280, 0.336200,
+        0.290800, 0.195360, 0.095640, 0.032010, 0.004900, 0.009300, 0.063270, 0.165500,
+        0.290400, 0.433450, 0.594500, 0.762100, 0.916300, 1.026300, 1.062200, 1.002600,
+        0.854450, 0.642400, 0.447900, 0.283500, 0.164900, 0.087400, 0.046770, 0.022700,
+        0.011359, 0.005790, 0.002899, 0.001440, 0.000690, 0.000332, 0.000166, 0.000083,
+        0.000042
+    };
+
+    static constexpr double y_bar[size] = {
+        0.000039, 0.000120, 0.000396, 0.001210, 0.004000, 0.011600, 0.023000, 0.038000,
+        0.060000, 0.090980, 0.139020, 0.208020, 0.323000, 0.503000, 0.710000, 0.862000,
+        0.954000, 0.994950, 0.995000, 0.952000, 0.870000, 0.757000, 0.631000, 0.503000,
+        0.381000, 0.265000, 0.175000, 0.107000, 0.061000, 0.032000, 0.017000, 0.008210,
+        0.004102, 0.002091, 0.001047, 0.000520, 0.000249, 0.000120, 0.000060, 0.000030,
+        0.000015
+    };
+
+    static constexpr double z_bar[size] = {
+        0.006450, 0.020050, 0.067850, 0.207400, 0.645600, 1.385600, 1.747060, 1.772110,
+        1.669200, 1.287640, 0.812950, 0.465180, 0.272000, 0.158200, 0.078250, 0.042160,
+        0.020300, 0.008750, 0.003900, 0.002100, 0.001650, 0.001100, 0.000800, 0.000340,
+        0.000190, 0.000050, 0.000020, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000,
+        0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000,
+        0.000000
+    };
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // Wavelength of the i-th table entry.
+    //----------------------------------------------------------------------------------------------
+    inline constexpr Nanometer wavelength(std::size_t i) noexcept {
+        return Nanometer(lambda_min + lambda_step*i);
+    }
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // Color matching functions at an arbitrary wavelength (linear interpolation, 0 outside of
+    // the tabulated range).
+    //----------------------------------------------------------------------------------------------
+    inline XYZ<double> cmf(Nanometer lambda) noexcept {
+        const float f = (static_cast<float>(lambda) - lambda_min) / lambda_step;
+        if (f < 0 || f > size-1)
+            return XYZ<double>();
+        const std::size_t i = f < size-1 ? std::size_t(f) : size-2;
+        const double t = f - i;
+        return { x_bar[i]*(1-t) + x_bar[i+1]*t,
+                 y_bar[i]*(1-t) + y_bar[i+1]*t,
+                 z_bar[i]*(1-t) + z_bar[i+1]*t };
+    }
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // tristimulus:
+    //
+    //    Integrates an arbitrary spectral power distribution, given as a callable
+    //    'float(Nanometer)', against the color matching functions. The result is not normalized;
+    //    see 'normalized_tristimulus' for the usual "Y of the illuminant is 1" convention.
+    //----------------------------------------------------------------------------------------------
+    template <typename F>
+    inline XYZ<double> tristimulus(F const &spd)
+    {
+        XYZ<double> ret;
+        for (std::size_t i=0; i!=size; ++i) {
+            const double s = spd(wavelength(i));
+            ret.X += s * x_bar[i];
+            ret.Y += s * y_bar[i];
+            ret.Z += s * z_bar[i];
+        }
+        return ret * double(lambda_step);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // sampled_tristimulus:
+    //
+    //    Like 'tristimulus', but integrates over the bins of a sampled spectrum (Spectrum,
+    //    FixedSpectrum), interpolating the color matching functions instead. Use this for
+    //    spectra with narrow peaks, like fluorescent lamps, which would otherwise fall between
+    //    the 10nm steps of the table.
+    //----------------------------------------------------------------------------------------------
+    template <typename Spec>
+    inline XYZ<double> sampled_tristimulus(Spec const &spec)
+    {
+        const double lmin = static_cast<float>(spec.lambda_min()),
+                     lmax = static_cast<float>(spec.lambda_max()),
+                     step = (lmax - lmin) / (spec.size() - 1);
+        XYZ<double> ret;
+        for (std::size_t i=0; i!=spec.size(); ++i)
+            ret += cmf(Nanometer(lmin + step*i)) * double(spec[i]);
+        return ret * step;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // normalized_tristimulus:
+    //
+    //    Tristimulus values of a reflectance 'refl' lit by 'illum', scaled such that the perfect
+    //    reflector yields Y=1 (CIE 15:2004, section 7.1).
+    //----------------------------------------------------------------------------------------------
+    template <typename R, typename I>
+    inline XYZ<double> normalized_tristimulus(R const &refl, I const &illum)
+    {
+        XYZ<double> ret;
+        double k = 0;
+        for (std::size_t i=0; i!=size; ++i) {
+            const double s = illum(wavelength(i));
+            const double r = refl(wavelength(i));
+            ret.X += r * s * x_bar[i];
+            ret.Y += r * s * y_bar[i];
+            ret.Z += r * s * z_bar[i];
+            k     += s * y_bar[i];
+        }
+        return ret / k;
+    }
+
+} } }
+
+#endif // CIE1931_HH_INCLUDED_20261018
@@ -0,0 +1,361 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef ILLUMINANTS_HH_INCLUDED_20261018
+#define ILLUMINANTS_HH_INCLUDED_20261018
+
+#include "Spectrum.hh"
+#include "cie1931.hh"
+#include "../Nanometer.hh"
+#include "../XYZ.hh"
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// illuminant:
+//
+//    Spectral power distributions of the CIE standard illuminants, as compiled-in tables
+//    (no data files are read at runtime). Values from:
+//
+//      CIE 15:2004, "Colorimetry", 3rd edition. Tables T.1 (A), T.2 (daylight components S0,
+//      S1, S2) and T.6 (F1..F12).
+//
+//    A and the D-series are defined by formulae; they are generated on demand and relative to
+//    100 at 560nm. The F-series are tabulated in 5nm steps from 380nm to 780nm.
+//
+//    The whitepoints in whitepoints.hh can be re-derived from these spectra with
+//    'whitepoint_of', which is what the tests do.
+//
+//
+// Definitions:
+//
+//    constexpr FixedSpectrum<54>  S0, S1, S2       300nm..830nm, 10nm steps
+//    constexpr FixedSpectrum<81>  F1, ..., F12     380nm..780nm, 5nm steps
+//
+//    FixedSpectrum<107> A  ()                      300nm..830nm, 5nm steps
+//    FixedSpectrum<54>  E  ()
+//    FixedSpectrum<54>  D  (double cct)            throws std::out_of_range unless
+//                                                  4000K <= cct <= 25000K
+//    void               D  (double const *first, double const *last, FixedSpectrum<54> *out)
+//    FixedSpectrum<54>  D50(), D55(), D65(), D75()
+//
+//    XYZ<double> whitepoint_of (Spec const &spd)   tristimulus values, normalized to Y=1
+//
+//
+// Examples:
+//
+//    XYZ<double> wp = illuminant::whitepoint_of(illuminant::F11);
+//
+//    double ccts[] = {4000, 5000, 6000};
+//    FixedSpectrum<54> spds[3];
+//    illuminant::D(ccts, ccts+3, spds);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace future { namespace illuminant {
+
+    //----------------------------------------------------------------------------------------------
+    // Daylight components (CIE 15:2004, Table T.2).
+    //----------------------------------------------------------------------------------------------
+    static constexpr FixedSpectrum<54> S0 {Nanometer(300), Nanometer(830), {{
+          0.04f,    6.0f,   29.6f,   55.3f,   57.3f,   61.8f,   61.5f,   68.8f,   63.4f,   65.8f,
+          94.8f,  104.8f,  105.9f,   96.8f,  113.9f,  125.6f,  125.5f,  121.3f,  121.3f,  113.5f,
+         113.1f,  110.8f,  106.5f,  108.8f,  105.3f,  104.4f,  100.0f,   96.0f,   95.1f,   89.1f,
+          90.5f,   90.3f,   88.4f,   84.0f,   85.1f,   81.9f,   82.6f,   84.9f,   81.3f,   71.9f,
+          74.3f,   76.4f,   63.3f,   71.7f,   77.0f,   65.2f,   47.7f,   68.6f,   65.0f,   66.0f,
+          61.0f,   53.3f,   58.9f,   61.9f
+    }}};
+
+    static constexpr FixedSpectrum<54> S1 {Nanometer(300), Nanometer(830), {{
+          0.02f,    4.5f,   22.4f,   42.0f,   40.6f,   41.6f,   38.0f,   42.4f,   38.5f,   35.0f,
+          43.4f,   46.3f,   43.9f,   37.1f,   36.7f,   35.9f,   32.6f,   27.9f,   24.3f,   20.1f,
+          16.2f,   13.2f,    8.6f,    6.1f,    4.2f,    1.9f,    0.0f,   -1.6f,   -3.5f,   -3.5f,
+          -5.8f,   -7.2f,   -8.6f,   -9.5f,  -10.9f,  -10.7f,  -12.0f,  -14.0f,  -13.6f,  -12.0f,
+         -13.3f,  -12.9f,  -10.6f,  -11.6f,  -12.2f,  -10.2f,   -7.8f,  -11.2f,  -10.4f,  -10.6f,
+          -9.7f,   -8.3f,   -9.3f,   -9.8f
+    }}};
+
+    static constexpr FixedSpectrum<54> S2 {Nanometer(300), Nanometer(830), {{
+           0.0f,    2.0f,    4.0f,    8.5f,    7.8f,    6.7f,    5.3f,    6.1f,    3.0f,    1.2f,
+          -1.1f,   -0.5f,   -0.7f,   -1.2f,   -2.6f,   -2.9f,   -2.8f,   -2.6f,   -2.6f,   -1.8f,
+          -1.5f,   -1.3f,   -1.2f,   -1.0f,   -0.5f,   -0.3f,    0.0f,    0.2f,    0.5f,    2.1f,
+           3.2f,    4.1f,    4.7f,    5.1f,    6.7f,    7.3f,    8.6f,    9.8f,   10.2f,    8.3f,
+           9.6f,    8.5f,    7.0f,    7.6f,    8.0f,    6.7f,    5.2f,    7.4f,    6.8f,    7.0f,
+           6.4f,    5.5f,    6.1f,    6.5f
+    }}};
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // Fluorescent lamps (CIE 15:2004, Table T.6).
+    //
+    //    F1..F6 are standard halophosphate lamps, F7..F9 broadband lamps and F10..F12 narrow
+    //    triband lamps.
+    //----------------------------------------------------------------------------------------------
+    static constexpr FixedSpectrum<81> F1 {Nanometer(380), Nanometer(780), {{
+          1.87f,   2.36f,   2.94f,   3.47f,   5.17f,  19.49f,   6.13f,   6.24f,   7.01f,   7.79f,
+          8.56f,  43.67f,  16.94f,  10.72f,  11.35f,  11.89f,  12.37f,  12.75f,  13.00f,  13.15f,
+         13.23f,  13.17f,  13.13f,  12.85f,  12.52f,  12.20f,  11.83f,  11.50f,  11.22f,  11.05f,
+         11.03f,  11.18f,  11.53f,  27.74f,  17.05f,  13.55f,  14.33f,  15.01f,  15.52f,  18.29f,
+         19.55f,  15.48f,  14.91f,  14.15f,  13.22f,  12.19f,  11.12f,  10.03f,   8.95f,   7.96f,
+          7.02f,   6.20f,   5.42f,   4.73f,   4.15f,   3.64f,   3.20f,   2.81f,   2.47f,   2.18f,
+          1.93f,   1.72f,   1.67f,   1.43f,   1.29f,   1.19f,   1.08f,   0.96f,   0.88f,   0.81f,
+          0.77f,   0.75f,   0.73f,   0.68f,   0.69f,   0.64f,   0.68f,   0.69f,   0.61f,   0.52f,
+          0.43f
+    }}};
+
+    static constexpr FixedSpectrum<81> F2 {Nanometer(380), Nanometer(780), {{
+          1.18f,   1.48f,   1.84f,   2.15f,   3.44f,  15.69f,   3.85f,   3.74f,   4.19f,   4.62f,
+          5.06f,  34.98f,  11.81f,   6.27f,   6.63f,   6.93f,   7.19f,   7.40f,   7.54f,   7.62f,
+          7.65f,   7.62f,   7.62f,   7.45f,   7.28f,   7.15f,   7.05f,   7.04f,   7.16f,   7.47f,
+          8.04f,   8.88f,  10.01f,  24.88f,  16.64f,  14.59f,  16.16f,  17.56f,  18.62f,  21.47f,
+         22.79f,  19.29f,  18.66f,  17.73f,  16.54f,  15.21f,  13.80f,  12.36f,  10.95f,   9.65f,
+          8.40f,   7.32f,   6.31f,   5.43f,   4.68f,   4.02f,   3.45f,   2.96f,   2.55f,   2.19f,
+          1.89f,   1.64f,   1.53f,   1.27f,   1.10f,   0.99f,   0.88f,   0.76f,   0.68f,   0.61f,
+          0.56f,   0.54f,   0.51f,   0.47f,   0.47f,   0.43f,   0.46f,   0.47f,   0.40f,   0.33f,
+          0.27f
+    }}};
+
+    static constexpr FixedSpectrum<81> F3 {Nanometer(380), Nanometer(780), {{
+          0.82f,   1.02f,   1.26f,   1.44f,   2.57f,  14.36f,   2.70f,   2.45f,   2.73f,   3.00f,
+          3.28f,  31.85f,   9.47f,   4.02f,   4.25f,   4.44f,   4.59f,   4.72f,   4.80f,   4.86f,
+          4.87f,   4.85f,   4.88f,   4.77f,   4.67f,   4.62f,   4.62f,   4.73f,   4.99f,   5.48f,
+          6.25f,   7.34f,   8.78f,  23.82f,  16.14f,  14.59f,  16.63f,  18.49f,  19.95f,  23.11f,
+         24.69f,  21.41f,  20.85f,  19.93f,  18.67f,  17.22f,  15.65f,  14.04f,  12.45f,  10.95f,
+          9.51f,   8.27f,   7.11f,   6.09f,   5.22f,   4.45f,   3.80f,   3.23f,   2.75f,   2.33f,
+          1.99f,   1.70f,   1.55f,   1.27f,   1.09f,   0.96f,   0.83f,   0.71f,   0.62f,   0.54f,
+          0.49f,   0.46f,   0.43f,   0.39f,   0.39f,   0.35f,   0.38f,   0.39f,   0.33f,   0.28f,
+          0.21f
+    }}};
+
+    static constexpr FixedSpectrum<81> F4 {Nanometer(380), Nanometer(780), {{
+          0.57f,   0.70f,   0.87f,   0.98f,   2.01f,  13.75f,   1.95f,   1.59f,   1.76f,   1.93f,
+          2.10f,  30.28f,   8.03f,   2.55f,   2.70f,   2.82f,   2.91f,   2.99f,   3.04f,   3.08f,
+          3.09f,   3.09f,   3.14f,   3.06f,   3.00f,   2.98f,   3.01f,   3.14f,   3.41f,   3.90f,
+          4.69f,   5.81f,   7.32f,  22.59f,  15.11f,  13.88f,  16.33f,  18.68f,  20.64f,  24.28f,
+         26.26f,  23.28f,  22.94f,  22.14f,  20.91f,  19.43f,  17.74f,  16.00f,  14.42f,  12.56f,
+         10.93f,   9.52f,   8.18f,   7.01f,   6.00f,   5.11f,   4.36f,   3.69f,   3.13f,   2.64f,
+          2.24f,   1.91f,   1.70f,   1.39f,   1.18f,   1.03f,   0.88f,   0.74f,   0.64f,   0.54f,
+          0.49f,   0.46f,   0.42f,   0.37f,   0.37f,   0.33f,   0.35f,   0.36f,   0.31f,   0.26f,
+          0.19f
+    }}};
+
+    static constexpr FixedSpectrum<81> F5 {Nanometer(380), Nanometer(780), {{
+          1.87f,   2.35f,   2.92f,   3.45f,   5.10f,  18.91f,   6.00f,   6.11f,   6.85f,   7.58f,
+          8.31f,  40.76f,  16.06f,  10.32f,  10.91f,  11.40f,  11.83f,  12.17f,  12.40f,  12.54f,
+         12.58f,  12.52f,  12.47f,  12.20f,  11.89f,  11.61f,  11.33f,  11.10f,  10.96f,  10.97f,
+         11.16f,  11.54f,  12.12f,  27.78f,  17.73f,  14.47f,  15.20f,  15.77f,  16.10f,  18.54f,
+         19.50f,  15.39f,  14.64f,  13.72f,  12.69f,  11.57f,  10.45f,   9.35f,   8.29f,   7.32f,
+          6.41f,   5.63f,   4.90f,   4.26f,   3.72f,   3.25f,   2.83f,   2.49f,   2.19f,   1.93f,
+          1.71f,   1.52f,   1.43f,   1.26f,   1.13f,   1.05f,   0.96f,   0.85f,   0.78f,   0.72f,
+          0.68f,   0.67f,   0.65f,   0.61f,   0.62f,   0.59f,   0.62f,   0.64f,   0.55f,   0.47f,
+          0.40f
+    }}};
+
+    static constexpr FixedSpectrum<81> F6 {Nanometer(380), Nanometer(780), {{
+          1.05f,   1.31f,   1.63f,   1.90f,   3.11f,  14.80f,   3.43f,   3.30f,   3.68f,   4.07f,
+          4.45f,  32.61f,  10.74f,   5.48f,   5.78f,   6.03f,   6.25f,   6.41f,   6.52f,   6.58f,
+          6.59f,   6.56f,   6.56f,   6.42f,   6.28f,   6.20f,   6.19f,   6.30f,   6.60f,   7.12f,
+          7.94f,   9.07f,  10.49f,  25.22f,  17.46f,  15.63f,  17.22f,  18.53f,  19.43f,  21.97f,
+         23.01f,  19.41f,  18.56f,  17.42f,  16.09f,  14.64f,  13.15f,  11.68f,  10.25f,   8.95f,
+          7.74f,   6.69f,   5.71f,   4.87f,   4.16f,   3.55f,   3.02f,   2.57f,   2.20f,   1.87f,
+          1.60f,   1.37f,   1.29f,   1.05f,   0.91f,   0.81f,   0.71f,   0.61f,   0.54f,   0.48f,
+          0.44f,   0.43f,   0.40f,   0.37f,   0.38f,   0.35f,   0.39f,   0.41f,   0.33f,   0.26f,
+          0.21f
+    }}};
+
+    static constexpr FixedSpectrum<81> F7 {Nanometer(380), Nanometer(780), {{
+          2.56f,   3.18f,   3.84f,   4.53f,   6.15f,  19.37f,   7.37f,   7.05f,   7.71f,   8.41f,
+          9.15f,  44.14f,  17.52f,  11.35f,  12.00f,  12.58f,  13.08f,  13.45f,  13.71f,  13.88f,
+         13.95f,  13.93f,  13.82f,  13.64f,  13.43f,  13.25f,  13.08f,  12.93f,  12.78f,  12.60f,
+         12.44f,  12.33f,  12.26f,  29.52f,  17.05f,  12.44f,  12.58f,  12.72f,  12.83f,  15.46f,
+         16.75f,  12.83f,  12.67f,  12.45f,  12.19f,  11.89f,  11.60f,  11.35f,  11.12f,  10.95f,
+         10.76f,  10.42f,  10.11f,  10.04f,  10.02f,  10.11f,   9.87f,   8.65f,   7.27f,   6.44f,
+          5.83f,   5.41f,   5.04f,   4.57f,   4.12f,   3.77f,   3.46f,   3.08f,   2.73f,   2.47f,
+          2.25f,   2.06f,   1.90f,   1.75f,   1.62f,   1.54f,   1.45f,   1.32f,   1.17f,   0.99f,
+          0.81f
+    }}};
+
+    static constexpr FixedSpectrum<81> F8 {Nanometer(380), Nanometer(780), {{
+          1.21f,   1.50f,   1.81f,   2.13f,   3.17f,  13.08f,   3.83f,   3.45f,   3.86f,   4.42f,
+          5.09f,  34.10f,  12.42f,   7.68f,   8.60f,   9.46f,  10.24f,  10.84f,  11.33f,  11.71f,
+         11.98f,  12.17f,  12.28f,  12.32f,  12.35f,  12.44f,  12.55f,  12.68f,  12.77f,  12.72f,
+         12.60f,  12.43f,  12.22f,  28.96f,  16.51f,  11.79f,  11.76f,  11.77f,  11.84f,  14.61f,
+         16.11f,  12.34f,  12.53f,  12.72f,  12.92f,  13.12f,  13.34f,  13.61f,  13.87f,  14.07f,
+         14.20f,  14.16f,  14.13f,  14.34f,  14.50f,  14.46f,  14.00f,  12.58f,  10.99f,   9.98f,
+          9.22f,   8.62f,   8.07f,   7.39f,   6.71f,   6.16f,   5.63f,   5.03f,   4.46f,   4.02f,
+          3.66f,   3.36f,   3.09f,   2.85f,   2.65f,   2.51f,   2.37f,   2.15f,   1.89f,   1.61f,
+          1.32f
+    }}};
+
+    static constexpr FixedSpectrum<81> F9 {Nanometer(380), Nanometer(780), {{
+          0.90f,   1.12f,   1.36f,   1.60f,   2.59f,  12.80f,   3.05f,   2.56f,   2.86f,   3.30f,
+          3.82f,  32.62f,  10.77f,   5.84f,   6.57f,   7.25f,   7.86f,   8.35f,   8.75f,   9.06f,
+          9.31f,   9.48f,   9.61f,   9.68f,   9.74f,   9.88f,  10.04f,  10.26f,  10.48f,  10.63f,
+         10.78f,  10.96f,  11.18f,  27.71f,  16.29f,  12.28f,  12.74f,  13.21f,  13.65f,  16.57f,
+         18.14f,  14.55f,  14.65f,  14.66f,  14.61f,  14.50f,  14.39f,  14.40f,  14.47f,  14.62f,
+         14.72f,  14.55f,  14.40f,  14.58f,  14.88f,  15.51f,  15.47f,  13.20f,  10.57f,   9.18f,
+          8.25f,   7.57f,   7.03f,   6.35f,   5.72f,   5.25f,   4.80f,   4.29f,   3.80f,   3.43f,
+          3.12f,   2.86f,   2.64f,   2.43f,   2.26f,   2.14f,   2.02f,   1.83f,   1.61f,   1.38f,
+          1.12f
+    }}};
+
+    static constexpr FixedSpectrum<81> F10 {Nanometer(380), Nanometer(780), {{
+          1.11f,   0.63f,   0.62f,   0.57f,   1.48f,  12.16f,   2.12f,   2.70f,   3.74f,   5.14f,
+          6.75f,  34.39f,  14.86f,  10.40f,  10.76f,  10.67f,  10.11f,   9.27f,   8.29f,   7.29f,
+          7.91f,  16.64f,  16.73f,  10.44f,   5.94f,   3.34f,   2.35f,   1.88f,   1.59f,   1.47f,
+          1.80f,   5.71f,  40.98f,  73.69f,  33.61f,   8.24f,   3.38f,   2.47f,   2.14f,   4.86f,
+         11.45f,  14.79f,  12.16f,   8.97f,   6.52f,   8.31f,  44.12f,  34.55f,  12.09f,  12.15f,
+         10.52f,   4.43f,   1.95f,   2.19f,   3.19f,   2.77f,   2.29f,   2.00f,   1.52f,   1.35f,
+          1.47f,   1.79f,   1.74f,   1.02f,   1.14f,   3.32f,   4.49f,   2.05f,   0.49f,   0.24f,
+          0.21f,   0.21f,   0.24f,   0.24f,   0.21f,   0.17f,   0.21f,   0.22f,   0.17f,   0.12f,
+          0.09f
+    }}};
+
+    static constexpr FixedSpectrum<81> F11 {Nanometer(380), Nanometer(780), {{
+          0.91f,   0.63f,   0.46f,   0.37f,   1.29f,  12.68f,   1.59f,   1.79f,   2.46f,   3.33f,
+          4.49f,  33.94f,  12.13f,   6.95f,   7.19f,   7.12f,   6.72f,   6.13f,   5.46f,   4.79f,
+          5.66f,  14.29f,  14.96f,   8.97f,   4.72f,   2.33f,   1.47f,   1.10f,   0.89f,   0.83f,
+          1.18f,   4.90f,  39.59f,  72.84f,  32.61f,   7.52f,   2.83f,   1.96f,   1.67f,   4.43f,
+         11.28f,  14.76f,  12.73f,   9.74f,   7.33f,   9.72f,  55.27f,  42.58f,  13.18f,  13.16f,
+         12.26f,   5.11f,   2.07f,   2.34f,   3.58f,   3.01f,   2.48f,   2.14f,   1.54f,   1.33f,
+          1.46f,   1.94f,   2.00f,   1.20f,   1.35f,   4.10f,   5.58f,   2.51f,   0.57f,   0.27f,
+          0.23f,   0.21f,   0.24f,   0.24f,   0.20f,   0.24f,   0.32f,   0.26f,   0.16f,   0.12f,
+          0.09f
+    }}};
+
+    static constexpr FixedSpectrum<81> F12 {Nanometer(380), Nanometer(780), {{
+          0.96f,   0.64f,   0.40f,   0.33f,   1.19f,  12.48f,   1.12f,   0.94f,   1.08f,   1.37f,
+          1.78f,  29.05f,   7.90f,   2.65f,   2.71f,   2.65f,   2.49f,   2.33f,   2.10f,   1.91f,
+          3.01f,  10.83f,  11.88f,   6.88f,   3.43f,   1.49f,   0.92f,   0.71f,   0.60f,   0.63f,
+          1.10f,   4.56f,  34.40f,  65.40f,  29.48f,   7.16f,   3.08f,   2.47f,   2.27f,   5.09f,
+         11.96f,  15.32f,  14.27f,  11.86f,   9.28f,  12.31f,  68.53f,  53.02f,  14.67f,  14.38f,
+         14.71f,   6.46f,   2.57f,   2.75f,   4.18f,   3.44f,   2.81f,   2.42f,   1.64f,   1.36f,
+          1.49f,   2.14f,   2.34f,   1.42f,   1.61f,   5.04f,   6.98f,   3.19f,   0.71f,   0.30f,
+          0.26f,   0.23f,   0.28f,   0.28f,   0.21f,   0.17f,   0.21f,   0.19f,   0.15f,   0.10f,
+          0.05f
+    }}};
+
+
+
+    //----------------------------------------------------------------------------------------------
+    // Generated illuminants.
+    //----------------------------------------------------------------------------------------------
+    FixedSpectrum<107> A () noexcept ;
+    FixedSpectrum<54>  E () noexcept ;
+
+    FixedSpectrum<54> D (double cct);
+    void D (double const *first, double const *last, FixedSpectrum<54> *out);
+
+    FixedSpectrum<54> D50 () noexcept ;
+    FixedSpectrum<54> D55 () noexcept ;
+    FixedSpectrum<54> D65 () noexcept ;
+    FixedSpectrum<54> D75 () noexcept ;
+
+    template <typename Spec>
+    XYZ<double> whitepoint_of (Spec const &spd);
+
+} } }
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan { namespace future { namespace illuminant {
+
+    namespace detail {
+        // CIE 15:2004, eq. 3.1: Planck's law at T = 2848K with c2 = 1.435e7 nm K, normalized
+        // to 100 at 560nm. Only c2/T enters the formula, so this is the same curve as a 2856K
+        // radiator under the current c2 = 1.4388e7 nm K (the two ratios differ by 0.02%); the
+        // standard keeps the old pair so the tabulated values stay unchanged.
+        inline float A (double lambda) noexcept {
+            const double c2 = 1.435e7, T = 2848;
+            return float(100 * std::pow(560/lambda, 5)
+                             * std::expm1(c2/(T*560)) / std::expm1(c2/(T*lambda)));
+        }
+
+        // Weights of S1 and S2 for a correlated color temperature (CIE 15:2004, eqs. 3.3-3.6).
+        // M1 and M2 are rounded to three decimals as the standard demands; without that,
+        // D65 would not reproduce the tabulated values.
+        inline void daylight_weights (double cct, float &m1, float &m2)
+        {
+            if (cct < 4000 || cct > 25000)
+                throw std::out_of_range("illuminant::D: correlated color temperature "
+                                        "must be in [4000K..25000K]");
+            const double t = 1/cct;
+            const double x = cct <= 7000
+                           ? ((-4.6070e9*t + 2.9678e6)*t + 0.09911e3)*t + 0.244063
+                           : ((-2.0064e9*t + 1.9018e6)*t + 0.24748e3)*t + 0.237040;
+            const double y = -3*x*x + 2.870*x - 0.275;
+            const double M = 0.0241 + 0.2562*x - 0.7341*y;
+            m1 = float(std::round(1000 * (-1.3515 -  1.7703*x +  5.9114*y) / M) / 1000);
+            m2 = float(std::round(1000 * ( 0.0300 - 31.4424*x + 30.0717*y) / M) / 1000);
+        }
+
+        inline void daylight (float m1, float m2, FixedSpectrum<54> &out) noexcept
+        {
+            out = FixedSpectrum<54>(S0.lambda_min(), S0.lambda_max());
+            for (std::size_t i=0; i!=54; ++i)
+                out[i] = S0[i] + m1*S1[i] + m2*S2[i];
+        }
+    }
+
+
+    inline FixedSpectrum<107> A () noexcept
+    {
+        FixedSpectrum<107> ret {Nanometer(300), Nanometer(830)};
+        for (std::size_t i=0; i!=ret.size(); ++i)
+            ret[i] = detail::A(300 + 5*i);
+        return ret;
+    }
+
+
+    inline FixedSpectrum<54> E () noexcept
+    {
+        FixedSpectrum<54> ret {Nanometer(300), Nanometer(830)};
+        for (std::size_t i=0; i!=ret.size(); ++i)
+            ret[i] = 100;
+        return ret;
+    }
+
+
+    inline FixedSpectrum<54> D (double cct)
+    {
+        float m1, m2;
+        detail::daylight_weights(cct, m1, m2);
+        FixedSpectrum<54> ret;
+        detail::daylight(m1, m2, ret);
+        return ret;
+    }
+
+
+    inline void D (double const *first, double const *last, FixedSpectrum<54> *out)
+    {
+        for (; first!=last; ++first, ++out) {
+            float m1, m2;
+            detail::daylight_weights(*first, m1, m2);
+            detail::daylight(m1, m2, *out);
+        }
+    }
+
+
+    // The nominal temperatures times 1.4388/1.4380, for the change of c2 in 1968.
+    inline FixedSpectrum<54> D50 () noexcept { return D(5003); }
+    inline FixedSpectrum<54> D55 () noexcept { return D(5503); }
+    inline FixedSpectrum<54> D65 () noexcept { return D(6504); }
+    inline FixedSpectrum<54> D75 () noexcept { return D(7504); }
+
+
+    template <typename Spec>
+    inline XYZ<double> whitepoint_of (Spec const &spd)
+    {
+        const XYZ<double> xyz = cie1931::sampled_tristimulus(spd);
+        return xyz / xyz.Y;
+    }
+
+} } }
+
+#endif // ILLUMINANTS_HH_INCLUDED_20261018
@@ -0,0 +1,534 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef GAMUT_HH_INCLUDED_20261018
+#define GAMUT_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "luminance.hh"
+#include "profile.hh"
+#include "detail/Matrix33.hh"
+#include "detail/exp.hh"
+#include "detail/planes.hh"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Gamut mapping:
+//
+//    Converting between RGB spaces (e.g. ProPhotoRGB to sRGB) gives channels outside [0..1]
+//    for colours the target cannot show. gamut_map() converts into the target space and brings
+//    such colours into [0..1] with one of these strategies:
+//
+//    Clip            Clamps each channel. Cheapest; shifts the hue of saturated colours.
+//    LuminanceClip   Moves the colour towards the grey of its luminance (clamped to [0..1])
+//                    until all channels are in range. Keeps luminance and, roughly, hue.
+//    Compress        ACES reference gamut compression: the distance of each channel from the
+//                    largest one is compressed smoothly beyond 'threshold', so that distances
+//                    up to 'limit' land within the gamut. Also alters colours inside the gamut
+//                    near its boundary, which keeps gradients smooth. The defaults are those
+//                    of ACES 1.3. What is still out of range (e.g. above 1) is clipped.
+//    OklchChroma     Reduces the chroma in Oklch, keeping Oklab lightness (clamped to [0..1])
+//                    and hue, by bisection for the largest chroma that is in gamut. The most
+//                    faithful and the most expensive one. Oklab's LMS is normalized to the
+//                    target's white, so that its grey axis stays neutral in spaces with a
+//                    white point other than D65.
+//
+//    A colour is out of gamut if a channel is outside [0..1] by more than 1e-5, so that
+//    rounding in the conversion does not count. Colours in the gamut are kept (up to clamping
+//    to [0..1]) by all strategies but Compress.
+//
+//    The batch versions return the number of pixels that were out of gamut, and write an
+//    optional mask with 1 for those and 0 for the others. They split rows into planes, like
+//    tone mapping (tonemap.hh), so that the strategies vectorize; the ImageView versions are
+//    also parallel over rows. Strategies are function objects that map planes of colours in
+//    place, in the target space:
+//
+//        struct Strategy {
+//            static constexpr char const* name ();                 // for profile.hh
+//            template <typename T>
+//            void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+//                             GamutTarget<T> const &target) const noexcept ;
+//        };
+//
+//
+// Definitions:
+//
+//    // Per-space data of the strategies, computed on the first call per value type and space.
+//    template <typename T>
+//    struct GamutTarget {
+//        LuminanceWeights<T> y;
+//        detail::Matrix33<T> rgb_to_lms, lms_to_rgb;   // Oklab's LMS, normalized to the white
+//    };
+//    GamutTarget<T> const& gamut_target <T, RGBSpace> ()
+//
+//    struct Clip { };
+//    struct LuminanceClip { };
+//    struct Compress {
+//        double threshold[3] = {0.815, 0.803, 0.880},  // cyan, magenta, yellow
+//               limit[3]     = {1.147, 1.264, 1.312},
+//               power        = 1.2;
+//    };
+//    struct OklchChroma {
+//        int steps = 16;                               // of the bisection
+//    };
+//
+//    // In its own space, or converted to To.
+//    LinearRGB<T,S>  gamut_map      (LinearRGB<T,S> c, Strategy const &s)
+//    LinearRGB<T,To> gamut_map <To> (LinearRGB<T,From> c, Strategy const &s)
+//
+//    // 'out' may be 'first'; 'mask', if not null, receives one byte per pixel.
+//    std::size_t gamut_map (LinearRGB<T,From> const *first, LinearRGB<T,From> const *last,
+//                           LinearRGB<T,To> *out, Strategy const &s, std::uint8_t *mask = nullptr)
+//    // Throw std::logic_error if the views differ in extent.
+//    std::size_t gamut_map (ImageView<In> in, ImageView<Out> out, Strategy const &s)
+//    std::size_t gamut_map (ImageView<In> in, ImageView<Out> out, ImageView<std::uint8_t> mask,
+//                           Strategy const &s)
+//
+//
+// Examples:
+//
+//    const auto c = gamut_map<sRGB>(LinearRGB<float,ProPhotoRGB>(0.1f, 0.8f, 0.2f), OklchChroma());
+//
+//    std::vector<LinearRGB<float,sRGB>> display (w*h);
+//    const std::size_t clipped = gamut_map(image_view(photo.data(), w, h),
+//                                          image_view(display.data(), w, h), Compress());
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    template <typename T>
+    struct GamutTarget {
+        LuminanceWeights<T> y;
+        detail::Matrix33<T> rgb_to_lms, lms_to_rgb;
+    };
+
+    template <typename T, template <typename> class RGBSpace>
+    GamutTarget<T> const& gamut_target () noexcept ;
+
+
+    //----------------------------------------------------------------------------------------------
+    // Strategies
+    //----------------------------------------------------------------------------------------------
+    struct Clip {
+        static constexpr char const* name () noexcept { return "clip"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         GamutTarget<T> const &target) const noexcept ;
+    };
+
+
+    struct LuminanceClip {
+        static constexpr char const* name () noexcept { return "luminance_clip"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         GamutTarget<T> const &target) const noexcept ;
+    };
+
+
+    struct Compress {
+        double threshold[3] = {0.815, 0.803, 0.880},
+               limit[3] = {1.147, 1.264, 1.312},
+               power = 1.2;
+
+        static constexpr char const* name () noexcept { return "compress"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         GamutTarget<T> const &target) const noexcept ;
+    };
+
+
+    struct OklchChroma {
+        int steps = 16;
+
+        static constexpr char const* name () noexcept { return "oklch"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         GamutTarget<T> const &target) const noexcept ;
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Application
+    //----------------------------------------------------------------------------------------------
+    template <typename T, template <typename> class RGBSpace, typename Strategy>
+    LinearRGB<T,RGBSpace> gamut_map (LinearRGB<T,RGBSpace> c, Strategy const &s) noexcept ;
+
+    template <template <typename> class To, typename T, template <typename> class From,
+              typename Strategy>
+    LinearRGB<T,To> gamut_map (LinearRGB<T,From> c, Strategy const &s) noexcept ;
+
+    template <typename T, template <typename> class From, template <typename> class To,
+              typename Strategy>
+    std::size_t gamut_map (LinearRGB<T,From> const *first, LinearRGB<T,From> const *last,
+                           LinearRGB<T,To> *out, Strategy const &s,
+                           std::uint8_t *mask = nullptr) noexcept ;
+
+    template <typename In, typename Out, typename Strategy>
+    std::size_t gamut_map (ImageView<In> in, ImageView<Out> out, Strategy const &s);
+
+    template <typename In, typename Out, typename Strategy>
+    std::size_t gamut_map (ImageView<In> in, ImageView<Out> out, ImageView<std::uint8_t> mask,
+                           Strategy const &s);
+
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+        // Oklab, after Björn Ottosson: XYZ (D65) to LMS, and the cube roots of LMS to Lab.
+        inline Matrix33<double> oklab_xyz_to_lms () noexcept {
+            return {0.8189330101, 0.3618667424, -0.1288597137,
+                    0.0329845436, 0.9293118715,  0.0361456387,
+                    0.0482003018, 0.2643662691,  0.6338517070};
+        }
+
+        template <typename T>
+        inline Matrix33<T> oklab_lms_to_lab () noexcept {
+            return {T(0.2104542553),  T(0.7936177850), T(-0.0040720468),
+                    T(1.9779984951), T(-2.4285922050),  T(0.4505937099),
+                    T(0.0259040371),  T(0.7827717662), T(-0.8086757660)};
+        }
+
+        template <typename T>
+        inline Matrix33<T> oklab_lab_to_lms () noexcept {
+            return {T(1),  T(0.3963377774),  T(0.2158037573),
+                    T(1), T(-0.1055613458), T(-0.0638541728),
+                    T(1), T(-0.0894841775), T(-1.2914855480)};
+        }
+
+        constexpr double gamut_tolerance = 1e-5;
+    }
+
+
+    template <typename T, template <typename> class RGBSpace>
+    inline GamutTarget<T> const& gamut_target () noexcept
+    {
+        static const GamutTarget<T> target = [] {
+            using detail::Matrix33;
+            Matrix33<double> m = detail::oklab_xyz_to_lms() * RGBSpace<double>().rgb_to_xyz;
+            // Rows scaled so that the space's white is LMS (1,1,1).
+            const double l = m._11 + m._12 + m._13,
+                         s = m._21 + m._22 + m._23,
+                         v = m._31 + m._32 + m._33;
+            m = Matrix33<double>(m._11/l, m._12/l, m._13/l,
+                                 m._21/s, m._22/s, m._23/s,
+                                 m._31/v, m._32/v, m._33/v);
+            const Matrix33<double> i = inverse(m);
+            return GamutTarget<T>{
+                luminance_weights<T,RGBSpace>(),
+                {T(m._11), T(m._12), T(m._13), T(m._21), T(m._22), T(m._23),
+                 T(m._31), T(m._32), T(m._33)},
+                {T(i._11), T(i._12), T(i._13), T(i._21), T(i._22), T(i._23),
+                 T(i._31), T(i._32), T(i._33)}
+            };
+        }();
+        return target;
+    }
+
+
+    namespace detail {
+        template <typename T>
+        inline bool in_gamut (T r, T g, T b) noexcept {
+            const T lo = T(-gamut_tolerance), hi = T(1 + gamut_tolerance);
+            return (r >= lo) & (r <= hi) & (g >= lo) & (g <= hi) & (b >= lo) & (b <= hi);
+        }
+    }
+
+
+    // Clip
+    template <typename T>
+    inline void Clip::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                  GamutTarget<T> const &) const noexcept
+    {
+        detail::map_planes(r, g, b, n, [](T v) { return detail::clamp01(v); });
+    }
+
+
+    // LuminanceClip
+    namespace detail {
+        // The largest t <= 'limit' for which l + t*d is within [0..1].
+        template <typename T>
+        inline T luminance_clip_limit (T l, T d, T limit) noexcept {
+            const T room = select(d > 0, 1 - l, -l);
+            const T t = select(d != 0, room / d, limit);
+            return select(t < limit, t, limit);
+        }
+    }
+
+    template <typename T>
+    inline void LuminanceClip::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                           GamutTarget<T> const &target) const noexcept
+    {
+        using detail::clamp01;
+        using detail::luminance_clip_limit;
+        const T kr = target.y.r, kg = target.y.g, kb = target.y.b;
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i) {
+            const T l = clamp01(kr*r[i] + kg*g[i] + kb*b[i]);
+            const T dr = r[i] - l, dg = g[i] - l, db = b[i] - l;
+            T t = luminance_clip_limit(l, dr, T(1));
+            t = luminance_clip_limit(l, dg, t);
+            t = luminance_clip_limit(l, db, t);
+            r[i] = clamp01(l + t*dr);
+            g[i] = clamp01(l + t*dg);
+            b[i] = clamp01(l + t*db);
+        }
+    }
+
+
+    // Compress
+    namespace detail {
+        // One channel: its distance from 'ach', the largest channel, relative to |ach|.
+        template <typename T>
+        inline void compress_plane (T *v, T const *ach, std::ptrdiff_t n,
+                                    double threshold, double limit, double power) noexcept
+        {
+            const double s = (limit - threshold)
+                           / std::pow(std::pow((1 - threshold) / (limit - threshold), -power) - 1,
+                                      1 / power);
+            const T thr = T(threshold), inv_scale = T(1 / s), scale = T(s),
+                    p = T(power), inv_p = T(1 / power);
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const T a = ach[i], abs_a = select(a < 0, -a, a);
+                const T d = select(a != 0, (a - v[i]) / abs_a, T(0));
+                const T x = select(d > thr, (d - thr) * inv_scale, T(0));
+                const T c = thr + scale * x / pow_simd(1 + pow_simd(x, p), inv_p);
+                v[i] = a - select(d > thr, c, d) * abs_a;
+            }
+        }
+    }
+
+    template <typename T>
+    inline void Compress::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                      GamutTarget<T> const &) const noexcept
+    {
+        T ach[detail::plane_chunk];
+        for (std::ptrdiff_t first=0; first<n; first+=detail::plane_chunk) {
+            const std::ptrdiff_t c = std::min(detail::plane_chunk, n - first);
+            T *pr = r + first, *pg = g + first, *pb = b + first;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<c; ++i) {
+                const T m = pr[i] > pg[i] ? pr[i] : pg[i];
+                ach[i] = m > pb[i] ? m : pb[i];
+            }
+            detail::compress_plane(pr, ach, c, threshold[0], limit[0], power);
+            detail::compress_plane(pg, ach, c, threshold[1], limit[1], power);
+            detail::compress_plane(pb, ach, c, threshold[2], limit[2], power);
+            detail::map_planes(pr, pg, pb, c, [](T v) { return detail::clamp01(v); });
+        }
+    }
+
+
+    // OklchChroma
+    namespace detail {
+        // RGB of the Oklab colour (L, t*a, t*b).
+        template <typename T>
+        struct oklab_to_rgb {
+            Matrix33<T> lab_to_lms, lms_to_rgb;
+
+            void operator() (T L, T a, T b, T t, T &r, T &g, T &bl) const noexcept {
+                const Matrix33<T> &m = lab_to_lms, &k = lms_to_rgb;
+                a *= t;
+                b *= t;
+                T l = L + m._12*a + m._13*b,
+                  s = L + m._22*a + m._23*b,
+                  v = L + m._32*a + m._33*b;
+                l = l*l*l;
+                s = s*s*s;
+                v = v*v*v;
+                r  = k._11*l + k._12*s + k._13*v;
+                g  = k._21*l + k._22*s + k._23*v;
+                bl = k._31*l + k._32*s + k._33*v;
+            }
+        };
+
+        // Planes of at most plane_chunk colours.
+        template <typename T>
+        inline void oklch_chroma (T *r, T *g, T *b, std::ptrdiff_t n, int steps,
+                                  GamutTarget<T> const &target) noexcept
+        {
+            T L[plane_chunk], A[plane_chunk], B[plane_chunk], lo[plane_chunk], hi[plane_chunk];
+            const Matrix33<T> to_lms = target.rgb_to_lms;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const T vr = r[i], vg = g[i], vb = b[i];
+                L[i] = to_lms._11*vr + to_lms._12*vg + to_lms._13*vb;
+                A[i] = to_lms._21*vr + to_lms._22*vg + to_lms._23*vb;
+                B[i] = to_lms._31*vr + to_lms._32*vg + to_lms._33*vb;
+            }
+            map_planes(L, A, B, n, [](T v) { return cbrt_simd(v); });
+            multiply_planes(L, A, B, n, oklab_lms_to_lab<T>());
+
+            // Lightness beyond white or black maps to those.
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                L[i] = clamp01(L[i]);
+                lo[i] = 0;
+                hi[i] = 1;
+            }
+
+            const oklab_to_rgb<T> to_rgb {oklab_lab_to_lms<T>(), target.lms_to_rgb};
+            for (int step=0; step<steps; ++step) {
+                #pragma omp simd
+                for (std::ptrdiff_t i=0; i<n; ++i) {
+                    const T t = (lo[i] + hi[i]) * T(0.5);
+                    T vr, vg, vb;
+                    to_rgb(L[i], A[i], B[i], t, vr, vg, vb);
+                    const bool inside = in_gamut(vr, vg, vb);
+                    lo[i] = select(inside, t, lo[i]);
+                    hi[i] = select(inside, hi[i], t);
+                }
+            }
+
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                T vr, vg, vb;
+                to_rgb(L[i], A[i], B[i], lo[i], vr, vg, vb);
+                const bool keep = in_gamut(r[i], g[i], b[i]);
+                r[i] = clamp01(select(keep, r[i], vr));
+                g[i] = clamp01(select(keep, g[i], vg));
+                b[i] = clamp01(select(keep, b[i], vb));
+            }
+        }
+    }
+
+    // In passes over the planes, one per step of the bisection.
+    template <typename T>
+    inline void OklchChroma::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                         GamutTarget<T> const &target) const noexcept
+    {
+        for (std::ptrdiff_t first=0; first<n; first+=detail::plane_chunk)
+            detail::oklch_chroma(r + first, g + first, b + first,
+                                 std::min(detail::plane_chunk, n - first), steps, target);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Application
+    //----------------------------------------------------------------------------------------------
+    namespace detail {
+        // From's RGB to To's, cached like luminance_weights().
+        template <typename T, template <typename> class From, template <typename> class To>
+        inline Matrix33<T> const& gamut_conversion () noexcept
+        {
+            static const Matrix33<T> m = [] {
+                if (std::is_same<From<double>, To<double>>::value)
+                    return Matrix33<T>();
+                const Matrix33<double> d = To<double>().xyz_to_rgb * From<double>().rgb_to_xyz;
+                return Matrix33<T>(T(d._11), T(d._12), T(d._13), T(d._21), T(d._22), T(d._23),
+                                   T(d._31), T(d._32), T(d._33));
+            }();
+            return m;
+        }
+
+        // Flags the colours that are out of gamut into 'mask', and returns their number.
+        template <typename T>
+        inline std::size_t gamut_test (T const *r, T const *g, T const *b, std::ptrdiff_t n,
+                                       std::uint8_t *mask) noexcept
+        {
+            std::size_t count = 0;
+            #pragma omp simd reduction(+:count)
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const std::uint8_t out = !in_gamut(r[i], g[i], b[i]);
+                mask[i] = out;
+                count += out;
+            }
+            return count;
+        }
+    }
+
+
+    template <typename T, template <typename> class RGBSpace, typename Strategy>
+    inline LinearRGB<T,RGBSpace> gamut_map (LinearRGB<T,RGBSpace> c, Strategy const &s) noexcept
+    {
+        T r = c.r, g = c.g, b = c.b;
+        s(&r, &g, &b, 1, gamut_target<T,RGBSpace>());
+        return {r, g, b};
+    }
+
+
+    template <template <typename> class To, typename T, template <typename> class From,
+              typename Strategy>
+    inline LinearRGB<T,To> gamut_map (LinearRGB<T,From> c, Strategy const &s) noexcept
+    {
+        detail::Matrix33<T> const &m = detail::gamut_conversion<T,From,To>();
+        return gamut_map(LinearRGB<T,To>(m._11*c.r + m._12*c.g + m._13*c.b,
+                                         m._21*c.r + m._22*c.g + m._23*c.b,
+                                         m._31*c.r + m._32*c.g + m._33*c.b), s);
+    }
+
+
+    template <typename T, template <typename> class From, template <typename> class To,
+              typename Strategy>
+    inline std::size_t gamut_map (LinearRGB<T,From> const *first, LinearRGB<T,From> const *last,
+                                  LinearRGB<T,To> *out, Strategy const &s,
+                                  std::uint8_t *mask) noexcept
+    {
+        static_assert(sizeof(LinearRGB<T,From>) == 3*sizeof(T) &&
+                      sizeof(LinearRGB<T,To>) == 3*sizeof(T),
+                      "gamut_map: pixels must be three channels without padding");
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("gamut_map", Strategy::name());
+        const profile::Scope scope (site, n, n * 2 * sizeof *first);
+
+        GamutTarget<T> const &target = gamut_target<T,To>();
+        std::size_t count = 0;
+        detail::transform_planes(reinterpret_cast<T const*>(first), n, reinterpret_cast<T*>(out),
+                                 detail::gamut_conversion<T,From,To>(),
+            [&](T *r, T *g, T *b, std::ptrdiff_t c, std::ptrdiff_t offset) {
+                std::uint8_t flags[detail::plane_chunk];
+                count += detail::gamut_test(r, g, b, c, flags);
+                if (mask)
+                    std::memcpy(mask + offset, flags, c);
+                s(r, g, b, c, target);
+            });
+        return count;
+    }
+
+
+    template <typename In, typename Out, typename Strategy>
+    inline std::size_t gamut_map (ImageView<In> in, ImageView<Out> out, Strategy const &s)
+    {
+        return gamut_map(in, out, ImageView<std::uint8_t>(), s);
+    }
+
+
+    template <typename In, typename Out, typename Strategy>
+    inline std::size_t gamut_map (ImageView<In> in, ImageView<Out> out,
+                                  ImageView<std::uint8_t> mask, Strategy const &s)
+    {
+        if (!same_extent(in, out) || (mask.data && !same_extent(in, mask)))
+            throw std::logic_error("gamut_map: views differ in extent");
+
+        const long height = static_cast<long>(in.height);
+        std::size_t count = 0;
+        #pragma omp parallel for schedule(static) reduction(+:count)
+        for (long y=0; y<height; ++y) {
+            In *first = in.row(y);
+            count += gamut_map(first, first + in.width, out.row(y), s,
+                               mask.data ? mask.row(y) : nullptr);
+        }
+        return count;
+    }
+
+}
+
+#endif // GAMUT_HH_INCLUDED_20261018
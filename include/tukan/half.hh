@@ -0,0 +1,269 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef HALF_HH_INCLUDED_20261018
+#define HALF_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "profile.hh"
+#include "detail/half.hh"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// half:
+//
+//    An IEEE 754 binary16 storage type, meant to halve the memory traffic of frame buffers and
+//    intermediate images. half converts implicitly from and to float and has no arithmetic of
+//    its own, so all arithmetic is done in float and only the result is rounded to half.
+//    Therefore it can be used as T in LinearRGB, LinearRGBA, RGB and XYZ:
+//
+//        LinearRGB<half,sRGB> c (0.5f, 0.25f, 1);
+//        c *= 2;                                     // computed in float, stored as half
+//
+//    Note that colors over half also convert to XYZ through an RGBSpace<half>, i.e. with matrix
+//    coefficients rounded to half; convert to float first where this matters.
+//
+//    If the compiler targets F16C (e.g. -mf16c or -march=native), conversions use the hardware
+//    instructions, otherwise the portable implementation in detail/half.hh. Both round to
+//    nearest even and give the same results.
+//
+//
+// Definitions:
+//
+//    half (float f)                                  rounds to nearest even
+//    operator float () const                         exact
+//    static constexpr half from_bits (uint16_t)
+//    uint16_t bits () const
+//
+//    half& operator+= (float)  -=  *=  /=
+//
+//    std::numeric_limits<half>
+//
+//    // Batch conversion of [first,last) into out, which must not overlap the input.
+//    void pack_half   (float const *first, float const *last, half *out)
+//    void unpack_half (half const *first, half const *last, float *out)
+//
+//    // Same for whole images of floats or of colors over float/half, e.g. from
+//    // ImageView<LinearRGB<float,sRGB>> to ImageView<LinearRGB<half,sRGB>>.
+//    // Throws std::logic_error if the views differ in extent.
+//    void pack_half   (ImageView<In> in, ImageView<Out> out)
+//    void unpack_half (ImageView<In> in, ImageView<Out> out)
+//
+//
+// Examples:
+//
+//    using RGBh = RebindValueType<half, LinearRGB<float,sRGB>>;   // LinearRGB<half,sRGB>
+//    std::vector<RGBh> buffer (width*height);
+//    pack_half(image_view(hdr.data(), width, height), image_view(buffer.data(), width, height));
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    //----------------------------------------------------------------------------------------------
+    // half
+    //----------------------------------------------------------------------------------------------
+    struct half {
+
+        constexpr half() noexcept = default;
+        half (float f) noexcept ;
+
+        operator float () const noexcept ;
+
+        static constexpr half from_bits (std::uint16_t bits) noexcept { return half(bits, 0); }
+        constexpr std::uint16_t bits() const noexcept { return bits_; }
+
+        half& operator+= (float rhs) noexcept { return *this = float(*this) + rhs; }
+        half& operator-= (float rhs) noexcept { return *this = float(*this) - rhs; }
+        half& operator*= (float rhs) noexcept { return *this = float(*this) * rhs; }
+        half& operator/= (float rhs) noexcept { return *this = float(*this) / rhs; }
+
+    private:
+        constexpr half (std::uint16_t bits, int) noexcept : bits_(bits) {}
+        std::uint16_t bits_ = 0;
+    };
+
+    static_assert(sizeof(half) == 2, "half must be two bytes");
+
+
+    // -- batch conversion ------------------------------------------------------------------------
+    void pack_half   (float const *first, float const *last, half *out) noexcept ;
+    void unpack_half (half const *first, half const *last, float *out) noexcept ;
+
+    template <typename In, typename Out>
+    void pack_half   (ImageView<In> in, ImageView<Out> out);
+
+    template <typename In, typename Out>
+    void unpack_half (ImageView<In> in, ImageView<Out> out);
+
+}
+
+namespace std {
+    template <>
+    class numeric_limits<tukan::half> {
+        using half = tukan::half;
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr bool has_infinity = true;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr bool has_signaling_NaN = true;
+        static constexpr float_denorm_style has_denorm = denorm_present;
+        static constexpr bool has_denorm_loss = false;
+        static constexpr float_round_style round_style = round_to_nearest;
+        static constexpr bool is_iec559 = true;
+        static constexpr bool is_bounded = true;
+        static constexpr bool is_modulo = false;
+        static constexpr int digits = 11;
+        static constexpr int digits10 = 3;
+        static constexpr int max_digits10 = 5;
+        static constexpr int radix = 2;
+        static constexpr int min_exponent = -13;
+        static constexpr int min_exponent10 = -4;
+        static constexpr int max_exponent = 16;
+        static constexpr int max_exponent10 = 4;
+        static constexpr bool traps = false;
+        static constexpr bool tinyness_before = false;
+
+        static constexpr half min()           noexcept { return half::from_bits(0x0400); }
+        static constexpr half lowest()        noexcept { return half::from_bits(0xfbff); }
+        static constexpr half max()           noexcept { return half::from_bits(0x7bff); }
+        static constexpr half epsilon()       noexcept { return half::from_bits(0x1400); }
+        static constexpr half round_error()   noexcept { return half::from_bits(0x3800); }
+        static constexpr half infinity()      noexcept { return half::from_bits(0x7c00); }
+        static constexpr half quiet_NaN()     noexcept { return half::from_bits(0x7e00); }
+        static constexpr half signaling_NaN() noexcept { return half::from_bits(0x7d00); }
+        static constexpr half denorm_min()    noexcept { return half::from_bits(0x0001); }
+    };
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    inline half::half (float f) noexcept
+#if defined(__F16C__)
+        : bits_(static_cast<std::uint16_t>(_cvtss_sh(f, 0)))
+#else
+        : bits_(detail::float_to_half_bits(f))
+#endif
+    {
+    }
+
+
+    inline half::operator float () const noexcept
+    {
+#if defined(__F16C__)
+        return _cvtsh_ss(bits_);
+#else
+        return detail::half_bits_to_float(bits_);
+#endif
+    }
+
+
+    namespace detail {
+        // For profiling.
+#if defined(__F16C__)
+        constexpr char const *half_kernel = "f16c";
+#else
+        constexpr char const *half_kernel = "portable";
+#endif
+    }
+
+
+    inline void pack_half (float const *first, float const *last, half *out) noexcept
+    {
+        static const profile::Site site ("pack_half", detail::half_kernel);
+        const profile::Scope scope (site, last - first,
+                                    (last - first) * (sizeof(float) + sizeof(half)));
+#if defined(__F16C__)
+        for (; last-first >= 8; first += 8, out += 8) {
+            const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(first), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), h);
+        }
+#endif
+        for (; first!=last; ++first, ++out)
+            *out = half(*first);
+    }
+
+
+    inline void unpack_half (half const *first, half const *last, float *out) noexcept
+    {
+        static const profile::Site site ("unpack_half", detail::half_kernel);
+        const profile::Scope scope (site, last - first,
+                                    (last - first) * (sizeof(float) + sizeof(half)));
+#if defined(__F16C__)
+        for (; last-first >= 8; first += 8, out += 8) {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+            _mm256_storeu_ps(out, _mm256_cvtph_ps(h));
+        }
+#endif
+        for (; first!=last; ++first, ++out)
+            *out = float(*first);
+    }
+
+
+    namespace detail {
+        // The number of float/half components of a pixel type, which is either float, half, or
+        // a color type over one of these (which are arrays of their value_type).
+        template <typename T>
+        struct half_components {
+            using scalar = typename T::value_type;
+            static_assert(std::is_same<scalar, float>::value || std::is_same<scalar, half>::value,
+                          "pack_half/unpack_half: pixels must be over float or half");
+            static_assert(sizeof(T) % sizeof(scalar) == 0, "pixel type with padding");
+            enum { count = sizeof(T) / sizeof(scalar) };
+        };
+        template <> struct half_components<float> { using scalar = float; enum { count = 1 }; };
+        template <> struct half_components<half>  { using scalar = half;  enum { count = 1 }; };
+
+        template <typename In, typename Out, typename InScalar, typename OutScalar>
+        void convert_half_rows (ImageView<In> in, ImageView<Out> out,
+                                void (*convert)(InScalar const*, InScalar const*, OutScalar*))
+        {
+            using I = half_components<typename std::remove_const<In>::type>;
+            using O = half_components<Out>;
+            static_assert(std::is_same<typename I::scalar, InScalar>::value &&
+                          std::is_same<typename O::scalar, OutScalar>::value,
+                          "pack_half converts float to half pixels, unpack_half half to float");
+            static_assert(int(I::count) == int(O::count),
+                          "pack_half/unpack_half: pixels differ in number of components");
+
+            transform_rows(in, out, [convert](In *first, In *last, Out *o) {
+                convert(reinterpret_cast<InScalar const*>(first),
+                        reinterpret_cast<InScalar const*>(last),
+                        reinterpret_cast<OutScalar*>(o));
+            });
+        }
+    }
+
+
+    template <typename In, typename Out>
+    inline void pack_half (ImageView<In> in, ImageView<Out> out)
+    {
+        detail::convert_half_rows<In, Out, float, half>(in, out, pack_half);
+    }
+
+
+    template <typename In, typename Out>
+    inline void unpack_half (ImageView<In> in, ImageView<Out> out)
+    {
+        detail::convert_half_rows<In, Out, half, float>(in, out, unpack_half);
+    }
+
+}
+
+#endif // HALF_HH_INCLUDED_20261018
@@ -117,4 +117,14 @@ namespace tukan {
 
 }
 
+namespace tukan {
+    namespace detail {
+        // See LinearRGB.inl.hh.
+        template <typename To, typename From, template <typename> class RGBSpace>
+        struct rebind_value_type<To, RGB<From, RGBSpace>> {
+            using type = RGB<To, RGBSpace>;
+        };
+    }
+}
+
 #endif // RGB_INL_HH_20140112
@@ -0,0 +1,158 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef LUMINANCE_HH_INCLUDED_20261018
+#define LUMINANCE_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "LinearRGBA.hh"
+#include "profile.hh"
+#include <cstddef>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Luminance:
+//
+//    The luminance Y of linear RGB colours, i.e. static_cast<XYZ<T>>(c).Y without computing X
+//    and Z: three multiplications instead of nine. The weights are the second row of the
+//    space's rgb_to_xyz matrix; constructing a space inverts its matrices, so they are computed
+//    once per value type and space, and cached.
+//
+//    The batch versions write a single-channel plane, e.g. as the input of luminance-only tone
+//    mapping; they vectorize, and the ImageView version is also parallel over rows. Alpha is
+//    ignored.
+//
+//
+// Definitions:
+//
+//    template <typename T>
+//    struct LuminanceWeights { T r, g, b; };
+//
+//    // The Y row of RGBSpace<T>().rgb_to_xyz, computed on the first call.
+//    LuminanceWeights<T> const& luminance_weights <T, RGBSpace> ()
+//
+//    // Pixel is LinearRGB<T,RGBSpace> or LinearRGBA<T,RGBSpace>.
+//    T    luminance (Pixel c)
+//    void luminance (Pixel const *first, Pixel const *last, T *out)
+//    // Throws std::logic_error if the views differ in extent.
+//    void luminance (ImageView<Pixel> in, ImageView<T> out)
+//
+//
+// Examples:
+//
+//    const float y = luminance(LinearRGB<float,sRGB>(0.2f, 0.5f, 0.1f));
+//
+//    std::vector<float> plane (w*h);
+//    luminance(image_view(frame.data(), w, h), image_view(plane.data(), w, h));
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    template <typename T>
+    struct LuminanceWeights {
+        T r, g, b;
+    };
+
+    template <typename T, template <typename> class RGBSpace>
+    LuminanceWeights<T> const& luminance_weights () noexcept ;
+
+
+    template <typename T, template <typename> class RGBSpace>
+    T luminance (LinearRGB<T,RGBSpace> c) noexcept ;
+
+    template <typename T, template <typename> class RGBSpace>
+    T luminance (LinearRGBA<T,RGBSpace> c) noexcept ;
+
+    template <typename T, template <typename> class RGBSpace>
+    void luminance (LinearRGB<T,RGBSpace> const *first, LinearRGB<T,RGBSpace> const *last,
+                    T *out) noexcept ;
+
+    template <typename T, template <typename> class RGBSpace>
+    void luminance (LinearRGBA<T,RGBSpace> const *first, LinearRGBA<T,RGBSpace> const *last,
+                    T *out) noexcept ;
+
+    template <typename Pixel, typename T>
+    void luminance (ImageView<Pixel> in, ImageView<T> out);
+
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan {
+
+    template <typename T, template <typename> class RGBSpace>
+    inline LuminanceWeights<T> const& luminance_weights () noexcept
+    {
+        static const LuminanceWeights<T> weights = [] {
+            const RGBSpace<T> space;
+            return LuminanceWeights<T>{space.rgb_to_xyz._21, space.rgb_to_xyz._22,
+                                       space.rgb_to_xyz._23};
+        }();
+        return weights;
+    }
+
+
+    // Same expression as the Y of operator XYZ<T>, so that both round alike.
+    template <typename T, template <typename> class RGBSpace>
+    inline T luminance (LinearRGB<T,RGBSpace> c) noexcept {
+        LuminanceWeights<T> const &w = luminance_weights<T,RGBSpace>();
+        return c.r*w.r + c.g*w.g + c.b*w.b;
+    }
+
+    template <typename T, template <typename> class RGBSpace>
+    inline T luminance (LinearRGBA<T,RGBSpace> c) noexcept {
+        LuminanceWeights<T> const &w = luminance_weights<T,RGBSpace>();
+        return c.r*w.r + c.g*w.g + c.b*w.b;
+    }
+
+
+    namespace detail {
+        // Over pixels of C channels, r, g and b first.
+        template <unsigned C, typename T>
+        inline void luminance_plane (T const *in, std::ptrdiff_t n, LuminanceWeights<T> w,
+                                     T *out) noexcept
+        {
+            const T wr = w.r, wg = w.g, wb = w.b;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i)
+                out[i] = in[C*i+0]*wr + in[C*i+1]*wg + in[C*i+2]*wb;
+        }
+    }
+
+    template <typename T, template <typename> class RGBSpace>
+    inline void luminance (LinearRGB<T,RGBSpace> const *first, LinearRGB<T,RGBSpace> const *last,
+                           T *out) noexcept
+    {
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("luminance", "LinearRGB");
+        const profile::Scope scope (site, n, n * (sizeof *first + sizeof *out));
+        detail::luminance_plane<3>(reinterpret_cast<T const*>(first), n,
+                                   luminance_weights<T,RGBSpace>(), out);
+    }
+
+    template <typename T, template <typename> class RGBSpace>
+    inline void luminance (LinearRGBA<T,RGBSpace> const *first, LinearRGBA<T,RGBSpace> const *last,
+                           T *out) noexcept
+    {
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("luminance", "LinearRGBA");
+        const profile::Scope scope (site, n, n * (sizeof *first + sizeof *out));
+        detail::luminance_plane<4>(reinterpret_cast<T const*>(first), n,
+                                   luminance_weights<T,RGBSpace>(), out);
+    }
+
+
+    template <typename Pixel, typename T>
+    inline void luminance (ImageView<Pixel> in, ImageView<T> out)
+    {
+        transform_rows(in, out, [](Pixel *first, Pixel *last, T *o) { luminance(first, last, o); });
+    }
+
+}
+
+#endif // LUMINANCE_HH_INCLUDED_20261018
@@ -0,0 +1,1078 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef LUT_IO_HH_INCLUDED_20261018
+#define LUT_IO_HH_INCLUDED_20261018
+
+#include "LUT1D.hh"
+#include "LUT3D.hh"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// lut_io:
+//
+//    Reading and writing LUT1D and LUT3D in the common exchange formats:
+//
+//      .cube   Adobe/Resolve; LUT_1D_SIZE or LUT_3D_SIZE, DOMAIN_MIN/MAX and
+//              LUT_1D/3D_INPUT_RANGE; red changes fastest. If a file holds both a 1D and a
+//              3D table, reading a LUT3D skips the 1D one and vice versa.
+//      .3dl    Autodesk; the first line is the input mesh, which gives the size, followed by
+//              integer rows with blue changing fastest. The output depth is taken from a
+//              "Mesh in out" header, else from the largest value (10, 12 or 16 bit). 3D only.
+//      .clf    ACES Common LUT Format; the first LUT1D or LUT3D node of the ProcessList, with
+//              integer outBitDepths scaled back to [0..1]. Other process nodes are not
+//              applied. LUT1D arrays of dimension "N 1" are read as Curves::shared.
+//
+//    The size of a table is a template parameter, so the file has to match it; otherwise, and
+//    on malformed input, std::runtime_error is thrown, naming the line. inspect_lut() reads
+//    only the header, to choose the type when the size is not known in advance.
+//
+//    Files are memory mapped where the system allows it and parsed in place, without
+//    allocating per token, with a fast path for plain decimal numbers.
+//
+//    load_lut() keeps parsed LUTs in a process-wide cache, keyed by the path as given and the
+//    LUT type, and re-reads a file only when its modification time or size changed since.
+//    The cache holds the 32 most recently used LUTs and drops older versions of a file as
+//    soon as they are found out of date. It is thread-safe; the LUTs are shared and immutable.
+//
+//    The .cube and .clf writers write floats with enough digits to be read back exactly. .3dl
+//    holds integer codes only: its writer clamps to [0..1] and writes 12 bit codes, so values
+//    come back within half a code (1/8190), and not at all outside of [0..1]. .3dl and .clf
+//    have no domain, writing LUTs with a domain other than [0..1] to them throws
+//    std::logic_error, as does writing a LUT1D to .3dl.
+//
+//
+// Definitions:
+//
+//    enum class LUTFormat { cube, threedl, clf };
+//    struct LUTInfo { LUTFormat format; unsigned dimensions; unsigned size; };
+//
+//    // By extension; throws std::runtime_error for other extensions.
+//    LUTFormat lut_format (std::string const &path)
+//
+//    LUTInfo inspect_lut (std::string const &path)
+//    LUTInfo inspect_lut (char const *first, char const *last, LUTFormat)
+//
+//    // LUT is LUT1D<T,N> or LUT3D<T,N>.
+//    LUT  read_lut  <LUT> (std::string const &path)
+//    LUT  parse_lut <LUT> (char const *first, char const *last, LUTFormat)
+//    std::shared_ptr<LUT const> load_lut <LUT> (std::string const &path)
+//    void clear_lut_cache ()
+//
+//    void write_lut (std::ostream &os, LUT const &lut, LUTFormat)
+//    void write_lut (std::string const &path, LUT const &lut)
+//
+//
+// Examples:
+//
+//    auto grade = load_lut<LUT3D<float,33>>("shots/0420/grade.cube");
+//    apply(*grade, image_view(in.data(), w, h), image_view(out.data(), w, h));
+//
+//    if (inspect_lut(path).size == 65)
+//        write_lut("grade.clf", read_lut<LUT3D<float,65>>(path));
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    enum class LUTFormat {
+        cube,
+        threedl,
+        clf
+    };
+
+    struct LUTInfo {
+        LUTFormat format;
+        unsigned dimensions;    // 1 or 3
+        unsigned size;          // samples per curve or nodes per axis
+    };
+
+
+    LUTFormat lut_format  (std::string const &path);
+    LUTInfo   inspect_lut (std::string const &path);
+    LUTInfo   inspect_lut (char const *first, char const *last, LUTFormat format);
+
+    template <typename LUT>
+    LUT read_lut (std::string const &path);
+
+    template <typename LUT>
+    LUT parse_lut (char const *first, char const *last, LUTFormat format);
+
+    template <typename LUT>
+    std::shared_ptr<LUT const> load_lut (std::string const &path);
+
+    void clear_lut_cache ();
+
+    template <typename T, unsigned N>
+    void write_lut (std::ostream &os, LUT3D<T,N> const &lut, LUTFormat format);
+
+    template <typename T, unsigned N>
+    void write_lut (std::ostream &os, LUT1D<T,N> const &lut, LUTFormat format);
+
+    template <typename LUT>
+    void write_lut (std::string const &path, LUT const &lut);
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+
+        [[noreturn]] inline void lut_io_error (unsigned line, std::string const &what)
+        {
+            throw std::runtime_error("lut_io: " + (line ? "line " + std::to_string(line) + ": "
+                                                        : std::string()) + what);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Tokenizer
+        //------------------------------------------------------------------------------------------
+        struct lut_token {
+            char const *first = nullptr, *last = nullptr;
+
+            bool empty() const noexcept { return first == last; }
+
+            bool is (char const *s) const noexcept {
+                const std::size_t n = std::strlen(s);
+                return std::size_t(last - first) == n && std::memcmp(first, s, n) == 0;
+            }
+
+            bool numeric() const noexcept {
+                return !empty() && ((*first >= '0' && *first <= '9') || *first == '-'
+                                    || *first == '+' || *first == '.');
+            }
+        };
+
+
+        // Whitespace separated tokens over a range of characters, with '#' comments; nothing
+        // is copied.
+        class lut_tokenizer {
+        public:
+            lut_tokenizer (char const *first, char const *last) noexcept
+                : p_(first), last_(last) {}
+
+            // The next token, across line ends; empty at the end of the input.
+            lut_token next () noexcept {
+                for (;;) {
+                    const lut_token t = next_in_line();
+                    if (!t.empty() || p_ == last_)
+                        return t;
+                    ++p_;
+                    ++line_;
+                }
+            }
+
+            // The next token on the current line; empty at the end of it.
+            lut_token next_in_line () noexcept {
+                while (p_ != last_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r'))
+                    ++p_;
+                if (p_ != last_ && *p_ == '#')
+                    while (p_ != last_ && *p_ != '\n')
+                        ++p_;
+                lut_token t;
+                t.first = p_;
+                while (p_ != last_ && *p_ != ' ' && *p_ != '\t' && *p_ != '\r' && *p_ != '\n')
+                    ++p_;
+                t.last = p_;
+                return t;
+            }
+
+            void skip_line () noexcept {
+                while (p_ != last_ && *p_ != '\n')
+                    ++p_;
+            }
+
+            unsigned line () const noexcept { return line_; }
+
+        private:
+            char const *p_, *last_;
+            unsigned line_ = 1;
+        };
+
+
+        // Decimal numbers with at most 19 significant digits and a power of ten that is exact
+        // in double are converted exactly; anything else goes to strtod.
+        inline bool parse_lut_number (lut_token t, double &out) noexcept
+        {
+            static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                           1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                           1e18, 1e19, 1e20, 1e21, 1e22};
+            char const *p = t.first, *const e = t.last;
+            const bool negative = p != e && *p == '-';
+            if (p != e && (*p == '-' || *p == '+'))
+                ++p;
+
+            std::uint64_t m = 0;
+            int digits = 0, exp10 = 0;
+            bool any = false, exact = true;
+            auto digit = [&](int d, bool fraction) {
+                any = true;
+                if (digits < 19) {
+                    m = m * 10 + d;
+                    digits += m != 0;
+                    exp10 -= fraction;
+                } else {
+                    exact = exact && d == 0;
+                    exp10 += !fraction;
+                }
+            };
+            for (; p != e && *p >= '0' && *p <= '9'; ++p)
+                digit(*p - '0', false);
+            if (p != e && *p == '.')
+                for (++p; p != e && *p >= '0' && *p <= '9'; ++p)
+                    digit(*p - '0', true);
+            if (any && p != e && (*p == 'e' || *p == 'E')) {
+                ++p;
+                const bool negative_exp = p != e && *p == '-';
+                if (p != e && (*p == '-' || *p == '+'))
+                    ++p;
+                int x = 0;
+                bool any_exp = false;
+                for (; p != e && *p >= '0' && *p <= '9'; ++p) {
+                    any_exp = true;
+                    x = std::min(x * 10 + (*p - '0'), 100000);
+                }
+                if (!any_exp)
+                    return false;
+                exp10 += negative_exp ? -x : x;
+            }
+
+            if (any && p == e && exact && m < (std::uint64_t(1) << 53)
+                && exp10 >= -22 && exp10 <= 22)
+            {
+                const double v = exp10 < 0 ? double(m) / pow10[-exp10] : double(m) * pow10[exp10];
+                out = negative ? -v : v;
+                return true;
+            }
+
+            // Rare: many digits, huge exponents, nan and inf.
+            char buffer[64];
+            const std::size_t n = t.last - t.first;
+            if (n == 0 || n >= sizeof buffer)
+                return false;
+            std::memcpy(buffer, t.first, n);
+            buffer[n] = 0;
+            char *end;
+            out = std::strtod(buffer, &end);
+            return end == buffer + n;
+        }
+
+
+        template <typename T>
+        inline T lut_number (lut_tokenizer &tz, lut_token t)
+        {
+            double v;
+            if (t.empty())
+                lut_io_error(tz.line(), "unexpected end of input, expected a number");
+            if (!parse_lut_number(t, v))
+                lut_io_error(tz.line(), "expected a number, found '"
+                                        + std::string(t.first, t.last) + "'");
+            return T(v);
+        }
+
+
+        template <typename T>
+        inline T lut_number (lut_tokenizer &tz)
+        {
+            const lut_token t = tz.next_in_line();
+            return lut_number<T>(tz, t);
+        }
+
+
+        inline unsigned lut_size (lut_tokenizer &tz)
+        {
+            const double v = lut_number<double>(tz);
+            if (!(v >= 2 && v <= 4096) || v != unsigned(v))
+                lut_io_error(tz.line(), "invalid size");
+            return unsigned(v);
+        }
+
+
+        inline void expect_size (lut_tokenizer &tz, unsigned found, unsigned expected,
+                                 unsigned dimensions)
+        {
+            if (found == 0)
+                lut_io_error(tz.line(), "no " + std::to_string(dimensions) + "D table found");
+            if (found != expected)
+                lut_io_error(tz.line(), std::to_string(dimensions) + "D table has size "
+                                        + std::to_string(found) + ", expected "
+                                        + std::to_string(expected));
+        }
+
+
+        inline void expect_end (lut_tokenizer &tz)
+        {
+            if (!tz.next().empty())
+                lut_io_error(tz.line(), "more data than the table size");
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // .cube
+        //------------------------------------------------------------------------------------------
+        struct cube_header {
+            unsigned size_1d = 0, size_3d = 0;
+            double domain_min[3] = {0, 0, 0}, domain_max[3] = {1, 1, 1};
+            double range_1d[2] = {0, 1}, range_3d[2] = {0, 1};
+            bool has_domain = false;
+        };
+
+
+        // Reads the keywords and returns the first token of the data.
+        inline lut_token read_cube_header (lut_tokenizer &tz, cube_header &h)
+        {
+            for (;;) {
+                const lut_token t = tz.next();
+                if (t.empty() || t.numeric())
+                    return t;
+                if (t.is("TITLE")) {
+                    tz.skip_line();
+                } else if (t.is("LUT_1D_SIZE")) {
+                    h.size_1d = lut_size(tz);
+                } else if (t.is("LUT_3D_SIZE")) {
+                    h.size_3d = lut_size(tz);
+                } else if (t.is("DOMAIN_MIN") || t.is("DOMAIN_MAX")) {
+                    double *d = t.is("DOMAIN_MIN") ? h.domain_min : h.domain_max;
+                    for (int k=0; k!=3; ++k)
+                        d[k] = lut_number<double>(tz);
+                    h.has_domain = true;
+                } else if (t.is("LUT_1D_INPUT_RANGE") || t.is("LUT_3D_INPUT_RANGE")) {
+                    double *d = t.is("LUT_1D_INPUT_RANGE") ? h.range_1d : h.range_3d;
+                    d[0] = lut_number<double>(tz);
+                    d[1] = lut_number<double>(tz);
+                } else {
+                    lut_io_error(tz.line(), "unknown keyword '" + std::string(t.first, t.last)
+                                            + "'");
+                }
+            }
+        }
+
+
+        template <typename T, std::size_t M>
+        inline void set_cube_domain (cube_header const &h, double const (&range)[2],
+                                     std::array<T,M> &min, std::array<T,M> &max)
+        {
+            for (unsigned k=0; k!=3; ++k) {
+                min[k] = T(h.has_domain ? h.domain_min[k] : range[0]);
+                max[k] = T(h.has_domain ? h.domain_max[k] : range[1]);
+            }
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_cube (lut_tokenizer &tz, LUT3D<T,N> &lut)
+        {
+            cube_header h;
+            lut_token t = read_cube_header(tz, h);
+            expect_size(tz, h.size_3d, N, 3);
+            set_cube_domain(h, h.range_3d, lut.domain_min, lut.domain_max);
+            for (unsigned i=0; i!=3*h.size_1d; ++i, t = tz.next())
+                lut_number<T>(tz, t);
+            for (unsigned b=0; b!=N; ++b)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned r=0; r!=N; ++r) {
+                T *n = lut.node(r, g, b);
+                for (unsigned k=0; k!=3; ++k, t = tz.next())
+                    n[k] = lut_number<T>(tz, t);
+            }
+            if (!t.empty())
+                lut_io_error(tz.line(), "more data than the table size");
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_cube (lut_tokenizer &tz, LUT1D<T,N> &lut)
+        {
+            cube_header h;
+            lut_token t = read_cube_header(tz, h);
+            expect_size(tz, h.size_1d, N, 1);
+            set_cube_domain(h, h.range_1d, lut.domain_min, lut.domain_max);
+            for (unsigned i=0; i!=N; ++i)
+                for (unsigned k=0; k!=3; ++k, t = tz.next())
+                    lut.curve(k)[i] = lut_number<T>(tz, t);
+            // A 3D table may follow, for a LUT3D reader to find.
+            if (h.size_3d == 0 && !t.empty())
+                lut_io_error(tz.line(), "more data than the table size");
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // .3dl
+        //------------------------------------------------------------------------------------------
+        // Reads up to and including the input mesh, returns its size.
+        inline unsigned read_3dl_header (lut_tokenizer &tz, unsigned &out_bits)
+        {
+            out_bits = 0;
+            for (;;) {
+                lut_token t = tz.next();
+                if (t.empty())
+                    lut_io_error(tz.line(), "no input mesh found");
+                if (t.is("3DMESH"))
+                    continue;
+                if (t.is("Mesh")) {
+                    lut_number<double>(tz);
+                    const double bits = lut_number<double>(tz);
+                    if (!(bits >= 1 && bits <= 31) || bits != unsigned(bits))
+                        lut_io_error(tz.line(), "invalid output depth");
+                    out_bits = unsigned(bits);
+                    continue;
+                }
+                unsigned size = 0;
+                for (; !t.empty(); t = tz.next_in_line(), ++size)
+                    lut_number<double>(tz, t);
+                if (size < 2)
+                    lut_io_error(tz.line(), "invalid input mesh");
+                return size;
+            }
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_3dl (lut_tokenizer &tz, LUT3D<T,N> &lut)
+        {
+            unsigned out_bits;
+            expect_size(tz, read_3dl_header(tz, out_bits), N, 3);
+
+            double max = 0;
+            for (unsigned r=0; r!=N; ++r)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned b=0; b!=N; ++b) {
+                T *n = lut.node(r, g, b);
+                for (unsigned k=0; k!=3; ++k) {
+                    const T v = lut_number<T>(tz, tz.next());
+                    n[k] = v;
+                    max = std::max(max, double(v));
+                }
+            }
+            expect_end(tz);
+
+            const double code = out_bits ? double((std::uint32_t(1) << out_bits) - 1)
+                              : max <= 1023 ? 1023 : max <= 4095 ? 4095 : 65535;
+            const T scale = T(1 / code);
+            for (unsigned b=0; b!=N; ++b)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned r=0; r!=N; ++r) {
+                T *n = lut.node(r, g, b);
+                for (unsigned k=0; k!=3; ++k)
+                    n[k] *= scale;
+            }
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // .clf
+        //------------------------------------------------------------------------------------------
+        inline char const* find_text (char const *first, char const *last, char const *s) noexcept
+        {
+            return std::search(first, last, s, s + std::strlen(s));
+        }
+
+
+        inline unsigned line_at (char const *first, char const *p) noexcept
+        {
+            return 1 + unsigned(std::count(first, p, '\n'));
+        }
+
+
+        // The value of attribute 'name' in [first..last), which is the inside of a start tag.
+        inline lut_token clf_attribute (char const *first, char const *last, char const *name)
+        {
+            const std::size_t n = std::strlen(name);
+            for (char const *p = first; (p = find_text(p, last, name)) != last; p += n) {
+                char const *q = p + n;
+                if (p == first || !(p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\n'
+                                    || p[-1] == '\r'))
+                    continue;
+                while (q != last && (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r'))
+                    ++q;
+                if (q == last || *q != '=')
+                    continue;
+                ++q;
+                while (q != last && (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r'))
+                    ++q;
+                if (q == last || (*q != '"' && *q != '\''))
+                    continue;
+                lut_token t;
+                t.first = q + 1;
+                t.last = std::find(t.first, last, *q);
+                if (t.last != last)
+                    return t;
+            }
+            return lut_token();
+        }
+
+
+        struct clf_node {
+            char const *tag_first, *tag_last;       // inside of the start tag
+            char const *array_first, *array_last;   // contents of the Array
+            unsigned dim[4];
+            unsigned dims;
+            double scale;                           // from outBitDepth
+        };
+
+
+        // Finds the first element called 'name' ("LUT1D" or "LUT3D"); false if there is none.
+        inline bool find_clf_node (char const *first, char const *last, char const *name,
+                                   clf_node &node)
+        {
+            const std::string open = std::string("<") + name;
+            char const *p = first;
+            for (;; p += open.size()) {
+                p = find_text(p, last, open.c_str());
+                if (p == last)
+                    return false;
+                char const *q = p + open.size();
+                if (q != last && (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r'
+                                  || *q == '>'))
+                    break;
+            }
+            node.tag_first = p + open.size();
+            node.tag_last = std::find(node.tag_first, last, '>');
+            if (node.tag_last == last)
+                lut_io_error(line_at(first, p), std::string("unterminated ") + name);
+
+            const lut_token depth = clf_attribute(node.tag_first, node.tag_last, "outBitDepth");
+            node.scale = depth.empty() || depth.is("16f") || depth.is("32f") ? 1
+                       : depth.is("8i") ? 255 : depth.is("10i") ? 1023
+                       : depth.is("12i") ? 4095 : depth.is("16i") ? 65535 : 0;
+            if (node.scale == 0)
+                lut_io_error(line_at(first, p), "unsupported outBitDepth");
+            if (!clf_attribute(node.tag_first, node.tag_last, "halfDomain").empty())
+                lut_io_error(line_at(first, p), "halfDomain LUTs are not supported");
+
+            char const *array = find_text(node.tag_last, last, "<Array");
+            char const *array_tag_last = std::find(array, last, '>');
+            if (array == last || array_tag_last == last)
+                lut_io_error(line_at(first, p), std::string(name) + " without Array");
+            const lut_token dim = clf_attribute(array, array_tag_last, "dim");
+            lut_tokenizer tz (dim.first, dim.last);
+            node.dims = 0;
+            for (lut_token t = tz.next(); !t.empty(); t = tz.next()) {
+                if (node.dims == 4)
+                    lut_io_error(line_at(first, array), "invalid Array dim");
+                double v;
+                if (!parse_lut_number(t, v) || v < 1 || v > 4096 || v != unsigned(v))
+                    lut_io_error(line_at(first, array), "invalid Array dim");
+                node.dim[node.dims++] = unsigned(v);
+            }
+
+            node.array_first = array_tag_last + 1;
+            node.array_last = find_text(node.array_first, last, "</Array>");
+            if (node.array_last == last)
+                lut_io_error(line_at(first, array), "unterminated Array");
+            return true;
+        }
+
+
+        // The Array dim of a LUT3D is "N N N 3", that of a LUT1D "N 3" or "N 1".
+        inline void check_clf_dim (char const *first, clf_node const &node, bool lut3d)
+        {
+            if (lut3d ? node.dims != 4 || node.dim[0] != node.dim[1] || node.dim[0] != node.dim[2]
+                        || node.dim[3] != 3
+                      : node.dims != 2 || (node.dim[1] != 3 && node.dim[1] != 1))
+                lut_io_error(line_at(first, node.array_first),
+                             lut3d ? "invalid LUT3D Array dim" : "invalid LUT1D Array dim");
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_clf (char const *first, char const *last, LUT3D<T,N> &lut)
+        {
+            clf_node node;
+            if (!find_clf_node(first, last, "LUT3D", node))
+                lut_io_error(0, "no LUT3D found");
+            lut_tokenizer tz (node.array_first, node.array_last);
+            check_clf_dim(first, node, true);
+            expect_size(tz, node.dim[0], N, 3);
+
+            const T scale = T(1 / node.scale);
+            for (unsigned r=0; r!=N; ++r)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned b=0; b!=N; ++b) {
+                T *n = lut.node(r, g, b);
+                for (unsigned k=0; k!=3; ++k)
+                    n[k] = lut_number<T>(tz, tz.next()) * scale;
+            }
+            expect_end(tz);
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_clf (char const *first, char const *last, LUT1D<T,N> &lut)
+        {
+            clf_node node;
+            if (!find_clf_node(first, last, "LUT1D", node))
+                lut_io_error(0, "no LUT1D found");
+            lut_tokenizer tz (node.array_first, node.array_last);
+            check_clf_dim(first, node, false);
+            expect_size(tz, node.dim[0], N, 1);
+
+            if (node.dim[1] == 1)
+                lut = LUT1D<T,N>(Curves::shared);
+            const unsigned channels = node.dim[1];
+            const T scale = T(1 / node.scale);
+            for (unsigned i=0; i!=N; ++i)
+                for (unsigned k=0; k!=channels; ++k)
+                    lut.curve(k)[i] = lut_number<T>(tz, tz.next()) * scale;
+            expect_end(tz);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Dispatch
+        //------------------------------------------------------------------------------------------
+        template <typename T, unsigned N>
+        inline void parse_lut (char const *first, char const *last, LUTFormat format,
+                               LUT3D<T,N> &lut)
+        {
+            lut_tokenizer tz (first, last);
+            switch (format) {
+            case LUTFormat::cube:    parse_cube(tz, lut); break;
+            case LUTFormat::threedl: parse_3dl(tz, lut); break;
+            case LUTFormat::clf:     parse_clf(first, last, lut); break;
+            }
+        }
+
+
+        template <typename T, unsigned N>
+        inline void parse_lut (char const *first, char const *last, LUTFormat format,
+                               LUT1D<T,N> &lut)
+        {
+            lut_tokenizer tz (first, last);
+            switch (format) {
+            case LUTFormat::cube:    parse_cube(tz, lut); break;
+            case LUTFormat::threedl: lut_io_error(0, ".3dl files hold 3D LUTs only");
+            case LUTFormat::clf:     parse_clf(first, last, lut); break;
+            }
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Files
+        //------------------------------------------------------------------------------------------
+        // The contents of a file, mapped read-only where possible.
+        class mapped_file {
+        public:
+            explicit mapped_file (std::string const &path) {
+#if defined(__unix__) || defined(__APPLE__)
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("lut_io: cannot open '" + path + "'");
+                struct stat st;
+                if (::fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    throw std::runtime_error("lut_io: cannot read '" + path + "'");
+                }
+                size_ = std::size_t(st.st_size);
+                if (size_ != 0) {
+                    addr_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (addr_ == MAP_FAILED) {
+                        ::close(fd);
+                        throw std::runtime_error("lut_io: cannot map '" + path + "'");
+                    }
+                }
+                ::close(fd);
+#else
+                std::ifstream ifs (path, std::ios::binary);
+                if (!ifs)
+                    throw std::runtime_error("lut_io: cannot open '" + path + "'");
+                data_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+#endif
+            }
+
+            ~mapped_file () {
+#if defined(__unix__) || defined(__APPLE__)
+                if (size_ != 0)
+                    ::munmap(addr_, size_);
+#endif
+            }
+
+            mapped_file (mapped_file const &) = delete;
+            mapped_file& operator= (mapped_file const &) = delete;
+
+#if defined(__unix__) || defined(__APPLE__)
+            char const* begin() const noexcept { return static_cast<char const*>(addr_); }
+            char const* end()   const noexcept { return begin() + size_; }
+        private:
+            void *addr_ = nullptr;
+            std::size_t size_ = 0;
+#else
+            char const* begin() const noexcept { return data_.data(); }
+            char const* end()   const noexcept { return data_.data() + data_.size(); }
+        private:
+            std::vector<char> data_;
+#endif
+        };
+
+
+        struct file_stamp {
+            long long mtime_sec, mtime_nsec, size;
+
+            bool operator== (file_stamp const &rhs) const noexcept {
+                return mtime_sec == rhs.mtime_sec && mtime_nsec == rhs.mtime_nsec
+                    && size == rhs.size;
+            }
+        };
+
+
+        inline file_stamp stamp_file (std::string const &path)
+        {
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0)
+                throw std::runtime_error("lut_io: cannot open '" + path + "'");
+#if defined(__APPLE__)
+            const long long nsec = st.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+            const long long nsec = st.st_mtim.tv_nsec;
+#else
+            const long long nsec = 0;
+#endif
+            return {(long long)st.st_mtime, nsec, (long long)st.st_size};
+        }
+
+
+        class lut_cache {
+        public:
+            static lut_cache& instance() {
+                static lut_cache cache;
+                return cache;
+            }
+
+            // The LUTs kept; beyond, the least recently used one is dropped.
+            static constexpr std::size_t capacity = 32;
+
+            // An entry of an older version of the file is dropped right away.
+            template <typename LUT>
+            std::shared_ptr<LUT const> find (std::string const &path, file_stamp stamp) {
+                std::lock_guard<std::mutex> lock (mutex_);
+                auto it = entries_.find(Key(path, std::type_index(typeid(LUT))));
+                if (it == entries_.end())
+                    return nullptr;
+                if (!(it->second.stamp == stamp)) {
+                    entries_.erase(it);
+                    return nullptr;
+                }
+                it->second.used = ++clock_;
+                return std::static_pointer_cast<LUT const>(it->second.lut);
+            }
+
+            // Replaces older versions of the same file.
+            template <typename LUT>
+            void insert (std::string const &path, file_stamp stamp,
+                         std::shared_ptr<LUT const> const &lut) {
+                std::lock_guard<std::mutex> lock (mutex_);
+                entries_[Key(path, std::type_index(typeid(LUT)))] = Entry{stamp, lut, ++clock_};
+                if (entries_.size() > capacity) {
+                    auto oldest = entries_.begin();
+                    for (auto i = entries_.begin(); i != entries_.end(); ++i)
+                        if (i->second.used < oldest->second.used)
+                            oldest = i;
+                    entries_.erase(oldest);
+                }
+            }
+
+            void clear () {
+                std::lock_guard<std::mutex> lock (mutex_);
+                entries_.clear();
+            }
+
+        private:
+            using Key = std::pair<std::string, std::type_index>;
+            struct Entry {
+                file_stamp stamp;
+                std::shared_ptr<void const> lut;
+                std::uint64_t used;
+            };
+
+            std::mutex mutex_;
+            std::map<Key, Entry> entries_;
+            std::uint64_t clock_ = 0;
+        };
+
+
+        //------------------------------------------------------------------------------------------
+        // Writers
+        //------------------------------------------------------------------------------------------
+        // Sets the precision for exact round trips and restores the stream's on destruction.
+        template <typename T>
+        class lut_ostream_guard {
+        public:
+            explicit lut_ostream_guard (std::ostream &os)
+                : os_(os), precision_(os.precision()), flags_(os.flags()) {
+                os.precision(std::numeric_limits<T>::max_digits10);
+                os.unsetf(std::ios::floatfield);
+            }
+            ~lut_ostream_guard () {
+                os_.precision(precision_);
+                os_.flags(flags_);
+            }
+        private:
+            std::ostream &os_;
+            std::streamsize precision_;
+            std::ios::fmtflags flags_;
+        };
+
+
+        template <typename T, std::size_t M>
+        inline void expect_unit_domain (std::array<T,M> const &min, std::array<T,M> const &max,
+                                        char const *format)
+        {
+            for (unsigned k=0; k!=3; ++k)
+                if (min[k] != 0 || max[k] != 1)
+                    throw std::logic_error(std::string("write_lut: ") + format
+                                           + " has no domain, it must be [0..1]");
+        }
+
+
+        inline void write_clf_header (std::ostream &os, char const *node)
+        {
+            os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<ProcessList id=\"tukan\" compCLFversion=\"3.0\">\n"
+                  "    <" << node << " inBitDepth=\"32f\" outBitDepth=\"32f\"";
+        }
+
+
+        inline void write_clf_footer (std::ostream &os, char const *node)
+        {
+            os << "        </Array>\n"
+                  "    </" << node << ">\n"
+                  "</ProcessList>\n";
+        }
+    }
+
+
+    inline LUTFormat lut_format (std::string const &path)
+    {
+        const std::size_t dot = path.rfind('.');
+        std::string ext = dot == std::string::npos ? std::string() : path.substr(dot + 1);
+        for (char &c : ext)
+            c = (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+        if (ext == "cube") return LUTFormat::cube;
+        if (ext == "3dl")  return LUTFormat::threedl;
+        if (ext == "clf")  return LUTFormat::clf;
+        throw std::runtime_error("lut_io: unknown LUT format of '" + path + "'");
+    }
+
+
+    inline LUTInfo inspect_lut (char const *first, char const *last, LUTFormat format)
+    {
+        detail::lut_tokenizer tz (first, last);
+        switch (format) {
+        case LUTFormat::cube: {
+            detail::cube_header h;
+            detail::read_cube_header(tz, h);
+            if (h.size_3d == 0 && h.size_1d == 0)
+                detail::lut_io_error(0, "no table size found");
+            return h.size_3d ? LUTInfo{format, 3, h.size_3d} : LUTInfo{format, 1, h.size_1d};
+        }
+        case LUTFormat::threedl: {
+            unsigned out_bits;
+            return LUTInfo{format, 3, detail::read_3dl_header(tz, out_bits)};
+        }
+        case LUTFormat::clf: {
+            detail::clf_node n1, n3;
+            const bool has_1d = detail::find_clf_node(first, last, "LUT1D", n1),
+                       has_3d = detail::find_clf_node(first, last, "LUT3D", n3);
+            if (!has_1d && !has_3d)
+                detail::lut_io_error(0, "no LUT1D or LUT3D found");
+            detail::check_clf_dim(first, has_3d ? n3 : n1, has_3d);
+            return has_3d ? LUTInfo{format, 3, n3.dim[0]} : LUTInfo{format, 1, n1.dim[0]};
+        }
+        }
+        throw std::logic_error("inspect_lut: invalid format");
+    }
+
+
+    inline LUTInfo inspect_lut (std::string const &path)
+    {
+        const LUTFormat format = lut_format(path);
+        const detail::mapped_file file (path);
+        return inspect_lut(file.begin(), file.end(), format);
+    }
+
+
+    template <typename LUT>
+    inline LUT parse_lut (char const *first, char const *last, LUTFormat format)
+    {
+        LUT lut;
+        detail::parse_lut(first, last, format, lut);
+        return lut;
+    }
+
+
+    template <typename LUT>
+    inline LUT read_lut (std::string const &path)
+    {
+        const LUTFormat format = lut_format(path);
+        const detail::mapped_file file (path);
+        try {
+            return parse_lut<LUT>(file.begin(), file.end(), format);
+        } catch (std::runtime_error const &e) {
+            throw std::runtime_error(path + ": " + e.what());
+        }
+    }
+
+
+    template <typename LUT>
+    inline std::shared_ptr<LUT const> load_lut (std::string const &path)
+    {
+        detail::lut_cache &cache = detail::lut_cache::instance();
+        const detail::file_stamp stamp = detail::stamp_file(path);
+        if (std::shared_ptr<LUT const> lut = cache.find<LUT>(path, stamp))
+            return lut;
+
+        // Parsed outside the lock; if the file changes meanwhile, the stamp taken before is
+        // older than the contents, so the next call parses it again.
+        std::shared_ptr<LUT const> lut = std::make_shared<LUT>(read_lut<LUT>(path));
+        cache.insert(path, stamp, lut);
+        return lut;
+    }
+
+
+    inline void clear_lut_cache ()
+    {
+        detail::lut_cache::instance().clear();
+    }
+
+
+    template <typename T, unsigned N>
+    inline void write_lut (std::ostream &os, LUT3D<T,N> const &lut, LUTFormat format)
+    {
+        const detail::lut_ostream_guard<T> guard (os);
+        switch (format) {
+        case LUTFormat::cube:
+            os << "LUT_3D_SIZE " << N << '\n'
+               << "DOMAIN_MIN " << lut.domain_min[0] << ' ' << lut.domain_min[1] << ' '
+                                << lut.domain_min[2] << '\n'
+               << "DOMAIN_MAX " << lut.domain_max[0] << ' ' << lut.domain_max[1] << ' '
+                                << lut.domain_max[2] << '\n';
+            for (unsigned b=0; b!=N; ++b)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned r=0; r!=N; ++r) {
+                T const *n = lut.node(r, g, b);
+                os << n[0] << ' ' << n[1] << ' ' << n[2] << '\n';
+            }
+            break;
+
+        case LUTFormat::threedl: {
+            detail::expect_unit_domain(lut.domain_min, lut.domain_max, ".3dl");
+            // The Mesh header gives the mesh as a power of two; without it, readers infer
+            // the output depth from the largest value.
+            unsigned mesh_bits = 0;
+            while ((1u << mesh_bits) < N - 1)
+                ++mesh_bits;
+            if ((1u << mesh_bits) == N - 1)
+                os << "3DMESH\nMesh " << mesh_bits << " 12\n";
+            for (unsigned i=0; i!=N; ++i)
+                os << (i ? " " : "") << (i * 1023 + (N - 1) / 2) / (N - 1);
+            os << '\n';
+            auto code = [](T v) {
+                return long(std::max(T(0), std::min(T(1), v)) * T(4095) + T(0.5));
+            };
+            for (unsigned r=0; r!=N; ++r)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned b=0; b!=N; ++b) {
+                T const *n = lut.node(r, g, b);
+                os << code(n[0]) << ' ' << code(n[1]) << ' ' << code(n[2]) << '\n';
+            }
+            break;
+        }
+
+        case LUTFormat::clf:
+            detail::expect_unit_domain(lut.domain_min, lut.domain_max, ".clf");
+            detail::write_clf_header(os, "LUT3D");
+            os << " interpolation=\"tetrahedral\">\n"
+                  "        <Array dim=\"" << N << ' ' << N << ' ' << N << " 3\">\n";
+            for (unsigned r=0; r!=N; ++r)
+            for (unsigned g=0; g!=N; ++g)
+            for (unsigned b=0; b!=N; ++b) {
+                T const *n = lut.node(r, g, b);
+                os << n[0] << ' ' << n[1] << ' ' << n[2] << '\n';
+            }
+            detail::write_clf_footer(os, "LUT3D");
+            break;
+        }
+    }
+
+
+    template <typename T, unsigned N>
+    inline void write_lut (std::ostream &os, LUT1D<T,N> const &lut, LUTFormat format)
+    {
+        const detail::lut_ostream_guard<T> guard (os);
+        switch (format) {
+        case LUTFormat::cube:
+            os << "LUT_1D_SIZE " << N << '\n'
+               << "DOMAIN_MIN " << lut.domain_min[0] << ' ' << lut.domain_min[1] << ' '
+                                << lut.domain_min[2] << '\n'
+               << "DOMAIN_MAX " << lut.domain_max[0] << ' ' << lut.domain_max[1] << ' '
+                                << lut.domain_max[2] << '\n';
+            for (unsigned i=0; i!=N; ++i)
+                os << lut.curve(0)[i] << ' ' << lut.curve(1)[i] << ' ' << lut.curve(2)[i]
+                   << '\n';
+            break;
+
+        case LUTFormat::threedl:
+            throw std::logic_error("write_lut: .3dl holds 3D LUTs only");
+
+        case LUTFormat::clf: {
+            detail::expect_unit_domain(lut.domain_min, lut.domain_max, ".clf");
+            const unsigned channels = lut.shared() ? 1 : 3;
+            detail::write_clf_header(os, "LUT1D");
+            os << ">\n"
+                  "        <Array dim=\"" << N << ' ' << channels << "\">\n";
+            for (unsigned i=0; i!=N; ++i) {
+                for (unsigned k=0; k!=channels; ++k)
+                    os << (k ? " " : "") << lut.curve(k)[i];
+                os << '\n';
+            }
+            detail::write_clf_footer(os, "LUT1D");
+            break;
+        }
+        }
+    }
+
+
+    template <typename LUT>
+    inline void write_lut (std::string const &path, LUT const &lut)
+    {
+        const LUTFormat format = lut_format(path);
+        std::ofstream ofs (path, std::ios::binary);
+        if (!ofs)
+            throw std::runtime_error("lut_io: cannot create '" + path + "'");
+        write_lut(ofs, lut, format);
+        if (!ofs.flush())
+            throw std::runtime_error("lut_io: cannot write '" + path + "'");
+    }
+
+}
+
+#endif // LUT_IO_HH_INCLUDED_20261018
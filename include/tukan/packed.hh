@@ -0,0 +1,341 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef PACKED_HH_INCLUDED_20261018
+#define PACKED_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "profile.hh"
+#include "unorm.hh"
+#include "detail/exp.hh"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Packed pixel formats:
+//
+//    Conversion between colors over float (LinearRGB, RGB, LinearRGBA) and the packed formats
+//    used by GPUs. Each format is a tag type in namespace 'packed'; channel i of the color goes
+//    to channel i of the format. Bit layouts follow DXGI, i.e. the first channel is in the least
+//    significant bits, except for RGB565, which follows DXGI_FORMAT_B5G6R5_UNORM and
+//    GL_UNSIGNED_SHORT_5_6_5 with red in the most significant bits.
+//
+//    packed::RGB565      uint16_t   r 11-15, g 5-10, b 0-4        unorm
+//    packed::RGB10A2     uint32_t   r 0-9, g 10-19, b 20-29, a 30-31   unorm, 4 channels
+//    packed::R11G11B10F  uint32_t   r 0-10, g 11-21, b 22-31      unsigned floats with 5 bit
+//                                                                 exponent, 6/6/5 bit mantissa
+//    packed::RGB9E5      uint32_t   r 0-8, g 9-17, b 18-26, shared exponent 27-31
+//
+//    Unorm channels are rounded exactly, as in unorm.hh. The small floats of R11G11B10F are
+//    rounded to nearest even; negative values and -inf become 0, +inf stays, NaN becomes a
+//    NaN, and finite values too large become the largest finite value, like DirectXMath's
+//    XMStoreFloat3PK. RGB9E5 follows the EXT_texture_shared_exponent specification to the bit,
+//    including its clamping to [0..65408] and its rounding of halfway cases upwards.
+//    Unpacking is exact for all formats.
+//
+//    The batch conversions are branch-free and vectorize. For RGB9E5 and for unpacking
+//    R11G11B10F, the compiler needs the shuffles of AVX2 (e.g. -march=x86-64-v3) to load and
+//    store the interleaved float triples; with plain SSE2, these loops stay scalar.
+//
+//
+// Definitions:
+//
+//    Format::type                                     the packed integer type
+//    Format::channels                                 3 or 4
+//    Format::name ()                                  e.g. "RGB565", for profile.hh
+//
+//    typename Format::type pack<Format> (Color c)
+//    Color unpack<Format, Color> (typename Format::type p)
+//
+//    void pack<Format>   (Color const *first, Color const *last, typename Format::type *out)
+//    void unpack<Format> (typename Format::type const *first, typename Format::type const *last,
+//                         Color *out)
+//
+//    // Throw std::logic_error if the views differ in extent.
+//    void pack<Format>   (ImageView<Color> in, ImageView<typename Format::type> out)
+//    void unpack<Format> (ImageView<typename Format::type> in, ImageView<Color> out)
+//
+//
+// Examples:
+//
+//    std::vector<LinearRGB<float,sRGB>> hdr = ...;
+//    std::vector<std::uint32_t> texture (hdr.size());
+//    pack<packed::RGB9E5>(hdr.data(), hdr.data()+hdr.size(), texture.data());
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    namespace packed {
+        struct RGB565 {
+            using type = std::uint16_t;
+            enum { channels = 3 };
+            static type pack (float const *c) noexcept ;
+            static void unpack (type p, float *c) noexcept ;
+            static constexpr char const* name () noexcept { return "RGB565"; }
+        };
+
+        struct RGB10A2 {
+            using type = std::uint32_t;
+            enum { channels = 4 };
+            static type pack (float const *c) noexcept ;
+            static void unpack (type p, float *c) noexcept ;
+            static constexpr char const* name () noexcept { return "RGB10A2"; }
+        };
+
+        struct R11G11B10F {
+            using type = std::uint32_t;
+            enum { channels = 3 };
+            static type pack (float const *c) noexcept ;
+            static void unpack (type p, float *c) noexcept ;
+            static constexpr char const* name () noexcept { return "R11G11B10F"; }
+        };
+
+        struct RGB9E5 {
+            using type = std::uint32_t;
+            enum { channels = 3 };
+            static type pack (float const *c) noexcept ;
+            static void unpack (type p, float *c) noexcept ;
+            static constexpr char const* name () noexcept { return "RGB9E5"; }
+        };
+    }
+
+
+    template <typename Format, typename Color>
+    typename Format::type pack (Color c) noexcept ;
+
+    template <typename Format, typename Color>
+    Color unpack (typename Format::type p) noexcept ;
+
+    template <typename Format, typename Color>
+    void pack (Color const *first, Color const *last, typename Format::type *out) noexcept ;
+
+    template <typename Format, typename Color>
+    void unpack (typename Format::type const *first, typename Format::type const *last,
+                 Color *out) noexcept ;
+
+    template <typename Format, typename In, typename Out>
+    void pack (ImageView<In> in, ImageView<Out> out);
+
+    template <typename Format, typename In, typename Out>
+    void unpack (ImageView<In> in, ImageView<Out> out);
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+        // Unsigned float with 5 exponent bits (bias 15) and M mantissa bits, see above.
+        template <unsigned M>
+        inline std::uint32_t float_to_ufloat (float f) noexcept
+        {
+            const std::uint32_t x = float_bits(f), abs = x & 0x7fffffffu;
+            const std::uint32_t inf = 0x1fu << M, nan = inf | ((1u << M) - 1),
+                                max_finite = inf - 1;
+            const unsigned shift = 23 - M;
+
+            // Normal results: rebias, round the dropped bits to nearest even. Overflow carries
+            // into the exponent and is clamped below.
+            const std::uint32_t rebiased = abs - 0x38000000u;
+            const std::uint32_t normal = (rebiased + (1u << (shift-1)) - 1
+                                          + ((rebiased >> shift) & 1)) >> shift;
+
+            // Below 2^-14, the result is a multiple of 2^(-14-M); the magic number rounds.
+            const float magic = 12582912.f;
+            const std::uint32_t sub = float_bits(bits_float(abs) * float(1u << (14 + M)) + magic)
+                                    - 0x4B400000u;
+
+            std::uint32_t r = select(abs < 0x38800000u, sub, normal);
+            r = select(r > max_finite, max_finite, r);
+            r = select(abs == 0x7f800000u, inf, r);
+            r = select(x >> 31 != 0, 0u, r);
+            r = select(abs > 0x7f800000u, nan, r);
+            return r;
+        }
+
+        template <unsigned M>
+        inline float ufloat_to_float (std::uint32_t u) noexcept
+        {
+            const std::uint32_t e = (u >> M) & 0x1fu, m = u & ((1u << M) - 1);
+            const std::uint32_t normal  = ((e + 112) << 23) | (m << (23 - M)),
+                                inf_nan = 0x7f800000u | (m << (23 - M));
+            const float sub = float(m) * (1.f / float(1u << (14 + M)));
+            return select(e == 0, sub, bits_float(e == 31 ? inf_nan : normal));
+        }
+    }
+
+
+    namespace packed {
+
+        // RGB565
+        inline RGB565::type RGB565::pack (float const *c) noexcept {
+            return type(detail::quantize_unorm<5>(c[0]) << 11
+                      | detail::quantize_unorm<6>(c[1]) << 5
+                      | detail::quantize_unorm<5>(c[2]));
+        }
+
+        inline void RGB565::unpack (type p, float *c) noexcept {
+            const std::uint32_t q = p; // widened first, which the vectorizer prefers
+            c[0] = float(q >> 11) / 31;
+            c[1] = float((q >> 5) & 0x3f) / 63;
+            c[2] = float(q & 0x1f) / 31;
+        }
+
+
+        // RGB10A2
+        inline RGB10A2::type RGB10A2::pack (float const *c) noexcept {
+            return detail::quantize_unorm<10>(c[0])
+                 | detail::quantize_unorm<10>(c[1]) << 10
+                 | detail::quantize_unorm<10>(c[2]) << 20
+                 | detail::quantize_unorm<2>(c[3]) << 30;
+        }
+
+        inline void RGB10A2::unpack (type p, float *c) noexcept {
+            c[0] = float(p & 0x3ff) / 1023;
+            c[1] = float((p >> 10) & 0x3ff) / 1023;
+            c[2] = float((p >> 20) & 0x3ff) / 1023;
+            c[3] = float(p >> 30) / 3;
+        }
+
+
+        // R11G11B10F
+        inline R11G11B10F::type R11G11B10F::pack (float const *c) noexcept {
+            return detail::float_to_ufloat<6>(c[0])
+                 | detail::float_to_ufloat<6>(c[1]) << 11
+                 | detail::float_to_ufloat<5>(c[2]) << 22;
+        }
+
+        inline void R11G11B10F::unpack (type p, float *c) noexcept {
+            c[0] = detail::ufloat_to_float<6>(p & 0x7ff);
+            c[1] = detail::ufloat_to_float<6>((p >> 11) & 0x7ff);
+            c[2] = detail::ufloat_to_float<5>(p >> 22);
+        }
+
+
+        // RGB9E5
+        inline RGB9E5::type RGB9E5::pack (float const *c) noexcept {
+            using detail::select;
+            // N=9 mantissa bits, exponent bias B=15.
+            const float sharedexp_max = 65408.f; // (2^N-1)/2^N * 2^(31-B)
+            const auto clamp = [&](float v) {
+                v = select(v > 0, v, 0.f); // also maps NaN to 0
+                return select(v < sharedexp_max, v, sharedexp_max);
+            };
+            const float r = clamp(c[0]), g = clamp(c[1]), b = clamp(c[2]);
+            const float max_c = select(r > g, r, g);
+            const float max_rgb = select(max_c > b, max_c, b);
+
+            // exp_shared_p = max(-B-1, floor(log2(max_rgb))) + 1 + B; exact via the exponent bits.
+            const std::int32_t log2_floor = std::int32_t(detail::float_bits(max_rgb) >> 23) - 127;
+            const std::int32_t exp_p = (log2_floor > -16 ? log2_floor : -16) + 16;
+
+            // Divisions by 2^(exp - B - N) are multiplications by 2^(24 - exp), exact.
+            const float scale_p = detail::bits_float(std::uint32_t(24 - exp_p + 127) << 23);
+            const std::int32_t max_s = std::int32_t(max_rgb * scale_p + 0.5f);
+            const std::int32_t exp = exp_p + (max_s == 512);
+            const float scale = detail::bits_float(std::uint32_t(24 - exp + 127) << 23);
+
+            return std::uint32_t(r * scale + 0.5f)
+                 | std::uint32_t(g * scale + 0.5f) << 9
+                 | std::uint32_t(b * scale + 0.5f) << 18
+                 | std::uint32_t(exp) << 27;
+        }
+
+        inline void RGB9E5::unpack (type p, float *c) noexcept {
+            const float scale = detail::bits_float(((p >> 27) - 24 + 127) << 23);
+            c[0] = float(p & 0x1ff) * scale;
+            c[1] = float((p >> 9) & 0x1ff) * scale;
+            c[2] = float((p >> 18) & 0x1ff) * scale;
+        }
+
+    }
+
+
+    namespace detail {
+        template <typename Format, typename Color>
+        struct check_packed_color {
+            using value_type = typename Color::value_type;
+            static_assert(std::is_same<value_type, float>::value,
+                          "packed formats convert colors over float");
+            static_assert(sizeof(Color) == Format::channels * sizeof(float),
+                          "color and packed format differ in number of channels");
+            enum { channels = Format::channels };
+        };
+    }
+
+
+    template <typename Format, typename Color>
+    inline typename Format::type pack (Color c) noexcept
+    {
+        float f[detail::check_packed_color<Format,Color>::channels];
+        for (std::size_t i=0; i!=Format::channels; ++i)
+            f[i] = c[i];
+        return Format::pack(f);
+    }
+
+
+    template <typename Format, typename Color>
+    inline Color unpack (typename Format::type p) noexcept
+    {
+        float f[detail::check_packed_color<Format,Color>::channels];
+        Format::unpack(p, f);
+        Color c;
+        for (std::size_t i=0; i!=Format::channels; ++i)
+            c[i] = f[i];
+        return c;
+    }
+
+
+    template <typename Format, typename Color>
+    inline void pack (Color const *first, Color const *last, typename Format::type *out) noexcept
+    {
+        enum { channels = detail::check_packed_color<Format,Color>::channels };
+        float const *f = reinterpret_cast<float const*>(first);
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("pack", Format::name());
+        const profile::Scope scope (site, n, n * (sizeof(Color) + sizeof(typename Format::type)));
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i)
+            out[i] = Format::pack(f + channels*i);
+    }
+
+
+    template <typename Format, typename Color>
+    inline void unpack (typename Format::type const *first, typename Format::type const *last,
+                        Color *out) noexcept
+    {
+        enum { channels = detail::check_packed_color<Format,Color>::channels };
+        float *f = reinterpret_cast<float*>(out);
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("unpack", Format::name());
+        const profile::Scope scope (site, n, n * (sizeof(Color) + sizeof(typename Format::type)));
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i)
+            Format::unpack(first[i], f + channels*i);
+    }
+
+
+    template <typename Format, typename In, typename Out>
+    inline void pack (ImageView<In> in, ImageView<Out> out)
+    {
+        transform_rows(in, out, [](In *first, In *last, Out *o) { pack<Format>(first, last, o); });
+    }
+
+
+    template <typename Format, typename In, typename Out>
+    inline void unpack (ImageView<In> in, ImageView<Out> out)
+    {
+        transform_rows(in, out, [](In *first, In *last, Out *o) { unpack<Format>(first, last, o); });
+    }
+
+}
+
+#endif // PACKED_HH_INCLUDED_20261018
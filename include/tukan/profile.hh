@@ -0,0 +1,338 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef PROFILE_HH_INCLUDED_20261018
+#define PROFILE_HH_INCLUDED_20261018
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Profiling counters:
+//
+//    Counts, per call site, how often the batch operations run, over how many pixels and bytes,
+//    and how long they take, to tell from a running application which conversions dominate and
+//    which kernels are hit. Counting is off by default and switched on at runtime with
+//    profile::enable(); while off, an instrumented call costs one relaxed atomic load, nothing
+//    per pixel.
+//
+//    A Site names a call site and the kernel it runs, plus the instruction set the site was
+//    compiled for. tukan has no runtime dispatch, so the instruction set is the compile target,
+//    e.g. "avx2" with -march=haswell; a site that was expected to run SIMD code but reports
+//    "sse2" was built without the flags. A Scope counts one call of a site, timing it with the
+//    time stamp counter on x86 (cycles at the TSC's constant rate), elsewhere in nanoseconds.
+//
+//    Instrumented are the pointer-range and image batch operations: apply() of LUT1D, Log2LUT1D
+//    and LUT3D (by interpolation), pack_half/unpack_half (F16C or portable), pack/unpack of
+//    packed formats (by format) and the dithered encode() (by method). Baked LUTs count as their
+//    shaper and cube. Bytes are the pixel data read and written, not lookup tables; pack_half
+//    and unpack_half count single values as pixels.
+//
+//    Each thread counts into its own table, with plain relaxed stores and no locks; a lock is
+//    only taken when a thread counts for the first time, when it exits (adding its counts to
+//    the totals), and by snapshot() and reset(). A snapshot sums all threads; taken while
+//    operations run, it may lag by the calls in flight.
+//
+//
+// Definitions:
+//
+//    void enable (bool on = true)
+//    bool enabled ()
+//
+//    struct Record {
+//        std::string name, kernel, isa;
+//        uint64_t calls, pixels, bytes, cycles;
+//    };
+//
+//    // Counts since the start or the last reset(), of sites that were called, in order of
+//    // their first call. Sites with equal name, kernel and isa, e.g. of the instantiations
+//    // of a template, are summed into one record.
+//    std::vector<Record> snapshot ()
+//    void reset ()
+//
+//    // Call sites, as function-local statics; name and kernel must be string literals (or
+//    // otherwise outlive the program). Sites beyond the first max_sites are not counted.
+//    class Site {
+//        Site (char const *name, char const *kernel)
+//    };
+//    constexpr unsigned max_sites = 256
+//
+//    // Counts a call of 'site' from construction to destruction.
+//    class Scope {
+//        Scope (Site const &site, uint64_t pixels, uint64_t bytes)
+//    };
+//
+//    char const* isa ()             // the instruction set compiled for
+//    uint64_t ticks ()              // TSC on x86, else nanoseconds
+//
+//
+// Examples:
+//
+//    profile::enable();
+//    apply(lut, in, out, Interpolation::tetrahedral);
+//    for (auto const &r : profile::snapshot())
+//        std::cout << r.name << " " << r.kernel << " [" << r.isa << "]: "
+//                  << double(r.cycles) / r.pixels << " cycles/pixel\n";
+//
+//    // Instrumenting an own batch operation:
+//    void convert (Pixel const *first, Pixel const *last, Out *out) {
+//        static const profile::Site site ("convert", "scalar");
+//        const profile::Scope scope (site, last-first, (last-first) * (sizeof *first + sizeof *out));
+//        ...
+//    }
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan { namespace profile {
+
+    constexpr unsigned max_sites = 256;
+
+    struct Record {
+        std::string name, kernel, isa;
+        std::uint64_t calls = 0, pixels = 0, bytes = 0, cycles = 0;
+    };
+
+    class Site {
+    public:
+        Site (char const *name, char const *kernel) noexcept ;
+
+        Site (Site const &) = delete;
+        Site& operator= (Site const &) = delete;
+
+        char const* name () const noexcept { return name_; }
+        char const* kernel () const noexcept { return kernel_; }
+        char const* isa () const noexcept { return isa_; }
+        unsigned id () const noexcept { return id_; }
+
+    private:
+        char const *name_, *kernel_, *isa_;
+        unsigned id_;
+    };
+
+    class Scope {
+    public:
+        Scope (Site const &site, std::uint64_t pixels, std::uint64_t bytes) noexcept ;
+        ~Scope ();
+
+        Scope (Scope const &) = delete;
+        Scope& operator= (Scope const &) = delete;
+
+    private:
+        Site const *site_;
+        std::uint64_t pixels_, bytes_, start_;
+    };
+
+    void enable (bool on = true) noexcept ;
+    bool enabled () noexcept ;
+
+    std::vector<Record> snapshot ();
+    void reset ();
+
+    char const* isa () noexcept ;
+    std::uint64_t ticks () noexcept ;
+
+} }
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan { namespace profile {
+
+    namespace detail {
+        enum { calls, pixels, bytes, cycles, counter_count };
+
+        struct thread_table {
+            std::atomic<std::uint64_t> counters[max_sites][counter_count];
+            thread_table *prev = nullptr, *next = nullptr;
+
+            thread_table () noexcept ;
+            ~thread_table ();
+        };
+
+        // Globals without dynamic initialization, in a template to be header-only.
+        template <typename = void>
+        struct state {
+            static std::atomic<bool> enabled;
+            static std::atomic<unsigned> site_count;
+            static std::atomic<Site const*> sites[max_sites];
+            static std::mutex mutex;                               // guards the following
+            static thread_table *threads;
+            static std::uint64_t retired[max_sites][counter_count]; // of exited threads
+            static std::uint64_t base[max_sites][counter_count];    // at the last reset()
+        };
+        template <typename T> std::atomic<bool> state<T>::enabled {false};
+        template <typename T> std::atomic<unsigned> state<T>::site_count {0};
+        template <typename T> std::atomic<Site const*> state<T>::sites[max_sites];
+        template <typename T> std::mutex state<T>::mutex;
+        template <typename T> thread_table* state<T>::threads = nullptr;
+        template <typename T> std::uint64_t state<T>::retired[max_sites][counter_count];
+        template <typename T> std::uint64_t state<T>::base[max_sites][counter_count];
+        using globals = state<>;
+
+        inline thread_table::thread_table () noexcept {
+            for (auto &site : counters)
+                for (auto &c : site)
+                    c.store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock (globals::mutex);
+            next = globals::threads;
+            if (next)
+                next->prev = this;
+            globals::threads = this;
+        }
+
+        inline thread_table::~thread_table () {
+            std::lock_guard<std::mutex> lock (globals::mutex);
+            for (unsigned s=0; s!=max_sites; ++s)
+                for (unsigned c=0; c!=counter_count; ++c)
+                    globals::retired[s][c] += counters[s][c].load(std::memory_order_relaxed);
+            (prev ? prev->next : globals::threads) = next;
+            if (next)
+                next->prev = prev;
+        }
+
+        inline thread_table& this_thread () {
+            static thread_local thread_table table;
+            return table;
+        }
+
+        // Only the owning thread writes, so no read-modify-write is needed.
+        inline void add (std::atomic<std::uint64_t> &counter, std::uint64_t v) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        }
+
+        // Requires the lock.
+        inline void totals (std::uint64_t (&ret)[max_sites][counter_count]) {
+            for (unsigned s=0; s!=max_sites; ++s)
+                for (unsigned c=0; c!=counter_count; ++c)
+                    ret[s][c] = globals::retired[s][c];
+            for (thread_table *t = globals::threads; t; t = t->next)
+                for (unsigned s=0; s!=max_sites; ++s)
+                    for (unsigned c=0; c!=counter_count; ++c)
+                        ret[s][c] += t->counters[s][c].load(std::memory_order_relaxed);
+        }
+    }
+
+
+    inline char const* isa () noexcept {
+#if defined(__AVX512F__)
+        return "avx512f";
+#elif defined(__AVX2__)
+        return "avx2";
+#elif defined(__AVX__)
+        return "avx";
+#elif defined(__SSE4_2__)
+        return "sse4.2";
+#elif defined(__SSE2__) || defined(__x86_64__)
+        return "sse2";
+#elif defined(__ARM_NEON)
+        return "neon";
+#else
+        return "generic";
+#endif
+    }
+
+    inline std::uint64_t ticks () noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+
+    inline Site::Site (char const *name, char const *kernel) noexcept
+        : name_(name), kernel_(kernel), isa_(profile::isa()),
+          id_(detail::globals::site_count.fetch_add(1))
+    {
+        if (id_ < max_sites)
+            detail::globals::sites[id_].store(this, std::memory_order_release);
+    }
+
+
+    inline Scope::Scope (Site const &site, std::uint64_t pixels, std::uint64_t bytes) noexcept
+        : site_(enabled() && site.id() < max_sites ? &site : nullptr),
+          pixels_(pixels), bytes_(bytes), start_(site_ ? ticks() : 0)
+    {
+    }
+
+    inline Scope::~Scope () {
+        if (!site_)
+            return;
+        const std::uint64_t elapsed = ticks() - start_;
+        auto &c = detail::this_thread().counters[site_->id()];
+        detail::add(c[detail::calls], 1);
+        detail::add(c[detail::pixels], pixels_);
+        detail::add(c[detail::bytes], bytes_);
+        detail::add(c[detail::cycles], elapsed);
+    }
+
+
+    inline void enable (bool on) noexcept {
+        detail::globals::enabled.store(on, std::memory_order_relaxed);
+    }
+
+    inline bool enabled () noexcept {
+        return detail::globals::enabled.load(std::memory_order_relaxed);
+    }
+
+
+    inline std::vector<Record> snapshot ()
+    {
+        using namespace detail;
+        std::uint64_t t[max_sites][counter_count];
+        {
+            std::lock_guard<std::mutex> lock (globals::mutex);
+            totals(t);
+            for (unsigned s=0; s!=max_sites; ++s)
+                for (unsigned c=0; c!=counter_count; ++c)
+                    t[s][c] -= globals::base[s][c];
+        }
+
+        std::vector<Record> ret;
+        const unsigned n = std::min(globals::site_count.load(), max_sites);
+        for (unsigned s=0; s!=n; ++s) {
+            Site const *site = globals::sites[s].load(std::memory_order_acquire);
+            if (!site || t[s][calls] == 0)
+                continue;
+            auto r = std::find_if(ret.begin(), ret.end(), [site](Record const &r) {
+                return r.name == site->name() && r.kernel == site->kernel()
+                    && r.isa == site->isa();
+            });
+            if (r == ret.end()) {
+                ret.emplace_back();
+                r = ret.end() - 1;
+                r->name = site->name();
+                r->kernel = site->kernel();
+                r->isa = site->isa();
+            }
+            r->calls += t[s][calls];
+            r->pixels += t[s][pixels];
+            r->bytes += t[s][bytes];
+            r->cycles += t[s][cycles];
+        }
+        return ret;
+    }
+
+
+    inline void reset ()
+    {
+        std::lock_guard<std::mutex> lock (detail::globals::mutex);
+        detail::totals(detail::globals::base);
+    }
+
+} }
+
+#endif // PROFILE_HH_INCLUDED_20261018
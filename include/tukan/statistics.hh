@@ -0,0 +1,455 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef STATISTICS_HH_INCLUDED_20261018
+#define STATISTICS_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "luminance.hh"
+#include "detail/exp.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Image statistics:
+//
+//    Per-frame statistics of LinearRGB images, for auto exposure and quality checks: minimum,
+//    maximum and mean per channel and of the luminance, the log-average luminance, and
+//    histograms of the channels and the luminance, from which percentiles are read.
+//
+//    Luminance is Y, with the weights of luminance.hh (the Y row of the space's rgb_to_xyz).
+//    The log-average luminance is exp2(mean(log2(delta + max(Y,0)))), as used by Reinhard's
+//    key value; delta keeps black pixels from dominating it.
+//
+//    Both passes are vectorized within rows and parallel over blocks of rows. The image is cut
+//    into the same blocks regardless of the number of threads, each with its own partial
+//    minima, sums and histograms, which are merged at the end; so the results do not depend
+//    on the number of threads. Sums are kept in double. The logarithms are computed with
+//    detail::log2_approx (absolute error below 4e-6), in float also for images over double.
+//
+//    Images are expected to be finite. NaN channels are ignored by the minima and maxima, but
+//    turn the sums into NaN; histograms count NaN as below their range.
+//
+//    A Histogram has 'bins' bins of equal width between lo and hi, on a linear scale or on a
+//    log2 scale (where each bin spans the same number of stops, and lo must be positive).
+//    Values outside [lo..hi) are counted in 'below' and 'above'. Percentiles interpolate
+//    linearly (on the histogram's scale) within the bin where they fall, so they are exact to
+//    the bin width.
+//
+//
+// Definitions:
+//
+//    struct ImageStatistics {
+//        std::size_t pixels;
+//        double min[3], max[3], mean[3];                        // r, g, b
+//        double min_luminance, max_luminance, mean_luminance, log_average_luminance;
+//    };
+//
+//    // Pixel is LinearRGB<T,S> or LinearRGB<T,S> const. All zero for an empty image.
+//    ImageStatistics statistics (ImageView<Pixel> img, double delta = 1e-4)
+//
+//    struct Histogram {
+//        enum class Scale { linear, log2 };
+//
+//        double lo, hi;
+//        Scale scale;
+//        std::vector<std::uint64_t> counts;                      // one per bin
+//        std::uint64_t below, above;
+//
+//        // Throws std::logic_error if bins is 0, if !(lo < hi), or if lo <= 0 for log2.
+//        Histogram (unsigned bins, double lo, double hi, Scale scale = Scale::linear)
+//
+//        unsigned bins () const
+//        double edge (unsigned i) const               // lower edge of bin i; edge(bins()) = hi
+//        std::uint64_t total () const                 // including below and above
+//
+//        void add (double v)
+//        // Throws std::logic_error if the histograms differ in bins, range or scale.
+//        Histogram& operator+= (Histogram const &)
+//
+//        // The value below which the fraction p of all values lies, p in [0..1]. lo if it
+//        // falls below the range, hi above it, NaN if the histogram is empty.
+//        double percentile (double p) const
+//    };
+//
+//    struct ImageHistograms {
+//        Histogram r, g, b, luminance;
+//    };
+//
+//    // Adds the pixels to copies of 'channels' (for r, g and b) and 'luminance'; so the
+//    // given histograms define the bins, and may already hold counts, e.g. of earlier frames.
+//    ImageHistograms histograms (ImageView<Pixel> img, Histogram const &channels,
+//                                Histogram const &luminance)
+//
+//
+// Examples:
+//
+//    const auto s = statistics(image_view(frame.data(), w, h));
+//    const double exposure = 0.18 / s.log_average_luminance;
+//
+//    // 64 bins per 2 stops, from 2^-16 to 2^16.
+//    const Histogram lum (1024, std::ldexp(1,-16), std::ldexp(1,16), Histogram::Scale::log2);
+//    const auto h = histograms(image_view(frame.data(), w, h), Histogram(256, 0, 1), lum);
+//    const double white = h.luminance.percentile(0.99);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    struct ImageStatistics {
+        std::size_t pixels = 0;
+        double min[3] = {0, 0, 0}, max[3] = {0, 0, 0}, mean[3] = {0, 0, 0};
+        double min_luminance = 0, max_luminance = 0, mean_luminance = 0,
+               log_average_luminance = 0;
+    };
+
+    template <typename Pixel>
+    ImageStatistics statistics (ImageView<Pixel> img, double delta = 1e-4);
+
+
+    struct Histogram {
+        enum class Scale { linear, log2 };
+
+        double lo = 0, hi = 1;
+        Scale scale = Scale::linear;
+        std::vector<std::uint64_t> counts;
+        std::uint64_t below = 0, above = 0;
+
+        Histogram (unsigned bins, double lo, double hi, Scale scale = Scale::linear);
+
+        unsigned bins () const noexcept { return static_cast<unsigned>(counts.size()); }
+        double edge (unsigned i) const noexcept ;
+        std::uint64_t total () const noexcept ;
+
+        void add (double v) noexcept ;
+        Histogram& operator+= (Histogram const &rhs);
+
+        double percentile (double p) const noexcept ;
+    };
+
+    struct ImageHistograms {
+        Histogram r, g, b, luminance;
+    };
+
+    template <typename Pixel>
+    ImageHistograms histograms (ImageView<Pixel> img, Histogram const &channels,
+                                Histogram const &luminance);
+
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan {
+
+    namespace detail {
+        // Blocks of rows with separate partial results; fixed, for results independent of the
+        // number of threads.
+        inline std::size_t reduction_blocks (std::size_t height) noexcept {
+            return std::min<std::size_t>(height, 32);
+        }
+
+        // Histogram axis in the units of the scale, with the bin of a value computed in float.
+        struct histogram_axis {
+            float lo, inv_width;
+            std::uint32_t bins;
+            bool log2;
+
+            explicit histogram_axis (Histogram const &h) noexcept
+                : lo(float(h.scale == Histogram::Scale::log2 ? std::log2(h.lo) : h.lo)),
+                  inv_width(float(h.bins() / (h.scale == Histogram::Scale::log2
+                                              ? std::log2(h.hi) - std::log2(h.lo)
+                                              : h.hi - h.lo))),
+                  bins(h.bins()),
+                  log2(h.scale == Histogram::Scale::log2)
+            {}
+
+            // 0 for below (and NaN), 1 + bin, or bins + 1 for above. The bin is clamped to
+            // [0..bins] (NaN to 0) before the conversion, which is undefined outside of that.
+            std::uint32_t operator() (float v) const noexcept {
+                const float u = log2 ? select(v > 0, log2_approx(select(v > 0, v, 1.f)),
+                                              -std::numeric_limits<float>::infinity())
+                                     : v;
+                const float t = (u - lo) * inv_width;
+                float c = select(t > 0, t, 0.f);
+                c = select(c < float(bins), c, float(bins));
+                return select(t >= 0, std::uint32_t(c) + 1, 0u);
+            }
+        };
+
+        template <typename T>
+        struct statistics_partial {
+            T min[4], max[4];
+            double sum[4] = {0, 0, 0, 0}, log_sum = 0;
+
+            statistics_partial () noexcept {
+                std::fill(min, min + 4, std::numeric_limits<T>::infinity());
+                std::fill(max, max + 4, -std::numeric_limits<T>::infinity());
+            }
+        };
+
+        // Rows are split into channel planes first: loading interleaved triples needs the
+        // shuffles of AVX2, with plain SSE2 the loops over them vectorize poorly.
+        template <typename T>
+        inline void deinterleave (T const *p, std::ptrdiff_t n, T *r, T *g, T *b) noexcept {
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                r[i] = p[3*i+0];
+                g[i] = p[3*i+1];
+                b[i] = p[3*i+2];
+            }
+        }
+
+        // Minima and maxima use the conditional operator, which the compiler maps to min/max
+        // instructions in a reduction (and which ignores NaN like these instructions do).
+        template <typename T>
+        inline void statistics_row (T const *pr, T const *pg, T const *pb, std::ptrdiff_t n,
+                                    LuminanceWeights<T> y, float delta,
+                                    statistics_partial<T> &s) noexcept
+        {
+            T rmin = s.min[0], gmin = s.min[1], bmin = s.min[2], ymin = s.min[3],
+              rmax = s.max[0], gmax = s.max[1], bmax = s.max[2], ymax = s.max[3];
+            double rsum = 0, gsum = 0, bsum = 0, ysum = 0, lsum = 0;
+            const T kr = y.r, kg = y.g, kb = y.b;
+
+            #pragma omp simd reduction(min:rmin,gmin,bmin,ymin) reduction(max:rmax,gmax,bmax,ymax) \
+                             reduction(+:rsum,gsum,bsum,ysum,lsum)
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const T r = pr[i], g = pg[i], b = pb[i];
+                const T l = kr*r + kg*g + kb*b;
+                rmin = r < rmin ? r : rmin;  rmax = r > rmax ? r : rmax;
+                gmin = g < gmin ? g : gmin;  gmax = g > gmax ? g : gmax;
+                bmin = b < bmin ? b : bmin;  bmax = b > bmax ? b : bmax;
+                ymin = l < ymin ? l : ymin;  ymax = l > ymax ? l : ymax;
+                rsum += r;
+                gsum += g;
+                bsum += b;
+                ysum += l;
+                const float lf = float(l);
+                lsum += log2_approx(select(lf > 0, lf, 0.f) + delta);
+            }
+
+            s.min[0] = rmin; s.min[1] = gmin; s.min[2] = bmin; s.min[3] = ymin;
+            s.max[0] = rmax; s.max[1] = gmax; s.max[2] = bmax; s.max[3] = ymax;
+            s.sum[0] += rsum; s.sum[1] += gsum; s.sum[2] += bsum; s.sum[3] += ysum;
+            s.log_sum += lsum;
+        }
+
+        template <typename T, template <typename> class S>
+        inline ImageStatistics statistics (ImageView<LinearRGB<T,S> const> img, double delta)
+        {
+            static_assert(sizeof(LinearRGB<T,S>) == 3*sizeof(T),
+                          "statistics: pixels must be three channels without padding");
+            ImageStatistics ret;
+            if (img.empty())
+                return ret;
+
+            const LuminanceWeights<T> y = luminance_weights<T,S>();
+            const std::size_t height = img.height, blocks = reduction_blocks(height);
+            std::vector<statistics_partial<T>> partials (blocks);
+
+            #pragma omp parallel for schedule(static)
+            for (long k=0; k<long(blocks); ++k) {
+                const std::ptrdiff_t n = std::ptrdiff_t(img.width);
+                std::vector<T> planes (3*n);
+                T *r = planes.data(), *g = r + n, *b = g + n;
+                for (std::size_t row=k*height/blocks; row!=(k+1)*height/blocks; ++row) {
+                    deinterleave(reinterpret_cast<T const*>(img.row(row)), n, r, g, b);
+                    statistics_row(r, g, b, n, y, float(delta), partials[k]);
+                }
+            }
+
+            statistics_partial<T> total;
+            for (auto const &p : partials) {
+                for (int c=0; c!=4; ++c) {
+                    total.min[c] = std::min(total.min[c], p.min[c]);
+                    total.max[c] = std::max(total.max[c], p.max[c]);
+                    total.sum[c] += p.sum[c];
+                }
+                total.log_sum += p.log_sum;
+            }
+
+            const double n = double(img.size());
+            ret.pixels = img.size();
+            for (int c=0; c!=3; ++c) {
+                ret.min[c] = total.min[c];
+                ret.max[c] = total.max[c];
+                ret.mean[c] = total.sum[c] / n;
+            }
+            ret.min_luminance = total.min[3];
+            ret.max_luminance = total.max[3];
+            ret.mean_luminance = total.sum[3] / n;
+            ret.log_average_luminance = std::exp2(total.log_sum / n);
+            return ret;
+        }
+
+
+        // Counts per channel as [below, bins..., above].
+        template <typename T>
+        inline void histogram_row (T const *pr, T const *pg, T const *pb, std::ptrdiff_t n,
+                                   LuminanceWeights<T> y,
+                                   histogram_axis const &ca, histogram_axis const &la,
+                                   std::uint32_t *index, std::uint64_t *counts) noexcept
+        {
+            const T kr = y.r, kg = y.g, kb = y.b;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const T r = pr[i], g = pg[i], b = pb[i];
+                index[4*i+0] = ca(float(r));
+                index[4*i+1] = ca(float(g));
+                index[4*i+2] = ca(float(b));
+                index[4*i+3] = la(float(kr*r + kg*g + kb*b));
+            }
+            const std::size_t cn = ca.bins + 2;
+            std::uint64_t *rc = counts, *gc = rc + cn, *bc = gc + cn, *yc = bc + cn;
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                ++rc[index[4*i+0]];
+                ++gc[index[4*i+1]];
+                ++bc[index[4*i+2]];
+                ++yc[index[4*i+3]];
+            }
+        }
+
+        inline void add_counts (Histogram &h, std::uint64_t const *counts) noexcept {
+            h.below += counts[0];
+            for (unsigned i=0; i!=h.bins(); ++i)
+                h.counts[i] += counts[i+1];
+            h.above += counts[h.bins()+1];
+        }
+
+        template <typename T, template <typename> class S>
+        inline ImageHistograms histograms (ImageView<LinearRGB<T,S> const> img,
+                                           Histogram const &channels, Histogram const &luminance)
+        {
+            static_assert(sizeof(LinearRGB<T,S>) == 3*sizeof(T),
+                          "histograms: pixels must be three channels without padding");
+            ImageHistograms ret {channels, channels, channels, luminance};
+            if (img.empty())
+                return ret;
+
+            const LuminanceWeights<T> y = luminance_weights<T,S>();
+            const histogram_axis ca (channels), la (luminance);
+            const std::size_t cn = channels.bins() + 2, ln = luminance.bins() + 2,
+                              size = 3*cn + ln,
+                              height = img.height, blocks = reduction_blocks(height);
+            std::vector<std::uint64_t> partials (blocks * size);
+
+            #pragma omp parallel for schedule(static)
+            for (long k=0; k<long(blocks); ++k) {
+                const std::ptrdiff_t n = std::ptrdiff_t(img.width);
+                std::vector<T> planes (3*n);
+                std::vector<std::uint32_t> index (4*n);
+                T *r = planes.data(), *g = r + n, *b = g + n;
+                for (std::size_t row=k*height/blocks; row!=(k+1)*height/blocks; ++row) {
+                    deinterleave(reinterpret_cast<T const*>(img.row(row)), n, r, g, b);
+                    histogram_row(r, g, b, n, y, ca, la, index.data(), partials.data() + k*size);
+                }
+            }
+
+            for (std::size_t k=0; k!=blocks; ++k) {
+                std::uint64_t const *p = partials.data() + k*size;
+                add_counts(ret.r, p);
+                add_counts(ret.g, p + cn);
+                add_counts(ret.b, p + 2*cn);
+                add_counts(ret.luminance, p + 3*cn);
+            }
+            return ret;
+        }
+    }
+
+
+    template <typename Pixel>
+    inline ImageStatistics statistics (ImageView<Pixel> img, double delta)
+    {
+        return detail::statistics(ImageView<typename std::remove_const<Pixel>::type const>(img),
+                                  delta);
+    }
+
+    template <typename Pixel>
+    inline ImageHistograms histograms (ImageView<Pixel> img, Histogram const &channels,
+                                       Histogram const &luminance)
+    {
+        return detail::histograms(ImageView<typename std::remove_const<Pixel>::type const>(img),
+                                  channels, luminance);
+    }
+
+
+    inline Histogram::Histogram (unsigned bins, double lo, double hi, Scale scale)
+        : lo(lo), hi(hi), scale(scale)
+    {
+        if (bins == 0)
+            throw std::logic_error("Histogram: no bins");
+        if (!(lo < hi))
+            throw std::logic_error("Histogram: lo must be less than hi");
+        if (scale == Scale::log2 && !(lo > 0))
+            throw std::logic_error("Histogram: lo must be positive for a log2 scale");
+        counts.assign(bins, 0);
+    }
+
+    inline double Histogram::edge (unsigned i) const noexcept {
+        const double t = double(i) / bins();
+        return scale == Scale::log2 ? std::exp2(std::log2(lo) + t * (std::log2(hi) - std::log2(lo)))
+                                    : lo + t * (hi - lo);
+    }
+
+    inline std::uint64_t Histogram::total () const noexcept {
+        std::uint64_t ret = below + above;
+        for (auto c : counts)
+            ret += c;
+        return ret;
+    }
+
+    inline void Histogram::add (double v) noexcept {
+        const std::uint32_t i = detail::histogram_axis(*this)(float(v));
+        if (i == 0)
+            ++below;
+        else if (i > bins())
+            ++above;
+        else
+            ++counts[i-1];
+    }
+
+    inline Histogram& Histogram::operator+= (Histogram const &rhs) {
+        if (bins() != rhs.bins() || lo != rhs.lo || hi != rhs.hi || scale != rhs.scale)
+            throw std::logic_error("Histogram: cannot add histograms with different bins");
+        for (unsigned i=0; i!=bins(); ++i)
+            counts[i] += rhs.counts[i];
+        below += rhs.below;
+        above += rhs.above;
+        return *this;
+    }
+
+    inline double Histogram::percentile (double p) const noexcept {
+        const std::uint64_t n = total();
+        if (n == 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        const double target = std::min(std::max(p, 0.0), 1.0) * n;
+        double acc = double(below);
+        if (target <= acc)
+            return lo;
+        for (unsigned i=0; i!=bins(); ++i) {
+            const double next = acc + double(counts[i]);
+            if (target <= next && counts[i] != 0) {
+                const double f = (target - acc) / double(counts[i]),
+                             t = (i + f) / bins();
+                return scale == Scale::log2
+                     ? std::exp2(std::log2(lo) + t * (std::log2(hi) - std::log2(lo)))
+                     : lo + t * (hi - lo);
+            }
+            acc = next;
+        }
+        return hi;
+    }
+
+}
+
+#endif // STATISTICS_HH_INCLUDED_20261018
@@ -0,0 +1,442 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef TONEMAP_HH_INCLUDED_20261018
+#define TONEMAP_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "RGB.hh"
+#include "dither.hh"
+#include "luminance.hh"
+#include "profile.hh"
+#include "unorm.hh"
+#include "detail/Matrix33.hh"
+#include "detail/exp.hh"
+#include "detail/planes.hh"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Tone mapping:
+//
+//    Operators that map scene-linear HDR colours to display-linear colours, and their
+//    application to single colours, to pixel ranges and images, and fused with encoding.
+//
+//    Reinhard      L(1 + L/white^2) / (1 + L), on the luminance (scaling the colour, which
+//                  keeps its hue) or per channel. With the default white of infinity, this is
+//                  L/(1+L); with a finite white, inputs of 'white' map to 1. Per channel, the
+//                  result is in [0..1] (up to 'white'); on the luminance, only the luminance
+//                  is, and a saturated colour keeps channels above 1.
+//    ACESFilmic    Narkowicz's fit of the ACES reference and output transforms, per channel
+//                  and clamped to [0..1]. The fit expects the input pre-exposed by about 0.6.
+//    Hable         Hable's filmic curve from Uncharted 2, per channel, scaled so that 'white'
+//                  maps to 1. The parameters are those of the curve's publication.
+//    AgX           Sobotka's AgX in the common real-time form: an inset matrix, a log2 encoding
+//                  of [min_ev..max_ev] stops around 0.18, a polynomial sigmoid and the outset
+//                  matrix, then decoded with gamma 2.2. Its matrices are for Rec.709 primaries
+//                  and used as they are in other spaces.
+//
+//    Operators are function objects that map n colours in place, given as planes of red, green
+//    and blue (up to 256 colours per call, one for a single colour); 'y' are the luminance
+//    weights (luminance.hh) of the space the colours are in. Each loops over the planes itself,
+//    in passes small enough for the compiler to inline and vectorize; own operators should do
+//    likewise:
+//
+//        struct Op {
+//            static constexpr char const* name ();                 // for profile.hh
+//            template <typename T>
+//            void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+//                             LuminanceWeights<T> const &y) const noexcept ;
+//        };
+//
+//    Colours are multiplied with 'exposure' before the operator. The logarithms and powers
+//    (AgX) are detail::log2_approx and detail::pow_approx for float, so that loops over them
+//    vectorize, and std::log2 and std::pow for double. The operators are not written with
+//    cmath.hh: it applies the std:: functions per channel, which are calls into libm that the
+//    compiler neither inlines nor vectorizes. The approximations cost some accuracy (below 4e-6
+//    absolute in log2 and 3e-6 relative in pow, see detail/exp.hh), far less than an output step.
+//
+//    tonemap_encode() fuses exposure, conversion to the output's space, the operator, gamma
+//    encoding and (dithered) quantization into one pass over the pixels, like encode() in
+//    dither.hh, which it shares the encoding with: each row is tone mapped into a buffer in the
+//    cache and encoded from there. The operator is applied in the output's space, with its
+//    luminance weights; channels outside of [0..1] after it are clamped by the encoding.
+//
+//
+// Definitions:
+//
+//    struct Reinhard {
+//        enum class Mode { luminance, per_channel };
+//        double white;                          // default infinity
+//        Mode mode;                             // default luminance
+//        Reinhard (double white = infinity, Mode mode = Mode::luminance)
+//    };
+//
+//    struct ACESFilmic { };
+//
+//    struct Hable {
+//        double shoulder_strength = 0.15, linear_strength = 0.50, linear_angle = 0.10,
+//               toe_strength = 0.20, toe_numerator = 0.02, toe_denominator = 0.30,
+//               white = 11.2;
+//    };
+//
+//    struct AgX {
+//        double min_ev = -12.47393, max_ev = 4.026069;
+//    };
+//
+//    // Pixel is LinearRGB<T,S>, the output is in the same space.
+//    Pixel tonemap (Pixel c, Operator const &op, double exposure = 1)
+//    void  tonemap (Pixel const *first, Pixel const *last, Pixel *out, Operator const &op,
+//                   double exposure = 1)
+//    // Throws std::logic_error if the views differ in extent.
+//    void  tonemap (ImageView<Pixel> in, ImageView<Pixel> out, Operator const &op,
+//                   double exposure = 1)
+//
+//    // In is LinearRGB<float,S> (const), Out is RGB<unorm<B>,S2>. Throws std::logic_error if
+//    // the views differ in extent.
+//    void tonemap_encode (ImageView<In> in, ImageView<Out> out, Operator const &op,
+//                         double exposure = 1, Dither method = Dither::none)
+//
+//
+// Examples:
+//
+//    const auto ldr = tonemap(LinearRGB<float,sRGB>(4, 2, 1), Reinhard(16));
+//
+//    // Rendered frame to an 8 bit sRGB image, in one pass.
+//    std::vector<RGB<unorm8,sRGB>> png (w*h);
+//    tonemap_encode(image_view(hdr.data(), w, h), image_view(png.data(), w, h),
+//                   AgX(), exposure, Dither::blue_noise);
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    //----------------------------------------------------------------------------------------------
+    // Operators
+    //----------------------------------------------------------------------------------------------
+    struct Reinhard {
+        enum class Mode { luminance, per_channel };
+
+        double white;
+        Mode mode;
+
+        Reinhard (double white = std::numeric_limits<double>::infinity(),
+                  Mode mode = Mode::luminance) noexcept
+            : white(white), mode(mode) {}
+
+        static constexpr char const* name () noexcept { return "reinhard"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         LuminanceWeights<T> const &y) const noexcept ;
+    };
+
+
+    struct ACESFilmic {
+        static constexpr char const* name () noexcept { return "aces"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         LuminanceWeights<T> const &y) const noexcept ;
+    };
+
+
+    struct Hable {
+        double shoulder_strength = 0.15, linear_strength = 0.50, linear_angle = 0.10,
+               toe_strength = 0.20, toe_numerator = 0.02, toe_denominator = 0.30,
+               white = 11.2;
+
+        static constexpr char const* name () noexcept { return "hable"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         LuminanceWeights<T> const &y) const noexcept ;
+    };
+
+
+    struct AgX {
+        double min_ev = -12.47393, max_ev = 4.026069;
+
+        static constexpr char const* name () noexcept { return "agx"; }
+
+        template <typename T>
+        void operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                         LuminanceWeights<T> const &y) const noexcept ;
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Application
+    //----------------------------------------------------------------------------------------------
+    template <typename T, template <typename> class RGBSpace, typename Operator>
+    LinearRGB<T,RGBSpace> tonemap (LinearRGB<T,RGBSpace> c, Operator const &op,
+                                   double exposure = 1) noexcept ;
+
+    template <typename T, template <typename> class RGBSpace, typename Operator>
+    void tonemap (LinearRGB<T,RGBSpace> const *first, LinearRGB<T,RGBSpace> const *last,
+                  LinearRGB<T,RGBSpace> *out, Operator const &op, double exposure = 1) noexcept ;
+
+    template <typename In, typename Out, typename Operator>
+    void tonemap (ImageView<In> in, ImageView<Out> out, Operator const &op, double exposure = 1);
+
+    template <typename In, typename Out, typename Operator>
+    void tonemap_encode (ImageView<In> in, ImageView<Out> out, Operator const &op,
+                         double exposure = 1, Dither method = Dither::none);
+
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// implementation
+//--------------------------------------------------------------------------------------------------
+namespace tukan {
+
+    // Reinhard
+    template <typename T>
+    inline void Reinhard::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                      LuminanceWeights<T> const &y) const noexcept
+    {
+        using detail::select;
+        const T inv_white2 = T(1 / (white * white));
+        if (mode == Mode::luminance) {
+            const T kr = y.r, kg = y.g, kb = y.b;
+            #pragma omp simd
+            for (std::ptrdiff_t i=0; i<n; ++i) {
+                const T l = kr*r[i] + kg*g[i] + kb*b[i];
+                const T s = select(l > 0, (1 + l*inv_white2) / (1 + l), T(0));
+                r[i] *= s;
+                g[i] *= s;
+                b[i] *= s;
+            }
+        } else {
+            detail::map_planes(r, g, b, n, [inv_white2](T v) {
+                v = select(v > 0, v, T(0));
+                return v * (1 + v*inv_white2) / (1 + v);
+            });
+        }
+    }
+
+
+    // ACESFilmic
+    template <typename T>
+    inline void ACESFilmic::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                        LuminanceWeights<T> const &) const noexcept
+    {
+        detail::map_planes(r, g, b, n, [](T x) {
+            return detail::clamp01((x * (T(2.51)*x + T(0.03))) / (x * (T(2.43)*x + T(0.59)) + T(0.14)));
+        });
+    }
+
+
+    // Hable
+    namespace detail {
+        template <typename T>
+        struct hable_curve {
+            T a, b, c, d, e, f;
+
+            explicit hable_curve (Hable const &h) noexcept
+                : a(T(h.shoulder_strength)), b(T(h.linear_strength)), c(T(h.linear_angle)),
+                  d(T(h.toe_strength)), e(T(h.toe_numerator)), f(T(h.toe_denominator)) {}
+
+            T operator() (T x) const noexcept {
+                return (x*(a*x + c*b) + d*e) / (x*(a*x + b) + d*f) - e/f;
+            }
+        };
+    }
+
+    template <typename T>
+    inline void Hable::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                   LuminanceWeights<T> const &) const noexcept
+    {
+        const detail::hable_curve<T> curve (*this);
+        const T scale = 1 / curve(T(white));
+        detail::map_planes(r, g, b, n, [curve, scale](T x) {
+            return curve(detail::select(x > 0, x, T(0))) * scale;
+        });
+    }
+
+
+    // AgX
+    namespace detail {
+        // Troy Sobotka's default contrast, as fitted by Benjamin Wrensch.
+        template <typename T>
+        inline T agx_contrast (T x) noexcept {
+            const T x2 = x*x, x4 = x2*x2;
+            return T(15.5)*x4*x2 - T(40.14)*x4*x + T(31.96)*x4 - T(6.868)*x2*x + T(0.4298)*x2
+                 + T(0.1191)*x - T(0.00232);
+        }
+    }
+
+    // In passes over the planes: with all of it in one loop, the compiler does not inline the
+    // six logarithms and powers, and the loop does not vectorize.
+    template <typename T>
+    inline void AgX::operator() (T *r, T *g, T *b, std::ptrdiff_t n,
+                                 LuminanceWeights<T> const &) const noexcept
+    {
+        using detail::select;
+        const T lo = T(min_ev), inv_range = T(1 / (max_ev - min_ev));
+        detail::multiply_planes(r, g, b, n, detail::Matrix33<T>(
+            T(0.842479062253094),  T(0.0784335999999992), T(0.0792237451477643),
+            T(0.0423282422610123), T(0.878468636469772),  T(0.0791661274605434),
+            T(0.0423756549057051), T(0.0784336),          T(0.879142973793104)));
+        detail::map_planes(r, g, b, n, [lo, inv_range](T v) {
+            v = select(v > T(1e-10), v, T(1e-10));
+            return detail::agx_contrast(detail::clamp01((detail::log2_simd(v) - lo) * inv_range));
+        });
+        detail::multiply_planes(r, g, b, n, detail::Matrix33<T>(
+            T(1.19687900512017),    T(-0.0980208811401368), T(-0.0990297440797205),
+            T(-0.0528968517574562), T(1.15190312990417),    T(-0.0989611768448433),
+            T(-0.0529716355144438), T(-0.0980434501171241), T(1.15107367264116)));
+        detail::map_planes(r, g, b, n, [](T v) {
+            return detail::pow_simd(select(v > 0, v, T(0)), T(2.2));
+        });
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Application
+    //----------------------------------------------------------------------------------------------
+    namespace detail {
+        // n pixels of three channels, multiplied with m (which includes the exposure).
+        template <typename T, typename Operator>
+        inline void tonemap_pixels (T const *in, std::ptrdiff_t n, T *out, Operator const &op,
+                                    Matrix33<T> const &m, LuminanceWeights<T> y) noexcept
+        {
+            transform_planes(in, n, out, m, [&](T *r, T *g, T *b, std::ptrdiff_t c, std::ptrdiff_t) {
+                op(r, g, b, c, y);
+            });
+        }
+    }
+
+
+    template <typename T, template <typename> class RGBSpace, typename Operator>
+    inline LinearRGB<T,RGBSpace> tonemap (LinearRGB<T,RGBSpace> c, Operator const &op,
+                                          double exposure) noexcept
+    {
+        T r = c.r * T(exposure), g = c.g * T(exposure), b = c.b * T(exposure);
+        op(&r, &g, &b, 1, luminance_weights<T,RGBSpace>());
+        return {r, g, b};
+    }
+
+
+    template <typename T, template <typename> class RGBSpace, typename Operator>
+    inline void tonemap (LinearRGB<T,RGBSpace> const *first, LinearRGB<T,RGBSpace> const *last,
+                         LinearRGB<T,RGBSpace> *out, Operator const &op, double exposure) noexcept
+    {
+        static_assert(sizeof(LinearRGB<T,RGBSpace>) == 3*sizeof(T),
+                      "tonemap: pixels must be three channels without padding");
+        const std::ptrdiff_t n = last - first;
+        static const profile::Site site ("tonemap", Operator::name());
+        const profile::Scope scope (site, n, n * 2 * sizeof *first);
+        detail::tonemap_pixels(reinterpret_cast<T const*>(first), n, reinterpret_cast<T*>(out),
+                               op, detail::scale_matrix<T>(exposure),
+                               luminance_weights<T,RGBSpace>());
+    }
+
+
+    template <typename In, typename Out, typename Operator>
+    inline void tonemap (ImageView<In> in, ImageView<Out> out, Operator const &op, double exposure)
+    {
+        transform_rows(in, out, [&](In *first, In *last, Out *o) {
+            tonemap(first, last, o, op, exposure);
+        });
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // tonemap_encode
+    //----------------------------------------------------------------------------------------------
+    namespace detail {
+        // A row source for encode_ordered() and encode_floyd_steinberg() in dither.hh.
+        template <typename Operator>
+        struct tonemap_rows {
+            ImageView<float const> in;   // three times as wide as the image
+            Operator op;
+            Matrix33<float> m;
+            LuminanceWeights<float> y;
+
+            std::size_t scratch_size () const noexcept { return in.width; }
+
+            float const* operator() (std::size_t row, float *scratch) const noexcept {
+                tonemap_pixels(in.row(row), std::ptrdiff_t(in.width / 3), scratch, op, m, y);
+                return scratch;
+            }
+        };
+
+
+        template <typename Operator, unsigned B, template <typename> class SI,
+                  template <typename> class SO>
+        inline void tonemap_encode (ImageView<LinearRGB<float,SI> const> in,
+                                    ImageView<RGB<unorm<B>,SO>> out, Operator const &op,
+                                    double exposure, Dither method)
+        {
+            using storage_type = typename unorm<B>::storage_type;
+            static_assert(sizeof(LinearRGB<float,SI>) == 3*sizeof(float) &&
+                          sizeof(RGB<unorm<B>,SO>) == 3*sizeof(storage_type),
+                          "tonemap_encode: pixels must be three channels without padding");
+
+            if (!same_extent(in, out))
+                throw std::logic_error("tonemap_encode: input and output differ in extent");
+
+            // Exposure and the conversion to the output's space in one matrix, computed in
+            // double.
+            const bool convert = !std::is_same<SI<float>, SO<float>>::value;
+            const Matrix33<double> m = convert
+                ? SO<double>().xyz_to_rgb * SI<double>().rgb_to_xyz * exposure
+                : scale_matrix<double>(exposure);
+            const tonemap_rows<Operator> rows {
+                {reinterpret_cast<float const*>(in.data), 3*in.width, in.height, 3*in.stride},
+                op,
+                {float(m._11), float(m._12), float(m._13),
+                 float(m._21), float(m._22), float(m._23),
+                 float(m._31), float(m._32), float(m._33)},
+                luminance_weights<float,SO>()
+            };
+            const ImageView<storage_type> fout (reinterpret_cast<storage_type*>(out.data),
+                                                3*out.width, out.height, 3*out.stride);
+            const auto gamma = SO<float>().gamma;
+
+            static const profile::Site sites[] = {
+                {"tonemap_encode", "none"}, {"tonemap_encode", "bayer"},
+                {"tonemap_encode", "blue_noise"}, {"tonemap_encode", "floyd_steinberg"}
+            };
+            const std::uint64_t pixels = std::uint64_t(in.width) * in.height;
+            const profile::Scope scope (sites[int(method)], pixels,
+                                        pixels * (sizeof(LinearRGB<float,SI>) + sizeof(RGB<unorm<B>,SO>)));
+
+            switch (method) {
+            case Dither::none:
+                encode_ordered<B>(rows, fout, none_64x64, 64, 1.f, gamma);
+                break;
+            case Dither::bayer:
+                encode_ordered<B>(rows, fout, bayer_8x8, 8, 1/64.f, gamma);
+                break;
+            case Dither::blue_noise:
+                encode_ordered<B>(rows, fout, blue_noise_64x64, 64, 1/256.f, gamma);
+                break;
+            case Dither::floyd_steinberg:
+                encode_floyd_steinberg<B>(rows, fout, gamma);
+                break;
+            }
+        }
+    }
+
+
+    template <typename In, typename Out, typename Operator>
+    inline void tonemap_encode (ImageView<In> in, ImageView<Out> out, Operator const &op,
+                                double exposure, Dither method)
+    {
+        detail::tonemap_encode(ImageView<typename std::remove_const<In>::type const>(in), out, op,
+                               exposure, method);
+    }
+
+}
+
+#endif // TONEMAP_HH_INCLUDED_20261018
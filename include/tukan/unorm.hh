@@ -0,0 +1,307 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef UNORM_HH_INCLUDED_20261018
+#define UNORM_HH_INCLUDED_20261018
+
+#include "ImageView.hh"
+#include "LinearRGB.hh"
+#include "RGB.hh"
+#include "detail/exp.hh"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// unorm:
+//
+//    Normalized unsigned integer channels, i.e. the integer codes 0..2^Bits-1 standing for the
+//    reals 0..1, as found in 8 and 16 bit image files and 10 bit video. Like half, a unorm
+//    converts implicitly from and to float, so that it can be used as T in RGB:
+//
+//        RGB<unorm8,sRGB> c (1.0f, 0.5f, 0);      // codes 255, 128, 0
+//
+//    Conversion from float clamps to [0..1], maps NaN to 0 and rounds to the nearest code;
+//    this is exact for all floats, i.e. the same as rounding f*(2^Bits-1) computed with infinite
+//    precision. Conversion to float is code/(2^Bits-1), correctly rounded.
+//
+//    For whole colors, decode() linearizes with a lookup table per RGBSpace and bit depth, built
+//    on first use (256 to 65536 floats), and encode() applies the gamma, then rounds as above.
+//    The member conversions of RGB<unorm8,...> to LinearRGB and XYZ still exist, but yield
+//    colors over unorm8, too.
+//
+//
+// Definitions:
+//
+//    unorm8, unorm10, unorm16 = unorm<8>, unorm<10>, unorm<16>
+//
+//    unorm (float f)
+//    operator float () const
+//    static constexpr unorm from_code (storage_type c)      c <= max_code
+//    storage_type code () const
+//
+//    // Channels. Both vectorize; quantize() is exact as described above.
+//    void quantize   (float const *first, float const *last, unorm<B> *out)
+//    void dequantize (unorm<B> const *first, unorm<B> const *last, float *out)
+//
+//    // Colors. The ImageView overloads throw std::logic_error if the views differ in extent.
+//    LinearRGB<float,S> decode (RGB<unorm<B>,S> c)
+//    void decode (RGB<unorm<B>,S> const *first, RGB<unorm<B>,S> const *last, LinearRGB<float,S> *out)
+//    void decode (ImageView<In> in, ImageView<Out> out)
+//
+//    RGB<U,S> encode<U> (LinearRGB<float,S> c)                U is a unorm
+//    void encode (LinearRGB<float,S> const *first, LinearRGB<float,S> const *last, RGB<U,S> *out)
+//    void encode (ImageView<In> in, ImageView<Out> out)
+//
+//    // 10 bit colors packed into 32 bits: r in bits 0-9, g in 10-19, b in 20-29, 30-31 zero.
+//    uint32_t pack_rgb10 (RGB<unorm10,S> c)
+//    RGB<unorm10,S> unpack_rgb10<S> (uint32_t p)
+//
+//
+// Examples:
+//
+//    std::vector<RGB<unorm8,sRGB>> png = ...;
+//    std::vector<LinearRGB<float,sRGB>> linear (png.size());
+//    decode(png.data(), png.data()+png.size(), linear.data());
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+namespace tukan {
+
+    //----------------------------------------------------------------------------------------------
+    // unorm
+    //----------------------------------------------------------------------------------------------
+    template <unsigned Bits>
+    struct unorm {
+        static_assert(Bits >= 2 && Bits <= 16, "unorm: 2 to 16 bits are supported");
+
+        using storage_type = typename std::conditional<(Bits <= 8), std::uint8_t,
+                                                       std::uint16_t>::type;
+        static constexpr storage_type max_code = storage_type((1u << Bits) - 1);
+
+        constexpr unorm() noexcept = default;
+        unorm (float f) noexcept ;
+
+        operator float () const noexcept { return float(code_) / max_code; }
+
+        static constexpr unorm from_code (storage_type c) noexcept { return unorm(c, 0); }
+        constexpr storage_type code() const noexcept { return code_; }
+
+    private:
+        constexpr unorm (storage_type c, int) noexcept : code_(c) {}
+        storage_type code_ = 0;
+    };
+
+    using unorm8  = unorm<8>;
+    using unorm10 = unorm<10>;
+    using unorm16 = unorm<16>;
+
+
+    // -- channels --------------------------------------------------------------------------------
+    template <unsigned B>
+    void quantize (float const *first, float const *last, unorm<B> *out) noexcept ;
+
+    template <unsigned B>
+    void dequantize (unorm<B> const *first, unorm<B> const *last, float *out) noexcept ;
+
+
+    // -- colors ----------------------------------------------------------------------------------
+    template <unsigned B, template <typename> class S>
+    LinearRGB<float,S> decode (RGB<unorm<B>,S> c) noexcept ;
+
+    template <unsigned B, template <typename> class S>
+    void decode (RGB<unorm<B>,S> const *first, RGB<unorm<B>,S> const *last,
+                 LinearRGB<float,S> *out) noexcept ;
+
+    template <typename In, typename Out>
+    void decode (ImageView<In> in, ImageView<Out> out);
+
+
+    template <typename U, template <typename> class S>
+    RGB<U,S> encode (LinearRGB<float,S> c) noexcept ;
+
+    template <unsigned B, template <typename> class S>
+    void encode (LinearRGB<float,S> const *first, LinearRGB<float,S> const *last,
+                 RGB<unorm<B>,S> *out) noexcept ;
+
+    template <typename In, typename Out>
+    void encode (ImageView<In> in, ImageView<Out> out);
+
+
+    // -- packing ---------------------------------------------------------------------------------
+    template <template <typename> class S>
+    std::uint32_t pack_rgb10 (RGB<unorm10,S> c) noexcept ;
+
+    template <template <typename> class S>
+    RGB<unorm10,S> unpack_rgb10 (std::uint32_t p) noexcept ;
+
+}
+
+
+
+//---------------------------------------------------------------------------------------------
+// implementation
+//---------------------------------------------------------------------------------------------
+namespace tukan {
+
+    template <unsigned Bits>
+    constexpr typename unorm<Bits>::storage_type unorm<Bits>::max_code;
+
+
+    namespace detail {
+        // Rounds f*(2^Bits-1) to the nearest integer, exactly, after clamping f to [0..1].
+        //
+        // f*(2^Bits-1) = f*2^Bits - f, where the first product is exact. The difference is s+e
+        // exactly (Fast2Sum). Rounding s gives r, which is off by at most one; the sign of
+        // s+e-(r+-0.5) decides, and it is computed exactly. Ties cannot occur, as (k+0.5)/(2^Bits-1)
+        // is never a binary fraction.
+        template <unsigned Bits>
+        inline std::uint32_t quantize_unorm (float f) noexcept
+        {
+            float v = select(f > 0, f, 0.f); // also maps NaN to 0
+            v = select(v < 1, v, 1.f);
+
+            const float a = v * float(1u << Bits);
+            const float s = a - v;
+            const float e = (a - s) - v;
+
+            const float magic = 12582912.f; // see exp_approx
+            const float rm = s + magic;
+            std::uint32_t r;
+            std::memcpy(&r, &rm, sizeof r);
+            const float d = s - (rm - magic);
+
+            return r - 0x4B400000u
+                 + std::uint32_t(((d - 0.5f) + e) >= 0)
+                 - std::uint32_t(((d + 0.5f) + e) <  0);
+        }
+
+
+        // Table of the linearized value of every code, for the gamma of S.
+        template <unsigned Bits, template <typename> class S>
+        inline float const* decode_lut ()
+        {
+            static const std::vector<float> lut = [] {
+                std::vector<float> ret (std::size_t(unorm<Bits>::max_code) + 1);
+                for (std::size_t i=0; i!=ret.size(); ++i)
+                    ret[i] = static_cast<float>(
+                        S<double>().gamma.to_linear(double(i) / unorm<Bits>::max_code));
+                return ret;
+            } ();
+            return lut.data();
+        }
+    }
+
+
+    template <unsigned Bits>
+    inline unorm<Bits>::unorm (float f) noexcept
+        : code_(static_cast<storage_type>(detail::quantize_unorm<Bits>(f)))
+    {
+    }
+
+
+    template <unsigned B>
+    inline void quantize (float const *first, float const *last, unorm<B> *out) noexcept
+    {
+        static_assert(sizeof(unorm<B>) == sizeof(typename unorm<B>::storage_type), "");
+        using storage_type = typename unorm<B>::storage_type;
+
+        // Written as codes, as the compiler does not vectorize stores through unorm's constructor.
+        storage_type *codes = reinterpret_cast<storage_type*>(out);
+        const std::ptrdiff_t n = last - first;
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i)
+            codes[i] = static_cast<storage_type>(detail::quantize_unorm<B>(first[i]));
+    }
+
+
+    template <unsigned B>
+    inline void dequantize (unorm<B> const *first, unorm<B> const *last, float *out) noexcept
+    {
+        using storage_type = typename unorm<B>::storage_type;
+        storage_type const *codes = reinterpret_cast<storage_type const*>(first);
+        const std::ptrdiff_t n = last - first;
+        #pragma omp simd
+        for (std::ptrdiff_t i=0; i<n; ++i)
+            out[i] = float(codes[i]) / unorm<B>::max_code;
+    }
+
+
+    template <unsigned B, template <typename> class S>
+    inline LinearRGB<float,S> decode (RGB<unorm<B>,S> c) noexcept
+    {
+        float const *lut = detail::decode_lut<B,S>();
+        return {lut[c.r.code()], lut[c.g.code()], lut[c.b.code()]};
+    }
+
+
+    template <unsigned B, template <typename> class S>
+    inline void decode (RGB<unorm<B>,S> const *first, RGB<unorm<B>,S> const *last,
+                        LinearRGB<float,S> *out) noexcept
+    {
+        float const *lut = detail::decode_lut<B,S>();
+        for (; first!=last; ++first, ++out)
+            *out = {lut[first->r.code()], lut[first->g.code()], lut[first->b.code()]};
+    }
+
+
+    template <typename In, typename Out>
+    inline void decode (ImageView<In> in, ImageView<Out> out)
+    {
+        transform_rows(in, out, [](In *first, In *last, Out *o) { decode(first, last, o); });
+    }
+
+
+    template <typename U, template <typename> class S>
+    inline RGB<U,S> encode (LinearRGB<float,S> c) noexcept
+    {
+        auto gamma = S<double>().gamma;
+        return {U(static_cast<float>(gamma.to_nonlinear(c.r))),
+                U(static_cast<float>(gamma.to_nonlinear(c.g))),
+                U(static_cast<float>(gamma.to_nonlinear(c.b)))};
+    }
+
+
+    template <unsigned B, template <typename> class S>
+    inline void encode (LinearRGB<float,S> const *first, LinearRGB<float,S> const *last,
+                        RGB<unorm<B>,S> *out) noexcept
+    {
+        using U = unorm<B>;
+        auto gamma = S<double>().gamma;
+        for (; first!=last; ++first, ++out)
+            *out = {U(static_cast<float>(gamma.to_nonlinear(first->r))),
+                    U(static_cast<float>(gamma.to_nonlinear(first->g))),
+                    U(static_cast<float>(gamma.to_nonlinear(first->b)))};
+    }
+
+
+    template <typename In, typename Out>
+    inline void encode (ImageView<In> in, ImageView<Out> out)
+    {
+        transform_rows(in, out, [](In *first, In *last, Out *o) { encode(first, last, o); });
+    }
+
+
+    template <template <typename> class S>
+    inline std::uint32_t pack_rgb10 (RGB<unorm10,S> c) noexcept
+    {
+        return std::uint32_t(c.r.code())
+             | std::uint32_t(c.g.code()) << 10
+             | std::uint32_t(c.b.code()) << 20;
+    }
+
+
+    template <template <typename> class S>
+    inline RGB<unorm10,S> unpack_rgb10 (std::uint32_t p) noexcept
+    {
+        return {unorm10::from_code(p & 0x3ff),
+                unorm10::from_code((p >> 10) & 0x3ff),
+                unorm10::from_code((p >> 20) & 0x3ff)};
+    }
+
+}
+
+#endif // UNORM_HH_INCLUDED_20261018
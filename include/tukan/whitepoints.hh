@@ -4,6 +4,8 @@
 #ifndef WHITEPOINTS_HH_INCLUDED_20131213
 #define WHITEPOINTS_HH_INCLUDED_20131213
 
+#include "XYZ.hh"
+
 namespace tukan { namespace whitepoint {
     // TODO: with C++14, the whitepoints should be variable templates.
     // Whitepoints from: http://www.brucelindbloom.com/index.html?Eqn_ChromAdapt.html
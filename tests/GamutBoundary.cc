@@ -0,0 +1,134 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/GamutBoundary.hh"
+#include "tukan/RGBSpace.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    // The exact answer, by converting into the space.
+    template <template <typename> class RGBSpace>
+    bool exact_in_gamut (double L, double C, double h) {
+        const double a = C * std::cos(h * 3.14159265358979323846 / 180),
+                     b = C * std::sin(h * 3.14159265358979323846 / 180);
+        return detail::lab_gamut_test::of<RGBSpace>()(L, a, b);
+    }
+
+    template <template <typename> class RGBSpace>
+    double exact_max_chroma (double L, double h) {
+        return detail::lab_gamut_test::of<RGBSpace>().max_chroma(L, h);
+    }
+
+    // max_chroma() against the exact boundary between the samples, and in_gamut() against
+    // the exact test away from the boundary. Close to the cusps, few samples are further
+    // off than the tolerance.
+    template <template <typename> class RGBSpace>
+    void check_space (double tolerance) {
+        GamutBoundary<double,RGBSpace> const &boundary = gamut_boundary<double,RGBSpace>();
+        int samples = 0, off = 0;
+        for (double L = 0.3; L < 100; L += 1.9) {
+            for (double h = 0.7; h < 360; h += 3.1) {
+                const double exact = exact_max_chroma<RGBSpace>(L, h);
+                ++samples;
+                if (std::abs(boundary.max_chroma(L, h) - exact) > tolerance) {
+                    ++off;
+                    continue;
+                }
+                for (double C : {exact * 0.5, exact - 2*tolerance, exact + 2*tolerance,
+                                 exact * 1.5 + 1}) {
+                    if (C >= 0)
+                        REQUIRE(boundary.in_gamut(L, C, h) == exact_in_gamut<RGBSpace>(L, C, h));
+                }
+            }
+        }
+        REQUIRE(off * 100 < samples);
+    }
+}
+
+
+TEST_CASE("tukan/GamutBoundary", "GamutBoundary tests")
+{
+    SECTION("The table and its edges") {
+        const GamutBoundary<float,sRGB> b (36, 11);
+        REQUIRE(b.hues() == 36);
+        REQUIRE(b.lightnesses() == 11);
+
+        // Black and white have no chroma, the cusp the most; the samples are the exact boundary.
+        for (unsigned i=0; i!=36; ++i) {
+            REQUIRE(b.lightness(i, 0) == 0);
+            REQUIRE(b.lightness(i, 5) == b.cusp(i));
+            REQUIRE(b.lightness(i, 10) == 100);
+            REQUIRE(b.at(i, 0) == Approx(0).margin(1e-3));
+            REQUIRE(b.at(i, 10) == Approx(0).margin(1e-3));
+            REQUIRE(b.at(i, 5) > 20);
+            for (unsigned j=0; j!=11; ++j) {
+                REQUIRE(b.at(i, j) <= b.at(i, 5));
+                REQUIRE(b.at(i, j) == Approx(exact_max_chroma<sRGB>(b.lightness(i, j), i * 10.0))
+                                      .epsilon(1e-5).margin(1e-3));
+            }
+        }
+        REQUIRE_THROWS_AS(b.at(36, 0), std::out_of_range);
+        REQUIRE_THROWS_AS(b.at(0, 11), std::out_of_range);
+        REQUIRE_THROWS_AS(b.cusp(36), std::out_of_range);
+        REQUIRE_THROWS_AS(b.lightness(0, 11), std::out_of_range);
+        REQUIRE_THROWS_AS((GamutBoundary<float,sRGB>(2, 11)), std::logic_error);
+        REQUIRE_THROWS_AS((GamutBoundary<float,sRGB>(36, 2)), std::logic_error);
+
+        // Hue wraps around.
+        REQUIRE(b.max_chroma(50, 365) == Approx(b.max_chroma(50, 5)));
+        REQUIRE(b.max_chroma(50, -355) == Approx(b.max_chroma(50, 5)));
+        REQUIRE(b.max_chroma(b.cusp(35), 350) == Approx(b.at(35, 5)).epsilon(1e-5));
+
+        REQUIRE(b.max_chroma(50, -1e-30f) == Approx(b.max_chroma(50, 0)));
+        REQUIRE(b.max_chroma(-1, 0) == 0);
+        REQUIRE(b.max_chroma(101, 0) == 0);
+        REQUIRE(b.max_chroma(50, std::nanf("")) == 0);
+        REQUIRE(!b.in_gamut(100.5f, 0, 0));
+        REQUIRE(b.in_gamut(100, 0, 0));
+        REQUIRE(b.in_gamut(0, 0, 0));
+    }
+
+    SECTION("Interpolated against the exact boundary") {
+        check_space<sRGB>(0.5);
+        check_space<AdobeRGB>(0.5);
+        check_space<ProPhotoRGB>(0.5);
+
+        // Wider spaces hold more chroma.
+        REQUIRE(max_chroma<ProPhotoRGB>(50., 140.) > max_chroma<AdobeRGB>(50., 140.));
+        REQUIRE(max_chroma<AdobeRGB>(50., 140.) > max_chroma<sRGB>(50., 140.));
+        REQUIRE(in_gamut<sRGB>(50.f, 20.f, 30.f));
+        REQUIRE(!in_gamut<sRGB>(50.f, 120.f, 30.f));
+        REQUIRE(&gamut_boundary<float,sRGB>() == &gamut_boundary<float,sRGB>());
+    }
+
+    SECTION("Planes, counts and masks") {
+        GamutBoundary<float,sRGB> const &b = gamut_boundary<float,sRGB>();
+        std::vector<float> L, C, h;
+        for (int i=0; i!=600; ++i) {
+            L.push_back(i % 7 == 0 ? -1 + i * 0.2f : i * 0.17f);
+            C.push_back(i % 13 == 0 ? -1.f : (i * 37) % 130);
+            h.push_back(i % 11 == 0 ? std::nanf("") : i * 7.3f - 900);
+        }
+        h[5] = 1e30f;
+        h[6] = -1e-30f;
+
+        std::vector<std::uint8_t> mask (L.size(), 7);
+        std::size_t expected = 0;
+        for (std::size_t i=0; i!=L.size(); ++i)
+            expected += b.in_gamut(L[i], C[i], h[i]);
+        REQUIRE(expected > 50);
+        REQUIRE(b.in_gamut(L.data(), C.data(), h.data(), L.size(), mask.data()) == expected);
+        for (std::size_t i=0; i!=L.size(); ++i)
+            REQUIRE(mask[i] == (b.in_gamut(L[i], C[i], h[i]) ? 1 : 0));
+        REQUIRE(b.in_gamut(L.data(), C.data(), h.data(), 300)
+                + b.in_gamut(&L[300], &C[300], &h[300], 300) == expected);
+        REQUIRE(b.in_gamut(L.data(), C.data(), h.data(), 0) == 0);
+    }
+}
@@ -0,0 +1,49 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/ImageView.hh"
+#include "catch.hpp"
+#include <vector>
+
+TEST_CASE("tukan/ImageView", "ImageView tests")
+{
+    using namespace tukan;
+
+    std::vector<int> pixels = { 0,  1,  2, -1,
+                               10, 11, 12, -1,
+                               20, 21, 22, -1 };
+
+    SECTION("Access") {
+        const ImageView<int> img (pixels.data(), 3, 3, 4);
+        REQUIRE(img.size() == 9);
+        REQUIRE_FALSE(img.empty());
+        REQUIRE(img(0,0) == 0);
+        REQUIRE(img(2,1) == 12);
+        REQUIRE(img(1,2) == 21);
+        REQUIRE(img.row(2)[0] == 20);
+
+        img(1,1) = 42;
+        REQUIRE(pixels[5] == 42);
+
+        const ImageView<int const> cimg = img;
+        REQUIRE(cimg(1,1) == 42);
+
+        REQUIRE(ImageView<int>().empty());
+        REQUIRE(image_view(pixels.data(), 12, 1).stride == 12);
+    }
+
+    SECTION("transform_rows") {
+        std::vector<int> out(9);
+        transform_rows(ImageView<int const>(pixels.data(), 3, 3, 4),
+                       ImageView<int>(out.data(), 3, 3),
+                       [](int const *first, int const *last, int *out) {
+                           for (; first!=last; ++first, ++out) *out = 2 * *first;
+                       });
+        REQUIRE(out == (std::vector<int>{0, 2, 4, 20, 22, 24, 40, 42, 44}));
+
+        REQUIRE_THROWS(transform_rows(ImageView<int const>(pixels.data(), 3, 3, 4),
+                                      ImageView<int>(out.data(), 9, 1),
+                                      [](int const*, int const*, int*) {}));
+    }
+}
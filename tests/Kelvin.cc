@@ -0,0 +1,29 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/Kelvin.hh"
+#include "catch.hpp"
+
+TEST_CASE("tukan/Kelvin", "Kelvin tests")
+{
+    using namespace tukan;
+
+    REQUIRE(1_kelvin == 1_kelvin);
+    REQUIRE(1_kelvin != 2_kelvin);
+    REQUIRE(rel_equal(6500_kelvin, 6500.0_kelvin));
+    REQUIRE(static_cast<float>(6500_kelvin) == 6500.f);
+    REQUIRE((1_kelvin + 1_kelvin) == 2_kelvin);
+    REQUIRE((2_kelvin - 1_kelvin) == 1_kelvin);
+    REQUIRE((2 * 1_kelvin) == 2_kelvin);
+    REQUIRE((1_kelvin * 2) == 2_kelvin);
+    REQUIRE((1_kelvin / 2) == 0.5_kelvin);
+    REQUIRE((1_kelvin += 1_kelvin) == 2_kelvin);
+    REQUIRE((2_kelvin -= 1_kelvin) == 1_kelvin);
+    REQUIRE((1_kelvin *= 2) == 2_kelvin);
+    REQUIRE((1_kelvin /= 2) == 0.5_kelvin);
+    REQUIRE(1_kelvin < 2_kelvin);
+    REQUIRE(2_kelvin > 1_kelvin);
+    REQUIRE(1_kelvin <= 1_kelvin);
+    REQUIRE(1_kelvin >= 1_kelvin);
+}
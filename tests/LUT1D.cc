@@ -0,0 +1,149 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/LUT1D.hh"
+#include "tukan/LinearRGB.hh"
+#include "catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+TEST_CASE("tukan/LUT1D", "1D lookup table tests")
+{
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+
+    LUT1D<float,257> lut;
+    for (unsigned i=0; i!=257; ++i) {
+        lut.curve(0)[i] = std::sqrt(i / 256.f);
+        lut.curve(1)[i] = 1 - i / 256.f;
+        lut.curve(2)[i] = (i / 256.f) * (i / 256.f);
+    }
+
+    SECTION("identity") {
+        LUT1D<float,5> id;
+        for (int i=0; i<=100; ++i) {
+            const Color c (i/100.f, 1 - i/100.f, i/200.f);
+            const Color r = apply(id, c);
+            REQUIRE(std::fabs(r.r - c.r) < 1e-6f);
+            REQUIRE(std::fabs(r.g - c.g) < 1e-6f);
+            REQUIRE(std::fabs(r.b - c.b) < 1e-6f);
+        }
+        REQUIRE_THROWS_AS(id.at(3), std::out_of_range);
+    }
+
+    SECTION("curves, clamping, domain") {
+        REQUIRE(apply(lut, Color(0.25f, 0.5f, 1)) == Color(0.5f, 0.5f, 1));
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        REQUIRE(apply(lut, Color(-1, 2, nan)) == Color(0, 0, 0));
+        // Between samples, the curve is interpolated linearly.
+        const Color c = apply(lut, Color(0, 0, 1.5f / 256));
+        REQUIRE(std::fabs(c.b - (1.f + 4.f) / 2 / (256*256)) < 1e-9f);
+
+        LUT1D<float,257> wide = lut;
+        wide.domain_min = {{0, 0, 0}};
+        wide.domain_max = {{4, 4, 4}};
+        REQUIRE(apply(wide, Color(1, 2, 4)) == apply(lut, Color(0.25f, 0.5f, 1)));
+    }
+
+    SECTION("batch matches the reference") {
+        std::vector<Color> in;
+        for (int i=-10; i<=1010; ++i)
+            in.emplace_back(i/1000.f, (1000 - i)/1000.f, i/997.f);
+        std::vector<Color> out (in.size());
+        apply(lut, in.data(), in.data()+in.size(), out.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(out[i] == apply(lut, in[i]));
+
+        std::vector<Color> img (in.size());
+        apply(lut, image_view(in.data(), 3, 340), image_view(img.data(), 3, 340));
+        REQUIRE(std::equal(img.begin(), img.begin() + 1020, out.begin()));
+        REQUIRE_THROWS_AS(apply(lut, image_view(in.data(), 3, 340), image_view(img.data(), 340, 3)),
+                          std::logic_error);
+    }
+
+    SECTION("shared curves") {
+        LUT1D<float,257> shared (Curves::shared);
+        REQUIRE(shared.shared());
+        REQUIRE(shared.curve(0) == shared.curve(2));
+        for (unsigned i=0; i!=257; ++i)
+            shared.curve(0)[i] = std::sqrt(i / 256.f);
+        std::vector<Color> in {Color(0.25f, 1, 0.0625f)}, out (1);
+        apply(shared, in.data(), in.data()+1, out.data());
+        REQUIRE(out[0] == Color(0.5f, 1, 0.25f));
+        REQUIRE(apply(shared, in[0]) == out[0]);
+    }
+}
+
+TEST_CASE("tukan/Log2LUT1D", "log2 spaced 1D lookup table tests")
+{
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+    using LUT = Log2LUT1D<-14, 16, 5>;
+
+    SECTION("positions") {
+        REQUIRE(LUT::size() == 2 + 30*32);
+        REQUIRE(LUT::position(0) == 0);
+        REQUIRE(LUT::position(1) == std::ldexp(1.f, -14));
+        REQUIRE(LUT::position(2) == std::ldexp(1.f + 1/32.f, -14));
+        REQUIRE(LUT::position(1 + 14*32) == 1);
+        REQUIRE(LUT::position(LUT::size() - 1) == 65536);
+
+        // The identity is exact: interpolation is linear in the input.
+        const LUT id;
+        for (float x : {0.f, 1e-6f, 6.1e-5f, 0.3f, 1.f, 1.5f, 1000.f, 65535.f, 65536.f})
+            REQUIRE(apply(id, Color(x)).r == x);
+        REQUIRE(apply(id, Color(-1, 1e9f, std::numeric_limits<float>::quiet_NaN()))
+                == Color(0, 65536, 0));
+    }
+
+    SECTION("bounded relative error over the whole range") {
+        LUT lut (Curves::shared);
+        for (unsigned i=0; i!=LUT::size(); ++i)
+            lut.curve(0)[i] = std::pow(LUT::position(i), 1/2.4f);
+
+        std::vector<Color> in;
+        for (float x = std::ldexp(1.f, -14); x < 65536; x *= 1.0137f)
+            in.emplace_back(x, x * 1.5f, x * 0.3f);
+        std::vector<Color> out (in.size());
+        apply(lut, in.data(), in.data()+in.size(), out.data());
+        double worst = 0;
+        for (std::size_t i=0; i!=in.size(); ++i) {
+            const Color ref = apply(lut, in[i]);
+            for (int k=0; k!=3; ++k) {
+                REQUIRE(out[i][k] == ref[k]);
+                if (in[i][k] >= std::ldexp(1.f, -14) && in[i][k] <= 65536) {
+                    const double exact = std::pow(double(in[i][k]), 1/2.4);
+                    worst = std::max(worst, std::fabs(out[i][k] - exact) / exact);
+                }
+            }
+        }
+        // Spacing 2^-5 relative to x; the error of linear interpolation of x^(1/2.4) is
+        // below 1/8 * (1/2.4) * (1 - 1/2.4) * 2^-10.
+        REQUIRE(worst < 3.2e-5);
+
+        // A uniform table of the same size is far worse in the shadows.
+        LUT1D<float, LUT::size()> uniform (Curves::shared);
+        uniform.domain_max = {{65536, 65536, 65536}};
+        for (unsigned i=0; i!=LUT::size(); ++i)
+            uniform.curve(0)[i] = std::pow(65536.0 * i / (LUT::size() - 1), 1/2.4);
+        const float x = 0.01f;
+        REQUIRE(std::fabs(apply(uniform, Color(x)).r - std::pow(x, 1/2.4f)) > 0.1f);
+    }
+
+    SECTION("images") {
+        Log2LUT1D<-8, 8, 3> lut;
+        for (unsigned c=0; c!=3; ++c)
+            for (unsigned i=0; i!=lut.size(); ++i)
+                lut.curve(c)[i] = std::log2(1 + lut.position(i)) * (c + 1);
+        std::vector<Color> in, out (100), img (100);
+        for (int i=0; i!=100; ++i)
+            in.emplace_back(i * 2.5f, i / 100.f, 1e-3f * i);
+        apply(lut, in.data(), in.data()+100, out.data());
+        apply(lut, image_view(in.data(), 10, 10), image_view(img.data(), 10, 10));
+        REQUIRE(img == out);
+        REQUIRE_THROWS_AS(lut.at(3), std::out_of_range);
+    }
+}
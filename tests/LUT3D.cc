@@ -0,0 +1,166 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/LUT3D.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGB.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+
+    // Inputs on a skewed grid that covers all six tetrahedra of many cells, plus ties.
+    std::vector<Color> inputs () {
+        std::vector<Color> ret;
+        for (int r=0; r<=20; ++r)
+        for (int g=0; g<=20; ++g)
+        for (int b=0; b<=20; ++b)
+            ret.emplace_back(r/20.f, g/20.f + r/997.f, b/20.f - g/1013.f);
+        return ret;
+    }
+
+    template <unsigned N>
+    void fill (LUT3D<float,N> &lut) {
+        for (unsigned b=0; b!=N; ++b)
+        for (unsigned g=0; g!=N; ++g)
+        for (unsigned r=0; r!=N; ++r) {
+            const float x = r/float(N-1), y = g/float(N-1), z = b/float(N-1);
+            float *n = lut.node(r, g, b);
+            n[0] = std::sin(3*x) * y + z*z;
+            n[1] = x*y*z;
+            n[2] = std::sqrt(x + y) - z;
+        }
+    }
+
+    bool near (Color a, Color b, float eps) {
+        return std::fabs(a.r - b.r) <= eps && std::fabs(a.g - b.g) <= eps
+            && std::fabs(a.b - b.b) <= eps;
+    }
+}
+
+TEST_CASE("tukan/LUT3D", "3D lookup table tests")
+{
+    using namespace tukan;
+
+    SECTION("layout") {
+        LUT3D<float,17> lut;
+        std::set<float const*> nodes;
+        for (unsigned b=0; b!=17; ++b)
+        for (unsigned g=0; g!=17; ++g)
+        for (unsigned r=0; r!=17; ++r) {
+            float const *n = lut.node(r, g, b);
+            REQUIRE(n == lut.at(r, g, b));
+            REQUIRE(n[0] == r/16.f);
+            REQUIRE(n[1] == g/16.f);
+            REQUIRE(n[2] == b/16.f);
+            nodes.insert(n);
+        }
+        REQUIRE(nodes.size() == 17u*17*17);
+        // The 8 nodes of a cell within a brick are contiguous.
+        REQUIRE(lut.node(5, 5, 5) - lut.node(4, 4, 4) == 3*7);
+        REQUIRE_THROWS_AS(lut.at(17, 0, 0), std::out_of_range);
+        REQUIRE_THROWS_AS(lut.at(0, 0, 17), std::out_of_range);
+    }
+
+    SECTION("identity and affine maps are reproduced") {
+        LUT3D<float,5> id;
+        LUT3D<float,9> affine;
+        for (unsigned b=0; b!=9; ++b)
+        for (unsigned g=0; g!=9; ++g)
+        for (unsigned r=0; r!=9; ++r) {
+            float *n = affine.node(r, g, b);
+            n[0] = 0.5f*r/8 + 0.25f*g/8 + 0.1f;
+            n[1] = -1.0f*b/8 + 2;
+            n[2] = 0.3f*r/8 + 0.3f*g/8 + 0.3f*b/8;
+        }
+        for (Interpolation m : {Interpolation::trilinear, Interpolation::tetrahedral})
+            for (Color c : inputs()) {
+                const Color cc (c.r, std::min(c.g, 1.f), std::max(c.b, 0.f));
+                REQUIRE(near(apply(id, cc, m), cc, 1e-6f));
+                const Color expected (0.5f*cc.r + 0.25f*cc.g + 0.1f, 2 - cc.b,
+                                      0.3f*(cc.r + cc.g + cc.b));
+                REQUIRE(near(apply(affine, cc, m), expected, 1e-5f));
+            }
+    }
+
+    SECTION("nodes are hit exactly") {
+        LUT3D<float,9> lut;
+        fill(lut);
+        for (Interpolation m : {Interpolation::trilinear, Interpolation::tetrahedral})
+            for (unsigned i : {0u, 3u, 8u}) {
+                const Color c = apply(lut, Color(i/8.f, 4/8.f, (8-i)/8.f), m);
+                float const *n = lut.node(i, 4, 8-i);
+                REQUIRE(c.r == n[0]);
+                REQUIRE(c.g == n[1]);
+                REQUIRE(c.b == n[2]);
+            }
+    }
+
+    SECTION("tetrahedral keeps to the diagonal for greys") {
+        LUT3D<float,9> lut;
+        fill(lut);
+        for (int i=0; i<=64; ++i) {
+            const float v = i/64.f;
+            const Color c = apply(lut, Color(v), Interpolation::tetrahedral);
+            const unsigned k = std::min(unsigned(v*8), 7u);
+            const float f = v*8 - k;
+            float const *a = lut.node(k, k, k), *b = lut.node(k+1, k+1, k+1);
+            REQUIRE(std::fabs(c.g - lerp(a[1], b[1], f)) <= 1e-6f);
+        }
+    }
+
+    SECTION("clamping and domain") {
+        LUT3D<float,9> lut;
+        fill(lut);
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        for (Interpolation m : {Interpolation::trilinear, Interpolation::tetrahedral}) {
+            REQUIRE(apply(lut, Color(-1, nan, 5), m) == apply(lut, Color(0, 0, 1), m));
+            std::vector<Color> in {Color(-1, nan, 5)}, out (1);
+            apply(lut, in.data(), in.data()+1, out.data(), m);
+            REQUIRE(out[0] == apply(lut, Color(0, 0, 1), m));
+        }
+
+        LUT3D<float,9> wide = lut;
+        wide.domain_min = {{-1, -1, -1}};
+        wide.domain_max = {{3, 3, 3}};
+        for (Interpolation m : {Interpolation::trilinear, Interpolation::tetrahedral})
+            REQUIRE(near(apply(wide, Color(1, 0, 2), m), apply(lut, Color(0.5f, 0.25f, 0.75f), m),
+                         1e-6f));
+    }
+
+    SECTION("batch matches the reference") {
+        LUT3D<float,17> lut;
+        fill(lut);
+        const std::vector<Color> in = inputs();
+        std::vector<Color> out (in.size());
+        std::vector<RGB<float,sRGB>> out_rgb (in.size());
+        for (Interpolation m : {Interpolation::trilinear, Interpolation::tetrahedral}) {
+            apply(lut, in.data(), in.data()+in.size(), out.data(), m);
+            apply(lut, in.data(), in.data()+in.size(), out_rgb.data(), m);
+            for (std::size_t i=0; i!=in.size(); ++i) {
+                const Color ref = apply(lut, in[i], m);
+                REQUIRE(near(out[i], ref, 1e-6f));
+                REQUIRE(out_rgb[i].r == out[i].r);
+            }
+        }
+    }
+
+    SECTION("images") {
+        LUT3D<float,5> lut;
+        fill(lut);
+        std::vector<Color> in (4*3, Color(0.2f, 0.4f, 0.9f)), out (4*3, Color(7));
+        apply(lut, ImageView<Color const>(in.data(), 3, 3, 4), ImageView<Color>(out.data(), 3, 3, 4),
+              Interpolation::trilinear);
+        const Color expected = apply(lut, in[0], Interpolation::trilinear);
+        for (int i=0; i!=12; ++i)
+            REQUIRE(near(out[i], i % 4 == 3 ? Color(7) : expected, 1e-6f));
+        REQUIRE_THROWS_AS(apply(lut, image_view(in.data(), 3, 4), image_view(out.data(), 4, 3)),
+                          std::logic_error);
+    }
+}
@@ -0,0 +1,89 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/bake_lut.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGB.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Linear = LinearRGB<float,sRGB>;
+    using Encoded = RGB<float,sRGB>;
+
+    // Mix channels, tone map, and encode.
+    Encoded chain (Linear c) {
+        const Linear m (0.8f*c.r + 0.15f*c.g + 0.05f*c.b,
+                        0.1f*c.r + 0.85f*c.g + 0.05f*c.b,
+                        0.05f*c.r + 0.1f*c.g + 0.85f*c.b);
+        const Linear t (m.r / (1 + m.r), m.g / (1 + m.g), m.b / (1 + m.b));
+        return static_cast<Encoded>(t);
+    }
+
+    // Largest deviation from the chain, on a grid other than the one used for baking.
+    template <typename Baked>
+    float measured_error (Baked const &lut, float max) {
+        float err = 0;
+        for (int r=0; r<=23; ++r)
+        for (int g=0; g<=23; ++g)
+        for (int b=0; b<=23; ++b) {
+            const float x = max * std::pow(r/23.f, 3.f), y = max * std::pow(g/23.f, 3.f),
+                        z = max * std::pow(b/23.f, 3.f);
+            const Encoded e = chain(Linear(x, y, z)), l = lut(Linear(x, y, z));
+            for (int k=0; k!=3; ++k)
+                err = std::max(err, std::fabs(e[k] - l[k]));
+        }
+        return err;
+    }
+}
+
+TEST_CASE("tukan/bake_lut", "LUT baking tests")
+{
+    using namespace tukan;
+
+    SECTION("linear domain") {
+        const auto lut = bake_lut<Linear, 33, 16>(chain);
+        static_assert(std::is_same<decltype(lut(Linear())), Encoded>::value, "");
+        REQUIRE(lut.max_error > 0);
+        REQUIRE(lut.max_error < 0.05f);
+        REQUIRE(measured_error(lut, 1) <= lut.max_error * 1.5f);
+
+        // More nodes, less error.
+        const auto fine = bake_lut<Linear, 65, 16>(chain);
+        REQUIRE(fine.max_error < lut.max_error / 1.5f);
+
+        // Exact at the nodes.
+        const Encoded e = chain(Linear(0.5f, 0.25f, 1)), l = lut(Linear(0.5f, 0.25f, 1));
+        for (int k=0; k!=3; ++k)
+            REQUIRE(std::fabs(e[k] - l[k]) < 1e-6f);
+    }
+
+    SECTION("shaped HDR domain") {
+        auto shape = [](float x) { return std::log2(1 + x) / std::log2(65.f); };
+        const auto linear = bake_lut<Linear, 33, 1024>(chain, interval(0.f, 64.f));
+        const auto shaped = bake_lut<Linear, 33, 1024>(chain, interval(0.f, 64.f), shape);
+        REQUIRE(shaped.max_error < linear.max_error / 3);
+        REQUIRE(measured_error(shaped, 64) <= shaped.max_error * 1.5f);
+        REQUIRE(shape(shaped.max_error_at.r) >= 0);
+    }
+
+    SECTION("drop-in replacement") {
+        const auto lut = bake_lut<Linear, 17, 64>(chain, interval(0.f, 4.f),
+                                                  [](float x) { return std::sqrt(x / 4); });
+        std::vector<Linear> in;
+        for (int i=0; i!=1000; ++i)
+            in.emplace_back(i / 250.f, std::fmod(i * 0.37f, 4.f), 4 - i / 250.f);
+        std::vector<Encoded> out (in.size()), img (in.size());
+        apply(lut, in.data(), in.data()+in.size(), out.data());
+        for (std::size_t i=0; i!=in.size(); ++i) {
+            const Encoded ref = apply(lut, in[i]);
+            for (int k=0; k!=3; ++k)
+                REQUIRE(std::fabs(out[i][k] - ref[k]) < 1e-6f);
+        }
+        apply(lut, image_view(in.data(), 40, 25), image_view(img.data(), 40, 25));
+        REQUIRE(img == out);
+    }
+}
@@ -0,0 +1,123 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/dither.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Linear = LinearRGB<float,sRGB>;
+    using Code8  = RGB<unorm8,sRGB>;
+
+    // Mean code of the green channel over the whole image.
+    double mean_green (std::vector<Code8> const &img) {
+        double sum = 0;
+        for (auto const &c : img)
+            sum += c.g.code();
+        return sum / img.size();
+    }
+}
+
+TEST_CASE("tukan/dither", "dithered encoding tests")
+{
+    using namespace tukan;
+
+    SECTION("tables") {
+        std::vector<int> count (256);
+        for (auto v : detail::blue_noise_64x64)
+            ++count[v];
+        for (auto c : count)
+            REQUIRE(c == 16);
+
+        std::vector<int> bayer (64);
+        for (auto v : detail::bayer_8x8)
+            ++bayer[v];
+        for (auto c : bayer)
+            REQUIRE(c == 1);
+    }
+
+    SECTION("none") {
+        // A gradient of 1024 pixels; without dither, the result is that of encode().
+        std::vector<Linear> in;
+        for (int i=0; i!=1024; ++i)
+            in.emplace_back(i/1023.f, (i/1023.f)*(i/1023.f), 1 - i/1023.f);
+        std::vector<Code8> out (in.size()), ref (in.size());
+
+        encode(image_view(in.data(), 32, 32), image_view(out.data(), 32, 32), Dither::none);
+        encode(in.data(), in.data()+in.size(), ref.data());
+        int differ = 0;
+        for (std::size_t i=0; i!=in.size(); ++i)
+            for (int c=0; c!=3; ++c) {
+                REQUIRE(std::abs(out[i][c].code() - ref[i][c].code()) <= 1);
+                differ += out[i][c].code() != ref[i][c].code();
+            }
+        REQUIRE(differ <= 2); // only values within 1e-6 of a rounding boundary
+    }
+
+    SECTION("clamping") {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        std::vector<Linear> in = {Linear(-1, 2, nan), Linear(0, 1, 100)};
+        for (Dither d : {Dither::none, Dither::bayer, Dither::blue_noise, Dither::floyd_steinberg}) {
+            std::vector<Code8> out (2);
+            encode(image_view(in.data(), 2, 1), image_view(out.data(), 2, 1), d);
+            REQUIRE(out[0].r.code() == 0);
+            REQUIRE(out[0].g.code() == 255);
+            REQUIRE(out[0].b.code() == 0);
+            REQUIRE(out[1].r.code() == 0);
+            REQUIRE(out[1].g.code() == 255);
+            REQUIRE(out[1].b.code() == 255);
+        }
+    }
+
+    SECTION("mean is preserved") {
+        // A constant image between two codes: dithering mixes them so that the mean matches.
+        const float linear = static_cast<float>(sRGB<double>().gamma.to_linear(100.3 / 255));
+        std::vector<Linear> in (128*128, Linear(linear));
+        std::vector<Code8> out (in.size());
+
+        encode(image_view(in.data(), 128, 128), image_view(out.data(), 128, 128), Dither::none);
+        REQUIRE(mean_green(out) == 100);
+
+        encode(image_view(in.data(), 128, 128), image_view(out.data(), 128, 128), Dither::bayer);
+        REQUIRE(std::fabs(mean_green(out) - 100.3) < 1/64.);
+
+        encode(image_view(in.data(), 128, 128), image_view(out.data(), 128, 128), Dither::blue_noise);
+        REQUIRE(std::fabs(mean_green(out) - 100.3) < 1/256.);
+        for (auto const &c : out)
+            REQUIRE((c.g.code() == 100 || c.g.code() == 101));
+
+        encode(image_view(in.data(), 128, 128), image_view(out.data(), 128, 128),
+               Dither::floyd_steinberg);
+        REQUIRE(std::fabs(mean_green(out) - 100.3) < 0.01);
+        for (auto const &c : out)
+            REQUIRE((c.g.code() == 100 || c.g.code() == 101));
+    }
+
+    SECTION("strides, 16 bit") {
+        // 3x2 pixels inside rows of 4.
+        std::vector<Linear> in (4*2, Linear(0.5f));
+        in[3] = in[7] = Linear(-1);
+        std::vector<RGB<unorm16,sRGB>> out (4*2, RGB<unorm16,sRGB>(unorm16::from_code(7)));
+
+        encode(ImageView<Linear>(in.data(), 3, 2, 4),
+               ImageView<RGB<unorm16,sRGB>>(out.data(), 3, 2, 4), Dither::blue_noise);
+        const double expected = sRGB<double>().gamma.to_nonlinear(0.5) * 65535;
+        for (int i : {0, 1, 2, 4, 5, 6})
+            REQUIRE(std::fabs(out[i].r.code() - expected) <= 1);
+        REQUIRE(out[3].r.code() == 7);
+        REQUIRE(out[7].r.code() == 7);
+    }
+
+    SECTION("extent") {
+        std::vector<Linear> in (16);
+        std::vector<Code8> out (16);
+        REQUIRE_THROWS_AS(encode(image_view(in.data(), 4, 4), image_view(out.data(), 2, 8),
+                                 Dither::bayer),
+                          std::logic_error);
+    }
+}
@@ -0,0 +1,115 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/IrregularSpectrum.hh"
+#include "catch.hpp"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("tukan/future/IrregularSpectrum", "IrregularSpectrum tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    SECTION("Construction") {
+        const std::vector<SpectrumSample> samples {{400_nm, 1}, {410_nm, 2}, {500_nm, 0.5}};
+        const IrregularSpectrum spec (samples);
+        REQUIRE(spec.size() == 3);
+        REQUIRE(!spec.empty());
+        REQUIRE(spec.lambda_min() == 400_nm);
+        REQUIRE(spec.lambda_max() == 500_nm);
+        REQUIRE(spec[1] == SpectrumSample(410_nm, 2));
+        REQUIRE(spec.at(2) == SpectrumSample(500_nm, 0.5));
+        REQUIRE_THROWS_AS(spec.at(3), std::out_of_range);
+
+        const std::vector<SpectrumSample> one {{400_nm, 1}},
+                                          unsorted {{400_nm, 1}, {390_nm, 2}},
+                                          duplicate {{400_nm, 1}, {400_nm, 2}};
+        REQUIRE_THROWS_AS(IrregularSpectrum{one}, std::logic_error);
+        REQUIRE_THROWS_AS(IrregularSpectrum{unsorted}, std::logic_error);
+        REQUIRE_THROWS_AS(IrregularSpectrum{duplicate}, std::logic_error);
+    }
+
+    SECTION("Point lookup") {
+        const std::vector<SpectrumSample> samples {{400_nm, 1}, {410_nm, 2}, {500_nm, 0.5}};
+        const IrregularSpectrum spec (samples);
+        const IrregularInterpolator ip (spec);
+        REQUIRE(ip(400_nm).amplitude == 1);
+        REQUIRE(ip(405_nm).amplitude == Approx(1.5));
+        REQUIRE(ip(410_nm).amplitude == Approx(2));
+        REQUIRE(ip(455_nm).amplitude == Approx(1.25));
+        REQUIRE(ip(500_nm).amplitude == Approx(0.5));
+        REQUIRE(ip(0.5f).amplitude == Approx(2 - 1.5*40/90));
+        REQUIRE(ip(0.5f).wavelength == 450_nm);
+
+        REQUIRE_THROWS_AS(ip(399_nm), std::logic_error);
+        REQUIRE_THROWS_AS(ip(501_nm), std::logic_error);
+        REQUIRE_THROWS_AS(ip(-0.1f), std::logic_error);
+        REQUIRE_THROWS_AS(ip(1.1f), std::logic_error);
+    }
+
+    SECTION("Grid lookup agrees with binary search") {
+        std::mt19937 rng (42);
+        std::uniform_real_distribution<float> step (0.01f, 20), amp (0, 1);
+
+        // Clustered samples, like a narrow LED peak on a coarse baseline.
+        std::vector<SpectrumSample> samples;
+        float l = 380;
+        for (int i=0; i!=200; ++i) {
+            samples.emplace_back(Nanometer(l), amp(rng));
+            l += i>50 && i<150 ? step(rng) / 100 : step(rng);
+        }
+        const IrregularSpectrum spec (samples);
+        const IrregularInterpolator ip (spec);
+
+        std::vector<float> lambdas;
+        for (auto const &s : samples)
+            lambdas.push_back(static_cast<float>(s.wavelength));
+
+        std::uniform_real_distribution<float> query (lambdas.front(), lambdas.back());
+        for (int q=0; q!=10000; ++q) {
+            const float g = query(rng);
+            const std::size_t i = std::max<std::ptrdiff_t>(
+                1, std::lower_bound(lambdas.begin(), lambdas.end(), g) - lambdas.begin()) - 1;
+            REQUIRE(spec.segment(g) == i);
+
+            const float t = (g - lambdas[i]) / (lambdas[i+1] - lambdas[i]);
+            const float expected = samples[i].amplitude*(1-t) + samples[i+1].amplitude*t;
+            REQUIRE(ip(Nanometer(g)).amplitude == Approx(expected));
+        }
+    }
+
+    SECTION("Interval averages match the uniform Spectrum") {
+        const std::vector<float> bins {1, 3, 0, 2, 5, 4, 1};
+        const Spectrum uniform (300_nm, 900_nm, bins);
+        std::vector<SpectrumSample> samples;
+        for (std::size_t i=0; i!=bins.size(); ++i)
+            samples.emplace_back(Nanometer(300 + 100*i), bins[i]);
+        const IrregularSpectrum irregular (samples);
+
+        for (auto r : {Interval<float>(0, 1), Interval<float>(0.1f, 0.35f),
+                       Interval<float>(0.5f, 0.52f), Interval<float>(0.2f, 0.2f)}) {
+            const auto a = LinearInterpolator(uniform)(r),
+                       b = IrregularInterpolator(irregular)(r);
+            REQUIRE(b.amplitude == Approx(a.amplitude));
+            REQUIRE(rel_equal(b.wavelength, a.wavelength, 1e-5f));
+        }
+    }
+
+    SECTION("Batch evaluation") {
+        const std::vector<SpectrumSample> samples {{400_nm, 1}, {410_nm, 2}, {500_nm, 0.5}};
+        const IrregularSpectrum spec (samples);
+        const IrregularInterpolator ip (spec);
+        const Nanometer lambdas[] = {400_nm, 405_nm, 455_nm, 500_nm};
+        float out[4];
+        ip(lambdas, lambdas+4, out);
+        for (int i=0; i!=4; ++i)
+            REQUIRE(out[i] == ip(lambdas[i]).amplitude);
+
+        const Nanometer bad[] = {450_nm, 600_nm};
+        REQUIRE_THROWS_AS(ip(bad, bad+2, out), std::logic_error);
+    }
+}
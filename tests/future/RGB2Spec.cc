@@ -0,0 +1,116 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/RGB2Spec.hh"
+#include "catch.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Reflectance to RGB, using the same equal-energy adaptation as the optimizer.
+    tukan::LinearRGB<double, tukan::sRGB> to_rgb (tukan::future::RGB2SpecCoefficients c)
+    {
+        using namespace tukan::future;
+        const detail::rgb2spec::Context ctx (tukan::sRGB<double>().rgb_to_xyz);
+        double xyz[3] = {0,0,0};
+        for (std::size_t i=0; i!=cie1931::size; ++i) {
+            const double s = c(cie1931::wavelength(i));
+            for (int j=0; j!=3; ++j)
+                xyz[j] += s * ctx.cmf[j][i];
+        }
+        const auto m = inverse(ctx.rgb_to_xyz_e);
+        return { m._11*xyz[0] + m._12*xyz[1] + m._13*xyz[2],
+                 m._21*xyz[0] + m._22*xyz[1] + m._23*xyz[2],
+                 m._31*xyz[0] + m._32*xyz[1] + m._33*xyz[2] };
+    }
+}
+
+TEST_CASE("tukan/future/RGB2Spec", "RGB to spectrum upsampling tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    const auto table = optimize_rgb2spec_table<sRGB>(16);
+    REQUIRE(table.resolution() == 16);
+
+    SECTION("Grays are constant spectra") {
+        REQUIRE(table(0,0,0)(550_nm) == 0.0f);
+        REQUIRE(table(1,1,1)(550_nm) == 1.0f);
+        REQUIRE(table(0.5,0.5,0.5)(400_nm) == rel_equal(0.5f));
+        REQUIRE(table(0.5,0.5,0.5)(700_nm) == rel_equal(0.5f));
+        REQUIRE(table(2,2,2)(700_nm) == 1.0f); // clamped
+    }
+
+    SECTION("Upsampled spectra reproduce their RGB") {
+        const float colors[][3] = { {0.2f, 0.5f, 0.1f}, {0.8f, 0.3f, 0.3f},
+                                    {0.1f, 0.2f, 0.7f}, {0.6f, 0.6f, 0.2f},
+                                    {0.35f, 0.3f, 0.32f} };
+        for (auto const &c : colors) {
+            const auto rgb = to_rgb(table(c[0], c[1], c[2]));
+            REQUIRE(rgb.r == Approx(c[0]).epsilon(0.02));
+            REQUIRE(rgb.g == Approx(c[1]).epsilon(0.02));
+            REQUIRE(rgb.b == Approx(c[2]).epsilon(0.02));
+        }
+    }
+
+    SECTION("Reflectances are bounded") {
+        const auto c = table(LinearRGB<float, sRGB>(0.9f, 0.05f, 0.1f));
+        for (int l=380; l<=780; l+=5) {
+            REQUIRE(c(Nanometer(l)) >= 0.0f);
+            REQUIRE(c(Nanometer(l)) <= 1.0f);
+        }
+    }
+
+    SECTION("Conversion to Spectrum") {
+        const auto spec = to_spectrum(table(0.2f, 0.5f, 0.1f), 400_nm, 700_nm, 31);
+        REQUIRE(spec.size() == 31);
+        REQUIRE(spec[15] == table(0.2f, 0.5f, 0.1f)(550_nm));
+        REQUIRE_THROWS(to_spectrum(table(0.2f, 0.5f, 0.1f), 400_nm, 700_nm, 1));
+    }
+
+    SECTION("Binary format round trip") {
+        std::stringstream ss;
+        table.write(ss);
+        const std::string bytes = ss.str();
+        REQUIRE(bytes.size() == 16 + 4*(16 + 9*16*16*16));
+
+        const auto read = RGB2SpecTable::read(ss);
+        REQUIRE(read.resolution() == 16);
+        REQUIRE(read(0.2f, 0.5f, 0.1f)(550_nm) == table(0.2f, 0.5f, 0.1f)(550_nm));
+
+        std::vector<float> mapped(bytes.size() / sizeof(float));
+        std::memcpy(mapped.data(), bytes.data(), bytes.size());
+        const auto view = RGB2SpecTable::from_memory(mapped.data(), bytes.size());
+        REQUIRE(view(0.7f, 0.1f, 0.4f)(620_nm) == table(0.7f, 0.1f, 0.4f)(620_nm));
+
+        REQUIRE_THROWS(RGB2SpecTable::from_memory(mapped.data(), 8));
+        REQUIRE_THROWS(RGB2SpecTable::from_memory(mapped.data(), bytes.size() - 4));
+
+        // Resolutions out of range are rejected before any size is computed from them, the
+        // size of a truncated table without overflow, and read() does not allocate the size
+        // the header claims up front.
+        for (std::uint32_t res : {0u, 1u, 4097u, 0x55555556u, 0xFFFFFFFFu}) {
+            std::vector<float> damaged (mapped);
+            std::memcpy(&damaged[2], &res, 4);
+            REQUIRE_THROWS(RGB2SpecTable::from_memory(damaged.data(), bytes.size()));
+            std::stringstream ds (std::string(reinterpret_cast<char const*>(damaged.data()),
+                                              bytes.size()));
+            REQUIRE_THROWS(RGB2SpecTable::read(ds));
+        }
+        std::vector<float> large (mapped);
+        const std::uint32_t res = 4096;
+        std::memcpy(&large[2], &res, 4);
+        REQUIRE_THROWS(RGB2SpecTable::from_memory(large.data(), bytes.size()));
+        std::stringstream ls (std::string(reinterpret_cast<char const*>(large.data()), bytes.size()));
+        REQUIRE_THROWS(RGB2SpecTable::read(ls));
+        std::stringstream garbage (std::string(64, 'x'));
+        REQUIRE_THROWS(RGB2SpecTable::read(garbage));
+
+        mapped[0] = 0;
+        REQUIRE_THROWS(RGB2SpecTable::from_memory(mapped.data(), bytes.size()));
+    }
+}
@@ -0,0 +1,84 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/Smits.hh"
+#include "catch.hpp"
+#include <vector>
+
+TEST_CASE("tukan/future/Smits", "Smits RGB to spectrum conversion tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+    using RGB = LinearRGB<float, sRGB>;
+
+    SECTION("Layout") {
+        const auto spec = smits(RGB(1,1,1));
+        REQUIRE(spec.size() == 10);
+        REQUIRE(spec.lambda_min() == 380_nm);
+        REQUIRE(spec.lambda_max() == 720_nm);
+        REQUIRE(smits<32>(RGB(1,1,1)).size() == 32);
+    }
+
+    SECTION("Basis spectra are reproduced") {
+        const auto white = smits(RGB(1,1,1));
+        const auto red   = smits(RGB(1,0,0));
+        const auto cyan  = smits(RGB(0,1,1));
+        REQUIRE(white[0] == 1.0f);
+        REQUIRE(white[3] == 0.9993f);
+        REQUIRE(red[0]   == 0.1012f);
+        REQUIRE(red[9]   == 1.0149f);
+        REQUIRE(cyan[6]  == 0.1564f);
+        REQUIRE(smits(RGB(0,0,0))[4] == 0.0f);
+    }
+
+    SECTION("Decomposition into white, secondary and primary") {
+        // r=0.2 is smallest, b=0.7 largest: 0.2*white + 0.3*cyan + 0.2*blue
+        const auto spec = smits(RGB(0.2f, 0.5f, 0.7f));
+        for (std::size_t i=0; i!=spec.size(); ++i) {
+            const float expected = 0.2f*smits(RGB(1,1,1))[i]
+                                 + 0.3f*smits(RGB(0,1,1))[i]
+                                 + 0.2f*smits(RGB(0,0,1))[i];
+            REQUIRE(spec[i] == Approx(expected));
+        }
+
+        const auto gray = smits(RGB(0.5f));
+        REQUIRE(gray[5] == Approx(0.5f*0.9998f));
+    }
+
+    SECTION("Resampling") {
+        const auto spec = smits<19>(RGB(0,1,0));
+        REQUIRE(spec[0]  == 0.0f);
+        REQUIRE(spec[8]  == Approx(1.0f));          // 560nm
+        REQUIRE(spec[7]  == Approx(0.5f*(0.7937f+1.0f)));
+    }
+
+    SECTION("Batch and image conversion") {
+        std::vector<RGB> in = { RGB(0.1f,0.2f,0.3f), RGB(0.9f,0.5f,0.1f),
+                                RGB(0.4f,0.8f,0.2f), RGB(0.3f,0.3f,0.6f),
+                                RGB(0,0,0),          RGB(1,0.5f,1) };
+        std::vector<FixedSpectrum<10>> out(in.size());
+
+        smits<10>(in.data(), in.data()+in.size(), out.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            for (std::size_t j=0; j!=10; ++j)
+                REQUIRE(out[i][j] == smits(in[i])[j]);
+
+        std::vector<FixedSpectrum<10>> img(in.size());
+        smits<10>(ImageView<RGB const>(in.data(), 3, 2),
+                  ImageView<FixedSpectrum<10>>(img.data(), 3, 2));
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(img[i][7] == out[i][7]);
+
+        REQUIRE_THROWS(smits<10>(ImageView<RGB const>(in.data(), 3, 2),
+                                 ImageView<FixedSpectrum<10>>(img.data(), 2, 3)));
+    }
+
+    SECTION("Conversion to Spectrum") {
+        const auto fixed = smits(RGB(0.2f, 0.5f, 0.7f));
+        const Spectrum spec (fixed.lambda_min(), fixed.lambda_max(), fixed);
+        REQUIRE(spec.size() == fixed.size());
+        REQUIRE(spec[4] == fixed[4]);
+        REQUIRE_THROWS(fixed.at(10));
+    }
+}
@@ -0,0 +1,143 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/SpectralLibrary.hh"
+#include "tukan/future/cie1931.hh"
+#include "catch.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string make_library (tukan::future::SpectralEncoding encoding) {
+        using namespace tukan;
+        using namespace tukan::future;
+        SpectralLibraryWriter w (400_nm, 700_nm, 4, encoding);
+        w.add("zinc",   std::vector<float>{0.5f, 0.5f, 0.5f, 0.5f});
+        w.add("brick",  std::vector<float>{0.1f, 0.2f, 0.4f, 0.8f});
+        w.add("a",      std::vector<float>{1, 2, 3, 65504});
+        w.add("grass",  std::vector<float>{0.05f, 0.6f, 0.1f, 0.03f});
+        std::ostringstream os;
+        w.write(os);
+        return os.str();
+    }
+}
+
+TEST_CASE("tukan/future/SpectralLibrary", "Spectral library tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    SECTION("Round trip, float32") {
+        const std::string bytes = make_library(SpectralEncoding::float32);
+        std::vector<std::uint64_t> aligned ((bytes.size()+7)/8);
+        std::memcpy(aligned.data(), bytes.data(), bytes.size());
+
+        const auto lib = SpectralLibrary::from_memory(aligned.data(), bytes.size());
+        REQUIRE(lib.size() == 4);
+        REQUIRE(lib.bins() == 4);
+        REQUIRE(lib.lambda_min() == 400_nm);
+        REQUIRE(lib.lambda_max() == 700_nm);
+        REQUIRE(lib.encoding() == SpectralEncoding::float32);
+
+        // Sorted by name.
+        REQUIRE(lib.name(0) == "a");
+        REQUIRE(lib.name(1) == "brick");
+        REQUIRE(lib.name(3) == "zinc");
+        REQUIRE(lib.find("grass") == 2);
+        REQUIRE(lib.find("gras") == 4);
+        REQUIRE(lib.find("zz") == 4);
+
+        const SpectrumView brick = lib.at("brick");
+        REQUIRE(brick.size() == 4);
+        REQUIRE(brick.lambda_min() == 400_nm);
+        REQUIRE(brick[0] == 0.1f);
+        REQUIRE(brick[3] == 0.8f);
+        REQUIRE_THROWS_AS(brick.at(4), std::out_of_range);
+        REQUIRE_THROWS_AS(lib.at("slate"), std::out_of_range);
+        REQUIRE_THROWS_AS(lib.at(4), std::out_of_range);
+
+        // Zero copy: views see changes to the underlying memory.
+        const float changed = 0.25f;
+        std::memcpy(reinterpret_cast<char*>(aligned.data()) + bytes.size() - 4*4*3,
+                    &changed, sizeof changed);
+        REQUIRE(brick[0] == 0.25f);
+        const Spectrum copy (brick.lambda_min(), brick.lambda_max(), brick);
+        REQUIRE(copy[2] == 0.4f);
+        REQUIRE(copy[0] == 0.25f);
+    }
+
+    SECTION("Round trip, float16") {
+        std::istringstream is (make_library(SpectralEncoding::float16));
+        const auto lib = SpectralLibrary::read(is);
+        REQUIRE(lib.encoding() == SpectralEncoding::float16);
+        REQUIRE(lib.at("a")[3] == 65504);
+        REQUIRE(lib.at("zinc")[0] == 0.5f);
+        REQUIRE(lib.at("brick")[1] == Approx(0.2f).epsilon(1e-3));
+        REQUIRE(lib.at("grass")[3] == Approx(0.03f).epsilon(1e-3));
+    }
+
+    SECTION("Views are sampled spectra") {
+        SpectralLibraryWriter w (380_nm, 780_nm, 41);
+        w.add("flat", std::vector<float>(41, 1.0f));
+        std::ostringstream os;
+        w.write(os);
+        std::istringstream is (os.str());
+        const auto lib = SpectralLibrary::read(is);
+        const auto xyz = cie1931::sampled_tristimulus(lib[0]);
+        REQUIRE(xyz.Y == Approx(cie1931::tristimulus([](Nanometer) { return 1.0; }).Y));
+    }
+
+    SECTION("Writer errors") {
+        SpectralLibraryWriter w (400_nm, 700_nm, 4);
+        w.add("x", std::vector<float>(4));
+        REQUIRE(w.size() == 1);
+        REQUIRE_THROWS_AS(w.add("x", std::vector<float>(4)), std::logic_error);
+        REQUIRE_THROWS_AS(w.add("y", std::vector<float>(3)), std::logic_error);
+        REQUIRE_THROWS_AS(SpectralLibraryWriter(400_nm, 700_nm, 1), std::logic_error);
+        std::ostringstream os;
+        REQUIRE_THROWS_AS(SpectralLibraryWriter(400_nm, 700_nm, 4).write(os), std::logic_error);
+    }
+
+    SECTION("Corrupt input") {
+        std::string bytes = make_library(SpectralEncoding::float32);
+        std::vector<std::uint64_t> aligned ((bytes.size()+7)/8 + 1);
+        char *base = reinterpret_cast<char*>(aligned.data());
+        std::memcpy(base, bytes.data(), bytes.size());
+
+        REQUIRE_THROWS_AS(SpectralLibrary::from_memory(base, 10), std::runtime_error);
+        REQUIRE_THROWS_AS(SpectralLibrary::from_memory(base, bytes.size()-1), std::runtime_error);
+        REQUIRE_THROWS_AS(SpectralLibrary::from_memory(base+1, bytes.size()), std::runtime_error);
+        base[0] = 'X';
+        REQUIRE_THROWS_AS(SpectralLibrary::from_memory(base, bytes.size()), std::runtime_error);
+
+        std::istringstream is (bytes.substr(0, bytes.size()-2));
+        REQUIRE_THROWS_AS(SpectralLibrary::read(is), std::runtime_error);
+
+        // Header fields that would size a huge buffer, or overflow, are rejected as corrupt
+        // input before anything is allocated; so are offsets inside the header, no spectra
+        // and too few bins. Each is a valid header with one field replaced, in a 64 byte file.
+        const auto damaged = [&](std::size_t offset, std::uint64_t value, std::size_t size) {
+            std::string header = bytes.substr(0, 64);
+            std::memcpy(&header[offset], &value, size);
+            return header;
+        };
+        for (std::string const &header : {damaged(20, 0xFFFFFFFFu, 4),      // bins
+                                          damaged(16, 0xFFFFFFFFu, 4),      // count
+                                          damaged(16, 0, 4),
+                                          damaged(20, 1, 4),
+                                          damaged(32, 8, 8),                // names_offset
+                                          damaged(40, 8, 8),                // data_offset
+                                          damaged(40, ~std::uint64_t(0), 8)}) {
+            std::istringstream his (header);
+            REQUIRE_THROWS_AS(SpectralLibrary::read(his), std::runtime_error);
+            std::vector<std::uint64_t> hmem (8);
+            std::memcpy(hmem.data(), header.data(), 64);
+            REQUIRE_THROWS_AS(SpectralLibrary::from_memory(hmem.data(), 64), std::runtime_error);
+        }
+    }
+}
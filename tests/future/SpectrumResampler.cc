@@ -0,0 +1,128 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/SpectrumResampler.hh"
+#include "catch.hpp"
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("tukan/future/SpectrumResampler", "Spectrum resampling tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    SECTION("Layouts") {
+        const auto u = SpectralLayout::uniform(400_nm, 700_nm, 4);
+        REQUIRE(u.size() == 4);
+        REQUIRE(u[0] == 400_nm);
+        REQUIRE(u[1] == 500_nm);
+        REQUIRE(u[3] == 700_nm);
+        REQUIRE(u == SpectralLayout::irregular({400_nm, 500_nm, 600_nm, 700_nm}));
+        REQUIRE(u != SpectralLayout::uniform(400_nm, 700_nm, 5));
+
+        REQUIRE_THROWS_AS(SpectralLayout::uniform(400_nm, 700_nm, 1), std::logic_error);
+        REQUIRE_THROWS_AS(SpectralLayout::uniform(700_nm, 400_nm, 4), std::logic_error);
+        REQUIRE_THROWS_AS(SpectralLayout::irregular({400_nm, 400_nm}), std::logic_error);
+        REQUIRE_THROWS_AS(SpectralLayout::irregular({500_nm, 400_nm}), std::logic_error);
+    }
+
+    SECTION("Linear mode") {
+        const SpectrumResampler same (SpectralLayout::uniform(400_nm, 700_nm, 4),
+                                      SpectralLayout::uniform(400_nm, 700_nm, 4),
+                                      ResampleMode::linear);
+        const float in[] = {1, 2, 4, 8};
+        float out[4];
+        same(in, out);
+        for (int i=0; i!=4; ++i)
+            REQUIRE(out[i] == Approx(in[i]));
+
+        const SpectrumResampler finer (SpectralLayout::uniform(400_nm, 700_nm, 4),
+                                       SpectralLayout::irregular({350_nm, 450_nm, 525_nm, 700_nm}),
+                                       ResampleMode::linear);
+        REQUIRE(finer.source_size() == 4);
+        REQUIRE(finer.destination_size() == 4);
+        finer(in, out);
+        REQUIRE(out[0] == 0);            // Outside of the source.
+        REQUIRE(out[1] == Approx(1.5));
+        REQUIRE(out[2] == Approx(2.5));
+        REQUIRE(out[3] == Approx(8));
+    }
+
+    SECTION("Box mode") {
+        // Constants and interior points of ramps are kept.
+        const SpectrumResampler r (SpectralLayout::uniform(380_nm, 780_nm, 81),
+                                   SpectralLayout::uniform(400_nm, 700_nm, 16));
+        std::vector<float> flat (81, 0.5f), ramp (81), out (16);
+        for (int i=0; i!=81; ++i)
+            ramp[i] = i;
+        r(flat.data(), out.data());
+        for (float f : out)
+            REQUIRE(f == Approx(0.5));
+        r(ramp.data(), out.data());
+        for (int j=0; j!=16; ++j)
+            REQUIRE(out[j] == Approx((400 + j*20 - 380) / 5.f));
+
+        // Same semantics as the interval lookup of LinearInterpolator.
+        std::vector<float> bumpy {1, 3, 0, 2, 5, 4, 1};
+        const Spectrum s (300_nm, 900_nm, bumpy);
+        const SpectrumResampler coarse (SpectralLayout::uniform(300_nm, 900_nm, 7),
+                                        SpectralLayout::uniform(400_nm, 800_nm, 3));
+        float c[3];
+        coarse(bumpy.data(), c);
+        const float expected = LinearInterpolator(s)(Interval<float>(1.f/3, 2.f/3)).amplitude;
+        REQUIRE(c[1] == Approx(expected));
+
+        // End bins only average over their overlap with the source.
+        const SpectrumResampler wide (SpectralLayout::uniform(400_nm, 500_nm, 2),
+                                      SpectralLayout::uniform(400_nm, 500_nm, 2));
+        const float two[] = {1, 3};
+        float w[2];
+        wide(two, w);
+        REQUIRE(w[0] == Approx(1.5));
+        REQUIRE(w[1] == Approx(2.5));
+    }
+
+    SECTION("Batches") {
+        const SpectrumResampler r (SpectralLayout::uniform(380_nm, 780_nm, 41),
+                                   SpectralLayout::uniform(400_nm, 700_nm, 8));
+        std::vector<float> in (41*100), out (8*100);
+        for (std::size_t i=0; i!=in.size(); ++i)
+            in[i] = float(i % 13) / 13;
+        r(in.data(), out.data(), 100);
+
+        float single[8];
+        for (int k=0; k!=100; ++k) {
+            r(&in[k*41], single);
+            for (int j=0; j!=8; ++j)
+                REQUIRE(out[k*8+j] == single[j]);
+        }
+    }
+
+    SECTION("Cache") {
+        // More distinct layouts than the cache holds; resamplers keep their evicted matrices.
+        const auto dst = SpectralLayout::uniform(400_nm, 700_nm, 4);
+        const SpectrumResampler first (SpectralLayout::uniform(380_nm, 780_nm, 3), dst);
+        for (std::size_t n=4; n!=200; ++n)
+            SpectrumResampler(SpectralLayout::uniform(380_nm, 780_nm, n), dst);
+        const SpectrumResampler again (SpectralLayout::uniform(380_nm, 780_nm, 3), dst);
+        const float in[3] = {0.25f, 0.5f, 1};
+        float a[4], b[4];
+        first(in, a);
+        again(in, b);
+        for (int j=0; j!=4; ++j)
+            REQUIRE(a[j] == b[j]);
+    }
+
+    SECTION("Spectrum convenience") {
+        const Spectrum s (380_nm, 780_nm, std::vector<float>(41, 0.25f));
+        const auto a = resample(s, 400_nm, 700_nm, 16);
+        REQUIRE(a.size() == 16);
+        REQUIRE(a.lambda_min() == 400_nm);
+        REQUIRE(a[7] == Approx(0.25));
+
+        const auto b = resample<16>(s, 400_nm, 700_nm, ResampleMode::linear);
+        REQUIRE(b.lambda_max() == 700_nm);
+        REQUIRE(b[15] == Approx(0.25));
+    }
+}
@@ -0,0 +1,89 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/blackbody.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // Reference in double precision with std::exp.
+    double planck (double T, double lambda) {
+        return 1.191042972e20 / std::pow(lambda, 5) / std::expm1(1.438776877e7 / (lambda*T));
+    }
+}
+
+TEST_CASE("tukan/future/blackbody", "Planckian radiator tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    SECTION("exp_approx") {
+        for (float x=-80; x<80; x+=0.37f)
+            REQUIRE(std::fabs(tukan::detail::exp_approx(x) / std::exp(double(x)) - 1) < 2e-7);
+        REQUIRE(tukan::detail::exp_approx(0) == Approx(1));
+        REQUIRE(std::isfinite(tukan::detail::exp_approx(1000)));
+        REQUIRE(tukan::detail::exp_approx(-1000) > 0);
+
+        float in[] = {-1, 0, 1, 2}, out[4];
+        tukan::detail::exp_approx(in, in+4, out);
+        for (int i=0; i!=4; ++i)
+            REQUIRE(out[i] == tukan::detail::exp_approx(in[i]));
+    }
+
+    SECTION("Absolute radiance") {
+        for (float T : {1000.f, 2856.f, 5778.f, 6504.f, 20000.f})
+            for (float l=300; l<=830; l+=10)
+                REQUIRE(blackbody(Kelvin(T), Nanometer(l)) == Approx(planck(T, l)).epsilon(1e-5));
+    }
+
+    SECTION("Normalization at Wien's peak") {
+        REQUIRE(static_cast<float>(wien_peak(5778_kelvin)) == Approx(501.52).epsilon(1e-4));
+        REQUIRE(blackbody_normalized(5778_kelvin, wien_peak(5778_kelvin)) == Approx(1).epsilon(1e-5));
+        REQUIRE(blackbody_normalized(5778_kelvin, 400_nm) < 1);
+        REQUIRE(blackbody_normalized(5778_kelvin, 700_nm) < 1);
+        REQUIRE(blackbody_normalized(3000_kelvin, 700_nm)
+                == Approx(planck(3000, 700) / planck(3000, 2.897771955e6/3000)).epsilon(1e-5));
+    }
+
+    SECTION("Batch and spectrum overloads agree with the single overload") {
+        Nanometer lambdas[] = {380_nm, 450_nm, 550_nm, 780_nm};
+        float abs[4], norm[4];
+        blackbody(3200_kelvin, lambdas, lambdas+4, abs);
+        blackbody_normalized(3200_kelvin, lambdas, lambdas+4, norm);
+        for (int i=0; i!=4; ++i) {
+            REQUIRE(abs[i]  == blackbody(3200_kelvin, lambdas[i]));
+            REQUIRE(norm[i] == blackbody_normalized(3200_kelvin, lambdas[i]));
+        }
+
+        const auto spec = blackbody_normalized<41>(3200_kelvin, 380_nm, 780_nm);
+        REQUIRE(spec.size() == 41);
+        REQUIRE(spec.lambda_min() == 380_nm);
+        REQUIRE(spec.lambda_max() == 780_nm);
+        REQUIRE(spec[17] == blackbody_normalized(3200_kelvin, 550_nm));
+        REQUIRE(blackbody<41>(3200_kelvin, 380_nm, 780_nm)[0] == blackbody(3200_kelvin, 380_nm));
+    }
+
+    SECTION("Planckian locus") {
+        auto chromaticity = [](XYZ<double> xyz, double x, double y) {
+            const double sum = xyz.X + xyz.Y + xyz.Z;
+            return std::fabs(xyz.X/sum - x) < 0.001 && std::fabs(xyz.Y/sum - y) < 0.001;
+        };
+        REQUIRE(chromaticity(blackbody_xyz(2856_kelvin), 0.44757, 0.40745));
+        REQUIRE(chromaticity(blackbody_xyz(6500_kelvin), 0.31352, 0.32363));
+        REQUIRE(blackbody_xyz(6500_kelvin).Y == Approx(1));
+
+        // Interpolated values are close to the directly integrated ones.
+        for (float T : {1000.f, 1234.f, 4567.f, 9876.f, 40000.f}) {
+            auto direct = cie1931::tristimulus([T](Nanometer l) { return planck(T, float(l)); });
+            direct = direct / direct.Y;
+            const auto xyz = blackbody_xyz<float>(Kelvin(T));
+            REQUIRE(xyz.X == Approx(direct.X).epsilon(1e-4));
+            REQUIRE(xyz.Z == Approx(direct.Z).epsilon(1e-4));
+        }
+
+        REQUIRE_THROWS_AS(blackbody_xyz(999_kelvin), std::out_of_range);
+        REQUIRE_THROWS_AS(blackbody_xyz(40001_kelvin), std::out_of_range);
+    }
+}
@@ -0,0 +1,102 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/future/illuminants.hh"
+#include "tukan/whitepoints.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    bool near (tukan::XYZ<double> a, tukan::XYZ<double> b, double rel) {
+        return std::fabs(a.X-b.X) <= rel*b.X
+            && std::fabs(a.Y-b.Y) <= rel*b.Y
+            && std::fabs(a.Z-b.Z) <= rel*b.Z;
+    }
+
+    template <typename Spec>
+    bool chromaticity (Spec const &spd, double x, double y) {
+        const auto xyz = tukan::future::illuminant::whitepoint_of(spd);
+        const double sum = xyz.X + xyz.Y + xyz.Z;
+        return std::fabs(xyz.X/sum - x) < 0.002 && std::fabs(xyz.Y/sum - y) < 0.002;
+    }
+}
+
+TEST_CASE("tukan/future/illuminants", "CIE standard illuminant tests")
+{
+    using namespace tukan;
+    using namespace tukan::future;
+
+    SECTION("Layout") {
+        REQUIRE(illuminant::S0.size() == 54);
+        REQUIRE(illuminant::S0.lambda_min() == 300_nm);
+        REQUIRE(illuminant::S0.lambda_max() == 830_nm);
+        REQUIRE(illuminant::F7.size() == 81);
+        REQUIRE(illuminant::F7.lambda_min() == 380_nm);
+        REQUIRE(illuminant::F7.lambda_max() == 780_nm);
+        REQUIRE(illuminant::A().size() == 107);
+    }
+
+    SECTION("Normalization at 560nm") {
+        REQUIRE(illuminant::A()[52] == Approx(100));
+        REQUIRE(illuminant::D65()[26] == Approx(100));
+        REQUIRE(illuminant::D50()[26] == Approx(100));
+        REQUIRE(illuminant::E()[26] == 100);
+    }
+
+    SECTION("D65 reproduces the tabulated values") {
+        // CIE 15:2004, Table T.1.
+        const auto d65 = illuminant::D65();
+        REQUIRE(d65[0]  == Approx(0.0341).epsilon(0.02));
+        REQUIRE(d65[10] == Approx(82.7549).epsilon(0.001));
+        REQUIRE(d65[16] == Approx(117.812).epsilon(0.001));
+        REQUIRE(d65[53] == Approx(60.3125).epsilon(0.001));
+    }
+
+    SECTION("Whitepoints") {
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::A()),   whitepoint::A,   0.002));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::E()),   whitepoint::E,   0.002));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::D50()), whitepoint::D50, 0.002));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::D55()), whitepoint::D55, 0.002));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::D65()), whitepoint::D65, 0.002));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::D75()), whitepoint::D75, 0.002));
+
+        // The 5nm lamp spectra integrated against the 10nm observer are somewhat less exact.
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::F2),  whitepoint::F2,  0.01));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::F7),  whitepoint::F7,  0.01));
+        REQUIRE(near(illuminant::whitepoint_of(illuminant::F11), whitepoint::F11, 0.01));
+    }
+
+    SECTION("F-series chromaticities") {
+        // CIE 15:2004, Table T.8.
+        REQUIRE(chromaticity(illuminant::F1,  0.31310, 0.33727));
+        REQUIRE(chromaticity(illuminant::F2,  0.37208, 0.37529));
+        REQUIRE(chromaticity(illuminant::F3,  0.40910, 0.39430));
+        REQUIRE(chromaticity(illuminant::F4,  0.44018, 0.40329));
+        REQUIRE(chromaticity(illuminant::F5,  0.31379, 0.34531));
+        REQUIRE(chromaticity(illuminant::F6,  0.37790, 0.38835));
+        REQUIRE(chromaticity(illuminant::F7,  0.31292, 0.32933));
+        REQUIRE(chromaticity(illuminant::F8,  0.34588, 0.35875));
+        REQUIRE(chromaticity(illuminant::F9,  0.37417, 0.37281));
+        REQUIRE(chromaticity(illuminant::F10, 0.34609, 0.35986));
+        REQUIRE(chromaticity(illuminant::F11, 0.38052, 0.37713));
+        REQUIRE(chromaticity(illuminant::F12, 0.43695, 0.40441));
+    }
+
+    SECTION("Batch D-series") {
+        const double ccts[] = {4000, 6504, 25000};
+        FixedSpectrum<54> spds[3];
+        illuminant::D(ccts, ccts+3, spds);
+        for (std::size_t i=0; i!=54; ++i)
+            REQUIRE(spds[1][i] == illuminant::D65()[i]);
+        // Higher temperature, more blue.
+        REQUIRE(spds[0][10] < spds[1][10]);
+        REQUIRE(spds[1][10] < spds[2][10]);
+    }
+
+    SECTION("Out of range") {
+        REQUIRE_THROWS_AS(illuminant::D(3999), std::out_of_range);
+        REQUIRE_THROWS_AS(illuminant::D(25001), std::out_of_range);
+    }
+}
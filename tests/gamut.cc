@@ -0,0 +1,219 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/gamut.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGBSpace.hh"
+#include "tukan/XYZ.hh"
+#include "catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Pro = LinearRGB<float,ProPhotoRGB>;
+    using Linear = LinearRGB<float,sRGB>;
+
+    // Colours over the ProPhotoRGB cube, many of them outside of sRGB.
+    std::vector<Pro> prophoto_colors () {
+        std::vector<Pro> ret;
+        for (int r=0; r<=6; ++r)
+            for (int g=0; g<=6; ++g)
+                for (int b=0; b<=6; ++b)
+                    ret.emplace_back(r / 6.f, g / 6.f, b / 6.f);
+        return ret;
+    }
+
+    bool in_range (Linear c) {
+        return c.r >= 0 && c.r <= 1 && c.g >= 0 && c.g <= 1 && c.b >= 0 && c.b <= 1;
+    }
+
+    bool outside (Linear c) {
+        const float e = 1e-5f;
+        return c.r < -e || c.r > 1+e || c.g < -e || c.g > 1+e || c.b < -e || c.b > 1+e;
+    }
+
+    Linear converted (Pro c) {
+        return Linear(static_cast<XYZ<float>>(c));
+    }
+
+    // Oklab L, a and b, in double.
+    struct Lab { double L, a, b; };
+    Lab oklab (LinearRGB<double,sRGB> c) {
+        auto const &m = gamut_target<double,sRGB>().rgb_to_lms;
+        const double l = std::cbrt(m._11*c.r + m._12*c.g + m._13*c.b),
+                     s = std::cbrt(m._21*c.r + m._22*c.g + m._23*c.b),
+                     v = std::cbrt(m._31*c.r + m._32*c.g + m._33*c.b);
+        return {0.2104542553*l + 0.7936177850*s - 0.0040720468*v,
+                1.9779984951*l - 2.4285922050*s + 0.4505937099*v,
+                0.0259040371*l + 0.7827717662*s - 0.8086757660*v};
+    }
+    Lab oklab (Linear c) {
+        return oklab(LinearRGB<double,sRGB>(c.r, c.g, c.b));
+    }
+
+    template <typename Strategy>
+    void check_strategy (Strategy const &s) {
+        for (Pro p : prophoto_colors()) {
+            const Linear c = converted(p), m = gamut_map<sRGB>(p, s);
+            REQUIRE(in_range(m));
+            if (!outside(c)) {
+                REQUIRE(m.r == Approx(c.r).margin(1e-4));
+                REQUIRE(m.g == Approx(c.g).margin(1e-4));
+                REQUIRE(m.b == Approx(c.b).margin(1e-4));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("tukan/gamut", "gamut tests")
+{
+    SECTION("Mapping single colours") {
+        check_strategy(Clip());
+        check_strategy(LuminanceClip());
+        check_strategy(OklchChroma());
+        for (Pro p : prophoto_colors())
+            REQUIRE(in_range(gamut_map<sRGB>(p, Compress())));
+
+        REQUIRE(gamut_map(Linear(1.5f, -0.5f, 0.25f), Clip()) == Linear(1, 0, 0.25f));
+
+        // The white of the space is Oklab (1, 0, 0).
+        const Lab white = oklab(LinearRGB<double,sRGB>(1, 1, 1));
+        REQUIRE(white.L == Approx(1));
+        REQUIRE(white.a == Approx(0).margin(1e-7));
+        REQUIRE(white.b == Approx(0).margin(1e-7));
+    }
+
+    SECTION("Keeps luminance") {
+        for (Pro p : prophoto_colors()) {
+            const Linear c = converted(p), m = gamut_map(c, LuminanceClip());
+            const float y = luminance(c);
+            if (y >= 0 && y <= 1)
+                REQUIRE(luminance(m) == Approx(y).margin(1e-5));
+        }
+        REQUIRE(gamut_map(Linear(2, 3, 4), LuminanceClip()) == Linear(1, 1, 1));
+        REQUIRE(gamut_map(Linear(-2, -3, 1), LuminanceClip()) == Linear(0, 0, 0));
+    }
+
+    SECTION("ACES gamut compression") {
+        // Distances below the threshold stay, up to the limit they land in the gamut.
+        const Linear c = gamut_map(Linear(1, -0.1f, 0.5f), Compress());
+        REQUIRE(c.r == 1);
+        REQUIRE(c.b == Approx(0.5));
+        REQUIRE(c.g > 0);
+        REQUIRE(c.g < 0.2f);
+
+        Compress compress;
+        const Linear at_limit = gamut_map(Linear(1, 1 - float(compress.limit[1]), 1), compress);
+        REQUIRE(at_limit.g == Approx(0).margin(1e-4));
+
+        // Monotonic in the distance.
+        float prev = 1;
+        for (float g = 1; g > -0.5f; g -= 0.01f) {
+            const float v = gamut_map(Linear(1, g, 0.9f), compress).g;
+            REQUIRE(v <= prev + 1e-6f);
+            prev = v;
+        }
+
+        // float and double agree.
+        for (Pro p : prophoto_colors()) {
+            const Linear f = gamut_map<sRGB>(p, compress);
+            const LinearRGB<double,sRGB> d =
+                gamut_map<sRGB>(LinearRGB<double,ProPhotoRGB>(p.r, p.g, p.b), compress);
+            REQUIRE(f.r == Approx(d.r).margin(1e-4));
+            REQUIRE(f.g == Approx(d.g).margin(1e-4));
+        }
+    }
+
+    SECTION("Chroma reduction at constant lightness and hue") {
+        for (Pro p : prophoto_colors()) {
+            const Linear c = converted(p);
+            const Lab in = oklab(c);
+            if (!outside(c) || in.L <= 0.01 || in.L >= 0.99)
+                continue;
+            const Linear m = gamut_map(c, OklchChroma());
+            const Lab out = oklab(m);
+            REQUIRE(out.L == Approx(in.L).margin(2e-3));
+            const double chroma_in = std::hypot(in.a, in.b), chroma_out = std::hypot(out.a, out.b);
+            REQUIRE(chroma_out < chroma_in);
+            if (chroma_out > 0.02)
+                REQUIRE(std::abs(std::remainder(std::atan2(out.b, out.a) - std::atan2(in.b, in.a),
+                                                2 * 3.14159265358979)) < 0.02);
+            // On the boundary.
+            const float lo = std::min(m.r, std::min(m.g, m.b)),
+                        hi = std::max(m.r, std::max(m.g, m.b));
+            REQUIRE((lo < 1e-3f || hi > 1 - 1e-3f));
+
+            const LinearRGB<double,sRGB> d = gamut_map(LinearRGB<double,sRGB>(c.r, c.g, c.b),
+                                                       OklchChroma());
+            REQUIRE(m.r == Approx(d.r).margin(2e-4));
+            REQUIRE(m.b == Approx(d.b).margin(2e-4));
+        }
+        const Linear bright = gamut_map(Linear(4, 4, 4), OklchChroma());
+        REQUIRE(bright.r == Approx(1).margin(1e-4));
+        REQUIRE(bright.g == Approx(1).margin(1e-4));
+        REQUIRE(bright.b == Approx(1).margin(1e-4));
+    }
+
+    SECTION("Pointer ranges, images, counts and masks") {
+        const std::vector<Pro> img = prophoto_colors();
+        const std::size_t w = 49, h = 7;
+        REQUIRE(img.size() == w*h);
+
+        std::size_t expected = 0;
+        for (Pro p : img)
+            expected += outside(converted(p));
+        REQUIRE(expected > 0);
+        REQUIRE(expected < img.size());
+
+        std::vector<Linear> out (img.size());
+        std::vector<std::uint8_t> mask (img.size(), 7);
+        REQUIRE(gamut_map(img.data(), img.data() + img.size(), out.data(), OklchChroma(),
+                          mask.data()) == expected);
+        for (std::size_t i=0; i!=img.size(); ++i) {
+            REQUIRE(mask[i] == (outside(converted(img[i])) ? 1 : 0));
+            const Linear ref = gamut_map<sRGB>(img[i], OklchChroma());
+            REQUIRE(out[i].r == Approx(ref.r).margin(1e-6));
+            REQUIRE(out[i].b == Approx(ref.b).margin(1e-6));
+        }
+
+        // In place, in the same space.
+        std::vector<Linear> same;
+        for (Pro p : img)
+            same.push_back(converted(p));
+        REQUIRE(gamut_map(same.data(), same.data() + same.size(), same.data(), Clip()) == expected);
+        for (Linear c : same)
+            REQUIRE(in_range(c));
+
+        // A window into a padded mask.
+        const ImageView<Pro const> window (img.data() + 2, 40, h, w);
+        std::vector<Linear> wout (40*h);
+        std::vector<std::uint8_t> wmask (42*h, 7);
+        const std::size_t count = gamut_map(window, image_view(wout.data(), 40, h),
+                                            ImageView<std::uint8_t>(wmask.data(), 40, h, 42),
+                                            LuminanceClip());
+        std::size_t wexpected = 0;
+        for (std::size_t y=0; y!=h; ++y) {
+            for (std::size_t x=0; x!=40; ++x) {
+                const bool o = outside(converted(window(x, y)));
+                wexpected += o;
+                REQUIRE(wmask[y*42 + x] == (o ? 1 : 0));
+                REQUIRE(in_range(wout[y*40 + x]));
+            }
+            REQUIRE(wmask[y*42 + 40] == 7);
+        }
+        REQUIRE(count == wexpected);
+        REQUIRE(gamut_map(window, image_view(wout.data(), 40, h), Compress()) == wexpected);
+
+        REQUIRE_THROWS_AS(gamut_map(window, image_view(wout.data(), h, 40), Clip()),
+                          std::logic_error);
+        REQUIRE_THROWS_AS(gamut_map(window, image_view(wout.data(), 40, h),
+                                    image_view(wmask.data(), 41, h), Clip()),
+                          std::logic_error);
+    }
+}
@@ -0,0 +1,130 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/half.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/LinearRGBA.hh"
+#include "tukan/XYZ.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <vector>
+
+TEST_CASE("tukan/half", "half tests")
+{
+    using namespace tukan;
+
+    SECTION("conversion") {
+        REQUIRE(half(1.0f).bits() == 0x3c00);
+        REQUIRE(half(-2.0f).bits() == 0xc000);
+        REQUIRE(half(65504.0f).bits() == 0x7bff);
+        REQUIRE(half(65520.0f).bits() == 0x7c00);
+        REQUIRE(half(1.0f + 1.0f/2048).bits() == 0x3c00);   // ties to even
+        REQUIRE(half(1.0f + 3.0f/2048).bits() == 0x3c02);
+        REQUIRE(float(half(0.333333f)) == 0.333251953125f);
+        REQUIRE(float(half::from_bits(0x0001)) == std::ldexp(1.0f, -24));
+        REQUIRE(std::isnan(float(half(std::numeric_limits<float>::quiet_NaN()))));
+
+        for (unsigned b=0; b!=0x10000; ++b) {
+            const half h = half::from_bits(b);
+            if (std::isnan(float(h)))
+                continue;
+            REQUIRE(half(float(h)).bits() == b);
+        }
+
+        for (float f=-70000; f<70000; f+=13.37f)
+            REQUIRE(half(f).bits() == detail::float_to_half_bits(f));
+    }
+
+    SECTION("numeric_limits") {
+        using L = std::numeric_limits<half>;
+        REQUIRE(L::is_specialized);
+        REQUIRE(float(L::max()) == 65504.0f);
+        REQUIRE(float(L::lowest()) == -65504.0f);
+        REQUIRE(float(L::min()) == std::ldexp(1.0f, -14));
+        REQUIRE(float(L::epsilon()) == std::ldexp(1.0f, -10));
+        REQUIRE(float(half(1.0f + float(L::epsilon()))) > 1.0f);
+        REQUIRE(std::isinf(float(L::infinity())));
+        REQUIRE(std::isnan(float(L::quiet_NaN())));
+    }
+
+    SECTION("arithmetic") {
+        half h = 1.5f;
+        h += 1;
+        REQUIRE(float(h) == 2.5f);
+        h *= 2;
+        REQUIRE(float(h) == 5.0f);
+        REQUIRE(float(h / h) == 1.0f);
+        REQUIRE(h > half(4.0f));
+        REQUIRE(h == half(5.0f));
+    }
+
+    SECTION("as value type of colors") {
+        using RGBh = RebindValueType<half, LinearRGB<float,sRGB>>;
+        REQUIRE((std::is_same<RGBh, LinearRGB<half,sRGB>>::value));
+        REQUIRE((std::is_same<RebindValueType<float, RGBh>, LinearRGB<float,sRGB>>::value));
+        REQUIRE((std::is_same<RebindValueType<half, XYZ<float>>, XYZ<half>>::value));
+        REQUIRE(sizeof(RGBh) == 6);
+
+        RGBh c (0.5f, 0.25f, 1);
+        c *= 2;
+        c += RGBh(1);
+        REQUIRE(float(c.r) == 2.0f);
+        REQUIRE(float(c.g) == 1.5f);
+        REQUIRE(float(c.b) == 3.0f);
+        REQUIRE(float((c - c)[1]) == 0.0f);
+        REQUIRE(float((c * half(0.5f)).b) == 1.5f);
+
+        const XYZ<half> x = XYZ<half>(RGBh(1));
+        const XYZ<float> xf = XYZ<float>(LinearRGB<float,sRGB>(1));
+        REQUIRE(std::fabs(x.Y - xf.Y) < 2e-3f);
+
+        LinearRGBA<half,sRGB> a (0.5f, 0.5f, 0.5f, 1);
+        a += a;
+        REQUIRE(float(a.r) == 1.0f);
+        REQUIRE(float(a.a) == 2.0f);
+    }
+
+    SECTION("batch") {
+        std::vector<float> f;
+        for (int i=0; i!=67; ++i)
+            f.push_back(i * 0.173f - 5);
+
+        std::vector<half> h (f.size());
+        pack_half(f.data(), f.data()+f.size(), h.data());
+        for (std::size_t i=0; i!=f.size(); ++i)
+            REQUIRE(h[i].bits() == detail::float_to_half_bits(f[i]));
+
+        std::vector<float> back (f.size());
+        unpack_half(h.data(), h.data()+h.size(), back.data());
+        for (std::size_t i=0; i!=f.size(); ++i)
+            REQUIRE(back[i] == detail::half_bits_to_float(h[i].bits()));
+    }
+
+    SECTION("images") {
+        using RGBf = LinearRGB<float,sRGB>;
+        using RGBh = LinearRGB<half,sRGB>;
+
+        // 5x3 pixels with a stride of 7.
+        std::vector<RGBf> in (7*3);
+        for (std::size_t i=0; i!=in.size(); ++i)
+            in[i] = RGBf(i, i*0.5f, -float(i));
+        std::vector<RGBh> mid (5*3);
+        std::vector<RGBf> out (5*3);
+
+        pack_half(ImageView<RGBf const>(in.data(), 5, 3, 7), image_view(mid.data(), 5, 3));
+        unpack_half(image_view(mid.data(), 5, 3), image_view(out.data(), 5, 3));
+
+        for (std::size_t y=0; y!=3; ++y)
+        for (std::size_t x=0; x!=5; ++x) {
+            REQUIRE(out[y*5+x].r == float(half(in[y*7+x].r)));
+            REQUIRE(out[y*5+x].g == float(half(in[y*7+x].g)));
+            REQUIRE(out[y*5+x].b == float(half(in[y*7+x].b)));
+        }
+
+        std::vector<float> plain (5*3);
+        REQUIRE_THROWS_AS(pack_half(image_view(plain.data(), 5, 3),
+                                    image_view(reinterpret_cast<half*>(mid.data()), 3, 5)),
+                          std::logic_error);
+    }
+}
@@ -0,0 +1,77 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/luminance.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/LinearRGBA.hh"
+#include "tukan/RGBSpace.hh"
+#include "tukan/XYZ.hh"
+#include "catch.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    template <typename T, template <typename> class Space>
+    void check_against_xyz () {
+        for (int i=0; i!=50; ++i) {
+            const LinearRGB<T,Space> c (T(i % 7) / 6, T(i % 5) / 4 - T(0.1), T(i % 3) * 2);
+            REQUIRE(luminance(c) == Approx(static_cast<XYZ<T>>(c).Y).epsilon(1e-6));
+        }
+    }
+}
+
+
+TEST_CASE("tukan/luminance", "luminance tests")
+{
+    SECTION("Luminance is the Y of the XYZ conversion") {
+        check_against_xyz<float, sRGB>();
+        check_against_xyz<double, sRGB>();
+        check_against_xyz<float, AdobeRGB>();
+        check_against_xyz<double, ProPhotoRGB>();
+        check_against_xyz<float, ECIRGBv2>();
+
+        // The white of the space has the Y of its white point.
+        auto const &w = luminance_weights<double, sRGB>();
+        REQUIRE(w.r + w.g + w.b == Approx(1));
+        REQUIRE(w.g > w.r);
+        REQUIRE(w.r > w.b);
+        REQUIRE(&w == &luminance_weights<double, sRGB>());
+
+        const LinearRGBA<float,sRGB> rgba (0.25f, 0.5f, 0.75f, 0.1f);
+        REQUIRE(luminance(rgba) == luminance(LinearRGB<float,sRGB>(0.25f, 0.5f, 0.75f)));
+    }
+
+    SECTION("Pointer ranges and images match the scalar version") {
+        std::vector<LinearRGB<float,sRGB>> rgb;
+        std::vector<LinearRGBA<double,AdobeRGB>> rgba;
+        for (int i=0; i!=37; ++i) {
+            rgb.emplace_back(i / 37.f, (i % 4) / 3.f, 1 - i / 37.f);
+            rgba.emplace_back(i / 37., (i % 4) / 3., 1 - i / 37., 0.5);
+        }
+
+        std::vector<float> y (rgb.size());
+        luminance(rgb.data(), rgb.data() + rgb.size(), y.data());
+        for (std::size_t i=0; i!=rgb.size(); ++i)
+            REQUIRE(y[i] == Approx(luminance(rgb[i])).epsilon(1e-6));
+
+        std::vector<double> ya (rgba.size());
+        luminance(rgba.data(), rgba.data() + rgba.size(), ya.data());
+        for (std::size_t i=0; i!=rgba.size(); ++i)
+            REQUIRE(ya[i] == Approx(luminance(rgba[i])).epsilon(1e-12));
+
+        // A 4x5 window of a 7-wide image into a padded plane.
+        const ImageView<LinearRGB<float,sRGB> const> window (rgb.data() + 1, 4, 5, 7);
+        std::vector<float> plane (6*5, -1);
+        luminance(window, ImageView<float>(plane.data(), 4, 5, 6));
+        for (std::size_t row=0; row!=5; ++row) {
+            for (std::size_t x=0; x!=4; ++x)
+                REQUIRE(plane[row*6 + x] == Approx(luminance(window(x, row))).epsilon(1e-6));
+            REQUIRE(plane[row*6 + 4] == -1);
+        }
+
+        REQUIRE_THROWS_AS(luminance(window, image_view(plane.data(), 5, 4)), std::logic_error);
+    }
+}
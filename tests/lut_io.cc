@@ -0,0 +1,289 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/lut_io.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    using namespace tukan;
+
+    template <unsigned N>
+    LUT3D<float,N> cube () {
+        LUT3D<float,N> lut;
+        for (unsigned b=0; b!=N; ++b)
+        for (unsigned g=0; g!=N; ++g)
+        for (unsigned r=0; r!=N; ++r) {
+            const float x = r/float(N-1), y = g/float(N-1), z = b/float(N-1);
+            float *n = lut.node(r, g, b);
+            n[0] = (std::sin(3*x) * y + z*z) / 2;
+            n[1] = x*y*z;
+            n[2] = (std::sqrt(x + y) - z) / 3 + 0.4f;
+        }
+        return lut;
+    }
+
+    template <unsigned N>
+    bool equal (LUT3D<float,N> const &a, LUT3D<float,N> const &b, float eps) {
+        for (unsigned b_=0; b_!=N; ++b_)
+        for (unsigned g=0; g!=N; ++g)
+        for (unsigned r=0; r!=N; ++r)
+            for (unsigned k=0; k!=3; ++k)
+                if (!(std::fabs(a.node(r, g, b_)[k] - b.node(r, g, b_)[k]) <= eps))
+                    return false;
+        return a.domain_min == b.domain_min && a.domain_max == b.domain_max;
+    }
+
+    template <typename LUT>
+    LUT parse (std::string const &s, LUTFormat format) {
+        return parse_lut<LUT>(s.data(), s.data() + s.size(), format);
+    }
+
+    template <typename LUT>
+    std::string write (LUT const &lut, LUTFormat format) {
+        std::ostringstream ss;
+        write_lut(ss, lut, format);
+        return ss.str();
+    }
+
+    void write_file (std::string const &path, std::string const &contents) {
+        std::ofstream ofs (path, std::ios::binary);
+        ofs << contents;
+    }
+}
+
+TEST_CASE("tukan/lut_io", "LUT file format tests")
+{
+    using namespace tukan;
+    using LUT = LUT3D<float,9>;
+
+    SECTION("number parsing") {
+        auto number = [](char const *s) {
+            double v = -1;
+            detail::lut_token t;
+            t.first = s;
+            t.last = s + std::strlen(s);
+            REQUIRE(detail::parse_lut_number(t, v));
+            return v;
+        };
+        REQUIRE(number("0") == 0);
+        REQUIRE(number("-0.5") == -0.5);
+        REQUIRE(number("1.000000") == 1);
+        REQUIRE(number("0.1") == 0.1);
+        REQUIRE(number(".25e1") == 2.5);
+        REQUIRE(number("+1E-3") == 1e-3);
+        REQUIRE(number("0.123456789012345678901234") == 0.123456789012345678901234);
+        REQUIRE(number("1e300") == 1e300);
+        REQUIRE(float(number("0.72896587848663330078")) == 0.72896587848663330078f);
+
+        double v;
+        for (char const *s : {"", "-", ".", "1e", "1.2.3", "abc", "1,5"}) {
+            detail::lut_token t;
+            t.first = s;
+            t.last = s + std::strlen(s);
+            REQUIRE_FALSE(detail::parse_lut_number(t, v));
+        }
+    }
+
+    SECTION(".cube") {
+        const std::string text =
+            "# comment\n"
+            "TITLE \"a title, with spaces\"\n"
+            "LUT_3D_SIZE 2\r\n"
+            "DOMAIN_MIN 0 -1 0\n"
+            "DOMAIN_MAX 1 1 2\n"
+            "\n"
+            "0 0 0\n1 0 0\n0 1 0\n1 1 0   # red changes fastest\n"
+            "0 0 1\n1 0 1\n0 1 1\n1 1 1\n";
+        const auto lut = parse<LUT3D<float,2>>(text, LUTFormat::cube);
+        REQUIRE(lut.node(1, 0, 0)[0] == 1);
+        REQUIRE(lut.node(0, 1, 1)[1] == 1);
+        REQUIRE(lut.node(0, 1, 1)[2] == 1);
+        REQUIRE(lut.node(1, 1, 0)[2] == 0);
+        REQUIRE(lut.domain_min[1] == -1);
+        REQUIRE(lut.domain_max[2] == 2);
+
+        const auto info = inspect_lut(text.data(), text.data() + text.size(), LUTFormat::cube);
+        REQUIRE(info.dimensions == 3);
+        REQUIRE(info.size == 2);
+
+        const LUT a = cube<9>();
+        REQUIRE(equal(parse<LUT>(write(a, LUTFormat::cube), LUTFormat::cube), a, 0));
+    }
+
+    SECTION(".cube with shaper") {
+        const std::string text =
+            "LUT_1D_SIZE 2\nLUT_1D_INPUT_RANGE 0 4\n"
+            "LUT_3D_SIZE 2\nLUT_3D_INPUT_RANGE 0 1\n"
+            "0 0 0\n0.5 1 1\n"
+            "0 0 0\n1 0 0\n0 1 0\n1 1 0\n0 0 1\n1 0 1\n0 1 1\n1 1 1\n";
+        const auto lut3 = parse<LUT3D<float,2>>(text, LUTFormat::cube);
+        REQUIRE(lut3.node(1, 0, 1)[0] == 1);
+        REQUIRE(lut3.domain_max[0] == 1);
+        const auto lut1 = parse<LUT1D<float,2>>(text, LUTFormat::cube);
+        REQUIRE(lut1.curve(0)[1] == 0.5f);
+        REQUIRE(lut1.curve(2)[1] == 1);
+        REQUIRE(lut1.domain_max[0] == 4);
+    }
+
+    SECTION(".3dl") {
+        const std::string text =
+            "# comment\n"
+            "0 1023\n"
+            "0 0 0\n0 0 4095\n0 4095 0\n0 4095 4095\n"
+            "4095 0 0\n4095 0 4095\n4095 4095 0\n4095 4095 2048\n";
+        const auto lut = parse<LUT3D<float,2>>(text, LUTFormat::threedl);
+        REQUIRE(lut.node(0, 0, 1)[2] == 1);
+        REQUIRE(lut.node(1, 0, 0)[0] == 1);
+        REQUIRE(lut.node(0, 1, 0)[1] == 1);
+        REQUIRE(std::fabs(lut.node(1, 1, 1)[2] - 2048/4095.f) < 1e-7f);
+
+        // 10 bit output, inferred from the largest value.
+        const std::string ten = "0 1023\n"
+                                "0 0 0\n0 0 1023\n0 1023 0\n0 1023 1023\n"
+                                "1023 0 0\n1023 0 1023\n1023 1023 0\n1023 1023 1023\n";
+        REQUIRE(parse<LUT3D<float,2>>(ten, LUTFormat::threedl).node(0, 0, 1)[2] == 1);
+
+        // 12 bit, so within half a code.
+        const LUT a = cube<9>();
+        const std::string written = write(a, LUTFormat::threedl);
+        REQUIRE(written.compare(0, 15, "3DMESH\nMesh 3 1") == 0);
+        REQUIRE(equal(parse<LUT>(written, LUTFormat::threedl), a, 0.5f/4095 + 1e-6f));
+        REQUIRE(inspect_lut(written.data(), written.data() + written.size(),
+                            LUTFormat::threedl).size == 9);
+
+        LUT wide;
+        wide.domain_max[0] = 2;
+        REQUIRE_THROWS_AS(write(wide, LUTFormat::threedl), std::logic_error);
+        REQUIRE_THROWS_AS(write(LUT1D<float,4>(), LUTFormat::threedl), std::logic_error);
+    }
+
+    SECTION(".clf") {
+        const std::string text =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<ProcessList id=\"x\" compCLFversion=\"3.0\">\n"
+            "  <Description>LUT3D and LUT1D</Description>\n"
+            "  <LUT1D id=\"curve\" inBitDepth=\"32f\" outBitDepth=\"32f\">\n"
+            "    <Array dim=\"3 1\"> 0 0.25 1 </Array>\n"
+            "  </LUT1D>\n"
+            "  <LUT3D id=\"cube\" inBitDepth=\"32f\" outBitDepth='10i' interpolation=\"trilinear\">\n"
+            "    <Array dim=\"2 2 2 3\">\n"
+            "      0 0 0  0 0 1023  0 1023 0  0 1023 1023\n"
+            "      1023 0 0  1023 0 1023  1023 1023 0  1023 1023 1023\n"
+            "    </Array>\n"
+            "  </LUT3D>\n"
+            "</ProcessList>\n";
+        const auto lut3 = parse<LUT3D<float,2>>(text, LUTFormat::clf);
+        REQUIRE(lut3.node(0, 0, 1)[2] == 1);
+        REQUIRE(lut3.node(1, 0, 0)[0] == 1);
+        REQUIRE(lut3.node(1, 0, 0)[2] == 0);
+        const auto lut1 = parse<LUT1D<float,3>>(text, LUTFormat::clf);
+        REQUIRE(lut1.shared());
+        REQUIRE(lut1.curve(2)[1] == 0.25f);
+        REQUIRE(inspect_lut(text.data(), text.data() + text.size(), LUTFormat::clf).size == 2);
+
+        const LUT a = cube<9>();
+        REQUIRE(equal(parse<LUT>(write(a, LUTFormat::clf), LUTFormat::clf), a, 0));
+
+        LUT1D<float,5> curves;
+        curves.curve(1)[2] = 0.1f;
+        const auto b = parse<LUT1D<float,5>>(write(curves, LUTFormat::clf), LUTFormat::clf);
+        REQUIRE_FALSE(b.shared());
+        REQUIRE(b.curve(1)[2] == 0.1f);
+        REQUIRE(b.curve(0)[2] == 0.5f);
+    }
+
+    SECTION("errors") {
+        using LUT2 = LUT3D<float,2>;
+        auto fails = [](std::string const &s, LUTFormat format) {
+            REQUIRE_THROWS_AS(parse<LUT2>(s, format), std::runtime_error);
+        };
+        const std::string rows = "0 0 0\n1 0 0\n0 1 0\n1 1 0\n0 0 1\n1 0 1\n0 1 1\n1 1 1\n";
+        fails("LUT_3D_SIZE 3\n" + rows, LUTFormat::cube);
+        fails("LUT_3D_SIZE 2\n" + rows + "1 1 1\n", LUTFormat::cube);
+        fails("LUT_3D_SIZE 2\n" + rows.substr(0, rows.size() - 6), LUTFormat::cube);
+        fails("LUT_3D_SIZE 2\nFOO 1\n" + rows, LUTFormat::cube);
+        fails("LUT_3D_SIZE 2\n0 0 zero\n" + rows, LUTFormat::cube);
+        fails("LUT_1D_SIZE 2\n0 0 0\n1 1 1\n", LUTFormat::cube);
+        fails("0 512 1023\n" + rows, LUTFormat::threedl);
+        for (char const *mesh : {"Mesh 1 -5\n", "Mesh 1 1e30\n", "Mesh 1 12.5\n", "Mesh 1 0\n"}) {
+            const std::string text = mesh + std::string("0 1023\n") + rows;
+            fails(text, LUTFormat::threedl);
+            REQUIRE_THROWS_AS(inspect_lut(text.data(), text.data() + text.size(), LUTFormat::threedl),
+                              std::runtime_error);
+        }
+        fails("<ProcessList></ProcessList>", LUTFormat::clf);
+        fails("<LUT3D><Array dim=\"2 2 2\">" + rows + "</Array></LUT3D>", LUTFormat::clf);
+        fails("<LUT3D><Array dim=\"2 2 2 3\">" + rows + "</LUT3D>", LUTFormat::clf);
+        // inspect_lut() checks the dim as the readers do, including a missing one.
+        for (std::string const &text : {"<LUT3D><Array>" + rows + "</Array></LUT3D>",
+                                       "<LUT3D><Array dim=\"\">" + rows + "</Array></LUT3D>",
+                                       "<LUT3D><Array dim=\"2 2 3\">" + rows + "</Array></LUT3D>",
+                                       std::string("<LUT1D><Array dim=\"\">0 1</Array></LUT1D>")}) {
+            fails(text, LUTFormat::clf);
+            REQUIRE_THROWS_AS(inspect_lut(text.data(), text.data() + text.size(), LUTFormat::clf),
+                              std::runtime_error);
+        }
+
+        try {
+            parse<LUT3D<float,2>>("LUT_3D_SIZE 2\n0 0 0\n1 x 0\n", LUTFormat::cube);
+            FAIL("no exception");
+        } catch (std::runtime_error const &e) {
+            REQUIRE(std::string(e.what()).find("line 3") != std::string::npos);
+        }
+
+        REQUIRE(lut_format("a/b.CUBE") == LUTFormat::cube);
+        REQUIRE(lut_format("x.3dl") == LUTFormat::threedl);
+        REQUIRE_THROWS_AS(lut_format("x.csp"), std::runtime_error);
+        REQUIRE_THROWS_AS(read_lut<LUT>("/nonexistent/x.cube"), std::runtime_error);
+    }
+
+    SECTION("files and cache") {
+        const std::string path = "tukan_lut_io_test.cube";
+        const LUT a = cube<9>();
+        write_lut(path, a);
+        REQUIRE(equal(read_lut<LUT>(path), a, 0));
+        REQUIRE(inspect_lut(path).size == 9);
+
+        clear_lut_cache();
+        const auto first = load_lut<LUT>(path);
+        REQUIRE(equal(*first, a, 0));
+        REQUIRE(load_lut<LUT>(path) == first);
+        // Other types are cached separately.
+        REQUIRE(load_lut<LUT3D<double,9>>(path)->node(3, 4, 5)[1] == a.node(3, 4, 5)[1]);
+
+        // A changed file is parsed again.
+        LUT b = a;
+        b.node(1, 2, 3)[0] = 0.75f;
+        b.domain_max[0] = 1.5f;
+        write_lut(path, b);
+        const auto second = load_lut<LUT>(path);
+        REQUIRE(second != first);
+        REQUIRE(equal(*second, b, 0));
+        REQUIRE(equal(*first, a, 0));
+        REQUIRE(load_lut<LUT>(path) == second);
+
+        clear_lut_cache();
+        REQUIRE(load_lut<LUT>(path) != second);
+
+        // The least recently used LUTs are dropped beyond the capacity.
+        const auto kept = load_lut<LUT>(path);
+        for (int i=0; i!=40; ++i) {
+            const std::string other = "tukan_lut_io_test_" + std::to_string(i) + ".cube";
+            write_lut(other, LUT3D<float,2>());
+            load_lut<LUT3D<float,2>>(other);
+            std::remove(other.c_str());
+        }
+        REQUIRE(load_lut<LUT>(path) != kept);
+        REQUIRE(equal(*load_lut<LUT>(path), b, 0));
+
+        write_file(path, "LUT_3D_SIZE 9\n0 0 0\n");
+        REQUIRE_THROWS_AS(load_lut<LUT>(path), std::runtime_error);
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,181 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/packed.hh"
+#include "tukan/LinearRGBA.hh"
+#include "catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+    // Straightforward reference for the unsigned small floats, following the specification.
+    std::uint32_t ref_ufloat (float f, int M) {
+        const std::uint32_t inf = 0x1fu << M, max_finite = inf - 1;
+        if (std::isnan(f)) return inf | ((1u << M) - 1);
+        if (f <= 0) return 0;
+        if (std::isinf(f)) return inf;
+
+        // Exact value in units of the spacing at its exponent, rounded to nearest even.
+        int e;
+        std::frexp(f, &e);      // f = m * 2^e, m in [0.5, 1)
+        e = std::max(e - 1, -14);
+        const double units = std::ldexp(double(f), M - e);
+        double r = std::floor(units);
+        const double frac = units - r;
+        if (frac > 0.5 || (frac == 0.5 && std::fmod(r, 2) == 1)) r += 1;
+        const double value = std::ldexp(r, e - M);
+
+        // Encode the rounded value.
+        if (value >= std::ldexp(1.0, 16)) return max_finite;
+        if (value < std::ldexp(1.0, -14))
+            return std::uint32_t(std::ldexp(value, 14 + M));
+        int ve;
+        const double vm = std::frexp(value, &ve);
+        const std::uint32_t mant = std::uint32_t(std::ldexp(vm, M + 1)) & ((1u << M) - 1);
+        const std::uint32_t r_bits = std::uint32_t(ve - 1 + 15) << M | mant;
+        return std::min(r_bits, max_finite);
+    }
+
+    // EXT_texture_shared_exponent, literally.
+    std::uint32_t ref_rgb9e5 (float r, float g, float b) {
+        const double N=9, B=15, sharedexp_max = 511.0/512 * std::ldexp(1.0, 31-15);
+        auto clamp = [&](double v) { return std::isnan(v) ? 0 : std::max(0.0, std::min(sharedexp_max, v)); };
+        const double rc = clamp(r), gc = clamp(g), bc = clamp(b);
+        const double max_c = std::max(rc, std::max(gc, bc));
+        const double exp_p = std::max(-B-1, std::floor(std::log2(max_c))) + 1 + B;
+        const double max_s = std::floor(max_c / std::pow(2, exp_p - B - N) + 0.5);
+        const double exp = max_s == 512 ? exp_p + 1 : exp_p;
+        auto s = [&](double v) { return std::uint32_t(std::floor(v / std::pow(2, exp - B - N) + 0.5)); };
+        return s(rc) | s(gc) << 9 | s(bc) << 18 | std::uint32_t(exp) << 27;
+    }
+
+    std::vector<float> samples () {
+        std::vector<float> ret;
+        for (std::uint32_t bits=0; bits<0x80000000u; bits+=65537) {
+            float f;
+            std::memcpy(&f, &bits, sizeof f);
+            ret.push_back(f);
+            ret.push_back(-f);
+        }
+        const float special[] = {0.f, 1.f, 0.5f, 65024.f, 65023.f, 65535.f, 65536.f, 64512.f,
+                                 65408.f, 65409.f, 1e-5f, 6.1035156e-05f,
+                                 std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::quiet_NaN()};
+        ret.insert(ret.end(), std::begin(special), std::end(special));
+        return ret;
+    }
+}
+
+TEST_CASE("tukan/packed", "packed pixel format tests")
+{
+    using namespace tukan;
+    using RGBf  = LinearRGB<float,sRGB>;
+    using RGBAf = LinearRGBA<float,sRGB>;
+
+    SECTION("RGB565") {
+        REQUIRE(pack<packed::RGB565>(RGBf(1, 0, 0)) == 0xf800);
+        REQUIRE(pack<packed::RGB565>(RGBf(0, 1, 0)) == 0x07e0);
+        REQUIRE(pack<packed::RGB565>(RGBf(0, 0, 1)) == 0x001f);
+        REQUIRE(pack<packed::RGB565>(RGBf(2, -1, 0.5f)) == (0xf800 | 16));
+        for (unsigned p=0; p!=0x10000; ++p)
+            REQUIRE(pack<packed::RGB565>(unpack<packed::RGB565, RGBf>(std::uint16_t(p))) == p);
+    }
+
+    SECTION("RGB10A2") {
+        REQUIRE(pack<packed::RGB10A2>(RGBAf(1, 0, 0, 1)) == (0x3ffu | 3u << 30));
+        REQUIRE(pack<packed::RGB10A2>(RGBAf(0, 0.5f, 1, 0.4f)) == (512u << 10 | 0x3ffu << 20 | 1u << 30));
+        const RGBAf c = unpack<packed::RGB10A2, RGBAf>(0xffffffffu);
+        REQUIRE(c == RGBAf(1, 1, 1, 1));
+        for (std::uint32_t p=0; p<0xffffffffu - 12345; p+=12345)
+            REQUIRE(pack<packed::RGB10A2>(unpack<packed::RGB10A2, RGBAf>(p)) == p);
+    }
+
+    SECTION("R11G11B10F") {
+        for (float f : samples()) {
+            const std::uint32_t p = pack<packed::R11G11B10F>(RGBf(f, f, f));
+            REQUIRE((p & 0x7ff) == ref_ufloat(f, 6));
+            REQUIRE(((p >> 11) & 0x7ff) == ref_ufloat(f, 6));
+            REQUIRE((p >> 22) == ref_ufloat(f, 5));
+        }
+        // Unpacking is exact, and packing the result gives the same bits.
+        for (std::uint32_t v=0; v!=0x800; ++v) {
+            const std::uint32_t p = v | (v << 11) | ((v >> 1) << 22);
+            const RGBf c = unpack<packed::R11G11B10F, RGBf>(p);
+            if (std::isnan(c.r) || std::isnan(c.b))
+                continue;
+            REQUIRE(pack<packed::R11G11B10F>(c) == p);
+        }
+        REQUIRE(unpack<packed::R11G11B10F, RGBf>(0x3c0u | 0x3c0u << 11 | 0x1e0u << 22) == RGBf(1));
+        REQUIRE(unpack<packed::R11G11B10F, RGBf>(0x7bfu).r == 65024.f);
+        REQUIRE(unpack<packed::R11G11B10F, RGBf>(1u).r == std::ldexp(1.f, -20));
+    }
+
+    SECTION("RGB9E5") {
+        const std::vector<float> s = samples();
+        for (std::size_t i=0; i+2<s.size(); ++i)
+            REQUIRE(pack<packed::RGB9E5>(RGBf(s[i], s[i+1], s[i+2]))
+                    == ref_rgb9e5(s[i], s[i+1], s[i+2]));
+        for (std::size_t i=0; i+2<s.size(); ++i) {
+            const float a = s[i] * 1e-30f, b = s[i+1] * 1e30f, c = std::sqrt(std::fabs(s[i+2]));
+            REQUIRE(pack<packed::RGB9E5>(RGBf(a, b, c)) == ref_rgb9e5(a, b, c));
+        }
+
+        REQUIRE(pack<packed::RGB9E5>(RGBf(1, 0, 0)) == (256u | 16u << 27));
+        REQUIRE(unpack<packed::RGB9E5, RGBf>(256u | 16u << 27) == RGBf(1, 0, 0));
+        for (std::uint32_t p=0; p<0xffffffffu - 9973; p+=9973) {
+            const RGBf c = unpack<packed::RGB9E5, RGBf>(p);
+            const std::uint32_t q = pack<packed::RGB9E5>(c);
+            REQUIRE(unpack<packed::RGB9E5, RGBf>(q) == c);
+        }
+    }
+
+    SECTION("batch") {
+        std::vector<RGBf> in;
+        const std::vector<float> s = samples();
+        for (std::size_t i=0; i+2<s.size(); i+=3)
+            in.emplace_back(s[i], s[i+1], s[i+2]);
+
+        std::vector<std::uint32_t> p (in.size());
+        std::vector<RGBf> out (in.size());
+        pack<packed::RGB9E5>(in.data(), in.data()+in.size(), p.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(p[i] == pack<packed::RGB9E5>(in[i]));
+        unpack<packed::RGB9E5>(p.data(), p.data()+p.size(), out.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(out[i] == (unpack<packed::RGB9E5, RGBf>(p[i])));
+
+        pack<packed::R11G11B10F>(in.data(), in.data()+in.size(), p.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(p[i] == pack<packed::R11G11B10F>(in[i]));
+
+        std::vector<std::uint16_t> p16 (in.size());
+        pack<packed::RGB565>(in.data(), in.data()+in.size(), p16.data());
+        for (std::size_t i=0; i!=in.size(); ++i)
+            REQUIRE(p16[i] == pack<packed::RGB565>(in[i]));
+    }
+
+    SECTION("images") {
+        std::vector<RGBAf> in (4*3, RGBAf(0.25f, 0.5f, 0.75f, 1));
+        std::vector<std::uint32_t> p (4*3, 7);
+        pack<packed::RGB10A2>(ImageView<RGBAf const>(in.data(), 3, 3, 4),
+                              ImageView<std::uint32_t>(p.data(), 3, 3, 4));
+        const std::uint32_t expected = pack<packed::RGB10A2>(in[0]);
+        for (int i=0; i!=12; ++i)
+            REQUIRE(p[i] == (i % 4 == 3 ? 7u : expected));
+
+        std::vector<RGBAf> out (9);
+        unpack<packed::RGB10A2>(ImageView<std::uint32_t const>(p.data(), 3, 3, 4),
+                                image_view(out.data(), 3, 3));
+        for (auto const &c : out)
+            REQUIRE(c == (unpack<packed::RGB10A2, RGBAf>(expected)));
+
+        REQUIRE_THROWS_AS(unpack<packed::RGB10A2>(image_view(p.data(), 3, 4),
+                                                  image_view(out.data(), 3, 3)),
+                          std::logic_error);
+    }
+}
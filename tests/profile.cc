@@ -0,0 +1,114 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/profile.hh"
+#include "tukan/LUT3D.hh"
+#include "tukan/half.hh"
+#include "tukan/packed.hh"
+#include "tukan/LinearRGB.hh"
+#include "catch.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+
+    profile::Record find (std::vector<profile::Record> const &records, std::string const &name,
+                          std::string const &kernel)
+    {
+        for (auto const &r : records)
+            if (r.name == name && r.kernel == kernel)
+                return r;
+        return profile::Record();
+    }
+
+    void user_operation (std::size_t pixels) {
+        static const profile::Site site ("user operation", "scalar");
+        const profile::Scope scope (site, pixels, 16 * pixels);
+    }
+}
+
+
+TEST_CASE("tukan/profile", "profile tests")
+{
+    SECTION("Nothing is counted while profiling is off") {
+        REQUIRE(!profile::enabled());
+        profile::reset();
+        std::vector<float> in (100, 0.5f);
+        std::vector<half> out (100);
+        pack_half(in.data(), in.data() + in.size(), out.data());
+        user_operation(10);
+        REQUIRE(profile::snapshot().empty());
+    }
+
+    SECTION("Calls, pixels and bytes per site and kernel") {
+        profile::reset();
+        profile::enable();
+        REQUIRE(profile::enabled());
+
+        std::vector<float> in (100, 0.5f), back (100);
+        std::vector<half> h (100);
+        pack_half(in.data(), in.data() + in.size(), h.data());
+        pack_half(in.data(), in.data() + 50, h.data());
+        unpack_half(h.data(), h.data() + h.size(), back.data());
+
+        using Color = LinearRGB<float,sRGB>;
+        const LUT3D<float,17> lut;
+        std::vector<Color> colors (64, Color(0.25f, 0.5f, 0.75f)), mapped (64);
+        apply(lut, colors.data(), colors.data() + 64, mapped.data(), Interpolation::tetrahedral);
+
+        std::vector<std::uint32_t> packed (64);
+        pack<packed::RGB9E5>(colors.data(), colors.data() + 64, packed.data());
+        profile::enable(false);
+        pack<packed::RGB9E5>(colors.data(), colors.data() + 64, packed.data());
+
+        const auto records = profile::snapshot();
+        const auto p = find(records, "pack_half", tukan::detail::half_kernel);
+        REQUIRE(p.calls == 2);
+        REQUIRE(p.pixels == 150);
+        REQUIRE(p.bytes == 150 * (sizeof(float) + sizeof(half)));
+        REQUIRE(p.isa == profile::isa());
+
+        const auto u = find(records, "unpack_half", p.kernel);
+        REQUIRE(u.calls == 1);
+        REQUIRE(u.pixels == 100);
+
+        const auto t = find(records, "LUT3D apply", "tetrahedral");
+        REQUIRE(t.calls == 1);
+        REQUIRE(t.pixels == 64);
+        REQUIRE(t.bytes == 64 * 2 * sizeof(Color));
+        REQUIRE(find(records, "LUT3D apply", "trilinear").calls == 0);
+
+        const auto e = find(records, "pack", "RGB9E5");
+        REQUIRE(e.calls == 1);
+        REQUIRE(e.bytes == 64 * (sizeof(Color) + 4));
+
+        profile::reset();
+        REQUIRE(profile::snapshot().empty());
+    }
+
+    SECTION("Counts of running and exited threads are summed") {
+        profile::reset();
+        profile::enable();
+
+        std::vector<std::thread> threads;
+        for (int t=0; t!=4; ++t)
+            threads.emplace_back([] {
+                for (int i=0; i!=1000; ++i)
+                    user_operation(3);
+            });
+        for (auto &t : threads)
+            t.join();
+        user_operation(5);
+
+        const auto r = find(profile::snapshot(), "user operation", "scalar");
+        profile::enable(false);
+        REQUIRE(r.calls == 4001);
+        REQUIRE(r.pixels == 12005);
+        REQUIRE(r.bytes == 16 * 12005);
+        REQUIRE(r.isa == profile::isa());
+        profile::reset();
+    }
+}
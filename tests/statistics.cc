@@ -0,0 +1,211 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/statistics.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGBSpace.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Color = LinearRGB<float,sRGB>;
+
+    std::vector<Color> test_image (std::size_t w, std::size_t h) {
+        std::vector<Color> ret;
+        for (std::size_t y=0; y!=h; ++y)
+            for (std::size_t x=0; x!=w; ++x)
+                ret.emplace_back(float(x) / w, float(y) / h, float((x*7 + y*3) % 11) / 10);
+        return ret;
+    }
+
+    double luminance_of (Color c) {
+        return static_cast<XYZ<float>>(c).Y;
+    }
+}
+
+
+TEST_CASE("tukan/statistics", "statistics tests")
+{
+    SECTION("Min, max, means and log-average against a plain loop") {
+        const std::size_t w = 37, h = 53;
+        const auto pixels = test_image(w, h);
+        const auto s = statistics(image_view(pixels.data(), w, h));
+
+        double min[4], max[4], sum[4] = {0, 0, 0, 0}, log_sum = 0;
+        std::fill(min, min + 4, 1e30);
+        std::fill(max, max + 4, -1e30);
+        for (Color c : pixels) {
+            const double v[4] = {c.r, c.g, c.b, luminance_of(c)};
+            for (int k=0; k!=4; ++k) {
+                min[k] = std::min(min[k], v[k]);
+                max[k] = std::max(max[k], v[k]);
+                sum[k] += v[k];
+            }
+            log_sum += std::log2(1e-4 + std::max(v[3], 0.0));
+        }
+
+        REQUIRE(s.pixels == w*h);
+        for (int k=0; k!=3; ++k) {
+            REQUIRE(s.min[k] == min[k]);
+            REQUIRE(s.max[k] == max[k]);
+            REQUIRE(s.mean[k] == Approx(sum[k] / (w*h)).epsilon(1e-6));
+        }
+        REQUIRE(s.min_luminance == Approx(min[3]).epsilon(1e-5));
+        REQUIRE(s.max_luminance == Approx(max[3]).epsilon(1e-5));
+        REQUIRE(s.mean_luminance == Approx(sum[3] / (w*h)).epsilon(1e-5));
+        REQUIRE(s.log_average_luminance == Approx(std::exp2(log_sum / (w*h))).epsilon(1e-5));
+    }
+
+    SECTION("Strided views, const pixels, double and empty images") {
+        const std::size_t w = 20, h = 10;
+        const auto pixels = test_image(w, h);
+
+        // The right half, through a view with stride.
+        const ImageView<Color const> half (pixels.data() + 10, 10, h, w);
+        std::vector<Color> copy;
+        for (std::size_t y=0; y!=h; ++y)
+            copy.insert(copy.end(), half.row(y), half.row(y) + 10);
+        const auto a = statistics(half), b = statistics(image_view(copy.data(), 10, h));
+        REQUIRE(a.min[0] == b.min[0]);
+        REQUIRE(a.mean[1] == b.mean[1]);
+        REQUIRE(a.log_average_luminance == b.log_average_luminance);
+        REQUIRE(a.min[0] == 0.5f);
+
+        std::vector<LinearRGB<double,sRGB>> d;
+        for (Color c : pixels)
+            d.emplace_back(c.r, c.g, c.b);
+        const auto s = statistics(image_view(d.data(), w, h)),
+                   f = statistics(image_view(pixels.data(), w, h));
+        REQUIRE(s.max[2] == f.max[2]);
+        REQUIRE(s.mean_luminance == Approx(f.mean_luminance).epsilon(1e-6));
+
+        const auto e = statistics(ImageView<Color>());
+        REQUIRE(e.pixels == 0);
+        REQUIRE(e.mean_luminance == 0);
+    }
+
+    SECTION("Bins, edges, percentiles and errors") {
+        Histogram lin (10, 0, 1);
+        REQUIRE(lin.bins() == 10);
+        REQUIRE(lin.edge(0) == 0);
+        REQUIRE(lin.edge(10) == 1);
+        REQUIRE(lin.edge(5) == Approx(0.5));
+        for (int i=0; i!=100; ++i)
+            lin.add((i + 0.5) / 100);
+        lin.add(-1);
+        lin.add(2);
+        lin.add(1);
+        REQUIRE(lin.below == 1);
+        REQUIRE(lin.above == 2);
+        REQUIRE(lin.total() == 103);
+        for (unsigned i=0; i!=10; ++i)
+            REQUIRE(lin.counts[i] == 10);
+        REQUIRE(lin.percentile(0) == 0);
+        REQUIRE(lin.percentile(1) == 1);
+        REQUIRE(lin.percentile(51.0 / 103) == Approx(0.5));     // 1 below, 50 in bins 0-4
+        REQUIRE(lin.percentile(56.0 / 103) == Approx(0.55));
+
+        Histogram stops (8, 1.0/16, 16, Histogram::Scale::log2);
+        REQUIRE(stops.edge(4) == Approx(1));
+        stops.add(1.5);
+        stops.add(0);
+        stops.add(std::numeric_limits<double>::quiet_NaN());
+        REQUIRE(stops.counts[4] == 1);
+        REQUIRE(stops.below == 2);
+        REQUIRE(stops.percentile(1) == Approx(stops.edge(5)));  // the top of the last bin used
+        REQUIRE(std::isnan(Histogram(4, 0, 1).percentile(0.5)));
+
+        // Far out of range and NaN, in both scales.
+        Histogram far (16, 0, 1);
+        for (double v : {-5.0, -1e30, -std::numeric_limits<double>::infinity(),
+                         std::numeric_limits<double>::quiet_NaN()})
+            far.add(v);
+        far.add(1e30);
+        far.add(std::numeric_limits<double>::infinity());
+        REQUIRE(far.below == 4);
+        REQUIRE(far.above == 2);
+        REQUIRE(far.total() == 6);
+        Histogram far_stops (8, 1.0/16, 16, Histogram::Scale::log2);
+        far_stops.add(-5);
+        far_stops.add(1e-30);
+        far_stops.add(1e30);
+        REQUIRE(far_stops.below == 2);
+        REQUIRE(far_stops.above == 1);
+
+        REQUIRE_THROWS_AS(Histogram(0, 0, 1), std::logic_error);
+        REQUIRE_THROWS_AS(Histogram(4, 1, 1), std::logic_error);
+        REQUIRE_THROWS_AS(Histogram(4, 0, 1, Histogram::Scale::log2), std::logic_error);
+        REQUIRE_THROWS_AS(lin += stops, std::logic_error);
+
+        Histogram sum (10, 0, 1);
+        sum += lin;
+        sum += lin;
+        REQUIRE(sum.counts[3] == 20);
+        REQUIRE(sum.above == 4);
+    }
+
+    SECTION("Image histograms match adding each pixel") {
+        const std::size_t w = 41, h = 67;
+        const auto pixels = test_image(w, h);
+        const Histogram channels (16, 0, 1),
+                        luminance (12, 1.0/64, 1, Histogram::Scale::log2);
+        const auto hs = histograms(image_view(pixels.data(), w, h), channels, luminance);
+
+        Histogram r = channels, g = channels, b = channels, y = luminance;
+        for (Color c : pixels) {
+            r.add(c.r);
+            g.add(c.g);
+            b.add(c.b);
+            y.add(luminance_of(c));
+        }
+        REQUIRE(hs.r.counts == r.counts);
+        REQUIRE(hs.g.counts == g.counts);
+        REQUIRE(hs.b.counts == b.counts);
+        REQUIRE(hs.b.above == b.above);
+        REQUIRE(hs.luminance.total() == w*h);
+        // Luminance may fall differently on bin edges, from the rounding of its sum.
+        std::uint64_t moved = 0;
+        for (unsigned i=0; i!=y.bins(); ++i)
+            moved += std::max(hs.luminance.counts[i], y.counts[i])
+                   - std::min(hs.luminance.counts[i], y.counts[i]);
+        REQUIRE(moved <= 4);
+
+        // Counts add to those already in the given histograms.
+        const auto twice = histograms(image_view(pixels.data(), w, h), hs.r, hs.luminance);
+        REQUIRE(twice.r.counts[5] == 2 * hs.r.counts[5]);
+        REQUIRE(twice.luminance.total() == 2*w*h);
+
+        // Percentiles are within a bin of the exact ones.
+        std::vector<float> reds;
+        for (Color c : pixels)
+            reds.push_back(c.r);
+        std::sort(reds.begin(), reds.end());
+        REQUIRE(std::fabs(hs.r.percentile(0.9) - reds[reds.size() * 9 / 10]) <= 1.0/16);
+
+        // Negative, huge and NaN channels, through the rows.
+        std::vector<Color> odd;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        for (int i=0; i!=40; ++i)
+            odd.emplace_back(i % 4 == 0 ? -5.f : i % 4 == 1 ? nan : i % 4 == 2 ? 1e30f : 0.5f,
+                             -1e30f, i * 0.025f);
+        const auto ho = histograms(image_view(odd.data(), 8, 5), channels, luminance);
+        Histogram ro = channels, go = channels, bo = channels;
+        for (Color c : odd) {
+            ro.add(c.r);
+            go.add(c.g);
+            bo.add(c.b);
+        }
+        REQUIRE(ho.r.below == 20);
+        REQUIRE(ho.r.above == 10);
+        REQUIRE(ho.r.counts == ro.counts);
+        REQUIRE(ho.r.below == ro.below);
+        REQUIRE(ho.g.below == 40);
+        REQUIRE(ho.g.below == go.below);
+        REQUIRE(ho.b.counts == bo.counts);
+        REQUIRE(ho.luminance.total() == 40);
+    }
+}
@@ -0,0 +1,194 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/tonemap.hh"
+#include "tukan/LinearRGB.hh"
+#include "tukan/RGB.hh"
+#include "tukan/RGBSpace.hh"
+#include "tukan/XYZ.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using Linear = LinearRGB<float,sRGB>;
+    using Code8  = RGB<unorm8,sRGB>;
+
+    template <typename Operator>
+    float grey (Operator const &op, float v) {
+        return tonemap(Linear(v, v, v), op).g;
+    }
+
+    // HDR values from 0 to about 64, with some saturated colours.
+    std::vector<Linear> hdr_image (std::size_t w, std::size_t h) {
+        std::vector<Linear> ret;
+        for (std::size_t y=0; y!=h; ++y)
+            for (std::size_t x=0; x!=w; ++x) {
+                const float v = std::exp2(float(x) / w * 12 - 6);
+                ret.emplace_back(v, v * float(y % 3) / 2, v * float(y % 5) / 4);
+            }
+        return ret;
+    }
+
+    // Monotonic from 0 up to 'hi', within [0..1].
+    template <typename Operator>
+    void check_curve (Operator const &op, float hi) {
+        float prev = grey(op, 0);
+        REQUIRE(prev >= 0);
+        REQUIRE(prev < 1e-3f);
+        for (float x = 1/1024.f; x <= hi; x *= 1.03f) {
+            const float v = grey(op, x);
+            REQUIRE(v >= prev);
+            REQUIRE(v <= 1.0001f);
+            prev = v;
+        }
+        REQUIRE(prev > 0.9f);
+    }
+}
+
+
+TEST_CASE("tukan/tonemap", "tonemap tests")
+{
+    SECTION("Values of the curves") {
+        REQUIRE(grey(Reinhard(), 1) == Approx(0.5));
+        REQUIRE(grey(Reinhard(), 3) == Approx(0.75));
+        REQUIRE(grey(Reinhard(4), 4) == Approx(1));
+        REQUIRE(grey(Reinhard(4, Reinhard::Mode::per_channel), 4) == Approx(1));
+
+        // On the luminance, the ratios of the channels stay.
+        const Linear c (4, 2, 1);
+        const Linear l = tonemap(c, Reinhard()),
+                     p = tonemap(c, Reinhard(std::numeric_limits<double>::infinity(),
+                                             Reinhard::Mode::per_channel));
+        REQUIRE(l.r / l.g == Approx(2));
+        REQUIRE(l.g / l.b == Approx(2));
+        REQUIRE(luminance(l) == Approx(luminance(c) / (1 + luminance(c))));
+        REQUIRE(p.r == Approx(0.8));
+        REQUIRE(p.b == Approx(0.5));
+        REQUIRE(tonemap(Linear(-1, 0, 0), Reinhard()).r == 0);
+        // ... so a saturated colour keeps a channel above 1, which encoding clamps.
+        const Linear red = tonemap(Linear(8, 0, 0), Reinhard());
+        REQUIRE(red.r > 1);
+        REQUIRE(luminance(red) < 1);
+        Linear red_in (8, 0, 0);
+        Code8 code;
+        tonemap_encode(image_view(&red_in, 1, 1), image_view(&code, 1, 1), Reinhard());
+        REQUIRE(code.r.code() == 255);
+
+        REQUIRE(grey(ACESFilmic(), 1) == Approx(2.54 / 3.16));
+        REQUIRE(grey(ACESFilmic(), 100) == 1);
+
+        REQUIRE(grey(Hable(), 0) == Approx(0).margin(1e-6));
+        REQUIRE(grey(Hable(), 11.2f) == Approx(1));
+        Hable soft;
+        soft.white = 4;
+        REQUIRE(grey(soft, 4) == Approx(1));
+
+        // Middle grey lands near the middle of the display range.
+        const float agx = grey(AgX(), 0.18f);
+        REQUIRE(agx > 0.1f);
+        REQUIRE(agx < 0.3f);
+
+        check_curve(Reinhard(), 1024);
+        check_curve(ACESFilmic(), 1024);
+        check_curve(Hable(), 11.2f);
+        check_curve(AgX(), 1024);
+
+        // float (with the approximations) and double agree.
+        for (float v : {0.01f, 0.18f, 1.f, 5.f}) {
+            const LinearRGB<double,sRGB> d (v, v/2, v/4);
+            const Linear f (v, v/2, v/4);
+            REQUIRE(tonemap(f, AgX()).r == Approx(tonemap(d, AgX()).r).epsilon(1e-4));
+            REQUIRE(tonemap(f, AgX()).b == Approx(tonemap(d, AgX()).b).epsilon(1e-4));
+            REQUIRE(tonemap(f, Hable(), 2).g == Approx(tonemap(d, Hable(), 2).g).epsilon(1e-5));
+        }
+    }
+
+    SECTION("Pointer ranges and images match single colours") {
+        const std::size_t w = 29, h = 7;
+        const auto img = hdr_image(w, h);
+        std::vector<Linear> out (img.size());
+
+        tonemap(img.data(), img.data() + img.size(), out.data(), AgX(), 0.5);
+        for (std::size_t i=0; i!=img.size(); ++i) {
+            const Linear ref = tonemap(img[i], AgX(), 0.5);
+            REQUIRE(out[i].r == Approx(ref.r).epsilon(1e-5));
+            REQUIRE(out[i].b == Approx(ref.b).epsilon(1e-5));
+        }
+
+        tonemap(image_view(img.data(), w, h), image_view(out.data(), w, h), Reinhard(8));
+        for (std::size_t i=0; i!=img.size(); ++i)
+            REQUIRE(out[i].g == Approx(tonemap(img[i], Reinhard(8)).g).epsilon(1e-6));
+
+        std::vector<LinearRGB<double,sRGB>> d (img.size()), dout (img.size());
+        for (std::size_t i=0; i!=img.size(); ++i)
+            d[i] = LinearRGB<double,sRGB>(img[i].r, img[i].g, img[i].b);
+        tonemap(d.data(), d.data() + d.size(), dout.data(), ACESFilmic(), 0.6);
+        for (std::size_t i=0; i!=d.size(); ++i)
+            REQUIRE(dout[i].r == Approx(tonemap(d[i], ACESFilmic(), 0.6).r).epsilon(1e-12));
+
+        REQUIRE_THROWS_AS(tonemap(image_view(img.data(), w, h), image_view(out.data(), h, w),
+                                  Hable()),
+                          std::logic_error);
+    }
+
+    SECTION("Fused tone mapping and encoding") {
+        const std::size_t w = 67, h = 9;
+        const auto img = hdr_image(w, h);
+
+        // As tone mapping, then encoding.
+        for (Dither method : {Dither::none, Dither::bayer, Dither::blue_noise,
+                              Dither::floyd_steinberg}) {
+            std::vector<Linear> mapped (img.size());
+            tonemap(img.data(), img.data() + img.size(), mapped.data(), Hable(), 2);
+            std::vector<Code8> ref (img.size()), fused (img.size());
+            encode(image_view(mapped.data(), w, h), image_view(ref.data(), w, h), method);
+            tonemap_encode(image_view(img.data(), w, h), image_view(fused.data(), w, h), Hable(), 2,
+                           method);
+            for (std::size_t i=0; i!=img.size(); ++i) {
+                REQUIRE(fused[i].r.code() == ref[i].r.code());
+                REQUIRE(fused[i].b.code() == ref[i].b.code());
+            }
+        }
+
+        // From another space: converted before the operator, in the output's space.
+        std::vector<LinearRGB<float,AdobeRGB>> adobe;
+        std::vector<Linear> converted;
+        for (Linear c : img) {
+            const LinearRGB<float,AdobeRGB> a (c.r, c.g, c.b);
+            adobe.push_back(a);
+            converted.push_back(tonemap(Linear(static_cast<XYZ<float>>(a)), Reinhard()));
+        }
+        std::vector<Code8> ref (img.size()), fused (img.size());
+        encode(image_view(converted.data(), w, h), image_view(ref.data(), w, h), Dither::none);
+        tonemap_encode(image_view(adobe.data(), w, h), image_view(fused.data(), w, h), Reinhard());
+        for (std::size_t i=0; i!=img.size(); ++i) {
+            REQUIRE(std::abs(int(fused[i].r.code()) - int(ref[i].r.code())) <= 1);
+            REQUIRE(std::abs(int(fused[i].g.code()) - int(ref[i].g.code())) <= 1);
+            REQUIRE(std::abs(int(fused[i].b.code()) - int(ref[i].b.code())) <= 1);
+        }
+
+        // A window of the image, into a padded output.
+        std::vector<Code8> padded (10*4);
+        const ImageView<Linear const> window (img.data() + 3, 8, 4, w);
+        tonemap_encode(window, ImageView<Code8>(padded.data(), 8, 4, 10), ACESFilmic());
+        std::vector<Linear> copy;
+        for (std::size_t y=0; y!=4; ++y)
+            copy.insert(copy.end(), window.row(y), window.row(y) + 8);
+        std::vector<Code8> dense (8*4);
+        tonemap_encode(image_view(copy.data(), 8, 4), image_view(dense.data(), 8, 4), ACESFilmic());
+        for (std::size_t y=0; y!=4; ++y) {
+            for (std::size_t x=0; x!=8; ++x)
+                REQUIRE(padded[y*10 + x].g.code() == dense[y*8 + x].g.code());
+            REQUIRE(padded[y*10 + 8].g.code() == 0);
+        }
+
+        REQUIRE_THROWS_AS(tonemap_encode(window, image_view(padded.data(), 10, 4), AgX()),
+                          std::logic_error);
+    }
+}
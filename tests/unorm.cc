@@ -0,0 +1,145 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+#include "tukan/unorm.hh"
+#include "catch.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+    template <unsigned B>
+    unsigned reference (float f) {
+        const double v = f > 0 ? (f < 1 ? f : 1) : 0;
+        return unsigned(std::floor(v * ((1u<<B)-1) + 0.5));
+    }
+
+    template <unsigned B>
+    void check_quantize () {
+        using namespace tukan;
+        // Every 97th float in [0..1], which includes many just around the rounding boundaries.
+        std::vector<float> f;
+        for (std::uint32_t bits=0; bits<=0x3f800000u; bits+=97) {
+            float x;
+            std::memcpy(&x, &bits, sizeof x);
+            f.push_back(x);
+        }
+        // The boundaries themselves, and their neighbours.
+        for (unsigned k=0; k!=(1u<<B)-1; ++k) {
+            const float t = float((k + 0.5) / ((1u<<B)-1));
+            f.push_back(t);
+            f.push_back(std::nextafter(t, 0.f));
+            f.push_back(std::nextafter(t, 1.f));
+        }
+
+        std::vector<unorm<B>> q (f.size());
+        quantize(f.data(), f.data()+f.size(), q.data());
+        std::size_t wrong = 0;
+        for (std::size_t i=0; i!=f.size(); ++i)
+            wrong += q[i].code() != reference<B>(f[i]) || unorm<B>(f[i]).code() != q[i].code();
+        REQUIRE(wrong == 0);
+
+        // Round trip.
+        for (unsigned c=0; c<=unorm<B>::max_code; ++c)
+            wrong += unorm<B>(float(unorm<B>::from_code(c))).code() != c;
+        REQUIRE(wrong == 0);
+    }
+}
+
+TEST_CASE("tukan/unorm", "unorm tests")
+{
+    using namespace tukan;
+
+    SECTION("conversion") {
+        REQUIRE(sizeof(unorm8) == 1);
+        REQUIRE(sizeof(unorm10) == 2);
+        REQUIRE(sizeof(unorm16) == 2);
+        REQUIRE(unorm8::max_code == 255);
+        REQUIRE(unorm10::max_code == 1023);
+        REQUIRE(unorm16::max_code == 65535);
+
+        REQUIRE(unorm8(0.5f).code() == 128);
+        REQUIRE(unorm8(-1.0f).code() == 0);
+        REQUIRE(unorm8(2.0f).code() == 255);
+        REQUIRE(unorm8(std::numeric_limits<float>::quiet_NaN()).code() == 0);
+        REQUIRE(unorm8(std::numeric_limits<float>::infinity()).code() == 255);
+        REQUIRE(unorm16(1.0f).code() == 65535);
+        REQUIRE(float(unorm8::from_code(51)) == 0.2f);
+        REQUIRE(float(unorm10::from_code(1023)) == 1.0f);
+    }
+
+    SECTION("quantize") {
+        check_quantize<8>();
+        check_quantize<10>();
+        check_quantize<16>();
+    }
+
+    SECTION("dequantize") {
+        std::vector<unorm16> q;
+        for (unsigned c=0; c<=65535; c+=7)
+            q.push_back(unorm16::from_code(c));
+        std::vector<float> f (q.size());
+        dequantize(q.data(), q.data()+q.size(), f.data());
+        for (std::size_t i=0; i!=q.size(); ++i)
+            REQUIRE(f[i] == float(q[i].code()) / 65535);
+    }
+
+    SECTION("as value type of RGB") {
+        RGB<unorm8,sRGB> c (1.0f, 0.5f, 0);
+        REQUIRE(c.r.code() == 255);
+        REQUIRE(c.g.code() == 128);
+        REQUIRE(c.b.code() == 0);
+        REQUIRE((RGB<unorm8,sRGB>().r.code() == 0));
+        REQUIRE((std::is_same<RebindValueType<unorm16, RGB<unorm8,sRGB>>, RGB<unorm16,sRGB>>::value));
+    }
+
+    SECTION("decode, encode") {
+        const RGB<float,sRGB> ref (0.0f, 0.2f, 0.8f);
+        const LinearRGB<float,sRGB> lin = static_cast<LinearRGB<float,sRGB>>(ref);
+
+        const RGB<unorm8,sRGB> c8 (unorm8::from_code(0), unorm8::from_code(51), unorm8::from_code(204));
+        const LinearRGB<float,sRGB> d8 = decode(c8);
+        REQUIRE(rel_equal(d8, lin, 1e-6f));
+        REQUIRE(encode<unorm8>(d8) == c8);
+
+        const RGB<unorm16,sRGB> c16 = encode<unorm16>(lin);
+        REQUIRE(c16.g.code() == 13107);
+        REQUIRE(rel_equal(decode(c16), lin, 1e-6f));
+
+        // Batch over all codes.
+        std::vector<RGB<unorm8,sRGB>> codes;
+        for (unsigned i=0; i!=256; ++i)
+            codes.emplace_back(unorm8::from_code(i), unorm8::from_code(255-i),
+                               unorm8::from_code(i/2));
+        std::vector<LinearRGB<float,sRGB>> linear (codes.size());
+        decode(codes.data(), codes.data()+codes.size(), linear.data());
+        std::vector<RGB<unorm8,sRGB>> back (codes.size());
+        encode(linear.data(), linear.data()+linear.size(), back.data());
+        REQUIRE(back == codes);
+
+        for (unsigned i=0; i!=256; ++i) {
+            const double v = sRGB<double>().gamma.to_linear(i/255.0);
+            REQUIRE(linear[i].r == static_cast<float>(v));
+        }
+
+        // Images.
+        std::vector<LinearRGB<float,sRGB>> linear2 (codes.size());
+        decode(image_view(codes.data(), 16, 16), image_view(linear2.data(), 16, 16));
+        REQUIRE(linear2 == linear);
+        std::vector<RGB<unorm8,sRGB>> back2 (codes.size());
+        encode(image_view(linear2.data(), 16, 16), image_view(back2.data(), 16, 16));
+        REQUIRE(back2 == codes);
+        REQUIRE_THROWS_AS(encode(image_view(linear2.data(), 16, 16), image_view(back2.data(), 8, 32)),
+                          std::logic_error);
+    }
+
+    SECTION("10 bit packing") {
+        const RGB<unorm10,sRGB> c (unorm10::from_code(1), unorm10::from_code(512),
+                                   unorm10::from_code(1023));
+        const std::uint32_t p = pack_rgb10(c);
+        REQUIRE(p == (1u | 512u << 10 | 1023u << 20));
+        REQUIRE(unpack_rgb10<sRGB>(p) == c);
+    }
+}
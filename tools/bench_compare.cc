@@ -0,0 +1,352 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+// Runs the benchmark suite (benchmarks/, 'scons bench') several times and compares the result
+// against a baseline, failing if any kernel got slower by more than a threshold.
+//
+// Usage: bench_compare [options] [-- <arguments for the benchmark>]
+//
+//   --bench=PATH        the benchmark executable, default ./tukan_bench
+//   --runs=N            number of runs of the suite, default 5
+//   --threshold=PCT     allowed slowdown in percent, default 5
+//   --baseline=FILE     default benchmarks/baseline.json
+//   --results=FILE      compare this result file instead of running the suite; repeatable
+//   --update            write the results as the new baseline instead of comparing
+//
+// Each kernel's ns/pixel is averaged over all runs, with a 95% confidence interval from
+// Student's t distribution over the runs. Repetitions within a run are averaged first and
+// count as one sample: they share the process's code and heap layout and clock scaling, so
+// they are not independent, and treating them as samples would make the interval too narrow.
+//
+// A kernel regresses if its mean is more than the threshold above the baseline's, and the
+// confidence intervals do not overlap; a slowdown above the threshold whose intervals overlap
+// is reported as noisy, but does not fail, as more runs are needed to tell. The exit status
+// is 1 if any kernel regressed, 2 on errors.
+//
+// The baseline has the layout of the benchmark's own JSON output, with the entries of all
+// runs; it is only comparable to results from the same machine and build flags.
+//
+// Example: bench_compare --update --runs=10             # on the reference machine, then commit
+//          bench_compare --threshold=3 -- --filter=^cmath/
+
+#include "json.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tools;
+
+    struct Options {
+        std::string bench = "./tukan_bench", baseline = "benchmarks/baseline.json", bench_args;
+        unsigned runs = 5;
+        double threshold = 5;
+        std::vector<std::string> results;
+        bool update = false;
+    };
+
+    struct Stats {
+        std::size_t n = 0;
+        double mean = 0, ci = 0;   // ci: half width of the 95% interval
+    };
+
+
+    int usage() {
+        std::cerr << "usage: bench_compare [--bench=PATH] [--runs=N] [--threshold=PCT] "
+                     "[--baseline=FILE] [--results=FILE]... [--update] [-- <benchmark args>]\n";
+        return 2;
+    }
+
+    // For the POSIX shell that std::system runs.
+    std::string quote (std::string const &arg) {
+        std::string ret = "'";
+        for (char c : arg)
+            ret += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        return ret + "'";
+    }
+
+    bool option (std::string const &arg, char const *name, std::string &value) {
+        const std::string prefix = std::string("--") + name + "=";
+        if (arg.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        value = arg.substr(prefix.size());
+        return true;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Statistics
+    //----------------------------------------------------------------------------------------------
+    // Two-sided 95% quantiles of Student's t distribution for 1..30 degrees of freedom.
+    double t95 (std::size_t dof) {
+        static const double t[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                   2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                   2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                   2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        return dof == 0 ? 0 : dof <= 30 ? t[dof-1] : 1.960;
+    }
+
+    Stats stats (std::vector<double> const &samples) {
+        Stats s;
+        s.n = samples.size();
+        if (s.n == 0)
+            return s;
+        for (double x : samples)
+            s.mean += x;
+        s.mean /= s.n;
+        if (s.n > 1) {
+            double var = 0;
+            for (double x : samples)
+                var += (x - s.mean) * (x - s.mean);
+            var /= s.n - 1;
+            s.ci = t95(s.n - 1) * std::sqrt(var / s.n);
+        }
+        return s;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Results
+    //----------------------------------------------------------------------------------------------
+    struct Results {
+        Json context;
+        std::vector<Json> entries;                          // as in the files
+        // ns/pixel by kernel, then by run (the process it was measured in).
+        std::map<std::string, std::map<std::size_t, std::vector<double>>> samples;
+        std::size_t runs = 0;
+    };
+
+    void add_file (Results &results, std::string const &path) {
+        std::ifstream ifs (path);
+        if (!ifs)
+            throw std::runtime_error("cannot read '" + path + "'");
+        const std::string text ((std::istreambuf_iterator<char>(ifs)),
+                                std::istreambuf_iterator<char>());
+        const Json root = JsonParser(text).parse();
+        Json const *context = root.member("context"), *list = root.member("benchmarks");
+        if (!list || list->type != Json::array)
+            throw std::runtime_error("'" + path + "' has no \"benchmarks\" array");
+        if (context && results.context.type == Json::null)
+            results.context = *context;
+
+        // A file is one run, unless its entries name their runs, as those of a baseline do;
+        // the runs are renumbered after those read before.
+        std::size_t runs = 1;
+        for (Json const &e : list->elements) {
+            Json const *name = e.member("name"), *ns = e.member("ns_per_pixel"),
+                       *run = e.member("run");
+            if (!name || name->type != Json::str || !ns || ns->type != Json::num)
+                throw std::runtime_error("'" + path + "': entries need a name and ns_per_pixel");
+            if (run && (run->type != Json::num || !(run->number >= 0 && run->number < 1e6)))
+                throw std::runtime_error("'" + path + "': invalid run of an entry");
+            const std::size_t r = run ? std::size_t(run->number) : 0;
+            runs = std::max(runs, r + 1);
+            results.samples[name->string][results.runs + r].push_back(ns->number);
+
+            Json entry = e;
+            Json number;
+            number.type = Json::num;
+            number.number = double(results.runs + r);
+            auto it = std::find_if(entry.members.begin(), entry.members.end(),
+                                   [](std::pair<std::string, Json> const &m) {
+                                       return m.first == "run"; });
+            if (it == entry.members.end())
+                entry.members.emplace_back("run", number);
+            else
+                it->second = number;
+            results.entries.push_back(entry);
+        }
+        results.runs += runs;
+    }
+
+    // The mean of each run of a kernel.
+    std::vector<double> run_means (std::map<std::size_t, std::vector<double>> const &runs) {
+        std::vector<double> ret;
+        for (auto const &r : runs) {
+            double sum = 0;
+            for (double x : r.second)
+                sum += x;
+            ret.push_back(sum / r.second.size());
+        }
+        return ret;
+    }
+
+    void write_string (std::ostream &os, std::string const &s) {
+        os << '"';
+        for (char c : s)
+            os << (c == '"' || c == '\\' ? "\\" : "") << c;
+        os << '"';
+    }
+
+    void write_json (std::ostream &os, Json const &v) {
+        switch (v.type) {
+        case Json::null:    os << "null"; break;
+        case Json::boolean: os << (v.number ? "true" : "false"); break;
+        case Json::num:     os << v.number; break;
+        case Json::str:     write_string(os, v.string); break;
+        case Json::array:
+            os << '[';
+            for (std::size_t i=0; i!=v.elements.size(); ++i) {
+                os << (i ? ", " : "");
+                write_json(os, v.elements[i]);
+            }
+            os << ']';
+            break;
+        case Json::object:
+            os << '{';
+            for (std::size_t i=0; i!=v.members.size(); ++i) {
+                os << (i ? ", " : "");
+                write_string(os, v.members[i].first);
+                os << ": ";
+                write_json(os, v.members[i].second);
+            }
+            os << '}';
+            break;
+        }
+    }
+
+    void write_baseline (std::string const &path, Results const &results) {
+        std::ofstream os (path);
+        os.precision(10);
+        os << "{\n  \"context\": ";
+        Json context = results.context, count;
+        context.type = Json::object;
+        count.type = Json::num;
+        count.number = double(results.runs);
+        context.members.emplace_back("runs", count);
+        write_json(os, context);
+        os << ",\n  \"benchmarks\": [";
+        for (std::size_t i=0; i!=results.entries.size(); ++i) {
+            os << (i ? "," : "") << "\n    ";
+            write_json(os, results.entries[i]);
+        }
+        os << "\n  ]\n}\n";
+        if (!os)
+            throw std::runtime_error("cannot write '" + path + "'");
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Running
+    //----------------------------------------------------------------------------------------------
+    Results run_suite (Options const &opts) {
+        Results results;
+        for (unsigned run=0; run!=opts.runs; ++run) {
+            const std::string json = "bench_compare_run" + std::to_string(run) + ".json";
+            const std::string command = quote(opts.bench) + " --json=" + quote(json) + " "
+                                      + opts.bench_args + " > /dev/null";
+            std::cerr << "run " << run+1 << "/" << opts.runs << ": " << command << std::endl;
+            const int status = std::system(command.c_str());
+            if (status != 0) {
+                std::remove(json.c_str());
+                throw std::runtime_error("benchmark failed with status " + std::to_string(status));
+            }
+            add_file(results, json);
+            std::remove(json.c_str());
+        }
+        return results;
+    }
+
+    std::string format_stats (Stats const &s) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%.3f +- %.3f", s.mean, s.ci);
+        return buffer;
+    }
+
+    // Prints the table, returns the number of regressions.
+    unsigned compare (Results const &baseline, Results const &current, double threshold) {
+        std::printf("%-44s %20s %20s %9s  %s\n", "kernel", "baseline ns/pixel",
+                    "current ns/pixel", "change", "status");
+        unsigned regressions = 0, noisy = 0, faster = 0;
+        for (auto const &k : current.samples) {
+            const Stats c = stats(run_means(k.second));
+            auto it = baseline.samples.find(k.first);
+            if (it == baseline.samples.end()) {
+                std::printf("%-44s %20s %20s %9s  %s\n", k.first.c_str(), "-",
+                            format_stats(c).c_str(), "", "new");
+                continue;
+            }
+            const Stats b = stats(run_means(it->second));
+            const double change = 100 * (c.mean - b.mean) / b.mean;
+            const bool disjoint = c.mean - c.ci > b.mean + b.ci || c.mean + c.ci < b.mean - b.ci;
+            char const *status = "ok";
+            if (change > threshold) {
+                status = disjoint ? "REGRESSION" : "noisy";
+                ++(disjoint ? regressions : noisy);
+            } else if (change < -threshold && disjoint) {
+                status = "faster";
+                ++faster;
+            }
+            std::printf("%-44s %20s %20s %+8.1f%%  %s\n", k.first.c_str(),
+                        format_stats(b).c_str(), format_stats(c).c_str(), change, status);
+        }
+        for (auto const &k : baseline.samples)
+            if (!current.samples.count(k.first))
+                std::printf("%-44s %20s %20s %9s  %s\n", k.first.c_str(),
+                            format_stats(stats(run_means(k.second))).c_str(), "-", "",
+                            "missing");
+
+        std::printf("\n%u regressions, %u noisy, %u faster (threshold %.1f%%)\n",
+                    regressions, noisy, faster, threshold);
+        return regressions;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    Options opts;
+    try {
+        for (int i=1; i<argc; ++i) {
+            const std::string arg = argv[i];
+            std::string v;
+            if (arg == "--") {
+                for (++i; i<argc; ++i)
+                    opts.bench_args += quote(argv[i]) + " ";
+            }
+            else if (option(arg, "bench", v))     opts.bench = v;
+            else if (option(arg, "runs", v))      opts.runs = std::stoul(v);
+            else if (option(arg, "threshold", v)) opts.threshold = std::stod(v);
+            else if (option(arg, "baseline", v))  opts.baseline = v;
+            else if (option(arg, "results", v))   opts.results.push_back(v);
+            else if (arg == "--update")           opts.update = true;
+            else return usage();
+        }
+    } catch (std::exception const &) {
+        return usage();
+    }
+    if (opts.runs == 0 || !(opts.threshold >= 0))
+        return usage();
+
+    try {
+        Results current;
+        if (opts.results.empty())
+            current = run_suite(opts);
+        for (auto const &path : opts.results)
+            add_file(current, path);
+
+        if (opts.update) {
+            write_baseline(opts.baseline, current);
+            std::cout << "wrote " << current.samples.size() << " kernels to "
+                      << opts.baseline << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        Results baseline;
+        add_file(baseline, opts.baseline);
+        return compare(baseline, current, opts.threshold) ? 1 : EXIT_SUCCESS;
+    } catch (std::exception const &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    }
+}
@@ -0,0 +1,147 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+#ifndef JSON_HH_INCLUDED_20261018
+#define JSON_HH_INCLUDED_20261018
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tools {
+
+    //----------------------------------------------------------------------------------------------
+    // JSON (only as much as the tools need)
+    //----------------------------------------------------------------------------------------------
+    struct Json {
+        enum Type { null, boolean, num, str, array, object } type = null;
+        double number = 0;
+        std::string string;
+        std::vector<Json> elements;
+        std::vector<std::pair<std::string, Json>> members;
+
+        Json const* member (std::string const &key) const {
+            for (auto const &m : members)
+                if (m.first == key)
+                    return &m.second;
+            return nullptr;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser (std::string const &text) : s(text) {}
+
+        Json parse() {
+            Json ret = value();
+            skip();
+            if (i != s.size())
+                fail("trailing characters");
+            return ret;
+        }
+
+    private:
+        std::string const &s;
+        std::size_t i = 0;
+
+        [[noreturn]] void fail (std::string const &what) const {
+            throw std::runtime_error("JSON: " + what + " at offset " + std::to_string(i));
+        }
+
+        void skip() {
+            while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])))
+                ++i;
+        }
+
+        void expect (char c) {
+            skip();
+            if (i >= s.size() || s[i] != c)
+                fail(std::string("expected '") + c + "'");
+            ++i;
+        }
+
+        bool literal (char const *word) {
+            const std::size_t n = std::strlen(word);
+            if (s.compare(i, n, word) != 0)
+                return false;
+            i += n;
+            return true;
+        }
+
+        std::string string() {
+            expect('"');
+            std::string ret;
+            while (i < s.size() && s[i] != '"') {
+                if (s[i] == '\\') {
+                    if (++i >= s.size()) break;
+                    switch (s[i]) {
+                    case 'n': ret += '\n'; break;
+                    case 't': ret += '\t'; break;
+                    case 'u': ret += '?'; i += 4; break; // Names are expected to be ASCII.
+                    default:  ret += s[i];
+                    }
+                    ++i;
+                } else {
+                    ret += s[i++];
+                }
+            }
+            expect('"');
+            return ret;
+        }
+
+        Json value() {
+            skip();
+            if (i >= s.size())
+                fail("unexpected end");
+
+            Json ret;
+            const char c = s[i];
+            if (c == '{') {
+                ret.type = Json::object;
+                ++i; skip();
+                if (i < s.size() && s[i] == '}') { ++i; return ret; }
+                do {
+                    std::string key = string();
+                    expect(':');
+                    ret.members.emplace_back(std::move(key), value());
+                    skip();
+                } while (i < s.size() && s[i] == ',' && ++i);
+                expect('}');
+            } else if (c == '[') {
+                ret.type = Json::array;
+                ++i; skip();
+                if (i < s.size() && s[i] == ']') { ++i; return ret; }
+                do {
+                    ret.elements.push_back(value());
+                    skip();
+                } while (i < s.size() && s[i] == ',' && ++i);
+                expect(']');
+            } else if (c == '"') {
+                ret.type = Json::str;
+                ret.string = string();
+            } else if (literal("true")) {
+                ret.type = Json::boolean;
+                ret.number = 1;
+            } else if (literal("false")) {
+                ret.type = Json::boolean;
+            } else if (literal("null")) {
+                ret.type = Json::null;
+            } else {
+                char *end = nullptr;
+                ret.type = Json::num;
+                ret.number = std::strtod(s.c_str() + i, &end);
+                if (end == s.c_str() + i)
+                    fail("unexpected character");
+                i = end - s.c_str();
+            }
+            return ret;
+        }
+    };
+
+}
+
+#endif // JSON_HH_INCLUDED_20261018
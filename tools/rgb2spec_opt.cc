@@ -0,0 +1,82 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+// Offline generator for RGB2Spec coefficient tables (see tukan/future/RGB2Spec.hh).
+//
+// Usage: rgb2spec_opt <space> <resolution> <output-file>
+//
+// Example: rgb2spec_opt sRGB 64 srgb.rgb2spec
+
+#include "tukan/future/RGB2Spec.hh"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+namespace {
+    using tukan::future::RGB2SpecTable;
+    using tukan::future::optimize_rgb2spec_table;
+
+    struct Entry {
+        char const *name;
+        RGB2SpecTable (*optimize)(std::size_t);
+    };
+
+    const Entry spaces[] = {
+        {"AppleRGB",      &optimize_rgb2spec_table<tukan::AppleRGB>},
+        {"AdobeRGB",      &optimize_rgb2spec_table<tukan::AdobeRGB>},
+        {"BestRGB",       &optimize_rgb2spec_table<tukan::BestRGB>},
+        {"BetaRGB",       &optimize_rgb2spec_table<tukan::BetaRGB>},
+        {"BruceRGB",      &optimize_rgb2spec_table<tukan::BruceRGB>},
+        {"CIERGB",        &optimize_rgb2spec_table<tukan::CIERGB>},
+        {"ColorMatchRGB", &optimize_rgb2spec_table<tukan::ColorMatchRGB>},
+        {"DonRGB4",       &optimize_rgb2spec_table<tukan::DonRGB4>},
+        {"ECIRGBv2",      &optimize_rgb2spec_table<tukan::ECIRGBv2>},
+        {"EktaSpacePS5",  &optimize_rgb2spec_table<tukan::EktaSpacePS5>},
+        {"NTSCRGB",       &optimize_rgb2spec_table<tukan::NTSCRGB>},
+        {"PALSECAMRGB",   &optimize_rgb2spec_table<tukan::PALSECAMRGB>},
+        {"ProPhotoRGB",   &optimize_rgb2spec_table<tukan::ProPhotoRGB>},
+        {"SMPTE_C",       &optimize_rgb2spec_table<tukan::SMPTE_C>},
+        {"sRGB",          &optimize_rgb2spec_table<tukan::sRGB>},
+        {"WideGamutRGB",  &optimize_rgb2spec_table<tukan::WideGamutRGB>},
+    };
+
+    int usage() {
+        std::cerr << "usage: rgb2spec_opt <space> <resolution> <output-file>\n"
+                     "spaces:";
+        for (auto const &e : spaces)
+            std::cerr << " " << e.name;
+        std::cerr << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4)
+        return usage();
+
+    const std::string name = argv[1];
+    const long resolution = std::atol(argv[2]);
+    if (resolution < 2)
+        return usage();
+
+    for (auto const &e : spaces) {
+        if (name != e.name)
+            continue;
+
+        std::cout << "optimizing " << name << " at resolution " << resolution << " ..."
+                  << std::endl;
+        const auto table = e.optimize(resolution);
+
+        std::ofstream os(argv[3], std::ios::binary);
+        table.write(os);
+        if (!os) {
+            std::cerr << "error: could not write '" << argv[3] << "'\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    return usage();
+}
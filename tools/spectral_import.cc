@@ -0,0 +1,266 @@
+// (C) 2013 Sebastian Mach (1983), this file is published under the terms of the
+// GNU General Public License, Version 3 (a.k.a. GPLv3).
+// See COPYING in the root-folder of the excygen project folder.
+
+// Converts measured spectra to a spectral library (see tukan/future/SpectralLibrary.hh).
+//
+// Usage: spectral_import [--f16] <lambda_min> <lambda_max> <bins> <output-file> <input-file>...
+//
+// All spectra are box-filtered to the given uniform layout. Input formats, detected by content:
+//
+//   CSV    A header row "wavelength,name1,name2,...", followed by rows "lambda,v1,v2,...".
+//
+//   CGATS  CGATS.17 / IT8 files with spectral fields in BEGIN_DATA_FORMAT, named
+//          SPECTRAL_NM<lambda> or SPECTRAL_NM_<lambda>, and SAMPLE_NAME or SAMPLE_ID.
+//
+//   JSON   Either an array of spectra, or an object with an array "spectra"; each spectrum is
+//          {"name": "...", "wavelengths": [...], "values": [...]}.
+//
+// Example: spectral_import --f16 380 780 81 materials.tksl macbeth.cgats leds.json
+
+#include "tukan/future/SpectralLibrary.hh"
+#include "tukan/future/SpectrumResampler.hh"
+#include "json.hh"
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace tukan;
+    using namespace tukan::future;
+    using namespace tools;
+
+    struct Measured {
+        std::string name;
+        std::vector<Nanometer> wavelengths;
+        std::vector<float> values;
+    };
+
+    std::vector<std::string> split (std::string const &line, char sep) {
+        std::vector<std::string> ret;
+        std::string field;
+        std::istringstream ss(line);
+        while (std::getline(ss, field, sep)) {
+            const auto first = field.find_first_not_of(" \t\r\""),
+                       last  = field.find_last_not_of(" \t\r\"");
+            ret.push_back(first == std::string::npos ? "" : field.substr(first, last-first+1));
+        }
+        return ret;
+    }
+
+    float number (std::string const &s) {
+        std::size_t used = 0;
+        const float f = std::stof(s, &used);
+        if (used != s.size())
+            throw std::runtime_error("not a number: '" + s + "'");
+        return f;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // CSV
+    //----------------------------------------------------------------------------------------------
+    std::vector<Measured> read_csv (std::istream &is) {
+        std::string line;
+        if (!std::getline(is, line))
+            throw std::runtime_error("empty CSV file");
+        const auto header = split(line, ',');
+        if (header.size() < 2)
+            throw std::runtime_error("CSV header needs a wavelength and at least one spectrum");
+
+        std::vector<Measured> ret (header.size()-1);
+        for (std::size_t i=1; i!=header.size(); ++i)
+            ret[i-1].name = header[i];
+
+        while (std::getline(is, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            const auto fields = split(line, ',');
+            if (fields.size() != header.size())
+                throw std::runtime_error("CSV row with wrong number of fields: " + line);
+            const Nanometer lambda (number(fields[0]));
+            for (std::size_t i=1; i!=fields.size(); ++i) {
+                ret[i-1].wavelengths.push_back(lambda);
+                ret[i-1].values.push_back(number(fields[i]));
+            }
+        }
+        return ret;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // CGATS
+    //----------------------------------------------------------------------------------------------
+    std::vector<std::string> tokens (std::string const &line) {
+        std::vector<std::string> ret;
+        std::size_t i = 0;
+        while (i < line.size()) {
+            if (std::isspace(static_cast<unsigned char>(line[i]))) { ++i; continue; }
+            if (line[i] == '"') {
+                const auto end = line.find('"', i+1);
+                ret.push_back(line.substr(i+1, end == std::string::npos ? end : end-i-1));
+                i = end == std::string::npos ? line.size() : end+1;
+            } else {
+                std::size_t end = i;
+                while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end])))
+                    ++end;
+                ret.push_back(line.substr(i, end-i));
+                i = end;
+            }
+        }
+        return ret;
+    }
+
+    std::vector<Measured> read_cgats (std::istream &is) {
+        std::vector<std::string> format;
+        std::string line;
+        bool in_format = false, in_data = false;
+
+        int name_field = -1;
+        std::vector<std::pair<std::size_t, Nanometer>> spectral; // field index, wavelength
+        std::vector<Measured> ret;
+
+        while (std::getline(is, line)) {
+            const auto t = tokens(line);
+            if (t.empty() || t[0][0] == '#')
+                continue;
+
+            if (t[0] == "BEGIN_DATA_FORMAT") { in_format = true; continue; }
+            if (t[0] == "END_DATA_FORMAT") {
+                in_format = false;
+                for (std::size_t i=0; i!=format.size(); ++i) {
+                    std::string const &f = format[i];
+                    if (f == "SAMPLE_NAME" || (f == "SAMPLE_ID" && name_field < 0))
+                        name_field = int(i);
+                    else if (f.compare(0, 11, "SPECTRAL_NM") == 0) {
+                        const std::string nm = f.substr(f.size() > 11 && f[11] == '_' ? 12 : 11);
+                        spectral.emplace_back(i, Nanometer(number(nm)));
+                    }
+                }
+                if (spectral.size() < 2)
+                    throw std::runtime_error("CGATS file without spectral fields");
+                continue;
+            }
+            if (t[0] == "BEGIN_DATA") { in_data = true; continue; }
+            if (t[0] == "END_DATA") { in_data = false; continue; }
+
+            if (in_format) {
+                format.insert(format.end(), t.begin(), t.end());
+            } else if (in_data) {
+                if (t.size() != format.size())
+                    throw std::runtime_error("CGATS row with wrong number of fields: " + line);
+                Measured m;
+                m.name = name_field >= 0 ? t[name_field] : std::to_string(ret.size()+1);
+                for (auto const &s : spectral) {
+                    m.wavelengths.push_back(s.second);
+                    m.values.push_back(number(t[s.first]));
+                }
+                ret.push_back(std::move(m));
+            }
+        }
+        return ret;
+    }
+
+
+    std::vector<Measured> read_json (std::istream &is) {
+        const std::string text ((std::istreambuf_iterator<char>(is)),
+                                std::istreambuf_iterator<char>());
+        const Json root = JsonParser(text).parse();
+        Json const *list = root.type == Json::array ? &root : root.member("spectra");
+        if (!list || list->type != Json::array)
+            throw std::runtime_error("JSON: expected an array of spectra");
+
+        std::vector<Measured> ret;
+        for (auto const &e : list->elements) {
+            Json const *name = e.member("name"),
+                       *wavelengths = e.member("wavelengths"),
+                       *values = e.member("values");
+            if (!name || name->type != Json::str || !wavelengths || !values
+                || wavelengths->elements.size() != values->elements.size())
+                throw std::runtime_error("JSON: spectra need a name and equally many "
+                                         "wavelengths and values");
+            Measured m;
+            m.name = name->string;
+            for (auto const &w : wavelengths->elements)
+                m.wavelengths.push_back(Nanometer(float(w.number)));
+            for (auto const &v : values->elements)
+                m.values.push_back(float(v.number));
+            ret.push_back(std::move(m));
+        }
+        return ret;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    std::vector<Measured> read_any (std::string const &path) {
+        std::ifstream is (path, std::ios::binary);
+        if (!is)
+            throw std::runtime_error("could not open '" + path + "'");
+        const std::string text ((std::istreambuf_iterator<char>(is)),
+                                std::istreambuf_iterator<char>());
+        std::istringstream ss(text);
+
+        const auto first = text.find_first_not_of(" \t\r\n");
+        if (first != std::string::npos && (text[first] == '{' || text[first] == '['))
+            return read_json(ss);
+        if (text.find("BEGIN_DATA_FORMAT") != std::string::npos)
+            return read_cgats(ss);
+        return read_csv(ss);
+    }
+
+    int usage() {
+        std::cerr << "usage: spectral_import [--f16] <lambda_min> <lambda_max> <bins> "
+                     "<output-file> <input-file>...\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> args (argv+1, argv+argc);
+    SpectralEncoding encoding = SpectralEncoding::float32;
+    if (!args.empty() && args[0] == "--f16") {
+        encoding = SpectralEncoding::float16;
+        args.erase(args.begin());
+    }
+    if (args.size() < 5)
+        return usage();
+
+    try {
+        const Nanometer lambda_min (number(args[0])), lambda_max (number(args[1]));
+        const long bins = std::atol(args[2].c_str());
+        if (bins < 2)
+            return usage();
+
+        const auto destination = SpectralLayout::uniform(lambda_min, lambda_max, bins);
+        SpectralLibraryWriter writer (lambda_min, lambda_max, bins, encoding);
+        std::vector<float> out (bins);
+
+        for (std::size_t f=4; f!=args.size(); ++f) {
+            for (auto const &m : read_any(args[f])) {
+                const SpectrumResampler resample (SpectralLayout::irregular(m.wavelengths),
+                                                  destination);
+                resample(m.values.data(), out.data());
+                writer.add(m.name, out);
+            }
+        }
+
+        std::ofstream os (args[3], std::ios::binary);
+        writer.write(os);
+        if (!os) {
+            std::cerr << "error: could not write '" << args[3] << "'\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "wrote " << writer.size() << " spectra to " << args[3] << std::endl;
+    } catch (std::exception const &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}